@@ -2096,6 +2096,42 @@ protected:
             const TensorLayout& grad_x, size_t workspace_in_bytes);
 };
 
+/*!
+ * \brief scaled dot-product attention: dst = softmax(q * k^T * scale + mask) * v
+ *
+ * q is (N, Sq, D), k is (N, Sk, D), v is (N, Sk, Dv) and dst is (N, Sq, Dv),
+ * where N is usually batch * heads. If param().has_mask is true, mask is
+ * added to the scaled scores and must be broadcastable to (N, Sq, Sk) with
+ * the shape of (N or 1, Sq or 1, Sk); otherwise mask is ignored and may be
+ * empty.
+ *
+ * The scores of shape (N, Sq, Sk) are not necessarily materialized, so
+ * implementations can tile the computation and keep it in the cache.
+ */
+class FusedAttentionForward : public OperatorBase {
+    DEF_OPR_PARAM(FusedAttention);
+    DEF_OPR_IMPL(FusedAttentionForward, OperatorBase, 4, 1);
+
+public:
+    virtual void exec(
+            _megdnn_tensor_in q, _megdnn_tensor_in k, _megdnn_tensor_in v,
+            _megdnn_tensor_in mask, _megdnn_tensor_out dst,
+            _megdnn_workspace workspace) = 0;
+    void deduce_layout(
+            const TensorLayout& q, const TensorLayout& k, const TensorLayout& v,
+            const TensorLayout& mask, TensorLayout& dst);
+    virtual size_t get_workspace_in_bytes(
+            const TensorLayout& q, const TensorLayout& k, const TensorLayout& v,
+            const TensorLayout& mask, const TensorLayout& dst) = 0;
+
+protected:
+    void check_exec(
+            const TensorLayout& q, const TensorLayout& k, const TensorLayout& v,
+            const TensorLayout& mask, const TensorLayout& dst,
+            size_t workspace_in_bytes);
+};
+using FusedAttention = FusedAttentionForward;
+
 class RNNCellForward : public OperatorBase {
     DEF_OPR_PARAM(RNNCell);
     DEF_OPR_IMPL(RNNCellForward, OperatorBase, 6, 1);
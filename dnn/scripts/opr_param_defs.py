@@ -1260,3 +1260,10 @@ PADDING_MODES = [Doc('REPLICATE = 0', 'aaaaaa|abcdefgh|hhhhhhh'),
  add_fields('float32', Doc('dropout', 'If introduce a Dropout layer on the outputs of each LSTM layer'), '0.f').
  add_enum_alias('FwdMode', 'BN', name_field='fwd_mode')
  )
+
+(pdef('FusedAttention').
+ add_fields('float32', Doc('scale', 'factor multiplied to the scores of q and k before '
+            'softmax'), '1.f').
+ add_fields('bool', Doc('has_mask', 'whether a mask is added to the scaled scores '
+            'before softmax'), 'false')
+ )
@@ -0,0 +1,68 @@
+/**
+ * \file dnn/src/common/fused_attention.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+#include "megdnn/oprs.h"
+
+#include "src/common/utils.h"
+
+namespace megdnn {
+
+void FusedAttentionForward::deduce_layout(
+        const TensorLayout& q, const TensorLayout& k, const TensorLayout& v,
+        const TensorLayout& mask, TensorLayout& dst) {
+    MEGDNN_MARK_USED_VAR(k);
+    MEGDNN_MARK_USED_VAR(mask);
+    megdnn_assert(
+            q.ndim == 3 && v.ndim == 3, "q and v of FusedAttention must be 3D: %s %s",
+            q.to_string().c_str(), v.to_string().c_str());
+    dst = TensorLayout{{q[0], q[1], v[2]}, q.dtype};
+}
+
+void FusedAttentionForward::check_exec(
+        const TensorLayout& q, const TensorLayout& k, const TensorLayout& v,
+        const TensorLayout& mask, const TensorLayout& dst, size_t workspace_in_bytes) {
+    auto errmsg = [&]() {
+        return megdnn_layout_msg(q) + ", " + megdnn_layout_msg(k) + ", " +
+               megdnn_layout_msg(v) + ", " + megdnn_layout_msg(mask) + ", " +
+               megdnn_layout_msg(dst);
+    };
+    MEGDNN_MARK_USED_VAR(errmsg);
+    megdnn_assert_contiguous(q);
+    megdnn_assert_contiguous(k);
+    megdnn_assert_contiguous(v);
+    megdnn_assert_contiguous(dst);
+    megdnn_assert(
+            q.ndim == 3 && k.ndim == 3 && v.ndim == 3 && dst.ndim == 3, "%s",
+            errmsg().c_str());
+    megdnn_assert(
+            q.dtype == dtype::Float32() && k.dtype == q.dtype && v.dtype == q.dtype &&
+                    dst.dtype == q.dtype,
+            "FusedAttention only supports float32: %s", errmsg().c_str());
+    megdnn_assert(
+            k[0] == q[0] && v[0] == q[0] && k[2] == q[2] && v[1] == k[1] &&
+                    dst[0] == q[0] && dst[1] == q[1] && dst[2] == v[2],
+            "%s", errmsg().c_str());
+    if (param().has_mask) {
+        megdnn_assert_contiguous(mask);
+        megdnn_assert(
+                mask.ndim == 3 && mask.dtype == q.dtype &&
+                        (mask[0] == q[0] || mask[0] == 1) &&
+                        (mask[1] == q[1] || mask[1] == 1) && mask[2] == k[1],
+                "mask of FusedAttention must be of shape (N or 1, Sq or 1, Sk): %s",
+                errmsg().c_str());
+    }
+    auto required_workspace_in_bytes = get_workspace_in_bytes(q, k, v, mask, dst);
+    megdnn_assert(workspace_in_bytes >= required_workspace_in_bytes);
+}
+
+}  // namespace megdnn
+
+// vim: syntax=cpp.doxygen
@@ -222,7 +222,8 @@ private:
     cb(LSTM) \
     cb(LSTMBackward) \
     cb(SoftmaxForward) \
-    cb(SoftmaxBackward)
+    cb(SoftmaxBackward) \
+    cb(FusedAttentionForward)
 // clang-format on
 
 /*!
@@ -148,6 +148,7 @@ DEF(LSTMForward, 8, true, true);
 DEF(LSTMBackward, 13, true, true);
 DEF(SoftmaxForward, 2, true, true);
 DEF(SoftmaxBackward, 3, true, false);
+DEF(FusedAttentionForward, 5, true, true);
 }  // namespace megdnn
 
 // vim: syntax=cpp.doxygen
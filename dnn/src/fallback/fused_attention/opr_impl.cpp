@@ -0,0 +1,338 @@
+/**
+ * \file dnn/src/fallback/fused_attention/opr_impl.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+
+#include "src/fallback/fused_attention/opr_impl.h"
+#include "src/common/utils.h"
+#include "src/naive/handle.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "midout.h"
+
+MIDOUT_DECL(megdnn_fallback_fused_attention)
+
+using namespace megdnn;
+using namespace fallback;
+
+namespace {
+
+struct KernParam {
+    const float *q, *k, *v, *mask;
+    float* dst;
+    float* workspace;
+    size_t nr_qblock, sq, sk, d, dv;
+    size_t mask_n_stride, mask_q_stride;
+    float scale;
+    FusedAttentionForwardImpl::TileMatmul matmul;
+};
+
+MatrixMulImpl::KernSizeParam make_matmul_param(
+        size_t M, size_t N, size_t K, size_t LDA, size_t LDB, size_t LDC, bool trB) {
+    MatrixMulImpl::KernSizeParam ret;
+    ret.A_type = ret.B_type = ret.C_type = dtype::Float32();
+    ret.M = M;
+    ret.N = N;
+    ret.K = K;
+    ret.LDA = LDA;
+    ret.LDB = LDB;
+    ret.LDC = LDC;
+    ret.trA = false;
+    ret.trB = trB;
+    ret.compute_mode = param::MatrixMul::ComputeMode::DEFAULT;
+    ret.format = param::MatrixMul::Format::DEFAULT;
+    return ret;
+}
+
+//! C(M, N) = A * B by the matmul kernel, with the ld of \p size_param
+void run_matmul(
+        const MatrixMulImpl::AlgoBase* algo,
+        const MatrixMulImpl::KernSizeParam& size_param, size_t M, size_t N, size_t K,
+        const float* A, const float* B, float* C, void* workspace,
+        size_t workspace_size) {
+    MatrixMulImpl::KernParam param;
+    static_cast<MatrixMulImpl::KernSizeParam&>(param) = size_param;
+    param.M = M;
+    param.N = N;
+    param.K = K;
+    param.A_ptr.reset(A);
+    param.B_ptr.reset(B);
+    param.C_ptr.reset(C);
+    param.workspace_ptr = workspace;
+    param.workspace_size = workspace_size;
+    algo->get_kern(param)(param);
+}
+
+//! number of query rows handled together by the micro kernels
+constexpr size_t NR_ROWS = 4;
+
+/*!
+ * \brief score rows [i0, i0 + NR_ROWS) of the tile: q_rows * kt
+ *
+ * kt is the key block transposed to (D, BLOCK_K) and padded by zero, so the
+ * inner loop is an axpy of constant length and would be vectorized without
+ * reassociating any reduction; each row of kt is reused by NR_ROWS queries.
+ */
+template <size_t nr_rows>
+void score_rows(
+        const float* __restrict q, size_t D, const float* __restrict kt,
+        float* __restrict score, float scale) {
+    constexpr size_t BK = FusedAttentionForwardImpl::BLOCK_K;
+    float acc[nr_rows][BK] = {};
+    for (size_t d = 0; d < D; ++d) {
+        const float* __restrict krow = kt + d * BK;
+        for (size_t r = 0; r < nr_rows; ++r) {
+            float qv = q[r * D + d];
+            for (size_t j = 0; j < BK; ++j) {
+                acc[r][j] += qv * krow[j];
+            }
+        }
+    }
+    for (size_t r = 0; r < nr_rows; ++r) {
+        for (size_t j = 0; j < BK; ++j) {
+            score[r * BK + j] = acc[r][j] * scale;
+        }
+    }
+}
+
+/*!
+ * \brief accumulate probs * v_blk into output rows [i0, i0 + NR_ROWS)
+ *
+ * The rows of v are loaded once for NR_ROWS outputs, and the loop over DV is
+ * an axpy.
+ */
+template <size_t nr_rows>
+void accum_rows(
+        const float* __restrict prob, size_t nr_k, const float* __restrict v,
+        size_t DV, float* __restrict acc) {
+    constexpr size_t BK = FusedAttentionForwardImpl::BLOCK_K;
+    for (size_t j = 0; j < nr_k; ++j) {
+        const float* __restrict vrow = v + j * DV;
+        float p[nr_rows];
+        for (size_t r = 0; r < nr_rows; ++r) {
+            p[r] = prob[r * BK + j];
+        }
+        for (size_t r = 0; r < nr_rows; ++r) {
+            float* __restrict arow = acc + r * DV;
+            for (size_t d = 0; d < DV; ++d) {
+                arow[d] += p[r] * vrow[d];
+            }
+        }
+    }
+}
+
+/*!
+ * \brief compute the block of queries [q0, q0 + nr_q) of batch n
+ *
+ * The workspace holds the workspace of the matmul kernels, the transposed key
+ * block, the score tile, the unnormalized output rows, the product of the
+ * probabilities and v, and the running max and sum of each row.
+ */
+void kern_block(const KernParam& kp, size_t n, size_t q0, size_t nr_q, float* ws) {
+    constexpr size_t BQ = FusedAttentionForwardImpl::BLOCK_Q,
+                     BK = FusedAttentionForwardImpl::BLOCK_K;
+    size_t D = kp.d, DV = kp.dv, nr_q_full = nr_q / NR_ROWS * NR_ROWS;
+    auto&& mm = kp.matmul;
+    void* matmul_ws = ws;
+    float* kt = ws + div_ceil(mm.workspace, sizeof(float));
+    float* score = kt + D * BK;
+    float* acc = score + BQ * BK;
+    float* pv = acc + BQ * DV;
+    float* row_max = pv + BQ * DV;
+    float* row_sum = row_max + BQ;
+    std::fill(acc, acc + nr_q * DV, 0.f);
+    std::fill(row_max, row_max + nr_q, -INFINITY);
+    std::fill(row_sum, row_sum + nr_q, 0.f);
+
+    const float* qblk = kp.q + (n * kp.sq + q0) * D;
+    const float* kbase = kp.k + n * kp.sk * D;
+    const float* vbase = kp.v + n * kp.sk * DV;
+    for (size_t k0 = 0; k0 < kp.sk; k0 += BK) {
+        size_t nr_k = std::min(BK, kp.sk - k0);
+        const float* kblk = kbase + k0 * D;
+        // score tile = q_blk * k_blk^T * scale + mask
+        if (mm.qk_algo) {
+            run_matmul(
+                    mm.qk_algo, mm.qk_param, nr_q, nr_k, D, qblk, kblk, score,
+                    matmul_ws, mm.workspace);
+            for (size_t i = 0; i < nr_q; ++i) {
+                float* srow = score + i * BK;
+                for (size_t j = 0; j < nr_k; ++j) {
+                    srow[j] *= kp.scale;
+                }
+            }
+        } else {
+            // kt = k_blk^T, with the columns beyond nr_k set to zero
+            if (nr_k < BK) {
+                std::fill(kt, kt + D * BK, 0.f);
+            }
+            for (size_t j = 0; j < nr_k; ++j) {
+                const float* krow = kblk + j * D;
+                for (size_t d = 0; d < D; ++d) {
+                    kt[d * BK + j] = krow[d];
+                }
+            }
+            for (size_t i = 0; i < nr_q_full; i += NR_ROWS) {
+                score_rows<NR_ROWS>(qblk + i * D, D, kt, score + i * BK, kp.scale);
+            }
+            for (size_t i = nr_q_full; i < nr_q; ++i) {
+                score_rows<1>(qblk + i * D, D, kt, score + i * BK, kp.scale);
+            }
+        }
+        if (kp.mask) {
+            for (size_t i = 0; i < nr_q; ++i) {
+                float* srow = score + i * BK;
+                const float* mrow = kp.mask + n * kp.mask_n_stride +
+                                    (q0 + i) * kp.mask_q_stride + k0;
+                for (size_t j = 0; j < nr_k; ++j) {
+                    srow[j] += mrow[j];
+                }
+            }
+        }
+        // online softmax: rescale what has been accumulated by the new max,
+        // and replace the scores by the unnormalized probabilities
+        for (size_t i = 0; i < nr_q; ++i) {
+            float* srow = score + i * BK;
+            float* arow = acc + i * DV;
+            float cur_max = row_max[i];
+            for (size_t j = 0; j < nr_k; ++j) {
+                cur_max = std::max(cur_max, srow[j]);
+            }
+            if (cur_max == -INFINITY) {
+                // all masked so far
+                std::fill(srow, srow + nr_k, 0.f);
+                continue;
+            }
+            float correction = std::exp(row_max[i] - cur_max);
+            row_max[i] = cur_max;
+            float sum = 0;
+            for (size_t j = 0; j < nr_k; ++j) {
+                srow[j] = std::exp(srow[j] - cur_max);
+                sum += srow[j];
+            }
+            row_sum[i] = row_sum[i] * correction + sum;
+            if (correction != 1.f) {
+                for (size_t d = 0; d < DV; ++d) {
+                    arow[d] *= correction;
+                }
+            }
+        }
+        const float* vblk = vbase + k0 * DV;
+        if (mm.pv_algo) {
+            run_matmul(
+                    mm.pv_algo, mm.pv_param, nr_q, DV, nr_k, score, vblk, pv,
+                    matmul_ws, mm.workspace);
+            for (size_t i = 0; i < nr_q * DV; ++i) {
+                acc[i] += pv[i];
+            }
+        } else {
+            for (size_t i = 0; i < nr_q_full; i += NR_ROWS) {
+                accum_rows<NR_ROWS>(score + i * BK, nr_k, vblk, DV, acc + i * DV);
+            }
+            for (size_t i = nr_q_full; i < nr_q; ++i) {
+                accum_rows<1>(score + i * BK, nr_k, vblk, DV, acc + i * DV);
+            }
+        }
+    }
+
+    float* dblk = kp.dst + (n * kp.sq + q0) * DV;
+    for (size_t i = 0; i < nr_q; ++i) {
+        float inv = 1.f / row_sum[i];
+        for (size_t d = 0; d < DV; ++d) {
+            dblk[i * DV + d] = acc[i * DV + d] * inv;
+        }
+    }
+}
+
+}  // anonymous namespace
+
+FusedAttentionForwardImpl::TileMatmul FusedAttentionForwardImpl::get_tile_matmul(
+        const TensorLayout& q, const TensorLayout& k, const TensorLayout& v) {
+    if (!m_matmul_opr) {
+        m_matmul_opr = handle()->create_operator<MatrixMul>();
+    }
+    auto&& algos =
+            static_cast<MatrixMulImpl*>(m_matmul_opr.get())->get_all_packed_algo();
+    auto get_algo = [&](const MatrixMulImpl::KernSizeParam& param) {
+        for (auto algo : algos) {
+            if (algo->usable(param) && algo->preferred(param)) {
+                return static_cast<const MatrixMulImpl::AlgoBase*>(algo);
+            }
+        }
+        return static_cast<const MatrixMulImpl::AlgoBase*>(nullptr);
+    };
+    size_t M = std::min(q[1], size_t(BLOCK_Q)), NK = std::min(k[1], size_t(BLOCK_K)),
+           D = q[2], DV = v[2];
+    TileMatmul ret;
+    ret.qk_param = make_matmul_param(M, NK, D, D, D, BLOCK_K, true);
+    ret.pv_param = make_matmul_param(M, DV, NK, BLOCK_K, DV, DV, false);
+    ret.qk_algo = get_algo(ret.qk_param);
+    ret.pv_algo = get_algo(ret.pv_param);
+    if (ret.qk_algo) {
+        ret.workspace = ret.qk_algo->get_workspace(ret.qk_param);
+    }
+    if (ret.pv_algo) {
+        ret.workspace =
+                std::max(ret.workspace, ret.pv_algo->get_workspace(ret.pv_param));
+    }
+    return ret;
+}
+
+size_t FusedAttentionForwardImpl::get_workspace_in_bytes(
+        const TensorLayout& q, const TensorLayout& k, const TensorLayout& v,
+        const TensorLayout&, const TensorLayout&) {
+    size_t nr_threads = static_cast<naive::HandleImpl*>(handle())
+                                ->megcore_dispatcher()
+                                ->nr_threads();
+    size_t matmul_ws = get_tile_matmul(q, k, v).workspace;
+    return nr_threads * get_thread_workspace(q[2], v[2], matmul_ws) * sizeof(float);
+}
+
+void FusedAttentionForwardImpl::exec(
+        _megdnn_tensor_in q, _megdnn_tensor_in k, _megdnn_tensor_in v,
+        _megdnn_tensor_in mask, _megdnn_tensor_out dst, _megdnn_workspace workspace) {
+    check_exec(q.layout, k.layout, v.layout, mask.layout, dst.layout, workspace.size);
+    MIDOUT_BEGIN(megdnn_fallback_fused_attention, midout_iv(0)) {
+        KernParam kp;
+        kp.q = q.ptr<dt_float32>();
+        kp.k = k.ptr<dt_float32>();
+        kp.v = v.ptr<dt_float32>();
+        kp.mask = param().has_mask ? mask.ptr<dt_float32>() : nullptr;
+        kp.dst = dst.ptr<dt_float32>();
+        kp.workspace = workspace.ptr<float>();
+        kp.sq = q.layout[1];
+        kp.sk = k.layout[1];
+        kp.d = q.layout[2];
+        kp.dv = v.layout[2];
+        kp.nr_qblock = div_ceil(kp.sq, BLOCK_Q);
+        kp.mask_n_stride = kp.mask_q_stride = 0;
+        if (kp.mask) {
+            kp.mask_q_stride = mask.layout[1] == 1 ? 0 : kp.sk;
+            kp.mask_n_stride = mask.layout[0] == 1 ? 0 : mask.layout[1] * kp.sk;
+        }
+        kp.scale = param().scale;
+        kp.matmul = get_tile_matmul(q.layout, k.layout, v.layout);
+
+        size_t thread_ws = get_thread_workspace(kp.d, kp.dv, kp.matmul.workspace);
+        auto run = [kp, thread_ws](size_t index, size_t thread_id) {
+            size_t n = index / kp.nr_qblock, q0 = index % kp.nr_qblock * BLOCK_Q;
+            kern_block(
+                    kp, n, q0, std::min(kp.sq - q0, size_t(BLOCK_Q)),
+                    kp.workspace + thread_id * thread_ws);
+        };
+        MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN_OPR(run, q.layout[0] * kp.nr_qblock);
+        return;
+    }
+    MIDOUT_END();
+}
+
+// vim: syntax=cpp.doxygen
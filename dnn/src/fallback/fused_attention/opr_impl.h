@@ -0,0 +1,70 @@
+/**
+ * \file dnn/src/fallback/fused_attention/opr_impl.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+#pragma once
+
+#include "src/fallback/matrix_mul/opr_impl.h"
+#include "src/naive/fused_attention/opr_impl.h"
+
+namespace megdnn {
+namespace fallback {
+
+/*!
+ * \brief tiled attention with online softmax
+ *
+ * Each task computes a block of queries of one batch, and iterates over blocks
+ * of keys while keeping the running max and sum of the softmax, so only a
+ * BLOCK_Q x BLOCK_K tile of the scores lives in the per-thread workspace.
+ * Both products on the tile are computed by the gemm kernel of the handle's
+ * MatrixMul, as im2col does; if no kernel is preferred for the tiles, the
+ * builtin register-blocked axpy loops are used instead.
+ */
+class FusedAttentionForwardImpl final : public naive::FusedAttentionForwardImpl {
+public:
+    using naive::FusedAttentionForwardImpl::FusedAttentionForwardImpl;
+
+    static constexpr size_t BLOCK_Q = 16, BLOCK_K = 64;
+
+    void exec(
+            _megdnn_tensor_in q, _megdnn_tensor_in k, _megdnn_tensor_in v,
+            _megdnn_tensor_in mask, _megdnn_tensor_out dst,
+            _megdnn_workspace workspace) override;
+    size_t get_workspace_in_bytes(
+            const TensorLayout& q, const TensorLayout& k, const TensorLayout& v,
+            const TensorLayout& mask, const TensorLayout& dst) override;
+
+    //! matmul kernels used on a tile of q * k^T and one of probs * v
+    struct TileMatmul {
+        //! null if the builtin loops are used
+        const MatrixMulImpl::AlgoBase *qk_algo = nullptr, *pv_algo = nullptr;
+        MatrixMulImpl::KernSizeParam qk_param, pv_param;
+        //! workspace of the kernels in bytes
+        size_t workspace = 0;
+    };
+
+private:
+    std::unique_ptr<MatrixMul> m_matmul_opr;
+
+    TileMatmul get_tile_matmul(
+            const TensorLayout& q, const TensorLayout& k, const TensorLayout& v);
+
+    //! number of floats in the workspace of a thread, aligned to 64 bytes
+    static size_t get_thread_workspace(size_t d, size_t dv, size_t matmul_ws) {
+        size_t nr = div_ceil(matmul_ws, sizeof(float)) + d * BLOCK_K +
+                    BLOCK_Q * BLOCK_K + BLOCK_Q * dv * 2 + BLOCK_Q * 2;
+        return round_up<size_t>(nr, 16);
+    }
+};
+
+}  // namespace fallback
+}  // namespace megdnn
+
+// vim: syntax=cpp.doxygen
@@ -20,8 +20,10 @@
 #include "src/fallback/elemwise/opr_impl.h"
 #include "src/fallback/elemwise_multi_type/opr_impl.h"
 #include "src/fallback/flip/opr_impl.h"
+#include "src/fallback/fused_attention/opr_impl.h"
 #include "src/fallback/gaussian_blur/opr_impl.h"
 #include "src/fallback/group_local/opr_impl.h"
+#include "src/fallback/layer_norm/opr_impl.h"
 #include "src/fallback/mask_conv/opr_impl.h"
 #include "src/fallback/matrix_mul/opr_impl.h"
 #include "src/fallback/pooling/opr_impl.h"
@@ -70,6 +72,8 @@ MEGDNN_SPECIALIZE_CREATE_OPERATOR(Resize)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(BatchedMatrixMulForward)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(ConvBias)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(PowC)
+MEGDNN_SPECIALIZE_CREATE_OPERATOR(FusedAttentionForward)
+MEGDNN_SPECIALIZE_CREATE_OPERATOR(LayerNormForward)
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wpragmas"
@@ -0,0 +1,102 @@
+/**
+ * \file dnn/src/fallback/layer_norm/opr_impl.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+
+#include "src/fallback/layer_norm/opr_impl.h"
+#include "src/common/utils.h"
+#include "src/naive/handle.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "midout.h"
+
+MIDOUT_DECL(megdnn_fallback_layer_norm)
+
+using namespace megdnn;
+using namespace fallback;
+
+namespace {
+
+struct KernParam {
+    const float *src, *weight, *bias;
+    float *dst, *mean, *rstd;
+    size_t nr_slice, slice_len, slice_per_task;
+    float eps;
+};
+
+void kern_slices(const KernParam& kp, size_t task_id) {
+    size_t begin = task_id * kp.slice_per_task,
+           end = std::min(begin + kp.slice_per_task, kp.nr_slice), len = kp.slice_len;
+    for (size_t i = begin; i < end; ++i) {
+        const float* src = kp.src + i * len;
+        float* dst = kp.dst + i * len;
+        float sum = 0;
+        for (size_t j = 0; j < len; ++j) {
+            sum += src[j];
+        }
+        float mean = sum / len;
+        float var = 0;
+        for (size_t j = 0; j < len; ++j) {
+            float d = src[j] - mean;
+            var += d * d;
+        }
+        float rstd = 1.f / std::sqrt(var / len + kp.eps);
+        if (kp.weight) {
+            for (size_t j = 0; j < len; ++j) {
+                dst[j] = (src[j] - mean) * rstd * kp.weight[j] + kp.bias[j];
+            }
+        } else {
+            for (size_t j = 0; j < len; ++j) {
+                dst[j] = (src[j] - mean) * rstd;
+            }
+        }
+        kp.mean[i] = mean;
+        kp.rstd[i] = rstd;
+    }
+}
+
+}  // anonymous namespace
+
+void LayerNormForwardImpl::exec(
+        _megdnn_tensor_in data, _megdnn_tensor_in weight, _megdnn_tensor_in bias,
+        _megdnn_tensor_out dst, _megdnn_tensor_out mean, _megdnn_tensor_out rstd,
+        _megdnn_workspace workspace) {
+    if (data.layout.dtype != dtype::Float32()) {
+        return naive::LayerNormForwardImpl::exec(
+                data, weight, bias, dst, mean, rstd, workspace);
+    }
+    check_exec(
+            data.layout, weight.layout, bias.layout, dst.layout, mean.layout,
+            rstd.layout, workspace.size);
+    MIDOUT_BEGIN(megdnn_fallback_layer_norm, midout_iv(0)) {
+        auto p = param();
+        KernParam kp;
+        kp.src = data.ptr<dt_float32>();
+        kp.weight = p.affine ? weight.ptr<dt_float32>() : nullptr;
+        kp.bias = p.affine ? bias.ptr<dt_float32>() : nullptr;
+        kp.dst = dst.ptr<dt_float32>();
+        kp.mean = mean.ptr<dt_float32>();
+        kp.rstd = rstd.ptr<dt_float32>();
+        kp.slice_len = p.normalized_size;
+        kp.nr_slice = data.layout.total_nr_elems() / kp.slice_len;
+        // about 16K elements per task to amortize the dispatch
+        kp.slice_per_task = std::max<size_t>(1, 16384 / kp.slice_len);
+        kp.eps = p.eps;
+        auto run = [kp](size_t index, size_t) { kern_slices(kp, index); };
+        MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN_OPR(
+                run, div_ceil(kp.nr_slice, kp.slice_per_task));
+        return;
+    }
+    MIDOUT_END();
+}
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,37 @@
+/**
+ * \file dnn/src/fallback/layer_norm/opr_impl.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+#pragma once
+
+#include "src/naive/layer_norm/opr_impl.h"
+
+namespace megdnn {
+namespace fallback {
+
+/*!
+ * \brief layer norm of float32, with the slices split among threads
+ *
+ * Each slice is read once for the mean, once for the variance and once for
+ * the output, which is cache resident for the usual hidden sizes.
+ */
+class LayerNormForwardImpl final : public naive::LayerNormForwardImpl {
+public:
+    using naive::LayerNormForwardImpl::LayerNormForwardImpl;
+    void exec(
+            _megdnn_tensor_in data, _megdnn_tensor_in weight, _megdnn_tensor_in bias,
+            _megdnn_tensor_out dst, _megdnn_tensor_out mean, _megdnn_tensor_out rstd,
+            _megdnn_workspace workspace) override;
+};
+
+}  // namespace fallback
+}  // namespace megdnn
+
+// vim: syntax=cpp.doxygen
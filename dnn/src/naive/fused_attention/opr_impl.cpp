@@ -0,0 +1,79 @@
+/**
+ * \file dnn/src/naive/fused_attention/opr_impl.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+#include "src/naive/fused_attention/opr_impl.h"
+#include <cmath>
+#include "src/common/utils.h"
+#include "src/naive/handle.h"
+
+using namespace megdnn;
+using namespace naive;
+
+namespace {
+
+void forward(
+        _megdnn_tensor_in q, _megdnn_tensor_in k, _megdnn_tensor_in v,
+        _megdnn_tensor_in mask, _megdnn_tensor_out dst, float* score,
+        const FusedAttention::Param& param) {
+    size_t N = q.layout[0], SQ = q.layout[1], SK = k.layout[1], D = q.layout[2],
+           DV = v.layout[2];
+    const float* mptr = param.has_mask ? mask.ptr<dt_float32>() : nullptr;
+    size_t mask_n_stride = 0, mask_q_stride = 0;
+    if (mptr) {
+        mask_q_stride = mask.layout[1] == 1 ? 0 : SK;
+        mask_n_stride = mask.layout[0] == 1 ? 0 : mask.layout[1] * SK;
+    }
+    for (size_t n = 0; n < N; ++n) {
+        for (size_t i = 0; i < SQ; ++i) {
+            const float* qrow = q.ptr<dt_float32>() + (n * SQ + i) * D;
+            float max_score = -INFINITY;
+            for (size_t j = 0; j < SK; ++j) {
+                const float* krow = k.ptr<dt_float32>() + (n * SK + j) * D;
+                float s = 0;
+                for (size_t d = 0; d < D; ++d) {
+                    s += qrow[d] * krow[d];
+                }
+                s *= param.scale;
+                if (mptr) {
+                    s += mptr[n * mask_n_stride + i * mask_q_stride + j];
+                }
+                score[j] = s;
+                max_score = std::max(max_score, s);
+            }
+            float sum = 0;
+            for (size_t j = 0; j < SK; ++j) {
+                score[j] = std::exp(score[j] - max_score);
+                sum += score[j];
+            }
+            float* orow = dst.ptr<dt_float32>() + (n * SQ + i) * DV;
+            for (size_t d = 0; d < DV; ++d) {
+                float acc = 0;
+                for (size_t j = 0; j < SK; ++j) {
+                    acc += score[j] * v.ptr<dt_float32>()[(n * SK + j) * DV + d];
+                }
+                orow[d] = acc / sum;
+            }
+        }
+    }
+}
+
+}  // namespace
+
+void FusedAttentionForwardImpl::exec(
+        _megdnn_tensor_in q, _megdnn_tensor_in k, _megdnn_tensor_in v,
+        _megdnn_tensor_in mask, _megdnn_tensor_out dst, _megdnn_workspace workspace) {
+    check_exec(q.layout, k.layout, v.layout, mask.layout, dst.layout, workspace.size);
+    auto score = workspace.ptr<float>();
+    auto param = this->param();
+    MEGDNN_DISPATCH_CPU_KERN_OPR(forward(q, k, v, mask, dst, score, param));
+}
+
+// vim: syntax=cpp.doxygen
@@ -43,6 +43,7 @@
 #include "src/naive/fake_quant/opr_impl.h"
 #include "src/naive/fill/opr_impl.h"
 #include "src/naive/flip/opr_impl.h"
+#include "src/naive/fused_attention/opr_impl.h"
 #include "src/naive/gaussian_blur/opr_impl.h"
 #include "src/naive/group_local/opr_impl.h"
 #include "src/naive/images2neibs/opr_impl.h"
@@ -15,7 +15,7 @@
 namespace megdnn {
 namespace naive {
 
-class LayerNormForwardImpl final : public LayerNormForward {
+class LayerNormForwardImpl : public LayerNormForward {
 public:
     using LayerNormForward::LayerNormForward;
     void exec(
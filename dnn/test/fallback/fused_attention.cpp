@@ -0,0 +1,56 @@
+/**
+ * \file dnn/test/fallback/fused_attention.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+#include "test/fallback/fixture.h"
+
+#include "test/common/checker.h"
+
+using namespace megdnn;
+using namespace test;
+
+namespace {
+
+void run_fused_attention_test(Handle* handle) {
+    using Param = FusedAttention::Param;
+    Checker<FusedAttention> checker(handle);
+    UniformFloatRNG rng(-2.f, 2.f);
+    checker.set_rng(0, &rng).set_rng(1, &rng).set_rng(2, &rng).set_rng(3, &rng);
+
+    Param param;
+    // sizes around the blocks of queries and keys
+    for (size_t sq : {1, 16, 37})
+        for (size_t sk : {1, 64, 130}) {
+            param.scale = 0.125f;
+            param.has_mask = false;
+            checker.set_param(param).execs(
+                    {{6, sq, 32}, {6, sk, 32}, {6, sk, 24}, {}, {}});
+
+            param.has_mask = true;
+            checker.set_param(param).execs(
+                    {{6, sq, 8}, {6, sk, 8}, {6, sk, 16}, {6, sq, sk}, {}});
+            checker.set_param(param).execs(
+                    {{6, sq, 8}, {6, sk, 8}, {6, sk, 16}, {1, 1, sk}, {}});
+            checker.set_param(param).execs(
+                    {{6, sq, 8}, {6, sk, 8}, {6, sk, 16}, {6, 1, sk}, {}});
+        }
+}
+
+}  // anonymous namespace
+
+TEST_F(FALLBACK, FUSED_ATTENTION) {
+    run_fused_attention_test(handle());
+}
+
+TEST_F(FALLBACK_MULTI_THREADS, FUSED_ATTENTION) {
+    run_fused_attention_test(handle());
+}
+
+// vim: syntax=cpp.doxygen
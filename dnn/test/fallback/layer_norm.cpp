@@ -0,0 +1,65 @@
+/**
+ * \file dnn/test/fallback/layer_norm.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+#include "test/fallback/fixture.h"
+
+#include "test/common/checker.h"
+
+using namespace megdnn;
+using namespace test;
+
+namespace {
+
+void run_layer_norm_test(Handle* handle) {
+    using Param = LayerNormForward::Param;
+    Checker<LayerNormForward> checker(handle);
+    Param param;
+    param.eps = 1e-5;
+    param.normalized_dim = 1;
+    for (bool affine : {true, false})
+        for (size_t n_slices : {1, 7, 300})
+            for (size_t slice_len : {1, 17, 768}) {
+                param.affine = affine;
+                param.normalized_size = slice_len;
+                checker.set_param(param)
+                        .set_dtype(4, dtype::Float32())
+                        .set_dtype(5, dtype::Float32());
+                if (affine) {
+                    checker.execs(
+                            {{n_slices, slice_len},
+                             {slice_len},
+                             {slice_len},
+                             {n_slices, slice_len},
+                             {n_slices},
+                             {n_slices}});
+                } else {
+                    checker.execs(
+                            {{n_slices, slice_len},
+                             {},
+                             {},
+                             {n_slices, slice_len},
+                             {n_slices},
+                             {n_slices}});
+                }
+            }
+}
+
+}  // anonymous namespace
+
+TEST_F(FALLBACK, LAYER_NORM_FORWARD) {
+    run_layer_norm_test(handle());
+}
+
+TEST_F(FALLBACK_MULTI_THREADS, LAYER_NORM_FORWARD) {
+    run_layer_norm_test(handle());
+}
+
+// vim: syntax=cpp.doxygen
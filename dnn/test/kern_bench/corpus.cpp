@@ -0,0 +1,233 @@
+/**
+ * \file dnn/test/kern_bench/corpus.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+#include "test/kern_bench/kern_bench.h"
+
+#include "test/common/rng.h"
+#include "test/common/warp_perspective.h"
+
+using namespace megdnn;
+using namespace test;
+using namespace kern_bench;
+
+/*
+ * The shapes are taken from the layers which dominate the inference time of
+ * common models, batch size 1 unless noted. Names are stable since they are
+ * the keys of the baseline.
+ */
+
+namespace {
+
+TensorLayout f32(const TensorShape& shape) {
+    return {shape, dtype::Float32()};
+}
+
+void conv_bias(
+        Context& ctx, const std::string& name, size_t ic, size_t ih, size_t iw,
+        size_t oc, size_t kernel, size_t stride, size_t group = 1,
+        bool quantized = false) {
+    using Param = ConvBias::Param;
+    Param param;
+    param.nonlineMode = Param::NonlineMode::RELU;
+    param.pad_h = param.pad_w = kernel / 2;
+    param.stride_h = param.stride_w = stride;
+    TensorShape filter{oc, ic, kernel, kernel};
+    if (group > 1) {
+        param.sparse = Param::Sparse::GROUP;
+        filter = {group, oc / group, ic / group, kernel, kernel};
+    }
+    size_t oh = (ih + kernel / 2 * 2 - kernel) / stride + 1,
+           ow = (iw + kernel / 2 * 2 - kernel) / stride + 1;
+
+    DType src_dtype = dtype::Float32(), bias_dtype = dtype::Float32(),
+          dst_dtype = dtype::Float32();
+    if (quantized) {
+        src_dtype = dtype::QuantizedS8(2.5f);
+        bias_dtype = dtype::QuantizedS32(6.25f);
+        dst_dtype = dtype::QuantizedS8(60.25f);
+    }
+    static UniformIntRNG int_rng{-50, 50};
+    std::map<size_t, RNG*> rngs;
+    if (quantized) {
+        rngs = {{0, &int_rng}, {1, &int_rng}, {2, &int_rng}};
+    }
+    ctx.bench_algos<ConvBias>(
+            "conv_bias/" + name,
+            {{{1, ic, ih, iw}, src_dtype},
+             {filter, src_dtype},
+             {{1, oc, 1, 1}, bias_dtype},
+             {{}, dst_dtype},
+             {{1, oc, oh, ow}, dst_dtype}},
+            param, rngs);
+}
+
+void run_conv_bias(Context& ctx) {
+    // resnet50
+    conv_bias(ctx, "resnet50_conv1", 3, 224, 224, 64, 7, 2);
+    conv_bias(ctx, "resnet50_res2_1x1", 64, 56, 56, 256, 1, 1);
+    conv_bias(ctx, "resnet50_res2_3x3", 64, 56, 56, 64, 3, 1);
+    conv_bias(ctx, "resnet50_res3_3x3_s2", 128, 56, 56, 128, 3, 2);
+    conv_bias(ctx, "resnet50_res4_3x3", 256, 14, 14, 256, 3, 1);
+    conv_bias(ctx, "resnet50_res5_1x1", 2048, 7, 7, 512, 1, 1);
+    // mobilenet v2
+    conv_bias(ctx, "mobilenetv2_dw_3x3", 144, 56, 56, 144, 3, 1, 144);
+    conv_bias(ctx, "mobilenetv2_dw_3x3_s2", 96, 112, 112, 96, 3, 2, 96);
+    conv_bias(ctx, "mobilenetv2_pw_expand", 24, 56, 56, 144, 1, 1);
+    conv_bias(ctx, "mobilenetv2_pw_project", 144, 56, 56, 24, 1, 1);
+    // shufflenet v2
+    conv_bias(ctx, "shufflenetv2_pw", 58, 28, 28, 58, 1, 1);
+    conv_bias(ctx, "shufflenetv2_dw_3x3", 116, 14, 14, 116, 3, 1, 116);
+    // quantized resnet
+    conv_bias(ctx, "resnet50_res2_3x3_int8", 64, 56, 56, 64, 3, 1, 1, true);
+    conv_bias(ctx, "resnet50_res4_1x1_int8", 1024, 14, 14, 256, 1, 1, 1, true);
+}
+
+void matrix_mul(
+        Context& ctx, const std::string& name, size_t m, size_t k, size_t n,
+        bool int8 = false) {
+    DType src_dtype = dtype::Float32(), dst_dtype = dtype::Float32();
+    std::map<size_t, RNG*> rngs;
+    static UniformIntRNG int_rng{-127, 127};
+    if (int8) {
+        src_dtype = dtype::Int8();
+        dst_dtype = dtype::Int32();
+        rngs = {{0, &int_rng}, {1, &int_rng}};
+    }
+    ctx.bench_algos<MatrixMul>(
+            "matrix_mul/" + name,
+            {{{m, k}, src_dtype}, {{k, n}, src_dtype}, {{m, n}, dst_dtype}}, {}, rngs);
+}
+
+void run_matrix_mul(Context& ctx) {
+    // fully connected of classification models
+    matrix_mul(ctx, "resnet50_fc", 1, 2048, 1000);
+    matrix_mul(ctx, "fc_batch32", 32, 2048, 1000);
+    // bert-base with sequence length 128
+    matrix_mul(ctx, "bert_qkv", 128, 768, 768);
+    matrix_mul(ctx, "bert_ffn_up", 128, 768, 3072);
+    matrix_mul(ctx, "bert_ffn_down", 128, 3072, 768);
+    matrix_mul(ctx, "bert_qkv_int8", 128, 768, 768, true);
+    // square
+    matrix_mul(ctx, "square_256", 256, 256, 256);
+    matrix_mul(ctx, "square_1024", 1024, 1024, 1024);
+}
+
+void run_elemwise(Context& ctx) {
+    using Mode = Elemwise::Param::Mode;
+    auto run = [&](const std::string& name, Mode mode, const TensorShapeArray& inps) {
+        TensorLayoutArray layouts;
+        TensorShapeArray shapes = inps;
+        for (auto&& i : inps) {
+            layouts.push_back(f32(i));
+        }
+        TensorShape dst;
+        Elemwise::deduce_shape(shapes, dst);
+        layouts.push_back(f32(dst));
+        ctx.bench<Elemwise>("elemwise/" + name, layouts, {mode});
+    };
+    TensorShape feat{1, 256, 56, 56}, chan{1, 256, 1, 1};
+    run("add", Mode::ADD, {feat, feat});
+    run("add_bias", Mode::ADD, {feat, chan});
+    run("mul_scale", Mode::MUL, {feat, chan});
+    run("relu", Mode::RELU, {feat});
+    run("h_swish", Mode::H_SWISH, {{1, 96, 56, 56}});
+    run("sigmoid", Mode::SIGMOID, {{1, 1024, 14, 14}});
+    run("exp", Mode::EXP, {{1, 12, 128, 128}});
+    run("fuse_mul_add3", Mode::FUSE_MUL_ADD3, {feat, chan, chan});
+}
+
+void run_reduce(Context& ctx) {
+    using Mode = Reduce::Param::Mode;
+    auto run = [&](const std::string& name, Mode mode, const TensorShape& src,
+                   size_t axis) {
+        TensorShape dst = src;
+        dst[axis] = 1;
+        ctx.bench<Reduce>(
+                "reduce/" + name, {f32(src), f32(dst)},
+                {mode, static_cast<int32_t>(axis)});
+    };
+    run("global_mean", Mode::MEAN, {1, 2048, 49}, 2);
+    run("channel_sum", Mode::SUM, {1, 256, 3136}, 1);
+    run("softmax_max", Mode::MAX, {12, 128, 128}, 2);
+    run("batch_sum", Mode::SUM, {64, 1000}, 1);
+}
+
+void run_pooling(Context& ctx) {
+    using Param = Pooling::Param;
+    auto run = [&](const std::string& name, Param::Mode mode, const TensorShape& src,
+                   size_t window, size_t stride, size_t pad) {
+        Param param{mode, pad, pad, stride, stride, window, window};
+        size_t oh = (src[2] + pad * 2 - window) / stride + 1,
+               ow = (src[3] + pad * 2 - window) / stride + 1;
+        ctx.bench<Pooling>(
+                "pooling/" + name, {f32(src), f32({src[0], src[1], oh, ow})}, param);
+    };
+    run("resnet50_max_3x3_s2", Param::Mode::MAX, {1, 64, 112, 112}, 3, 2, 1);
+    run("max_2x2_s2", Param::Mode::MAX, {1, 128, 56, 56}, 2, 2, 0);
+    run("resnet50_global_avg", Param::Mode::AVERAGE, {1, 2048, 7, 7}, 7, 1, 0);
+}
+
+void run_relayout(Context& ctx) {
+    auto run = [&](const std::string& name, const TensorShape& shape,
+                   const std::vector<size_t>& dimshuffle) {
+        auto src = f32(shape).dimshuffle(dimshuffle);
+        ctx.bench<Relayout>("relayout/" + name, {src, f32(src)});
+    };
+    run("nchw_to_nhwc", {1, 64, 56, 56}, {0, 2, 3, 1});
+    run("nhwc_to_nchw", {1, 56, 56, 64}, {0, 3, 1, 2});
+    run("shufflenetv2_channel_shuffle", {1, 2, 58, 28, 28}, {0, 2, 1, 3, 4});
+    run("transpose_1024", {1024, 1024}, {1, 0});
+}
+
+void run_resize(Context& ctx) {
+    using Param = Resize::Param;
+    auto run = [&](const std::string& name, Param::InterpolationMode imode,
+                   const TensorShape& src, size_t oh, size_t ow) {
+        ctx.bench<Resize>(
+                "resize/" + name, {f32(src), f32({src[0], src[1], oh, ow})},
+                {imode, Param::Format::NCHW});
+    };
+    run("linear_480x640_to_224", Param::InterpolationMode::LINEAR, {1, 3, 480, 640},
+        224, 224);
+    run("nearest_upsample_2x", Param::InterpolationMode::NEAREST, {1, 64, 56, 56},
+        112, 112);
+    run("linear_upsample_2x", Param::InterpolationMode::LINEAR, {1, 64, 56, 56}, 112,
+        112);
+}
+
+void run_warp(Context& ctx) {
+    static WarpPerspectiveMatRNG mat_rng;
+    auto run = [&](const std::string& name, const TensorShape& src, size_t oh,
+                   size_t ow) {
+        size_t n = src[0];
+        ctx.bench<WarpPerspective>(
+                "warp_perspective/" + name,
+                {f32(src), f32({n, 3, 3}), f32({n, src[1], oh, ow})}, {},
+                {{1, &mat_rng}});
+    };
+    run("crop_480x640_to_224", {1, 3, 480, 640}, 224, 224);
+    run("align_batch8_112", {8, 3, 112, 112}, 112, 112);
+}
+
+}  // namespace
+
+void kern_bench::run_corpus(Context& ctx) {
+    run_conv_bias(ctx);
+    run_matrix_mul(ctx);
+    run_elemwise(ctx);
+    run_reduce(ctx);
+    run_pooling(ctx);
+    run_relayout(ctx);
+    run_resize(ctx);
+    run_warp(ctx);
+}
+
+// vim: syntax=cpp.doxygen
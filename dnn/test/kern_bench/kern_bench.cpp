@@ -0,0 +1,97 @@
+/**
+ * \file dnn/test/kern_bench/kern_bench.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+#include "test/kern_bench/kern_bench.h"
+
+#include <algorithm>
+#include <cstdio>
+#if MEGDNN_X86
+#include "src/x86/utils.h"
+#endif
+
+using namespace megdnn;
+using namespace test;
+using namespace kern_bench;
+
+std::string Result::key() const {
+    return name + "|" + isa + "|" + std::to_string(nr_thread) + "|" + algo;
+}
+
+Context::Context(const Options& opt, std::string isa, size_t nr_thread)
+        : m_opt{opt},
+          m_isa{std::move(isa)},
+          m_nr_thread{nr_thread},
+          m_filter{opt.filter} {
+    TaskExecutorConfig config;
+    config.nr_thread = nr_thread;
+    m_handle = create_cpu_handle(0, true, &config);
+}
+
+bool Context::match(const std::string& name) {
+    if (!m_opt.filter.empty() && !std::regex_search(name, m_filter))
+        return false;
+    if (m_opt.list_only) {
+        printf("%s\n", name.c_str());
+        return false;
+    }
+    return true;
+}
+
+void Context::add_result(
+        const std::string& name, const TensorLayoutArray& layouts,
+        const std::string& algo, const std::string& impl,
+        std::vector<double> times) {
+    megdnn_assert(!times.empty());
+    std::sort(times.begin(), times.end());
+    Result ret;
+    ret.name = name;
+    for (auto&& i : layouts) {
+        if (!ret.shapes.empty())
+            ret.shapes += ",";
+        ret.shapes += i.to_string();
+    }
+    ret.isa = m_isa;
+    ret.algo = algo;
+    ret.impl = impl;
+    ret.nr_thread = m_nr_thread;
+    ret.time_ms = times[times.size() / 2];
+    ret.min_ms = times.front();
+    ret.max_ms = times.back();
+    printf("%-40s isa=%-6s threads=%-2zu %10.4fms (min %.4fms) %s\n", name.c_str(),
+           m_isa.c_str(), m_nr_thread, ret.time_ms, ret.min_ms,
+           impl.empty() ? algo.c_str() : impl.c_str());
+    fflush(stdout);
+    m_results.emplace_back(std::move(ret));
+}
+
+bool kern_bench::set_isa(const std::string& isa) {
+#if MEGDNN_X86
+    using x86::SIMDType;
+    //! the first SIMD type disabled for each level
+    static const std::pair<const char*, SIMDType> levels[] = {
+            {"sse4_2", SIMDType::AVX},
+            {"avx", SIMDType::AVX2},
+            {"avx2", SIMDType::VNNI},
+            {"native", SIMDType::__NR_SIMD_TYPE},
+    };
+    for (auto&& i : levels) {
+        if (isa == i.first) {
+            x86::disable_simd_type(i.second);
+            return true;
+        }
+    }
+    return false;
+#else
+    return isa == "native";
+#endif
+}
+
+// vim: syntax=cpp.doxygen
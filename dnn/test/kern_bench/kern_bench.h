@@ -0,0 +1,183 @@
+/**
+ * \file dnn/test/kern_bench/kern_bench.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+#pragma once
+
+#include <map>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+#include "megdnn/oprs.h"
+#include "test/common/benchmarker.h"
+#include "test/common/opr_algo_proxy.h"
+#include "test/common/utils.h"
+
+namespace megdnn {
+namespace test {
+namespace kern_bench {
+
+struct Options {
+    //! regex of case names to run, empty for all
+    std::string filter;
+    //! regex of algorithms to sweep for oprs with algorithms; empty to only
+    //! run the heuristic choice
+    std::string algo;
+    std::vector<size_t> threads{1};
+    //! highest SIMD level allowed for each sweep, see set_isa()
+    std::vector<std::string> isa{"native"};
+    //! seconds of running for one measurement
+    float min_secs = 0.1f;
+    //! number of measurements of each case, whose median is reported
+    size_t repeat = 5;
+    bool list_only = false;
+};
+
+struct Result {
+    //! algo is "heuristic", "default" for oprs without algorithms, or the
+    //! name of the algorithm; impl is the name of the heuristic choice
+    std::string name, shapes, isa, algo, impl;
+    size_t nr_thread = 1;
+    //! median, min and max time per run over the measurements, in ms
+    double time_ms = 0, min_ms = 0, max_ms = 0;
+
+    //! the key to match results of a baseline
+    std::string key() const;
+};
+
+/*!
+ * \brief run cases of the corpus on a cpu handle with given number of threads
+ *
+ * A case is measured only if its name matches Options::filter.
+ */
+class Context {
+public:
+    Context(const Options& opt, std::string isa, size_t nr_thread);
+
+    const Options& options() const { return m_opt; }
+    std::vector<Result>& results() { return m_results; }
+
+    //! benchmark an opr which has no algorithms
+    template <typename Opr>
+    void bench(
+            const std::string& name, const TensorLayoutArray& layouts,
+            const typename Opr::Param& param = {},
+            const std::map<size_t, RNG*>& rngs = {}) {
+        if (!match(name))
+            return;
+        Benchmarker<Opr> benchmarker(m_handle.get());
+        setup(benchmarker, param, rngs);
+        measure(benchmarker, name, layouts, "default", "");
+    }
+
+    /*!
+     * \brief benchmark an opr with algorithms
+     *
+     * The heuristic choice is always measured, and each algorithm matching
+     * Options::algo is measured on its own.
+     */
+    template <typename Opr>
+    void bench_algos(
+            const std::string& name, const TensorLayoutArray& layouts,
+            const typename Opr::Param& param = {},
+            const std::map<size_t, RNG*>& rngs = {}) {
+        if (!match(name))
+            return;
+        Benchmarker<Opr> benchmarker(m_handle.get());
+        setup(benchmarker, param, rngs);
+        auto opr = benchmarker.opr();
+        opr->param() = param;
+        auto heuristic = OprAlgoProxy<Opr>::get_algorithm_info_heuristic(opr, layouts);
+        measure(benchmarker, name, layouts, "heuristic", heuristic.desc.name);
+        if (m_opt.algo.empty())
+            return;
+        std::regex algo_regex{m_opt.algo};
+        for (auto&& i : OprAlgoProxy<Opr>::get_all_algorithms_info_safe(opr, layouts)) {
+            if (!std::regex_search(i.desc.name, algo_regex))
+                continue;
+            opr->execution_policy().algo = i.desc;
+            measure(benchmarker, name, layouts, i.desc.name, i.desc.name);
+        }
+        opr->execution_policy() = {};
+    }
+
+private:
+    bool match(const std::string& name);
+
+    template <typename Opr>
+    void setup(
+            Benchmarker<Opr>& benchmarker, const typename Opr::Param& param,
+            const std::map<size_t, RNG*>& rngs) {
+        benchmarker.set_display(false)
+                .set_param(param)
+                .set_adaptive_benchmark(m_opt.min_secs);
+        for (auto&& i : rngs) {
+            benchmarker.set_rng(i.first, i.second);
+        }
+    }
+
+    template <typename Opr>
+    void measure(
+            Benchmarker<Opr>& benchmarker, const std::string& name,
+            const TensorLayoutArray& layouts, const std::string& algo,
+            const std::string& impl) {
+        std::vector<double> times;
+        for (size_t i = 0; i < m_opt.repeat; ++i) {
+            times.push_back(benchmarker.execl(layouts));
+        }
+        add_result(name, layouts, algo, impl, times);
+    }
+
+    void add_result(
+            const std::string& name, const TensorLayoutArray& layouts,
+            const std::string& algo, const std::string& impl,
+            std::vector<double> times);
+
+    const Options& m_opt;
+    std::string m_isa;
+    size_t m_nr_thread;
+    std::unique_ptr<Handle> m_handle;
+    std::regex m_filter;
+    std::vector<Result> m_results;
+};
+
+/*!
+ * \brief limit the SIMD instructions used by the kernels
+ *
+ * Valid levels are "native" and, on x86, "sse4_2", "avx" and "avx2".
+ *
+ * \return whether the level is supported on this platform
+ */
+bool set_isa(const std::string& isa);
+
+//! run all cases of the shape corpus
+void run_corpus(Context& ctx);
+
+//! write the results to a JSON file
+void write_json(const std::string& path, const std::vector<Result>& results);
+
+/*!
+ * \brief compare the results with the ones in a baseline JSON file
+ *
+ * A case is regressed if both its median and min time increase by more than
+ * threshold, which filters out most of the noise of a single measurement.
+ *
+ * \return number of regressed cases
+ */
+size_t diff_baseline(
+        const std::string& path, const std::vector<Result>& results,
+        double threshold);
+
+}  // namespace kern_bench
+}  // namespace test
+}  // namespace megdnn
+
+// vim: syntax=cpp.doxygen
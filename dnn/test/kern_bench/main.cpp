@@ -0,0 +1,134 @@
+/**
+ * \file dnn/test/kern_bench/main.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+
+/*!
+ * Benchmark of megdnn cpu kernels on a curated corpus of shapes, sweeping
+ * thread numbers, SIMD levels and algorithms. Results can be written to JSON
+ * and compared with a baseline, so that kernel regressions are found before
+ * they show up in the end-to-end latency.
+ */
+
+#include "test/kern_bench/kern_bench.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+using namespace megdnn;
+using namespace test;
+using namespace kern_bench;
+
+namespace {
+
+const char* usage = R"(usage: megdnn_kern_bench [options]
+  --filter=<regex>      only run cases whose names match the regex
+  --algo=<regex>        also run each algorithm matching the regex besides the
+                        heuristic choice, for conv_bias and matrix_mul
+  --threads=<n,...>     thread numbers to sweep, default 1
+  --isa=<level,...>     SIMD levels to sweep: native, and sse4_2, avx, avx2 on
+                        x86; default native
+  --min_time=<secs>     running time of one measurement, default 0.1
+  --repeat=<n>          measurements of each case, default 5
+  --output=<path>       write the results to a JSON file
+  --baseline=<path>     compare the results with a JSON file written by
+                        --output, exit with 1 on regressions
+  --threshold=<ratio>   relative slowdown reported as regression, default 0.05
+  --list                list names of the cases
+)";
+
+std::vector<std::string> split(const std::string& str) {
+    std::vector<std::string> ret;
+    std::stringstream ss(str);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty())
+            ret.push_back(item);
+    }
+    return ret;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    std::string output, baseline;
+    double threshold = 0.05;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto sep = arg.find('=');
+        auto key = arg.substr(0, sep),
+             value = sep == std::string::npos ? "" : arg.substr(sep + 1);
+        if (key == "--filter") {
+            opt.filter = value;
+        } else if (key == "--algo") {
+            opt.algo = value;
+        } else if (key == "--threads") {
+            opt.threads.clear();
+            for (auto&& t : split(value)) {
+                opt.threads.push_back(std::stoul(t));
+            }
+        } else if (key == "--isa") {
+            opt.isa = split(value);
+        } else if (key == "--min_time") {
+            opt.min_secs = std::stof(value);
+        } else if (key == "--repeat") {
+            opt.repeat = std::stoul(value);
+        } else if (key == "--output") {
+            output = value;
+        } else if (key == "--baseline") {
+            baseline = value;
+        } else if (key == "--threshold") {
+            threshold = std::stod(value);
+        } else if (key == "--list") {
+            opt.list_only = true;
+        } else {
+            fprintf(stderr, "unknown option: %s\n%s", argv[i], usage);
+            return 2;
+        }
+    }
+    if (opt.threads.empty() || opt.isa.empty() || !opt.repeat) {
+        fprintf(stderr, "%s", usage);
+        return 2;
+    }
+
+    if (opt.list_only) {
+        Context ctx{opt, "native", 1};
+        run_corpus(ctx);
+        return 0;
+    }
+
+    std::vector<Result> results;
+    for (auto&& isa : opt.isa) {
+        if (!set_isa(isa)) {
+            fprintf(stderr, "isa level %s is not supported, skipped\n", isa.c_str());
+            continue;
+        }
+        for (auto nr_thread : opt.threads) {
+            Context ctx{opt, isa, nr_thread};
+            run_corpus(ctx);
+            results.insert(results.end(), ctx.results().begin(), ctx.results().end());
+        }
+    }
+    set_isa("native");
+
+    if (!output.empty()) {
+        write_json(output, results);
+        printf("results written to %s\n", output.c_str());
+    }
+    if (!baseline.empty() && diff_baseline(baseline, results, threshold)) {
+        return 1;
+    }
+    return 0;
+}
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,267 @@
+/**
+ * \file dnn/test/kern_bench/report.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+#include "test/kern_bench/kern_bench.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#if MEGDNN_X86
+#include "src/x86/utils.h"
+#endif
+
+using namespace megdnn;
+using namespace test;
+using namespace kern_bench;
+
+namespace {
+
+std::string escape(const std::string& str) {
+    std::string ret;
+    for (char c : str) {
+        if (c == '"' || c == '\\')
+            ret += '\\';
+        ret += c;
+    }
+    return ret;
+}
+
+/*!
+ * \brief reader of the JSON written by write_json
+ *
+ * Only the subset written by this tool is supported: objects, arrays, strings
+ * without unicode escapes, numbers and literals.
+ */
+class JsonReader {
+public:
+    explicit JsonReader(std::string text) : m_text{std::move(text)} {}
+
+    //! read the results array of the report
+    std::vector<Result> read_results() {
+        std::vector<Result> ret;
+        expect('{');
+        while (!consume('}')) {
+            auto key = read_string();
+            expect(':');
+            if (key != "results") {
+                skip_value();
+            } else {
+                expect('[');
+                while (!consume(']')) {
+                    ret.push_back(read_result());
+                    consume(',');
+                }
+            }
+            consume(',');
+        }
+        return ret;
+    }
+
+private:
+    Result read_result() {
+        Result ret;
+        expect('{');
+        while (!consume('}')) {
+            auto key = read_string();
+            expect(':');
+            if (key == "name") {
+                ret.name = read_string();
+            } else if (key == "shapes") {
+                ret.shapes = read_string();
+            } else if (key == "isa") {
+                ret.isa = read_string();
+            } else if (key == "algo") {
+                ret.algo = read_string();
+            } else if (key == "impl") {
+                ret.impl = read_string();
+            } else if (key == "threads") {
+                ret.nr_thread = read_number();
+            } else if (key == "time_ms") {
+                ret.time_ms = read_number();
+            } else if (key == "min_ms") {
+                ret.min_ms = read_number();
+            } else if (key == "max_ms") {
+                ret.max_ms = read_number();
+            } else {
+                skip_value();
+            }
+            consume(',');
+        }
+        return ret;
+    }
+
+    void skip_space() {
+        while (m_pos < m_text.size() && isspace(m_text[m_pos]))
+            ++m_pos;
+    }
+
+    char peek() {
+        skip_space();
+        megdnn_assert(m_pos < m_text.size(), "unexpected end of json");
+        return m_text[m_pos];
+    }
+
+    bool consume(char c) {
+        if (peek() == c) {
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        megdnn_assert(consume(c), "expect '%c' at %zu of json", c, m_pos);
+    }
+
+    std::string read_string() {
+        expect('"');
+        std::string ret;
+        while (m_pos < m_text.size() && m_text[m_pos] != '"') {
+            if (m_text[m_pos] == '\\')
+                ++m_pos;
+            ret += m_text[m_pos++];
+        }
+        expect('"');
+        return ret;
+    }
+
+    double read_number() {
+        skip_space();
+        char* end;
+        double ret = strtod(m_text.c_str() + m_pos, &end);
+        megdnn_assert(end != m_text.c_str() + m_pos, "expect number at %zu", m_pos);
+        m_pos = end - m_text.c_str();
+        return ret;
+    }
+
+    void skip_value() {
+        char c = peek();
+        if (c == '"') {
+            read_string();
+        } else if (c == '{' || c == '[') {
+            char close = c == '{' ? '}' : ']';
+            ++m_pos;
+            while (!consume(close)) {
+                if (c == '{') {
+                    read_string();
+                    expect(':');
+                }
+                skip_value();
+                consume(',');
+            }
+        } else if (isalpha(c)) {
+            while (m_pos < m_text.size() && isalpha(m_text[m_pos]))
+                ++m_pos;
+        } else {
+            read_number();
+        }
+    }
+
+    std::string m_text;
+    size_t m_pos = 0;
+};
+
+}  // anonymous namespace
+
+void kern_bench::write_json(const std::string& path, const std::vector<Result>& results) {
+    FILE* fout = fopen(path.c_str(), "w");
+    megdnn_assert(fout, "failed to open %s", path.c_str());
+    const char* arch = "unknown";
+#if MEGDNN_AARCH64
+    arch = "aarch64";
+#elif MEGDNN_ARMV7
+    arch = "armv7";
+#elif MEGDNN_X86_64
+    arch = "x86_64";
+#elif MEGDNN_X86
+    arch = "i386";
+#endif
+    fprintf(fout, "{\n\"env\": {\"arch\": \"%s\", \"nr_cpu\": %u", arch,
+            std::thread::hardware_concurrency());
+#if MEGDNN_X86
+    // is_supported() also honors the limit of set_isa(), so the level must
+    // have been reset to native
+    fprintf(fout, ", \"avx2\": %s, \"fma\": %s, \"vnni\": %s",
+            x86::is_supported(x86::SIMDType::AVX2) ? "true" : "false",
+            x86::is_supported(x86::SIMDType::FMA) ? "true" : "false",
+            x86::is_supported(x86::SIMDType::VNNI) ? "true" : "false");
+#endif
+    fprintf(fout, "},\n\"results\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        auto&& r = results[i];
+        fprintf(fout,
+                "{\"name\": \"%s\", \"shapes\": \"%s\", \"isa\": \"%s\", "
+                "\"threads\": %zu, \"algo\": \"%s\", \"impl\": \"%s\", "
+                "\"time_ms\": %.6f, \"min_ms\": %.6f, \"max_ms\": %.6f}%s\n",
+                escape(r.name).c_str(), escape(r.shapes).c_str(),
+                escape(r.isa).c_str(), r.nr_thread, escape(r.algo).c_str(),
+                escape(r.impl).c_str(), r.time_ms, r.min_ms, r.max_ms,
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(fout, "]\n}\n");
+    fclose(fout);
+}
+
+size_t kern_bench::diff_baseline(
+        const std::string& path, const std::vector<Result>& results,
+        double threshold) {
+    std::ifstream fin(path);
+    megdnn_assert(fin.good(), "failed to open %s", path.c_str());
+    std::stringstream text;
+    text << fin.rdbuf();
+    std::unordered_map<std::string, Result> baseline;
+    for (auto&& i : JsonReader{text.str()}.read_results()) {
+        baseline[i.key()] = i;
+    }
+
+    size_t nr_regressed = 0, nr_improved = 0, nr_missing = 0;
+    printf("\n=== diff with baseline %s, threshold %.1f%%\n", path.c_str(),
+           threshold * 100);
+    for (auto&& cur : results) {
+        auto iter = baseline.find(cur.key());
+        if (iter == baseline.end()) {
+            ++nr_missing;
+            continue;
+        }
+        auto&& base = iter->second;
+        if (base.shapes != cur.shapes) {
+            printf("%s: shapes changed, skipped\n", cur.key().c_str());
+            continue;
+        }
+        double ratio = cur.time_ms / base.time_ms - 1,
+               min_ratio = cur.min_ms / base.min_ms - 1;
+        const char* tag = nullptr;
+        if (ratio > threshold && min_ratio > threshold) {
+            tag = "REGRESSION";
+            ++nr_regressed;
+        } else if (ratio < -threshold && min_ratio < -threshold) {
+            tag = "improvement";
+            ++nr_improved;
+        }
+        if (tag) {
+            printf("%-11s %s: %.4fms -> %.4fms (%+.1f%%)\n", tag, cur.key().c_str(),
+                   base.time_ms, cur.time_ms, ratio * 100);
+            if (base.impl != cur.impl) {
+                printf("            heuristic changed: %s -> %s\n", base.impl.c_str(),
+                       cur.impl.c_str());
+            }
+        }
+    }
+    printf("%zu regressions, %zu improvements, %zu cases not in baseline\n",
+           nr_regressed, nr_improved, nr_missing);
+    return nr_regressed;
+}
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,80 @@
+/**
+ * \file dnn/test/x86/fused_attention.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#include "test/x86/fixture.h"
+
+#include "megdnn/oprs.h"
+#include "test/common/benchmarker.h"
+#include "test/common/checker.h"
+
+using namespace megdnn;
+using namespace test;
+
+TEST_F(X86, FUSED_ATTENTION) {
+    Checker<FusedAttention> checker(handle());
+    UniformFloatRNG rng(-2.f, 2.f);
+    checker.set_rng(0, &rng).set_rng(1, &rng).set_rng(2, &rng).set_rng(3, &rng);
+    FusedAttention::Param param;
+    param.scale = 0.125f;
+    for (size_t sq : {3, 16, 37})
+        for (size_t sk : {5, 64, 130}) {
+            param.has_mask = false;
+            checker.set_param(param).execs(
+                    {{4, sq, 64}, {4, sk, 64}, {4, sk, 64}, {}, {}});
+            param.has_mask = true;
+            checker.set_param(param).execs(
+                    {{4, sq, 32}, {4, sk, 32}, {4, sk, 48}, {4, sq, sk}, {}});
+        }
+}
+
+#if MEGDNN_WITH_BENCHMARK
+TEST_F(X86, BENCHMARK_FUSED_ATTENTION) {
+    constexpr size_t RUNS = 20;
+    Benchmarker<FusedAttention> bencher_fused(handle());
+    Benchmarker<BatchedMatrixMul> bencher_matmul(handle());
+    Benchmarker<Softmax> bencher_softmax(handle());
+    bencher_fused.set_times(RUNS).set_display(false);
+    bencher_matmul.set_times(RUNS).set_display(false);
+    bencher_softmax.set_times(RUNS).set_display(false);
+
+    auto run = [&](size_t N, size_t S, size_t D) {
+        FusedAttention::Param param;
+        param.scale = 1.f / std::sqrt(static_cast<float>(D));
+        float fused = bencher_fused.set_param(param).execs(
+                              {{N, S, D}, {N, S, D}, {N, S, D}, {}, {}}) /
+                      RUNS;
+
+        // the unfused graph: q * k^T, scale, softmax and probs * v
+        BatchedMatrixMul::Param matmul_param;
+        matmul_param.transposeB = true;
+        float qk = bencher_matmul.set_param(matmul_param)
+                           .execs({{N, S, D}, {N, S, D}, {}}) /
+                   RUNS;
+        matmul_param.transposeB = false;
+        float pv = bencher_matmul.set_param(matmul_param)
+                           .execs({{N, S, S}, {N, S, D}, {}}) /
+                   RUNS;
+        float softmax = bencher_softmax.execs({{N, S, S}, {}}) / RUNS;
+        float unfused = qk + softmax + pv;
+        float computation = 4.f * N * S * S * D * 1e-6;
+        printf("N=%zu S=%zu D=%zu: fused %.3fms %.2fGflops, unfused %.3fms "
+               "(qk %.3fms softmax %.3fms pv %.3fms, excluding scale) "
+               "%.2fGflops, speedup %.2f\n",
+               N, S, D, fused, computation / fused, unfused, qk, softmax, pv,
+               computation / unfused, unfused / fused);
+    };
+    for (size_t S : {64, 128, 256, 512, 1024})
+        for (size_t D : {64, 128}) {
+            run(12, S, D);
+        }
+}
+#endif
+
+// vim: syntax=cpp.doxygen
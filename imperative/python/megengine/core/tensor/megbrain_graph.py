@@ -289,6 +289,10 @@ def optimize_for_inference(dest_vars, **kwargs):
         inference_options.fuse_conv_bias_with_z = True
     if kwargs.pop("enable_fuse_preprocess", False):
         inference_options.fuse_preprocess = True
+    if kwargs.pop("enable_fuse_attention", False):
+        inference_options.fuse_attention = True
+    if kwargs.pop("enable_fuse_layer_norm_gelu", False):
+        inference_options.fuse_layer_norm_gelu = True
 
     if kwargs:
         raise ValueError("unknown options: %s" % list(kwargs))
@@ -337,6 +341,10 @@ def deserialize_infer_option(x: int) -> Dict[str, bool]:
         ret["enable_fuse_conv_bias_with_z"] = True
     if inference_options.fuse_preprocess:
         ret["enable_fuse_preprocess"] = True
+    if inference_options.fuse_attention:
+        ret["enable_fuse_attention"] = True
+    if inference_options.fuse_layer_norm_gelu:
+        ret["enable_fuse_layer_norm_gelu"] = True
 
     return ret
 
@@ -663,6 +663,10 @@ class trace:
           inference)
         * enable_fuse_preprocess: whether to fuse astype\pad_channel\dimshuffle and
           etc opr
+        * enable_fuse_attention: whether to fuse matmul + softmax + matmul of
+          the scaled dot-product attention into one opr for inference on cpu
+        * enable_fuse_layer_norm_gelu: whether to fuse layer norm and gelu
+          written in elementwise operators into the corresponding oprs
         """
         if not self._capture_as_const:
             raise ValueError(
@@ -295,6 +295,12 @@ void init_graph_rt(py::module m) {
                     .def_readwrite(
                             "fuse_preprocess",
                             &_OptimizeForInferenceOptions::fuse_preprocess)
+                    .def_readwrite(
+                            "fuse_attention",
+                            &_OptimizeForInferenceOptions::fuse_attention)
+                    .def_readwrite(
+                            "fuse_layer_norm_gelu",
+                            &_OptimizeForInferenceOptions::fuse_layer_norm_gelu)
                     .def_readwrite(
                             "layout_transform",
                             &_OptimizeForInferenceOptions::layout_transform);
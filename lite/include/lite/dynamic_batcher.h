@@ -0,0 +1,100 @@
+/**
+ * \file inlude/lite/dynamic_batcher.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include "network.h"
+#include "tensor.h"
+
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace lite {
+
+/*!
+ * \brief merge small requests to a network into batches
+ *
+ * Requests are collected until the number of samples reaches the largest
+ * batch size, or until the oldest request has waited for the timeout. The
+ * inputs of the collected requests are concatenated on dim 0 by
+ * TensorUtils::concat, and the batch is run by the plan with the smallest
+ * batch size that can hold it, padded with zeros. Each plan is a network
+ * sharing weights with the others, so it is compiled only once for its
+ * batch size.
+ *
+ * Each batch is run with new output buffers, and the outputs of a request
+ * are slices of them without copy. Callers may keep them as long as they
+ * want without blocking later batches.
+ *
+ * All inputs and outputs of the model must have the batch on dim 0.
+ */
+class LITE_API DynamicBatcher {
+public:
+    struct Options {
+        //! batch sizes of the plans
+        std::vector<size_t> batch_sizes = {1, 2, 4, 8};
+
+        //! max time in microseconds for the oldest request to wait for
+        //! more requests
+        size_t timeout_us = 2000;
+
+        //! run each plan on zero inputs at construction, so compiling is
+        //! not done while serving requests
+        bool warmup = true;
+    };
+
+    //! statistics of served requests
+    struct Stats {
+        size_t nr_request = 0;
+        size_t nr_batch = 0;
+        //! number of samples in all requests
+        size_t nr_sample = 0;
+        //! number of zero samples padded to fit the plans
+        size_t nr_padded = 0;
+    };
+
+    using Outputs = std::vector<std::shared_ptr<Tensor>>;
+
+    DynamicBatcher(
+            const std::string& model_path, const Options& options,
+            const Config& config = {}, const NetworkIO& network_io = {});
+
+    //! wait until all submitted requests are served
+    ~DynamicBatcher();
+
+    /*!
+     * \brief submit a request
+     * \param inputs input tensors in the order of the network inputs; all
+     *      of them must have the same size on dim 0, which is the number of
+     *      samples of the request
+     * \return outputs in the order of the network outputs
+     */
+    std::future<Outputs> submit(std::vector<std::shared_ptr<Tensor>> inputs);
+
+    //! submit a request and wait for its outputs
+    Outputs run(std::vector<std::shared_ptr<Tensor>> inputs) {
+        return submit(std::move(inputs)).get();
+    }
+
+    Stats stats() const;
+
+    //! get the network of the plan with given batch size
+    std::shared_ptr<Network> plan_network(size_t batch_size) const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+}  // namespace lite
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -124,6 +124,21 @@ LITE_API size_t get_device_count(LiteDeviceType device_type);
  */
 LITE_API void try_coalesce_all_free_memory();
 
+/*!
+ * \brief share CPU worker threads among all the multithread networks
+ *
+ * Networks set by Runtime::set_cpu_threads_number and loaded after this call
+ * run their kernels in nr_threads process-wide worker threads instead of
+ * creating their own ones. The workers are divided among the networks running
+ * at the same time by the weights set in Runtime::set_cpu_worker_weight.
+ *
+ * \param nr_threads number of the shared worker threads; 0 to make the
+ *      networks loaded later create their own worker threads again
+ * \param max_concurrency max number of kernels running in the shared workers
+ *      at the same time; 0 for no limit
+ */
+LITE_API void set_shared_cpu_worker_pool(size_t nr_threads, size_t max_concurrency = 0);
+
 /*!
  * \brief Set the loader to the lite
  * \param loader_path is the file path which store the cache
@@ -144,6 +159,12 @@ LITE_API void set_persistent_cache(
  */
 LITE_API void dump_persistent_cache(const std::string& cache_path);
 
+/*!
+ * \brief put the algo policy cache in memory into the PersistentCache in use,
+ * the data is in the same format as the file dumped by dump_persistent_cache
+ */
+LITE_API void merge_persistent_cache(const void* cache_data, size_t size);
+
 /*!
  * \brief Set the TensorRT engine cache path for serialized prebuilt ICudaEngine
  */
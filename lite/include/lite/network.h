@@ -277,6 +277,17 @@ public:
     //! enable profile the network, a file will be generated
     void enable_profile_performance(std::string profile_file_path);
 
+    /*!
+     * \brief enable the roofline analysis of operators, a JSON file will be
+     * generated after each forward
+     *
+     * The peak compute and bandwidth of the device are measured once by
+     * microbenchmarks, which takes about one second. Each operator is
+     * classified as compute-bound, memory-bound or overhead-bound by its
+     * measured kernel time and its computation and memory footprint.
+     */
+    void enable_profile_roofline(std::string roofline_file_path);
+
     //! get model extra info
     const std::string& get_model_extra_info();
 
@@ -313,11 +324,19 @@ public:
             std::shared_ptr<Network> dst_network, size_t nr_threads);
     static size_t get_cpu_threads_number(std::shared_ptr<Network> dst_network);
 
-    //! set threads affinity callback;
+    //! set threads affinity callback; if the network runs in the shared
+    //! worker pool set by set_shared_cpu_worker_pool, the callback binds all
+    //! the shared workers with id in [0, nr_shared_threads), and the threads
+    //! of the networks with id nr_shared_threads
     static void set_runtime_thread_affinity(
             std::shared_ptr<Network> network,
             const ThreadAffinityCallback& thread_affinity_callback);
 
+    //! set the weight of the network when dividing the shared worker pool
+    //! among the networks running at the same time, the default weight is 1;
+    //! it is shared by networks with the same device id and thread number
+    static void set_cpu_worker_weight(std::shared_ptr<Network> network, size_t weight);
+
     //! Set cpu default mode when device is CPU, in some low computation
     //! device or single core device, this mode will get good performace
     static void set_cpu_inplace_mode(std::shared_ptr<Network> dst_network);
@@ -343,6 +362,30 @@ public:
     static void set_network_algo_workspace_limit(
             std::shared_ptr<Network> dst_network, size_t workspace_limit);
 
+    /*!
+     * \brief set the budget in bytes of the memory used by running the
+     *      network, i.e. the memory of the vars and the workspaces, not
+     *      including the weights
+     *
+     * When the network is loaded, options that trade speed for memory are
+     * applied in order until the static memory plan for the input shapes in
+     * the model fits in the budget: algos with limited workspace, sublinear
+     * memory optimization that recomputes vars, and searching the static
+     * memory allocation algorithms. Once a later step fits, the remaining
+     * budget is given back to the algo workspace if it still fits. Loading
+     * fails if the budget can not be met. It should be called before the
+     * model is loaded.
+     *
+     * \note only the static memory plan is checked against the budget; the
+     *      memory allocated dynamically, e.g. for vars whose shapes are
+     *      unknown until running, is not, and may exceed it
+     */
+    static void set_memory_budget(std::shared_ptr<Network> network, size_t budget);
+
+    //! get the peak in bytes of the memory used by running the network in
+    //! all the forwards, only available after set_memory_budget
+    static size_t get_peak_memory_usage(std::shared_ptr<Network> network);
+
     //! set the network memroy allocator, the allocator is defined by user
     static void set_memory_allocator(
             std::shared_ptr<Network> dst_network,
@@ -0,0 +1,132 @@
+/**
+ * \file inlude/lite/network_pool.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include "network.h"
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lite {
+
+/*!
+ * \brief a pool of network instances loaded from one model, which can be
+ * used by concurrent callers
+ *
+ * The first instance loads the model and the others share its weights. An
+ * instance is leased to one caller at a time by acquire() or
+ * acquire_async(), and returned to the pool when the last copy of the
+ * leased shared_ptr is destroyed; the caller fills the input tensors of the
+ * leased network, runs forward() and wait(), and reads its outputs.
+ *
+ * When the device is CPU, each instance runs on its own comp node, and the
+ * CPU thread budget is divided between the instances, so the total number
+ * of threads used by concurrent requests does not exceed the budget.
+ */
+class LITE_API NetworkPool : public std::enable_shared_from_this<NetworkPool> {
+public:
+    using AcquireCallback = std::function<void(std::shared_ptr<Network>)>;
+
+    struct Options {
+        //! number of network instances
+        size_t nr_instance = 1;
+
+        //! total number of CPU threads used by all the instances; each
+        //! instance gets an equal share which is at least one. Zero means
+        //! not to change the thread setting of the instances.
+        size_t nr_total_threads = 0;
+    };
+
+    /*!
+     * \brief load a model and create the instances
+     * \param model_path the model to be loaded
+     * \param config config of the instances; on CPU instance i uses device
+     *      id config.device_id + i, and on other devices it uses stream i
+     */
+    static std::shared_ptr<NetworkPool> make(
+            const std::string& model_path, const Options& options,
+            const Config& config = {}, const NetworkIO& network_io = {});
+
+    ~NetworkPool();
+
+    /*!
+     * \brief lease an instance, waiting until one is available
+     */
+    std::shared_ptr<Network> acquire();
+
+    /*!
+     * \brief lease an instance if one is available without waiting
+     * \return the leased instance, or nullptr if all are in use
+     */
+    std::shared_ptr<Network> try_acquire();
+
+    /*!
+     * \brief lease an instance asynchronously
+     *
+     * The callback is called with the leased instance, either immediately on
+     * the caller thread, or on the thread that returns an instance to the
+     * pool. Callbacks are served in the order they are requested, and must
+     * not throw.
+     */
+    void acquire_async(AcquireCallback callback);
+
+    //! number of instances
+    size_t size() const { return m_instances.size(); }
+
+    //! number of CPU threads of an instance; always one on other devices
+    size_t nr_threads_per_instance(size_t idx) const { return m_nr_threads.at(idx); }
+
+    //! get an instance regardless of whether it is leased, e.g. to
+    //! configure it or to inspect its IO
+    std::shared_ptr<Network> instance(size_t idx) const { return m_instances.at(idx); }
+
+private:
+    NetworkPool() = default;
+
+    //! lock-free stack of idle instances
+    class FreeList {
+        //! tag in the high 32 bits to avoid ABA; (index + 1) in low 32 bits
+        std::atomic<uint64_t> m_head{0};
+        std::unique_ptr<std::atomic<uint32_t>[]> m_next;
+
+    public:
+        void init(size_t size);
+        void push(uint32_t idx);
+        //! return -1 if empty
+        int64_t pop();
+    };
+
+    std::vector<std::shared_ptr<Network>> m_instances;
+    std::vector<size_t> m_nr_threads;
+    FreeList m_free_list;
+
+    //! callbacks waiting for an instance; only accessed in the slow path
+    std::mutex m_pending_mtx;
+    std::deque<AcquireCallback> m_pending;
+    std::atomic<size_t> m_nr_pending{0};
+
+    //! wrap an instance into a lease which releases it on destruction
+    std::shared_ptr<Network> lease(size_t idx);
+
+    void release(size_t idx);
+
+    //! hand idle instances to pending callbacks
+    void serve_pending();
+};
+
+}  // namespace lite
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -0,0 +1,59 @@
+/**
+ * \file inlude/lite/pack_model.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include "macro.h"
+
+#include <string>
+#include <vector>
+
+namespace lite {
+
+/*!
+ * \brief pack a bare model with its json info and algo policy cache into one
+ * model file, which can be loaded by Network::load_model directly
+ *
+ * The info is parsed by the info parse method when the packed model is
+ * loaded, and the algo cache is merged into the PersistentCache in use, so
+ * the algos profiled before are chosen without profiling again. The model
+ * and the info are stored without encryption.
+ */
+class LITE_API ModelPacker {
+public:
+    /*!
+     * \param model_path path of the bare model
+     * \param model_name name of the model in the header, which must be the
+     *      same as the name in the info
+     */
+    ModelPacker(const std::string& model_path, const std::string& model_name);
+
+    //! set the json info and the method to parse it
+    void set_info(
+            const std::string& info, const std::string& parse_method = "LITE_default");
+
+    //! set the algo policy cache file dumped by dump_persistent_cache
+    void set_algo_cache(const std::string& cache_path);
+
+    //! write the packed model to the file
+    void pack(const std::string& packed_model_path) const;
+
+private:
+    std::string m_model_name;
+    std::vector<uint8_t> m_model;
+    std::string m_info;
+    std::string m_info_parse_method;
+    std::vector<uint8_t> m_algo_cache;
+};
+
+}  // namespace lite
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -38,6 +38,13 @@ LITE_API int LITE_get_device_count(LiteDeviceType device_type, size_t* count);
  */
 LITE_API int LITE_try_coalesce_all_free_memory();
 
+/*! \brief share CPU worker threads among all the multithread networks loaded
+ * later, see lite::set_shared_cpu_worker_pool
+ * \param[in] nr_threads number of the shared worker threads, 0 to disable
+ * \param[in] max_concurrency max number of concurrent kernels, 0 for no limit
+ */
+LITE_API int LITE_set_shared_cpu_worker_pool(size_t nr_threads, size_t max_concurrency);
+
 /**
  * \brief Model decryption function
  *
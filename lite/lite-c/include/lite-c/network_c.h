@@ -443,6 +443,22 @@ LITE_API int LITE_set_network_algo_fastrun_config(
 LITE_API int LITE_set_network_algo_workspace_limit(
         LiteNetwork network, size_t workspace_limit);
 
+/**
+ * \brief set the budget of the memory used by running the network, it should
+ * be called before the network loaded, see lite::Runtime::set_memory_budget
+ * \param[in] network The network not loaded
+ * \param[in] budget The memory budget in bytes
+ */
+LITE_API int LITE_set_memory_budget(LiteNetwork network, size_t budget);
+
+/**
+ * \brief get the peak of the memory used by running the network, only
+ * available after LITE_set_memory_budget
+ * \param[in] network The loaded network
+ * \param[out] peak The peak memory in bytes
+ */
+LITE_API int LITE_get_peak_memory_usage(LiteNetwork network, size_t* peak);
+
 /**
  * \brief set the network forward in async mode and set the async callback
  * function
@@ -547,6 +563,15 @@ LITE_API int LITE_share_runtime_memroy(
 LITE_API int LITE_enable_profile_performance(
         LiteNetwork network, const char* profile_json_file_path);
 
+/**
+ * \brief enable roofline analysis of the operators, a JSON format file will be
+ * generated
+ * \param[in] network The loaded model
+ * \param[in] roofline_json_file_path The roofline result file path
+ */
+LITE_API int LITE_enable_profile_roofline(
+        LiteNetwork network, const char* roofline_json_file_path);
+
 /**
  * \brief Dump input/output values of all internal variables to output file,
  * in text format
@@ -60,6 +60,12 @@ int LITE_try_coalesce_all_free_memory() {
     LITE_CAPI_END();
 }
 
+int LITE_set_shared_cpu_worker_pool(size_t nr_threads, size_t max_concurrency) {
+    LITE_CAPI_BEGIN();
+    lite::set_shared_cpu_worker_pool(nr_threads, max_concurrency);
+    LITE_CAPI_END();
+}
+
 int LITE_register_decryption_and_key(
         const char* decrypt_name, const LiteDecryptionFunc func,
         const uint8_t* key_data, size_t key_size) {
@@ -491,6 +491,15 @@ int LITE_enable_profile_performance(
     LITE_CAPI_END();
 }
 
+int LITE_enable_profile_roofline(
+        LiteNetwork network, const char* roofline_json_file_path) {
+    LITE_CAPI_BEGIN();
+    LITE_ASSERT(network, "The network pass to LITE api is null");
+    static_cast<lite::Network*>(network)->enable_profile_roofline(
+            roofline_json_file_path);
+    LITE_CAPI_END();
+}
+
 int LITE_is_cpu_inplace_mode(const LiteNetwork network, int* is_cpu_inplace_mode) {
     LITE_CAPI_BEGIN();
     LITE_ASSERT(network && is_cpu_inplace_mode, "The network pass to LITE api is null");
@@ -568,6 +577,24 @@ int LITE_set_network_algo_workspace_limit(LiteNetwork network, size_t workspace_
     LITE_CAPI_END();
 }
 
+int LITE_set_memory_budget(LiteNetwork network, size_t budget) {
+    LITE_CAPI_BEGIN();
+    LITE_ASSERT(network, "The network pass to LITE api is null");
+    std::shared_ptr<lite::Network> network_shared{
+            static_cast<lite::Network*>(network), [](void*) {}};
+    lite::Runtime::set_memory_budget(network_shared, budget);
+    LITE_CAPI_END();
+}
+
+int LITE_get_peak_memory_usage(LiteNetwork network, size_t* peak) {
+    LITE_CAPI_BEGIN();
+    LITE_ASSERT(network && peak, "The ptr pass to LITE api is null");
+    std::shared_ptr<lite::Network> network_shared{
+            static_cast<lite::Network*>(network), [](void*) {}};
+    *peak = lite::Runtime::get_peak_memory_usage(network_shared);
+    LITE_CAPI_END();
+}
+
 int LITE_set_runtime_thread_affinity(
         LiteNetwork network,
         const LiteThreadAffinityCallback thread_affinity_callback) {
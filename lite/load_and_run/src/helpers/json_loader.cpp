@@ -12,6 +12,8 @@
 
 #include "json_loader.h"
 
+#include <cstring>
+
 using namespace mgb;
 
 template <typename T>
@@ -74,6 +76,12 @@ std::string JsonLoader::Value::str() {
     return std::string();
 }
 
+bool JsonLoader::Value::boolean() {
+    mgb_assert(Type::BOOL == m_type);
+    auto t = safe_cast<JsonLoader::BoolValue>();
+    return t->value();
+}
+
 void JsonLoader::expect(char c) {
     mgb_assert(c == (*m_buf));
     m_buf++;
@@ -119,7 +127,7 @@ std::unique_ptr<JsonLoader::Value> JsonLoader::parse_object() {
             return ret;
         }
 
-        if (pObject->m_obj.find(pVal->str()) != pObject->m_obj.end()) {
+        if (pObject->m_obj.find(key->str()) != pObject->m_obj.end()) {
             m_state = State::KEY_NOT_UNIQUE;
             return ret;
         }
@@ -195,6 +203,38 @@ std::unique_ptr<JsonLoader::Value> JsonLoader::parse_string() {
         if (*p == '\"') {
             p++;
             break;
+        } else if (*p == '\0') {
+            m_state = State::BAD_TYPE;
+            break;
+        } else if (*p == '\\') {
+            //! unicode escapes are kept as they are
+            p++;
+            switch (*p) {
+                case 'b':
+                    pStr->m_value += '\b';
+                    break;
+                case 'f':
+                    pStr->m_value += '\f';
+                    break;
+                case 'n':
+                    pStr->m_value += '\n';
+                    break;
+                case 'r':
+                    pStr->m_value += '\r';
+                    break;
+                case 't':
+                    pStr->m_value += '\t';
+                    break;
+                case 'u':
+                    pStr->m_value += "\\u";
+                    break;
+                case '\0':
+                    m_state = State::BAD_TYPE;
+                    continue;
+                default:
+                    pStr->m_value += (*p);
+            }
+            p++;
         } else {
             pStr->m_value += (*p);
             p++;
@@ -247,6 +287,33 @@ std::unique_ptr<JsonLoader::Value> JsonLoader::parse_number() {
     return ret;
 }
 
+std::unique_ptr<JsonLoader::Value> JsonLoader::parse_literal() {
+    std::unique_ptr<JsonLoader::Value> ret;
+    auto match = [this](const char* literal) {
+        size_t len = strlen(literal);
+        if (strncmp(m_buf, literal, len)) {
+            return false;
+        }
+        m_buf += len;
+        return true;
+    };
+    auto make_bool = [](bool value) {
+        JsonLoader::BoolValue* pBool = new JsonLoader::BoolValue();
+        pBool->m_value = value;
+        return (JsonLoader::Value*)(pBool);
+    };
+    if (match("null")) {
+        ret.reset((JsonLoader::Value*)(new JsonLoader::NullValue()));
+    } else if (match("true")) {
+        ret.reset(make_bool(true));
+    } else if (match("false")) {
+        ret.reset(make_bool(false));
+    } else {
+        m_state = State::BAD_TYPE;
+    }
+    return ret;
+}
+
 std::unique_ptr<JsonLoader::Value> JsonLoader::parse_value() {
     switch (*m_buf) {
         case '[':
@@ -255,6 +322,10 @@ std::unique_ptr<JsonLoader::Value> JsonLoader::parse_value() {
             return parse_object();
         case '\"':
             return parse_string();
+        case 'n':
+        case 't':
+        case 'f':
+            return parse_literal();
         case '\0':
             m_state = State::BAD_TYPE;
             break;
@@ -30,7 +30,15 @@ public:
     // base class for different value format
     class Value {
     protected:
-        enum struct Type : uint8_t { UNKNOWN, NUMBER, STRING, OBJECT, ARRAY };
+        enum struct Type : uint8_t {
+            UNKNOWN,
+            NUMBER,
+            STRING,
+            OBJECT,
+            ARRAY,
+            BOOL,
+            NONE
+        };
         Type m_type;
 
     public:
@@ -51,6 +59,10 @@ public:
 
         bool is_str() { return Type::STRING == m_type; }
 
+        bool is_bool() { return Type::BOOL == m_type; }
+
+        bool is_null() { return Type::NONE == m_type; }
+
         std::unique_ptr<Value>& operator[](const std::string& key);
 
         std::unique_ptr<Value>& operator[](const size_t index);
@@ -64,6 +76,8 @@ public:
         double number();
 
         std::string str();
+
+        bool boolean();
     };
 
     void expect(char c);
@@ -78,6 +92,8 @@ public:
 
     std::unique_ptr<Value> parse_number();
 
+    std::unique_ptr<Value> parse_literal();
+
     std::unique_ptr<Value> parse_value();
 
     enum struct State : uint8_t {
@@ -117,6 +133,22 @@ public:
         friend std::unique_ptr<Value> JsonLoader::parse_string();
     };
 
+    class BoolValue final : public Value {
+        bool m_value;
+
+    public:
+        BoolValue() : Value(Type::BOOL) {}
+
+        bool value() { return m_value; }
+
+        friend std::unique_ptr<Value> JsonLoader::parse_literal();
+    };
+
+    class NullValue final : public Value {
+    public:
+        NullValue() : Value(Type::NONE) {}
+    };
+
     class ArrayValue final : public Value {
         megdnn::SmallVector<std::unique_ptr<Value>> m_obj;
 
@@ -0,0 +1,556 @@
+/**
+ * \file lite/load_and_run/src/helpers/report.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ */
+
+#include "report.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+#include "json_loader.h"
+#include "megbrain/utils/json.h"
+#include "megbrain/version.h"
+#include "megdnn/version.h"
+
+#if __linux__ || __unix__ || __APPLE__
+#include <sys/resource.h>
+#endif
+
+using namespace lar;
+using mgb::JsonLoader;
+
+namespace {
+
+struct Stat {
+    size_t nr = 0;
+    double mean = 0, stddev = 0, min = 0, median = 0, p90 = 0, p99 = 0, max = 0;
+};
+
+Stat get_stat(std::vector<double> values) {
+    Stat stat;
+    stat.nr = values.size();
+    if (values.empty()) {
+        return stat;
+    }
+    std::sort(values.begin(), values.end());
+    //! nearest-rank percentile
+    auto percentile = [&](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p / 100 * values.size()));
+        return values[std::max<size_t>(rank, 1) - 1];
+    };
+    double sum = 0, sqrsum = 0;
+    for (auto i : values) {
+        sum += i;
+        sqrsum += i * i;
+    }
+    stat.mean = sum / stat.nr;
+    if (stat.nr > 1) {
+        stat.stddev = std::sqrt(
+                std::max(sqrsum - sum * sum / stat.nr, 0.0) / (stat.nr - 1));
+    }
+    stat.min = values.front();
+    stat.max = values.back();
+    stat.median = percentile(50);
+    stat.p90 = percentile(90);
+    stat.p99 = percentile(99);
+    return stat;
+}
+
+/*!
+ * two-sided p-value of the Mann-Whitney U test, by the normal approximation
+ * with tie correction, which needs no assumption on the distribution of the
+ * timings
+ */
+double mann_whitney_p(const std::vector<double>& x, const std::vector<double>& y) {
+    double n1 = x.size(), n2 = y.size(), n = n1 + n2;
+    if (x.size() < 2 || y.size() < 2) {
+        return 1;
+    }
+    std::vector<std::pair<double, bool>> all;
+    for (auto i : x) {
+        all.emplace_back(i, true);
+    }
+    for (auto i : y) {
+        all.emplace_back(i, false);
+    }
+    std::sort(all.begin(), all.end());
+    double rank_sum = 0, tie = 0;
+    for (size_t i = 0; i < all.size();) {
+        size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first) {
+            ++j;
+        }
+        //! ranks of [i, j) are i + 1 ... j, take the average for ties
+        double rank = (i + 1 + j) / 2.0, nr_tie = j - i;
+        for (size_t k = i; k < j; ++k) {
+            if (all[k].second) {
+                rank_sum += rank;
+            }
+        }
+        tie += nr_tie * nr_tie * nr_tie - nr_tie;
+        i = j;
+    }
+    double u = rank_sum - n1 * (n1 + 1) / 2, mu = n1 * n2 / 2;
+    double sigma = std::sqrt(n1 * n2 / 12 * ((n + 1) - tie / (n * (n - 1))));
+    if (sigma == 0) {
+        return 1;
+    }
+    double z = std::max(std::abs(u - mu) - 0.5, 0.0) / sigma;
+    return std::erfc(z / std::sqrt(2.0));
+}
+
+std::string trim(const std::string& str) {
+    auto begin = str.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return {};
+    }
+    return str.substr(begin, str.find_last_not_of(" \t") - begin + 1);
+}
+
+void read_cpu_info(std::string& cpu_model, std::vector<std::string>& isa) {
+#if __linux__
+    std::ifstream fin("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(fin, line)) {
+        auto pos = line.find(':');
+        if (pos == std::string::npos) {
+            continue;
+        }
+        auto key = trim(line.substr(0, pos)), value = trim(line.substr(pos + 1));
+        if (cpu_model.empty() && (key == "model name" || key == "Hardware")) {
+            cpu_model = value;
+        } else if (isa.empty() && (key == "flags" || key == "Features")) {
+            std::stringstream flags(value);
+            std::string flag;
+            while (flags >> flag) {
+                isa.push_back(flag);
+            }
+        }
+    }
+#endif
+    if (cpu_model.empty()) {
+        cpu_model = "unknown";
+    }
+}
+
+size_t get_peak_rss_kb() {
+#if __linux__ || __unix__ || __APPLE__
+    struct rusage usage;
+    if (!getrusage(RUSAGE_SELF, &usage)) {
+#if __APPLE__
+        return usage.ru_maxrss / 1024;
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+#endif
+    return 0;
+}
+
+std::string version_str() {
+    auto v0 = mgb::get_version();
+    auto v1 = megdnn::get_version();
+    return mgb::ssprintf(
+            "MegBrain %d.%d.%d(%d) MegDNN %d.%d.%d", v0.major, v0.minor, v0.patch,
+            v0.is_dev, v1.major, v1.minor, v1.patch);
+}
+
+//! get the member of a json object, nullptr if not found
+JsonLoader::Value* find(JsonLoader::Value* obj, const std::string& key) {
+    if (!obj || !obj->is_object()) {
+        return nullptr;
+    }
+    auto&& members = obj->objects();
+    auto iter = members.find(key);
+    return iter == members.end() ? nullptr : iter->second.get();
+}
+
+double find_number(JsonLoader::Value* obj, const std::string& key) {
+    auto value = find(obj, key);
+    return value && value->is_number() ? value->number() : 0;
+}
+
+std::string csv_escape(const std::string& str) {
+    if (str.find_first_of(",\"\n") == std::string::npos) {
+        return str;
+    }
+    std::string ret = "\"";
+    for (auto c : str) {
+        if (c == '"') {
+            ret += '"';
+        }
+        ret += c;
+    }
+    return ret + "\"";
+}
+
+}  // namespace
+
+BenchReport::BenchReport(const std::string& model_path, size_t nr_thread)
+        : m_model_path{model_path}, m_nr_thread{nr_thread} {
+    auto argv = gflags::GetArgv();
+    m_command_line = argv ? argv : "";
+    read_cpu_info(m_cpu_model, m_isa);
+}
+
+BenchReport::Run& BenchReport::new_run() {
+    MGB_LOCK_GUARD(m_mtx);
+    m_runs.emplace_back();
+    return m_runs.back();
+}
+
+void BenchReport::load_profile(const std::string& profile_path) {
+    JsonLoader loader;
+    auto root = loader.load(profile_path.c_str());
+    mgb_assert(root, "failed to parse the profiling result %s", profile_path.c_str());
+    auto profiler = find(root.get(), "profiler");
+    auto oprs = find(find(root.get(), "graph_exec"), "operator");
+    if (!profiler || !oprs) {
+        mgb_log_warn(
+                "no operator found in the profiling result %s",
+                profile_path.c_str());
+        return;
+    }
+    auto device = find(profiler, "device"), host = find(profiler, "host");
+    //! the longest time among the comp nodes or threads executing the opr
+    auto get_ms = [](JsonLoader::Value* prof, const std::string& id,
+                     const char* begin) {
+        double ms = 0;
+        auto opr_prof = find(prof, id);
+        if (opr_prof) {
+            for (auto&& i : opr_prof->objects()) {
+                auto time = find_number(i.second.get(), "end") -
+                            find_number(i.second.get(), begin);
+                ms = std::max(ms, time * 1e3);
+            }
+        }
+        return ms;
+    };
+    m_oprs.clear();
+    for (auto&& i : oprs->objects()) {
+        Opr opr;
+        opr.id = i.first;
+        opr.device_ms = get_ms(device, i.first, "kern");
+        opr.host_ms = get_ms(host, i.first, "start");
+        if (opr.device_ms <= 0 && opr.host_ms <= 0) {
+            continue;
+        }
+        if (auto name = find(i.second.get(), "name")) {
+            opr.name = name->str();
+        }
+        if (auto type = find(i.second.get(), "type")) {
+            opr.type = type->str();
+        }
+        m_oprs.push_back(opr);
+    }
+    std::sort(m_oprs.begin(), m_oprs.end(), [](const Opr& a, const Opr& b) {
+        return std::make_pair(a.device_ms, a.host_ms) >
+               std::make_pair(b.device_ms, b.host_ms);
+    });
+}
+
+void BenchReport::write() {
+    m_peak_rss_kb = get_peak_rss_kb();
+    if (!FLAGS_report_json.empty()) {
+        write_json(FLAGS_report_json);
+        printf("benchmark report written to %s\n", FLAGS_report_json.c_str());
+    }
+    if (!FLAGS_report_csv.empty()) {
+        write_csv(FLAGS_report_csv);
+        printf("benchmark report written to %s\n", FLAGS_report_csv.c_str());
+    }
+}
+
+void BenchReport::write_json(const std::string& path) const {
+#if MGB_ENABLE_JSON
+    using namespace mgb::json;
+    auto numbers = [](const std::vector<double>& values) {
+        auto arr = Array::make();
+        for (auto i : values) {
+            arr->add(Number::make(i));
+        }
+        return arr;
+    };
+
+    auto isa = Array::make();
+    for (auto&& i : m_isa) {
+        isa->add(String::make(i));
+    }
+    auto env = Object::make(
+            {{"version", String::make(version_str())},
+             {"cpu_model", String::make(m_cpu_model)},
+             {"isa", isa},
+             {"nr_cpu", NumberInt::make(std::thread::hardware_concurrency())},
+             {"nr_thread", NumberInt::make(m_nr_thread)}});
+
+    auto runs = Array::make();
+    std::vector<double> all_times;
+    for (auto&& run : m_runs) {
+        auto testcases = Array::make();
+        for (auto&& testcase : run.testcases) {
+            std::vector<double> times, exec_times;
+            for (auto&& i : testcase) {
+                times.push_back(i.first);
+                exec_times.push_back(i.second);
+            }
+            all_times.insert(all_times.end(), times.begin(), times.end());
+            testcases->add(Object::make(
+                    {{"time_ms", numbers(times)}, {"exec_ms", numbers(exec_times)}}));
+        }
+        runs->add(Object::make(
+                {{"load_ms", Number::make(run.load_ms)},
+                 {"prepare_ms", Number::make(run.prepare_ms)},
+                 {"warmup_ms", numbers(run.warmup_ms)},
+                 {"testcases", testcases}}));
+    }
+
+    auto stat = get_stat(all_times);
+    auto summary = Object::make(
+            {{"nr_iter", NumberInt::make(stat.nr)},
+             {"mean_ms", Number::make(stat.mean)},
+             {"stddev_ms", Number::make(stat.stddev)},
+             {"min_ms", Number::make(stat.min)},
+             {"median_ms", Number::make(stat.median)},
+             {"p90_ms", Number::make(stat.p90)},
+             {"p99_ms", Number::make(stat.p99)},
+             {"max_ms", Number::make(stat.max)}});
+
+    auto oprs = Array::make();
+    for (auto&& i : m_oprs) {
+        oprs->add(Object::make(
+                {{"id", String::make(i.id)},
+                 {"name", String::make(i.name)},
+                 {"type", String::make(i.type)},
+                 {"device_ms", Number::make(i.device_ms)},
+                 {"host_ms", Number::make(i.host_ms)}}));
+    }
+
+    Object::make({{"model", String::make(m_model_path)},
+                  {"command_line", String::make(m_command_line)},
+                  {"env", env},
+                  {"runs", runs},
+                  {"summary", summary},
+                  {"memory",
+                   Object::make({{"peak_rss_kb", NumberInt::make(m_peak_rss_kb)}})},
+                  {"oprs", oprs}})
+            ->writeto_fpath(path);
+#else
+    mgb_assert(false, "JSON is disabled at compile time, use --report_csv instead.");
+#endif
+}
+
+void BenchReport::write_csv(const std::string& path) const {
+    FILE* fout = fopen(path.c_str(), "w");
+    mgb_assert(fout, "failed to open %s: %s", path.c_str(), strerror(errno));
+    auto row = [&](const std::string& section, const std::string& name,
+                   const std::string& value) {
+        fprintf(fout, "%s,%s,%s\n", section.c_str(), csv_escape(name).c_str(),
+                csv_escape(value).c_str());
+    };
+    auto number_row = [&](const std::string& section, const std::string& name,
+                          double value) {
+        row(section, name, mgb::ssprintf("%.6g", value));
+    };
+
+    fprintf(fout, "section,name,value\n");
+    std::string isa;
+    for (auto&& i : m_isa) {
+        isa += (isa.empty() ? "" : " ") + i;
+    }
+    row("env", "model", m_model_path);
+    row("env", "command_line", m_command_line);
+    row("env", "version", version_str());
+    row("env", "cpu_model", m_cpu_model);
+    row("env", "isa", isa);
+    number_row("env", "nr_cpu", std::thread::hardware_concurrency());
+    number_row("env", "nr_thread", m_nr_thread);
+
+    std::vector<double> all_times;
+    for (size_t i = 0; i < m_runs.size(); ++i) {
+        auto&& run = m_runs[i];
+        auto prefix = mgb::ssprintf("run%zu.", i);
+        number_row("run", prefix + "load_ms", run.load_ms);
+        number_row("run", prefix + "prepare_ms", run.prepare_ms);
+        for (size_t j = 0; j < run.warmup_ms.size(); ++j) {
+            number_row("warmup", prefix + mgb::ssprintf("iter%zu", j), run.warmup_ms[j]);
+        }
+        for (size_t j = 0; j < run.testcases.size(); ++j) {
+            auto&& testcase = run.testcases[j];
+            for (size_t k = 0; k < testcase.size(); ++k) {
+                auto name = prefix + mgb::ssprintf("case%zu.iter%zu.", j, k);
+                number_row("iter", name + "time_ms", testcase[k].first);
+                number_row("iter", name + "exec_ms", testcase[k].second);
+                all_times.push_back(testcase[k].first);
+            }
+        }
+    }
+
+    auto stat = get_stat(all_times);
+    number_row("summary", "nr_iter", stat.nr);
+    number_row("summary", "mean_ms", stat.mean);
+    number_row("summary", "stddev_ms", stat.stddev);
+    number_row("summary", "min_ms", stat.min);
+    number_row("summary", "median_ms", stat.median);
+    number_row("summary", "p90_ms", stat.p90);
+    number_row("summary", "p99_ms", stat.p99);
+    number_row("summary", "max_ms", stat.max);
+    number_row("memory", "peak_rss_kb", m_peak_rss_kb);
+    for (auto&& i : m_oprs) {
+        auto name = i.name + "(" + i.type + ")";
+        number_row("opr", name + ".device_ms", i.device_ms);
+        number_row("opr", name + ".host_ms", i.host_ms);
+    }
+    fclose(fout);
+}
+
+int BenchReport::compare(const std::string& base_path, const std::string& new_path) {
+    struct Report {
+        std::unique_ptr<JsonLoader::Value> root;
+        std::vector<double> times;
+        double load_ms = 0, prepare_ms = 0;
+        //! "name(type)" => device time, or host time if not on device
+        std::map<std::string, double> oprs;
+    };
+    auto load = [](const std::string& path) {
+        Report report;
+        JsonLoader loader;
+        report.root = loader.load(path.c_str());
+        auto runs = find(report.root.get(), "runs");
+        mgb_assert(
+                runs && runs->is_array(), "%s is not a load_and_run report",
+                path.c_str());
+        for (auto&& run : runs->array()) {
+            report.load_ms += find_number(run.get(), "load_ms") / runs->len();
+            report.prepare_ms += find_number(run.get(), "prepare_ms") / runs->len();
+            auto testcases = find(run.get(), "testcases");
+            if (!testcases) {
+                continue;
+            }
+            for (auto&& testcase : testcases->array()) {
+                auto times = find(testcase.get(), "time_ms");
+                if (!times) {
+                    continue;
+                }
+                for (auto&& i : times->array()) {
+                    report.times.push_back(i->number());
+                }
+            }
+        }
+        if (auto oprs = find(report.root.get(), "oprs")) {
+            for (auto&& i : oprs->array()) {
+                auto name = find(i.get(), "name"), type = find(i.get(), "type");
+                mgb_assert(
+                        name && name->is_str() && type && type->is_str(),
+                        "operator without name or type in %s", path.c_str());
+                auto key = name->str() + "(" + type->str() + ")";
+                auto ms = find_number(i.get(), "device_ms");
+                report.oprs[key] = ms > 0 ? ms : find_number(i.get(), "host_ms");
+            }
+        }
+        return report;
+    };
+    auto base = load(base_path), cur = load(new_path);
+    auto change = [](double base, double cur) {
+        return base > 0 ? (cur / base - 1) * 100 : 0;
+    };
+
+    auto base_env = find(base.root.get(), "env"), cur_env = find(cur.root.get(), "env");
+    for (auto key : {"cpu_model", "nr_thread"}) {
+        auto base_value = find(base_env, key), cur_value = find(cur_env, key);
+        bool same = base_value && cur_value &&
+                    (base_value->is_str() ? base_value->str() == cur_value->str()
+                                          : base_value->number() == cur_value->number());
+        if (!same) {
+            mgb_log_warn("%s differs between the reports, the comparison may be "
+                         "meaningless", key);
+        }
+    }
+
+    auto base_stat = get_stat(base.times), cur_stat = get_stat(cur.times);
+    printf("=== iteration time (ms)\n");
+    printf("%-6s %8s %10s %10s %10s %10s %10s\n", "", "nr_iter", "mean", "median",
+           "p90", "min", "max");
+    for (auto&& i : {std::make_pair("base", base_stat), std::make_pair("new", cur_stat)}) {
+        printf("%-6s %8zu %10.3f %10.3f %10.3f %10.3f %10.3f\n", i.first,
+               i.second.nr, i.second.mean, i.second.median, i.second.p90,
+               i.second.min, i.second.max);
+    }
+    if (base_stat.nr < 10 || cur_stat.nr < 10) {
+        mgb_log_warn("too few iterations to tell a significant change, use --iter");
+    }
+
+    double median_change = change(base_stat.median, cur_stat.median);
+    double p_value = mann_whitney_p(base.times, cur.times);
+    bool significant = p_value < FLAGS_compare_alpha &&
+                       std::abs(median_change) > FLAGS_compare_threshold * 100;
+    const char* verdict = !significant   ? "no significant change"
+                          : median_change > 0 ? "REGRESSION"
+                                              : "improvement";
+    printf("median: %+.2f%%, p-value: %.4g => %s\n\n", median_change, p_value,
+           verdict);
+
+    printf("load: %.3fms -> %.3fms (%+.2f%%)\n", base.load_ms, cur.load_ms,
+           change(base.load_ms, cur.load_ms));
+    printf("prepare: %.3fms -> %.3fms (%+.2f%%)\n", base.prepare_ms, cur.prepare_ms,
+           change(base.prepare_ms, cur.prepare_ms));
+    auto base_rss = find_number(find(base.root.get(), "memory"), "peak_rss_kb"),
+         cur_rss = find_number(find(cur.root.get(), "memory"), "peak_rss_kb");
+    printf("peak rss: %.0fKB -> %.0fKB (%+.2f%%)\n", base_rss, cur_rss,
+           change(base_rss, cur_rss));
+
+    //! the profiling result has a single run, so only large changes are shown
+    std::vector<std::pair<double, std::string>> opr_changes;
+    for (auto&& i : cur.oprs) {
+        auto iter = base.oprs.find(i.first);
+        if (iter == base.oprs.end()) {
+            continue;
+        }
+        if (std::abs(change(iter->second, i.second)) > FLAGS_compare_threshold * 100) {
+            opr_changes.emplace_back(i.second - iter->second, i.first);
+        }
+    }
+    if (!opr_changes.empty()) {
+        std::sort(
+                opr_changes.begin(), opr_changes.end(),
+                [](const std::pair<double, std::string>& a,
+                   const std::pair<double, std::string>& b) {
+                    return std::abs(a.first) > std::abs(b.first);
+                });
+        constexpr size_t MAX_OPR_SHOWN = 20;
+        printf("\n=== operators changed over %.2f%% (ms)\n",
+               FLAGS_compare_threshold * 100);
+        for (size_t i = 0; i < std::min(opr_changes.size(), MAX_OPR_SHOWN); ++i) {
+            auto&& name = opr_changes[i].second;
+            printf("%10.3f -> %10.3f (%+.2f%%) %s\n", base.oprs[name],
+                   cur.oprs[name], change(base.oprs[name], cur.oprs[name]),
+                   name.c_str());
+        }
+    }
+    return significant && median_change > 0;
+}
+
+DEFINE_string(
+        report_json, "",
+        "write a benchmark report in JSON to the given file, including the time "
+        "of each iteration, per operator times if --profile is given, the peak "
+        "memory and the environment");
+DEFINE_string(
+        report_csv, "",
+        "write the benchmark report as --report_json does in CSV of "
+        "section,name,value");
+DEFINE_double(
+        compare_alpha, 0.05,
+        "significance level of `load_and_run compare <base> <new>`");
+DEFINE_double(
+        compare_threshold, 0.02,
+        "relative change of the median time under which `load_and_run "
+        "compare` takes no change");
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
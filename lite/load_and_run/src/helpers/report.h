@@ -0,0 +1,93 @@
+/**
+ * \file lite/load_and_run/src/helpers/report.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ */
+
+#pragma once
+#include <gflags/gflags.h>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+DECLARE_string(report_json);
+DECLARE_string(report_csv);
+DECLARE_double(compare_alpha);
+DECLARE_double(compare_threshold);
+
+namespace lar {
+
+/*!
+ * \brief machine readable benchmark report for --report_json and --report_csv
+ *
+ * The report holds the timings of every run of the model, per operator times
+ * from the profiling result, the peak memory and the environment. Two JSON
+ * reports can be compared by `load_and_run compare <base> <new>`.
+ */
+class BenchReport {
+public:
+    //! timings of one loaded model, which is only written by its own thread
+    struct Run {
+        double load_ms = 0;
+        //! time from model loaded to the first warm up, mainly graph compiling
+        double prepare_ms = 0;
+        std::vector<double> warmup_ms;
+        //! (time, exec time) of each iteration of each testcase
+        std::vector<std::vector<std::pair<double, double>>> testcases;
+    };
+
+    struct Opr {
+        std::string id, name, type;
+        //! kernel time on device and total time on host of the last run
+        double device_ms = 0, host_ms = 0;
+    };
+
+    static bool is_enabled() {
+        return !FLAGS_report_json.empty() || !FLAGS_report_csv.empty();
+    }
+
+    BenchReport(const std::string& model_path, size_t nr_thread);
+
+    //! add a run of the model, which is valid until the report is destroyed
+    Run& new_run();
+
+    //! get per operator times from the json file written by --profile
+    void load_profile(const std::string& profile_path);
+
+    //! write the report to the files given by the flags
+    void write();
+
+    /*!
+     * \brief compare two JSON reports and print the differences
+     *
+     * Iteration times are compared by the Mann-Whitney U test, and a change
+     * of the median over --compare_threshold with p-value under
+     * --compare_alpha is significant.
+     *
+     * \return 1 if the new report has a significant regression, otherwise 0
+     */
+    static int compare(const std::string& base_path, const std::string& new_path);
+
+private:
+    void write_json(const std::string& path) const;
+    void write_csv(const std::string& path) const;
+
+    std::string m_model_path;
+    size_t m_nr_thread;
+    std::string m_command_line;
+    std::string m_cpu_model;
+    std::vector<std::string> m_isa;
+    //! peak resident memory of the process, 0 if unknown
+    size_t m_peak_rss_kb = 0;
+
+    std::mutex m_mtx;
+    std::deque<Run> m_runs;
+    std::vector<Opr> m_oprs;
+};
+
+}  // namespace lar
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -9,10 +9,13 @@
 
 #include <gflags/gflags.h>
 #include <string>
+#include "helpers/report.h"
 #include "strategys/strategy.h"
 
 int main(int argc, char** argv) {
-    std::string usage = "load_and_run <model_path> [options...]";
+    std::string usage =
+            "load_and_run <model_path> [options...]\n"
+            "       load_and_run compare <base_report> <new_report> [options...]";
     if (argc < 2) {
         printf("usage: %s\n", usage.c_str());
         return -1;
@@ -20,6 +23,15 @@ int main(int argc, char** argv) {
     gflags::SetUsageMessage(usage);
     gflags::SetVersionString("1.0");
     gflags::ParseCommandLineFlags(&argc, &argv, true);
+    if (std::string(argv[1]) == "compare") {
+        if (argc != 4) {
+            printf("usage: %s\n", usage.c_str());
+            return -1;
+        }
+        int ret = lar::BenchReport::compare(argv[2], argv[3]);
+        gflags::ShutDownCommandLineFlags();
+        return ret;
+    }
     std::string model_path = argv[1];
     auto strategy = lar::StrategyBase::create_strategy(model_path);
     strategy->run();
@@ -24,7 +24,10 @@ ModelMdl::ModelMdl(const std::string& path) : model_path(path) {
 
 void ModelMdl::load_model() {
     //! read dump file
-    if (share_model_mem) {
+    if (mmap_model) {
+        mgb_log_warn("map model file into memory");
+        m_model_file = mgb::serialization::InputFile::make_mmap(model_path.c_str());
+    } else if (share_model_mem) {
         mgb_log_warn("enable share model memory");
         FILE* fin = fopen(model_path.c_str(), "rb");
         mgb_assert(fin, "failed to open %s: %s", model_path.c_str(), strerror(errno));
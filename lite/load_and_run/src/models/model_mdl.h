@@ -34,6 +34,9 @@ public:
 
     void set_shared_mem(bool state) override { share_model_mem = state; }
 
+    //! map the model file into memory instead of reading it
+    void set_mmap_model(bool state) { mmap_model = state; }
+
     void load_model() override;
 
     void make_output_spec();
@@ -109,6 +112,7 @@ public:
 
 private:
     bool share_model_mem;
+    bool mmap_model = false;
     std::string model_path;
     std::unique_ptr<mgb::serialization::InputFile> m_model_file;
     mgb::serialization::GraphLoadConfig m_load_config;
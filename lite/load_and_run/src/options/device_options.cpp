@@ -176,7 +176,7 @@ bool XPUDeviceOption::is_valid() {
 }
 
 std::shared_ptr<OptionBase> XPUDeviceOption::create_option() {
-    static std::shared_ptr<lar::XPUDeviceOption> option(new XPUDeviceOption);
+    std::shared_ptr<lar::XPUDeviceOption> option(new XPUDeviceOption);
     if (XPUDeviceOption::is_valid()) {
         return std::static_pointer_cast<lar::OptionBase>(option);
     } else {
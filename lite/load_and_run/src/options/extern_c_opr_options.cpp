@@ -191,7 +191,7 @@ bool COprLibOption::is_valid() {
 }
 
 std::shared_ptr<OptionBase> COprLibOption::create_option() {
-    static std::shared_ptr<COprLibOption> option(new COprLibOption);
+    std::shared_ptr<COprLibOption> option(new COprLibOption);
     if (COprLibOption::is_valid()) {
         return std::static_pointer_cast<OptionBase>(option);
     } else {
@@ -18,7 +18,9 @@
 #endif
 #include "fastrun_options.h"
 #include "megbrain/gopt/inference.h"
+#include "megbrain/opr/search_policy/algo_cost_model.h"
 #include "megbrain/utils/infile_persistent_cache.h"
+#include "megbrain/utils/mmap_persistent_cache.h"
 #include "misc.h"
 #include "models/model_lite.h"
 #include "models/model_mdl.h"
@@ -54,6 +56,10 @@ void FastRunOption::config_model_internel<ModelLite>(
         }
         auto lite_strategy = static_cast<Strategy>(strategy);
         model->set_lite_strategy(lite_strategy);
+        LITE_ASSERT(
+                !m_cache_mem_plan,
+                "lite model don't support --fast-run-cache-mem-plan");
+        setup_cost_model();
     } else if (runtime_param.stage == RunStage::AFTER_MODEL_LOAD) {
         auto&& lite_network = model->get_lite_network();
         auto&& lite_strategy = model->get_lite_strategy();
@@ -77,6 +83,7 @@ void FastRunOption::config_model_internel<ModelLite>(
         if (!m_fast_run_cache.empty()) {
             lite::dump_persistent_cache(m_fast_run_cache);
         }
+        dump_cost_model();
 #endif
     }
 }
@@ -120,13 +127,25 @@ void FastRunOption::config_model_internel<ModelMdl>(
                     .comp_graph->options()
                     .fast_run_config.shared_batch_size = share_batch_size;
         }
+        if (m_cache_mem_plan) {
+            //! static memory plans are saved in the algo cache file as well
+            mgb_log_warn("enable static memory plan cache");
+            model->get_mdl_config().comp_graph->options().cache_static_mem_plan =
+                    true;
+        }
+        setup_cost_model();
     } else if (runtime_param.stage == RunStage::AFTER_MODEL_LOAD) {
         auto& vars = model->get_mdl_load_result().output_var_list;
         auto&& strategy = model->get_mdl_strategy();
         mgb::gopt::modify_opr_algo_strategy_inplace(vars, strategy);
         // set algo cache path
         if (!m_fast_run_cache.empty()) {
-            if (!access(m_fast_run_cache.c_str(), F_OK)) {
+            if (m_fast_run_cache_mmap) {
+                //! entries are written to the file as soon as they are put
+                mgb::PersistentCache::set_impl(
+                        std::make_shared<mgb::MmapPersistentCache>(
+                                m_fast_run_cache.c_str()));
+            } else if (!access(m_fast_run_cache.c_str(), F_OK)) {
                 mgb::PersistentCache::set_impl(
                         std::make_shared<mgb::InFilePersistentCache>(
                                 m_fast_run_cache.c_str()));
@@ -142,14 +161,42 @@ void FastRunOption::config_model_internel<ModelMdl>(
     } else if (runtime_param.stage == RunStage::AFTER_MODEL_RUNNING) {
 #if MGB_ENABLE_FASTRUN
         //! dump algo cache
-        if (!m_fast_run_cache.empty()) {
+        if (!m_fast_run_cache.empty() && !m_fast_run_cache_mmap) {
             static_cast<mgb::InFilePersistentCache&>(mgb::PersistentCache::inst())
                     .dump_cache(m_fast_run_cache.c_str());
         }
+        dump_cost_model();
 #endif
     }
 }
 
+void FastRunOption::setup_cost_model() {
+    if (m_cost_model.empty())
+        return;
+    auto model = mgb::opr::AlgoCostModel::load(m_cost_model.c_str());
+    model->min_confidence(m_cost_model_confidence);
+    mgb_log("algo cost model: %zu samples loaded from %s", model->nr_sample(),
+            m_cost_model.c_str());
+    mgb::opr::AlgoCostModel::set_inst(model);
+}
+
+void FastRunOption::dump_cost_model() {
+    if (m_dump_cost_model.empty())
+        return;
+    //! samples are accumulated in the model file over the runs
+    std::shared_ptr<mgb::opr::AlgoCostModel> model;
+    if (!access(m_dump_cost_model.c_str(), F_OK)) {
+        model = mgb::opr::AlgoCostModel::load(m_dump_cost_model.c_str());
+    } else {
+        model = std::make_shared<mgb::opr::AlgoCostModel>();
+    }
+    model->add_from_cache(
+            static_cast<mgb::InFilePersistentCache&>(mgb::PersistentCache::inst()));
+    model->dump(m_dump_cost_model.c_str());
+    mgb_log("algo cost model with %zu samples dumped to %s", model->nr_sample(),
+            m_dump_cost_model.c_str());
+}
+
 }  // namespace lar
 
 using namespace lar;
@@ -163,7 +210,12 @@ FastRunOption::FastRunOption() {
     batch_binary_equal = FLAGS_binary_equal_between_batch;
     enable_reproducible = FLAGS_reproducible;
     m_fast_run_cache = FLAGS_fast_run_algo_policy;
+    m_fast_run_cache_mmap = FLAGS_fast_run_cache_mmap;
+    m_cache_mem_plan = FLAGS_fast_run_cache_mem_plan;
     share_batch_size = FLAGS_fast_run_shared_batch_size;
+    m_cost_model = FLAGS_algo_cost_model;
+    m_cost_model_confidence = FLAGS_algo_cost_model_confidence;
+    m_dump_cost_model = FLAGS_dump_algo_cost_model;
 #if MGB_ENABLE_FASTRUN
     //! while fastrun cache file path is not empty and can't be accessed
     if (!m_fast_run_cache.empty() && access(m_fast_run_cache.c_str(), F_OK)) {
@@ -177,7 +229,24 @@ FastRunOption::FastRunOption() {
                 "--fast-run-shared-batch-size should be used with "
                 "--fast-run|--full-run|--fast-run-algo-policy");
     }
+    if (!m_cost_model.empty() && !enable_full_run && !enable_fast_run) {
+        mgb_log_warn(
+                "--algo-cost-model only takes effect when algos would be "
+                "profiled, i.e. with --fast-run or --full-run");
+    }
 #endif
+    if (m_cache_mem_plan) {
+        mgb_assert(
+                !m_fast_run_cache.empty(),
+                "--fast-run-cache-mem-plan should be used with "
+                "--fast-run-algo-policy");
+    }
+    if (!m_dump_cost_model.empty()) {
+        mgb_assert(
+                !m_fast_run_cache.empty() && !m_fast_run_cache_mmap,
+                "--dump-algo-cost-model should be used with --fast-run-algo-policy "
+                "without --fast-run-cache-mmap");
+    }
 }
 
 bool FastRunOption::is_valid() {
@@ -190,12 +259,14 @@ bool FastRunOption::is_valid() {
     ret = ret || FLAGS_fast_run_shared_batch_size > 0;
     ret = ret || FLAGS_reproducible;
     ret = ret || FLAGS_fast_run_algo_policy.size() > 0;
+    ret = ret || FLAGS_algo_cost_model.size() > 0;
+    ret = ret || FLAGS_dump_algo_cost_model.size() > 0;
 
     return ret;
 }
 
 std::shared_ptr<OptionBase> FastRunOption::create_option() {
-    static std::shared_ptr<FastRunOption> option(new FastRunOption);
+    std::shared_ptr<FastRunOption> option(new FastRunOption);
     if (FastRunOption::is_valid()) {
         return std::static_pointer_cast<OptionBase>(option);
     } else {
@@ -226,6 +297,34 @@ DEFINE_bool(
         "index.html#reproducibility"
         "for more details.");
 DEFINE_uint32(fast_run_shared_batch_size, 0, "Set the batch size used during fastrun");
-DEFINE_string(fast_run_algo_policy, "", "fast-run cache path.");
+DEFINE_string(
+        fast_run_algo_policy, "",
+        "fast-run cache path.");
+
+DEFINE_bool(
+        fast_run_cache_mem_plan, false,
+        "also cache the static memory plans in --fast-run-algo-policy, so "
+        "later runs of the same model and input shapes skip memory planning; "
+        "only for mdl models");
+
+DEFINE_bool(
+        fast_run_cache_mmap, false,
+        "use a memory-mapped and indexed file for --fast-run-algo-policy, which "
+        "can be shared by concurrent processes; only for mdl models, and the file "
+        "format differs from the default one");
+
+DEFINE_string(
+        algo_cost_model, "",
+        "choose algos by the cost model in this file instead of profiling them, "
+        "if the prediction is confident; algos are still profiled with "
+        "--fast-run or --full-run otherwise");
+DEFINE_double(
+        algo_cost_model_confidence, 0.5,
+        "minimal confidence in [0, 1] of a prediction of --algo-cost-model to be "
+        "used");
+DEFINE_string(
+        dump_algo_cost_model, "",
+        "add the profiling results in --fast-run-algo-policy to the cost model in "
+        "this file after running, to be used by --algo-cost-model");
 
 REGIST_OPTION_CREATOR(fastrun, lar::FastRunOption::create_option);
\ No newline at end of file
@@ -21,6 +21,11 @@ DECLARE_bool(reproducible);
 DECLARE_bool(binary_equal_between_batch);
 DECLARE_uint32(fast_run_shared_batch_size);
 DECLARE_string(fast_run_algo_policy);
+DECLARE_bool(fast_run_cache_mmap);
+DECLARE_bool(fast_run_cache_mem_plan);
+DECLARE_string(algo_cost_model);
+DECLARE_double(algo_cost_model_confidence);
+DECLARE_string(dump_algo_cost_model);
 
 namespace lar {
 class FastRunOption final : public OptionBase {
@@ -44,6 +49,11 @@ private:
     template <typename ModelImpl>
     void config_model_internel(RuntimeParam&, std::shared_ptr<ModelImpl>) {}
 
+    //! set the algo cost model used to choose algos
+    void setup_cost_model();
+    //! update the algo cost model file with the profiling results
+    void dump_cost_model();
+
 #if MGB_ENABLE_FASTRUN
     bool enable_fast_run;  //! fast run strategy flag
     bool enable_full_run;  //! full run strategy flag
@@ -52,6 +62,11 @@ private:
     bool enable_reproducible;      //! enable reproducible strategy
     size_t share_batch_size;       //! fast run strategy share batch size setting
     std::string m_fast_run_cache;  //! fast run cache file path
+    bool m_fast_run_cache_mmap;    //! use memory-mapped cache file
+    bool m_cache_mem_plan;         //! cache static memory plans in the cache file
+    std::string m_cost_model;      //! algo cost model file path
+    double m_cost_model_confidence;  //! min confidence of the cost model
+    std::string m_dump_cost_model;   //! path to dump the algo cost model
     std::string m_option_name;     //! option name
 };
 }  // namespace lar
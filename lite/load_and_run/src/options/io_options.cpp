@@ -203,7 +203,7 @@ InputOption::InputOption() {
 }
 
 std::shared_ptr<lar::OptionBase> lar::InputOption::create_option() {
-    static std::shared_ptr<InputOption> m_option(new InputOption);
+    std::shared_ptr<InputOption> m_option(new InputOption);
     if (InputOption::is_valid()) {
         return std::static_pointer_cast<OptionBase>(m_option);
     } else {
@@ -265,7 +265,7 @@ bool IOdumpOption::is_valid() {
 }
 
 std::shared_ptr<OptionBase> IOdumpOption::create_option() {
-    static std::shared_ptr<IOdumpOption> option(new IOdumpOption);
+    std::shared_ptr<IOdumpOption> option(new IOdumpOption);
     if (IOdumpOption::is_valid()) {
         return std::static_pointer_cast<OptionBase>(option);
     } else {
@@ -146,7 +146,7 @@ bool LayoutOption::is_valid() {
 };
 
 std::shared_ptr<OptionBase> LayoutOption::create_option() {
-    static std::shared_ptr<LayoutOption> option(new LayoutOption);
+    std::shared_ptr<LayoutOption> option(new LayoutOption);
     if (LayoutOption::is_valid()) {
         return std::static_pointer_cast<OptionBase>(option);
     } else {
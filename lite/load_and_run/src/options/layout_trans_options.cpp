@@ -118,7 +118,7 @@ bool GoptLayoutOption::is_valid() {
 }
 
 std::shared_ptr<OptionBase> GoptLayoutOption::create_option() {
-    static std::shared_ptr<GoptLayoutOption> option(new GoptLayoutOption);
+    std::shared_ptr<GoptLayoutOption> option(new GoptLayoutOption);
     if (GoptLayoutOption::is_valid()) {
         return std::static_pointer_cast<OptionBase>(option);
     } else {
@@ -55,7 +55,7 @@ bool FusePreprocessOption::is_valid() {
 }
 
 std::shared_ptr<OptionBase> FusePreprocessOption::create_option() {
-    static std::shared_ptr<FusePreprocessOption> option(new FusePreprocessOption);
+    std::shared_ptr<FusePreprocessOption> option(new FusePreprocessOption);
     if (FusePreprocessOption::is_valid()) {
         return std::static_pointer_cast<OptionBase>(option);
     } else {
@@ -116,7 +116,7 @@ bool WeightPreprocessOption::is_valid() {
 }
 
 std::shared_ptr<OptionBase> WeightPreprocessOption::create_option() {
-    static std::shared_ptr<WeightPreprocessOption> option(new WeightPreprocessOption);
+    std::shared_ptr<WeightPreprocessOption> option(new WeightPreprocessOption);
     if (WeightPreprocessOption::is_valid()) {
         return std::static_pointer_cast<OptionBase>(option);
     } else {
@@ -166,7 +166,7 @@ bool FuseConvBiasNonlinearOption::is_valid() {
 }
 
 std::shared_ptr<OptionBase> FuseConvBiasNonlinearOption::create_option() {
-    static std::shared_ptr<FuseConvBiasNonlinearOption> option(
+    std::shared_ptr<FuseConvBiasNonlinearOption> option(
             new FuseConvBiasNonlinearOption);
     if (FuseConvBiasNonlinearOption::is_valid()) {
         return std::static_pointer_cast<OptionBase>(option);
@@ -219,7 +219,7 @@ bool FuseConvBiasElemwiseAddOption::is_valid() {
 }
 
 std::shared_ptr<OptionBase> FuseConvBiasElemwiseAddOption::create_option() {
-    static std::shared_ptr<FuseConvBiasElemwiseAddOption> option(
+    std::shared_ptr<FuseConvBiasElemwiseAddOption> option(
             new FuseConvBiasElemwiseAddOption);
     if (FuseConvBiasElemwiseAddOption::is_valid()) {
         return std::static_pointer_cast<OptionBase>(option);
@@ -322,7 +322,7 @@ bool GraphRecordOption::is_valid() {
 }
 
 std::shared_ptr<OptionBase> GraphRecordOption::create_option() {
-    static std::shared_ptr<GraphRecordOption> option(new GraphRecordOption);
+    std::shared_ptr<GraphRecordOption> option(new GraphRecordOption);
     if (GraphRecordOption::is_valid()) {
         return std::static_pointer_cast<OptionBase>(option);
     } else {
@@ -389,7 +389,7 @@ bool MemoryOptimizeOption::is_valid() {
 }
 
 std::shared_ptr<OptionBase> MemoryOptimizeOption::create_option() {
-    static std::shared_ptr<MemoryOptimizeOption> option(new MemoryOptimizeOption);
+    std::shared_ptr<MemoryOptimizeOption> option(new MemoryOptimizeOption);
     if (MemoryOptimizeOption::is_valid()) {
         return std::static_pointer_cast<OptionBase>(option);
     } else {
@@ -439,7 +439,7 @@ bool JITOption::is_valid() {
 }
 
 std::shared_ptr<OptionBase> JITOption::create_option() {
-    static std::shared_ptr<JITOption> option(new JITOption);
+    std::shared_ptr<JITOption> option(new JITOption);
     if (JITOption::is_valid()) {
         return std::static_pointer_cast<OptionBase>(option);
     } else {
@@ -513,7 +513,7 @@ bool TensorRTOption::is_valid() {
 }
 
 std::shared_ptr<OptionBase> TensorRTOption::create_option() {
-    static std::shared_ptr<TensorRTOption> option(new TensorRTOption);
+    std::shared_ptr<TensorRTOption> option(new TensorRTOption);
     if (TensorRTOption::is_valid()) {
         return std::static_pointer_cast<OptionBase>(option);
     } else {
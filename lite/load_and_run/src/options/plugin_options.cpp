@@ -8,11 +8,78 @@
  */
 
 #include "plugin_options.h"
+#include <algorithm>
 #include "misc.h"
 #include "models/model_lite.h"
 #include "models/model_mdl.h"
 
 ///////////////////// Plugin options///////////////////////////
+namespace {
+#if MGB_ENABLE_JSON
+//! print the roofline summary and the most time consuming oprs
+void print_roofline(mgb::json::Object& rst, size_t nr_top = 10) {
+    using namespace mgb::json;
+    auto obj = [](std::shared_ptr<Value>& v) -> Object& {
+        return *static_cast<Object*>(v.get());
+    };
+    auto num = [&](Object& o, const char* key) {
+        return static_cast<Number*>(o[key].get())->get_impl();
+    };
+    auto str = [&](Object& o, const char* key) {
+        return static_cast<String*>(o[key].get())->get_impl();
+    };
+
+    auto&& peak = obj(rst["peak"]);
+    printf("\n=== roofline: peak %.2f GFLOP/s, %.2f GB/s, ridge %.2f FLOP/byte\n",
+           num(peak, "gflops"), num(peak, "gbps"), num(peak, "ridge"));
+    auto&& summary = obj(rst["summary"]);
+    double total = num(summary, "total");
+    for (auto bound : {"compute", "memory", "overhead"}) {
+        double time = num(summary, bound);
+        printf("%s-bound: %.3fms (%.2f%%)\n", bound, time * 1e3,
+               total > 0 ? time / total * 100 : 0.);
+    }
+
+    std::vector<Object*> oprs;
+    for (auto&& i : obj(rst["oprs"]).get_impl()) {
+        oprs.push_back(static_cast<Object*>(i.second.get()));
+    }
+    std::sort(oprs.begin(), oprs.end(), [&](Object* a, Object* b) {
+        return num(*a, "time") > num(*b, "time");
+    });
+    oprs.resize(std::min(oprs.size(), nr_top));
+
+    auto table = mgb::TextTable("roofline of top oprs");
+    table.padding(1);
+    table.align(mgb::TextTable::Align::Mid)
+            .add("name")
+            .add("type")
+            .add("time(ms)")
+            .add("GFLOP/s")
+            .add("GB/s")
+            .add("FLOP/byte")
+            .add("roof%")
+            .add("bound")
+            .eor();
+    for (auto i : oprs) {
+        table.align(mgb::TextTable::Align::Mid)
+                .add(str(*i, "name"))
+                .add(str(*i, "type"))
+                .add(mgb::ssprintf("%.3f", num(*i, "time") * 1e3))
+                .add(mgb::ssprintf("%.2f", num(*i, "gflops")))
+                .add(mgb::ssprintf("%.2f", num(*i, "gbps")))
+                .add(mgb::ssprintf("%.2f", num(*i, "intensity")))
+                .add(mgb::ssprintf("%.2f", num(*i, "efficiency") * 100))
+                .add(str(*i, "bound"))
+                .eor();
+    }
+    std::stringstream ss;
+    ss << table;
+    printf("%s\n\n", ss.str().c_str());
+}
+#endif
+}  // namespace
+
 namespace lar {
 
 template <>
@@ -26,6 +93,11 @@ void PluginOption::config_model_internel<ModelLite>(
         LITE_ASSERT(
                 var_value_check_str.empty(),
                 "lite model don't support VarValueChecker plugin");
+#if MGB_ENABLE_JSON
+        LITE_ASSERT(
+                !enable_perf_counter,
+                "lite model don't support PerfCounterProfiler plugin");
+#endif
     }
 #if MGB_ENABLE_JSON
     else if (runtime_param.stage == RunStage::AFTER_MODEL_LOAD) {
@@ -38,6 +110,10 @@ void PluginOption::config_model_internel<ModelLite>(
                 model->get_lite_network()->enable_profile_performance(profile_path);
             }
         }
+        if (!roofline_path.empty()) {
+            LITE_WARN("enable roofline analysis");
+            model->get_lite_network()->enable_profile_roofline(roofline_path);
+        }
     }
 #endif
 }
@@ -82,6 +158,19 @@ void PluginOption::config_model_internel<ModelMdl>(
             }
             model->set_profiler();
         }
+
+        if (!roofline_path.empty()) {
+            mgb_log_warn("enable roofline analysis");
+            if (!model->get_profiler()) {
+                model->set_profiler();
+            }
+        }
+
+        if (enable_perf_counter) {
+            mgb_log_warn("enable hardware performance counter profiling");
+            perf_counter_profiler = std::make_unique<mgb::PerfCounterProfiler>(
+                    config.comp_graph.get());
+        }
 #endif
     }
 
@@ -90,12 +179,25 @@ void PluginOption::config_model_internel<ModelMdl>(
         if (!profile_path.empty()) {
             mgb_log_warn("filename %s", profile_path.c_str());
             if (model->get_profiler()) {
-                model->get_profiler()
-                        ->to_json_full(model->get_async_func().get())
-                        ->writeto_fpath(profile_path);
+                auto rst = model->get_profiler()->to_json_full(
+                        model->get_async_func().get());
+                if (perf_counter_profiler) {
+                    (*rst)["perf_counter"] = perf_counter_profiler->to_json();
+                }
+                rst->writeto_fpath(profile_path);
                 mgb_log_warn("profiling result written to %s", profile_path.c_str());
             }
         }
+        if (!roofline_path.empty() && model->get_profiler()) {
+            auto cn = model->get_output_spec()[0].first.node()->comp_node();
+            auto peak = mgb::RooflinePeak::measure(cn);
+            auto rst = model->get_profiler()->roofline_json(peak);
+            rst->writeto_fpath(roofline_path);
+            print_roofline(*rst);
+            mgb_log_warn("roofline result written to %s", roofline_path.c_str());
+        }
+        // the option outlives the graph, so release the plugin here
+        perf_counter_profiler.reset();
 #endif
     }
 }
@@ -117,6 +219,11 @@ PluginOption::PluginOption() {
         enable_profile_host = !FLAGS_profile_host.empty();
         profile_path = FLAGS_profile_host;
     }
+    enable_perf_counter = FLAGS_profile_perf_counter;
+    mgb_assert(
+            !enable_perf_counter || !profile_path.empty(),
+            "--profile_perf_counter should be used with --profile");
+    roofline_path = FLAGS_profile_roofline;
 #endif
 }
 
@@ -127,12 +234,14 @@ bool PluginOption::is_valid() {
 #if MGB_ENABLE_JSON
     ret = ret || !FLAGS_profile.empty();
     ret = ret || !FLAGS_profile_host.empty();
+    ret = ret || FLAGS_profile_perf_counter;
+    ret = ret || !FLAGS_profile_roofline.empty();
 #endif
     return ret;
 }
 
 std::shared_ptr<OptionBase> PluginOption::create_option() {
-    static std::shared_ptr<PluginOption> option(new PluginOption);
+    std::shared_ptr<PluginOption> option(new PluginOption);
     if (PluginOption::is_valid()) {
         return std::static_pointer_cast<OptionBase>(option);
     } else {
@@ -338,7 +447,7 @@ bool DebugOption::is_valid() {
 }
 
 std::shared_ptr<OptionBase> DebugOption::create_option() {
-    static std::shared_ptr<DebugOption> option(new DebugOption);
+    std::shared_ptr<DebugOption> option(new DebugOption);
     if (DebugOption::is_valid()) {
         return std::static_pointer_cast<OptionBase>(option);
     } else {
@@ -370,6 +479,17 @@ DEFINE_string(
         "Write profiling result to given file. The output file is in "
         "JSON format");
 DEFINE_string(profile_host, "", "focus on host time profiling For some backends");
+DEFINE_bool(
+        profile_perf_counter, false,
+        "Add per-operator hardware performance counters (cycles, "
+        "instructions, LLC misses) of cpu comp nodes to the --profile result "
+        "under key perf_counter; requires linux perf_event");
+DEFINE_string(
+        profile_roofline, "",
+        "Write per-operator roofline analysis to given file in JSON format: "
+        "achieved GFLOP/s and GB/s compared with the peaks of the device "
+        "measured by microbenchmarks, and whether each operator is bound by "
+        "compute, memory or overhead");
 #endif
 
 ///////////////////// Debug gflags///////////////////////////
@@ -13,6 +13,7 @@
 #include <unistd.h>
 #endif
 #include "megbrain/plugin/cpu_dispatch_checker.h"
+#include "megbrain/plugin/perf_counter_profiler.h"
 #include "megbrain/plugin/var_value_checker.h"
 
 #include "helpers/common.h"
@@ -27,6 +28,8 @@ DECLARE_string(check_var_value);
 #if MGB_ENABLE_JSON
 DECLARE_string(profile);
 DECLARE_string(profile_host);
+DECLARE_bool(profile_perf_counter);
+DECLARE_string(profile_roofline);
 #endif
 
 DECLARE_bool(model_info);
@@ -62,6 +65,9 @@ private:
 #if MGB_ENABLE_JSON
     bool enable_profile_host;
     std::string profile_path;
+    bool enable_perf_counter;
+    std::string roofline_path;
+    std::unique_ptr<mgb::PerfCounterProfiler> perf_counter_profiler;
 #endif
 
     std::string var_value_check_str;
@@ -22,7 +22,7 @@ StrategyOption::StrategyOption() {
 }
 
 std::shared_ptr<OptionBase> StrategyOption::create_option() {
-    static std::shared_ptr<StrategyOption> option(new StrategyOption);
+    std::shared_ptr<StrategyOption> option(new StrategyOption);
     return std::static_pointer_cast<OptionBase>(option);
 }
 
@@ -30,6 +30,13 @@ void StrategyOption::config_model(
         RuntimeParam& runtime_param, std::shared_ptr<ModelBase> model) {
     if (runtime_param.stage == RunStage::BEFORE_MODEL_LOAD) {
         model->set_shared_mem(FLAGS_share_param_mem);
+        if (FLAGS_mmap_model) {
+            if (model->type() == ModelType::MEGDL_MODEL) {
+                std::static_pointer_cast<ModelMdl>(model)->set_mmap_model(true);
+            } else {
+                mgb_log_warn("--mmap_model is only supported for mgb models");
+            }
+        }
         runtime_param.warmup_iter = warmup_iter;
         runtime_param.run_iter = run_iter;
         runtime_param.threads = threads;
@@ -51,7 +58,7 @@ TestcaseOption::TestcaseOption() {
 }
 
 std::shared_ptr<OptionBase> TestcaseOption::create_option() {
-    static std::shared_ptr<TestcaseOption> option(new TestcaseOption);
+    std::shared_ptr<TestcaseOption> option(new TestcaseOption);
     return std::static_pointer_cast<OptionBase>(option);
 }
 
@@ -91,6 +98,11 @@ DEFINE_int32(
 
 DEFINE_bool(share_param_mem, false, "load model from shared memeory");
 
+DEFINE_bool(
+        mmap_model, false,
+        "map the model file into memory, so aligned tensor values are used "
+        "without copying");
+
 REGIST_OPTION_CREATOR(run_strategy, lar::StrategyOption::create_option);
 
 REGIST_OPTION_CREATOR(run_testcase, lar::TestcaseOption::create_option);
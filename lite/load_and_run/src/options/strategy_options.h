@@ -14,6 +14,7 @@ DECLARE_int32(iter);
 DECLARE_int32(warmup_iter);
 DECLARE_int32(thread);
 DECLARE_bool(share_param_mem);
+DECLARE_bool(mmap_model);
 
 namespace lar {
 /*!
@@ -16,6 +16,8 @@ using namespace lar;
 std::shared_ptr<StrategyBase> StrategyBase::create_strategy(std::string model_path) {
     if (FLAGS_fitting) {
         return std::make_shared<FittingStrategy>(model_path);
+    } else if (FLAGS_bench_instances > 0) {
+        return std::make_shared<ConcurrentStrategy>(model_path);
     } else {
         return std::make_shared<NormalStrategy>(model_path);
     }
@@ -9,13 +9,19 @@
 
 #pragma once
 #include <gflags/gflags.h>
+#include <map>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "helpers/common.h"
+#include "helpers/report.h"
 #include "models/model.h"
 #include "options/option_base.h"
 
 DECLARE_bool(fitting);
+DECLARE_string(fitting_output);
+DECLARE_int32(fitting_iter);
+DECLARE_int32(bench_instances);
 
 namespace lar {
 /*!
@@ -48,15 +54,64 @@ private:
     void run_subline();
 
     std::string m_model_path;
+
+    //! report for --report_json and --report_csv, null if not required
+    std::unique_ptr<BenchReport> m_report;
 };
 
 /*!
- * \brief: Fitting strategy for running
+ * \brief: Fitting strategy which searches the fastest options for the model
+ *
+ * The option space is searched one dimension at a time (device threads,
+ * layout, algo policy, weight/fuse preprocess, record level), keeping the
+ * best choice of each dimension for the following ones. The choices of a
+ * dimension are measured with a few iterations first, and only the faster
+ * half is measured again with doubled iterations, until one is left.
  */
 class FittingStrategy : public StrategyBase {
 public:
+    //! values of gflags for an option set
+    using FlagValues = std::map<std::string, std::string>;
+
     FittingStrategy(std::string model_path);
     void run() override;
+
+private:
+    //! run the model with the options, return the average time of an
+    //! iteration in ms, or infinity if the options fail
+    double profile(const FlagValues& flags, size_t run_iter);
+
+    //! run the model with the options of current gflags
+    double run_model(size_t run_iter);
+
+    //! choose the fastest one of the option sets
+    FlagValues select(const std::vector<FlagValues>& candidates);
+
+    //! dump the option file, the algo cache and the packed model
+    void dump_best(const FlagValues& best);
+
+    std::string m_model_path;
+};
+/*!
+ * \brief: strategy to measure throughput and latency of concurrent requests
+ *
+ * Requests are served by --bench_threads threads with --bench_instances
+ * model instances, each of which runs one request at a time on its own comp
+ * node. In closed loop, a thread sends a new request as soon as its last one
+ * is finished; in open loop, requests arrive as a Poisson process and wait in
+ * a queue until a thread serves them, and their latency is counted from the
+ * arrival.
+ */
+class ConcurrentStrategy : public StrategyBase {
+public:
+    ConcurrentStrategy(std::string model_path);
+    void run() override;
+
+private:
+    //! load a model instance whose comp node is not shared with others
+    std::shared_ptr<ModelBase> load_instance(size_t idx);
+
+    std::string m_model_path;
 };
 }  // namespace lar
 
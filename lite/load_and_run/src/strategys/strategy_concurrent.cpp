@@ -0,0 +1,368 @@
+/**
+ * \file lite/load_and_run/src/strategys/strategy_concurrent.cpp
+ *
+ * This file is part of MegEngine, a deep learning framework developed by
+ * Megvii.
+ *
+ * \copyright Copyright (c) 2020-2021 Megvii Inc. All rights reserved.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include "megbrain/common.h"
+#include "megbrain/comp_node_env.h"
+#include "megbrain/system.h"
+#include "megbrain/utils/timer.h"
+#include "megbrain/version.h"
+#include "megdnn/version.h"
+#include "misc.h"
+#include "models/model_lite.h"
+#include "models/model_mdl.h"
+#include "strategy.h"
+
+DECLARE_int32(bench_threads);
+DECLARE_int32(bench_requests);
+DECLARE_int32(bench_warmup_requests);
+DECLARE_double(bench_arrival_rate);
+DECLARE_string(bench_core_ids);
+
+using namespace lar;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double msecs(Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+//! nearest-rank percentile of sorted values
+double percentile(const std::vector<double>& sorted, double p) {
+    size_t rank = static_cast<size_t>(std::ceil(p / 100 * sorted.size()));
+    return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+std::vector<int> parse_core_ids(const std::string& core_ids) {
+    std::vector<int> ret;
+    std::stringstream id_stream(core_ids);
+    std::string id;
+    while (getline(id_stream, id, ',')) {
+        ret.push_back(atoi(id.c_str()));
+    }
+    return ret;
+}
+
+/*!
+ * \brief bind the runtime threads of an instance to core_ids[offset:] in turn
+ * \return number of the bound threads
+ */
+size_t bind_runtime_threads(
+        const std::shared_ptr<ModelBase>& model, const std::vector<int>& core_ids,
+        size_t offset) {
+    auto make_callback = [&core_ids](size_t first) {
+        return [core_ids, first](size_t thread_id) {
+            mgb::sys::set_cpu_affinity(
+                    {core_ids[(first + thread_id) % core_ids.size()]});
+        };
+    };
+    if (model->type() == ModelType::LITE_MODEL) {
+        auto lite_model = std::static_pointer_cast<ModelLite>(model);
+        auto&& network = lite_model->get_lite_network();
+        if (lite_model->get_config().device_type != LiteDeviceType::LITE_CPU) {
+            return 0;
+        }
+        if (lite::Runtime::is_cpu_inplace_mode(network)) {
+            mgb_log_warn("inplace instances run in the request threads, not bound");
+            return 0;
+        }
+        lite::Runtime::set_runtime_thread_affinity(network, make_callback(offset));
+        return lite::Runtime::get_cpu_threads_number(network);
+    }
+
+    using DeviceType = mgb::CompNode::DeviceType;
+    using Locator = mgb::CompNode::Locator;
+    mgb::CompNode::UnorderedSet comp_nodes;
+    auto mdl_model = std::static_pointer_cast<ModelMdl>(model);
+    for (auto&& i : mdl_model->get_mdl_load_result().output_var_list) {
+        comp_nodes.insert(i.node()->comp_node());
+    }
+    size_t nr_bound = 0;
+    for (auto&& cn : comp_nodes) {
+        auto loc = cn.locator();
+        if (loc.type != DeviceType::CPU && loc.type != DeviceType::MULTITHREAD) {
+            continue;
+        }
+        if (loc.device == Locator::DEVICE_CPU_DEFAULT ||
+            loc.device == Locator::DEVICE_MULTITHREAD_DEFAULT) {
+            mgb_log_warn("inplace instances run in the request threads, not bound");
+            continue;
+        }
+        mgb::CompNodeEnv::from_comp_node(cn).cpu_env().set_affinity(
+                make_callback(offset + nr_bound));
+        nr_bound += loc.type == DeviceType::MULTITHREAD ? loc.nr_threads : 1;
+    }
+    return nr_bound;
+}
+}  // namespace
+
+ConcurrentStrategy::ConcurrentStrategy(std::string model_path) {
+    mgb::set_log_level(mgb::LogLevel::WARN);
+    lite::set_log_level(LiteLogLevel::WARN);
+    m_model_path = model_path;
+    auto option_creator_map = OptionFactory::get_Instance().get_option_creator_map();
+    for (auto& creator : *option_creator_map) {
+        auto option = creator.second();
+        if (option) {
+            m_options.insert({creator.first, option});
+        }
+    }
+}
+
+std::shared_ptr<ModelBase> ConcurrentStrategy::load_instance(size_t idx) {
+    auto model = ModelBase::create_model(m_model_path);
+    mgb_assert(model != nullptr, "create model failed!!");
+    auto stage_config_model = [&](RunStage stage) {
+        m_runtime_param.stage = stage;
+        for (auto& option : m_options) {
+            option.second->config_model(m_runtime_param, model);
+        }
+    };
+
+    stage_config_model(RunStage::BEFORE_MODEL_LOAD);
+    //! instances on the same comp node would be run one by one
+    if (model->type() == ModelType::LITE_MODEL) {
+        auto&& config = std::static_pointer_cast<ModelLite>(model)->get_config();
+        if (config.device_type == LiteDeviceType::LITE_CPU) {
+            config.device_id = idx;
+        }
+    } else {
+        auto&& config = std::static_pointer_cast<ModelMdl>(model)->get_mdl_config();
+        auto mapper = config.comp_node_mapper;
+        config.comp_node_mapper = [mapper, idx](mgb::CompNode::Locator& loc) {
+            using DeviceType = mgb::CompNode::DeviceType;
+            using Locator = mgb::CompNode::Locator;
+            if (mapper) {
+                mapper(loc);
+            }
+            auto type = loc.to_physical().type;
+            if (type == DeviceType::CPU || type == DeviceType::MULTITHREAD) {
+                if (loc.device != Locator::DEVICE_CPU_DEFAULT &&
+                    loc.device != Locator::DEVICE_MULTITHREAD_DEFAULT) {
+                    loc.type = type;
+                    loc.device = idx;
+                }
+            } else {
+                loc.stream = idx;
+            }
+        };
+    }
+    model->load_model();
+    for (auto stage :
+         {RunStage::AFTER_MODEL_LOAD, RunStage::GLOBAL_OPTIMIZATION,
+          RunStage::BEFORE_OUTSPEC_SET, RunStage::AFTER_OUTSPEC_SET,
+          RunStage::MODEL_RUNNING}) {
+        stage_config_model(stage);
+    }
+    return model;
+}
+
+void ConcurrentStrategy::run() {
+#if MGB_HAVE_THREAD
+    auto v0 = mgb::get_version();
+    auto v1 = megdnn::get_version();
+    printf("megbrain/lite/load_and_run:\nusing MegBrain "
+           "%d.%d.%d(%d) and MegDNN %d.%d.%d\n",
+           v0.major, v0.minor, v0.patch, v0.is_dev, v1.major, v1.minor, v1.patch);
+
+    size_t nr_instance = FLAGS_bench_instances;
+    size_t nr_thread = FLAGS_bench_threads > 0 ? FLAGS_bench_threads : nr_instance;
+    mgb_assert(FLAGS_bench_requests > 0, "--bench_requests must be positive");
+    size_t nr_warmup = std::max(FLAGS_bench_warmup_requests, 0);
+    size_t nr_total = nr_warmup + FLAGS_bench_requests;
+    double arrival_rate = FLAGS_bench_arrival_rate;
+    auto core_ids = parse_core_ids(FLAGS_bench_core_ids);
+
+    mgb::RealTimer timer;
+    std::vector<std::shared_ptr<ModelBase>> instances;
+    for (size_t i = 0; i < nr_instance; ++i) {
+        instances.push_back(load_instance(i));
+    }
+    printf("load %zu instances: %.3fms\n", nr_instance, timer.get_msecs_reset());
+    if (!core_ids.empty()) {
+        //! each instance takes the next cores for its own runtime threads
+        size_t offset = 0;
+        for (auto&& model : instances) {
+            offset += bind_runtime_threads(model, core_ids, offset);
+        }
+        if (offset > core_ids.size()) {
+            mgb_log_warn(
+                    "%zu runtime threads share %zu cores", offset, core_ids.size());
+        }
+    }
+
+    //! the first runs are slow for profiling and memory allocation
+    for (auto&& model : instances) {
+        for (size_t i = 0; i < m_runtime_param.warmup_iter; ++i) {
+            model->run_model();
+            model->wait();
+        }
+    }
+    printf("warm up instances: %.3fms\n", timer.get_msecs_reset());
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<size_t> free_instances;
+    for (size_t i = 0; i < nr_instance; ++i) {
+        free_instances.push_back(i);
+    }
+    //! requests arrived but not served, only used in open loop
+    std::deque<size_t> pending;
+    bool all_arrived = false;
+    std::atomic_size_t next_request{0};
+
+    std::vector<Clock::time_point> arrivals(nr_total), finishes(nr_total);
+
+    auto serve = [&](size_t request) {
+        if (arrival_rate <= 0) {
+            arrivals[request] = Clock::now();
+        }
+        size_t idx;
+        {
+            std::unique_lock<std::mutex> lock{mtx};
+            cv.wait(lock, [&]() { return !free_instances.empty(); });
+            idx = free_instances.front();
+            free_instances.pop_front();
+        }
+        instances[idx]->run_model();
+        instances[idx]->wait();
+        finishes[request] = Clock::now();
+        {
+            std::lock_guard<std::mutex> lock{mtx};
+            free_instances.push_back(idx);
+        }
+        cv.notify_all();
+    };
+
+    auto worker = [&]() {
+        for (;;) {
+            size_t request;
+            if (arrival_rate <= 0) {
+                request = next_request++;
+                if (request >= nr_total) {
+                    return;
+                }
+            } else {
+                std::unique_lock<std::mutex> lock{mtx};
+                cv.wait(lock, [&]() { return all_arrived || !pending.empty(); });
+                if (pending.empty()) {
+                    return;
+                }
+                request = pending.front();
+                pending.pop_front();
+            }
+            serve(request);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < nr_thread; ++i) {
+        threads.emplace_back(worker);
+    }
+    if (arrival_rate > 0) {
+        //! the scheduled time is taken as the arrival, so the delay of the
+        //! arrivals caused by a busy system is still counted in the latency
+        std::mt19937 rng(0);
+        std::exponential_distribution<double> interval(arrival_rate);
+        auto time = Clock::now();
+        for (size_t i = 0; i < nr_total; ++i) {
+            time += std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(interval(rng)));
+            std::this_thread::sleep_until(time);
+            arrivals[i] = time;
+            {
+                std::lock_guard<std::mutex> lock{mtx};
+                pending.push_back(i);
+            }
+            cv.notify_all();
+        }
+        {
+            std::lock_guard<std::mutex> lock{mtx};
+            all_arrived = true;
+        }
+        cv.notify_all();
+    }
+    for (auto&& i : threads) {
+        i.join();
+    }
+
+    std::vector<double> latencies;
+    auto start = arrivals[nr_warmup], end = finishes[nr_warmup];
+    for (size_t i = nr_warmup; i < nr_total; ++i) {
+        latencies.push_back(msecs(finishes[i] - arrivals[i]));
+        start = std::min(start, arrivals[i]);
+        end = std::max(end, finishes[i]);
+    }
+    std::sort(latencies.begin(), latencies.end());
+    double tot_time = msecs(end - start), latency_sum = 0;
+    for (auto i : latencies) {
+        latency_sum += i;
+    }
+
+    if (arrival_rate > 0) {
+        printf("\n=== %zu instances, %zu threads, open loop of %.3f req/s\n",
+               nr_instance, nr_thread, arrival_rate);
+    } else {
+        printf("\n=== %zu instances, %zu threads, closed loop\n", nr_instance,
+               nr_thread);
+    }
+    printf("requests: %zu in %.3fms, throughput: %.3f req/s\n", latencies.size(),
+           tot_time, latencies.size() * 1000 / tot_time);
+    printf("latency: min=%.3fms mean=%.3fms p50=%.3fms p90=%.3fms p99=%.3fms "
+           "p99.9=%.3fms max=%.3fms\n",
+           latencies.front(), latency_sum / latencies.size(),
+           percentile(latencies, 50), percentile(latencies, 90),
+           percentile(latencies, 99), percentile(latencies, 99.9), latencies.back());
+
+    for (auto&& model : instances) {
+        m_runtime_param.stage = RunStage::AFTER_MODEL_RUNNING;
+        for (auto& option : m_options) {
+            option.second->config_model(m_runtime_param, model);
+        }
+    }
+#else
+    mgb_assert(
+            false,
+            "--bench_instances is requested, but load_and_run was compiled "
+            "without <thread> support.");
+#endif
+}
+
+DEFINE_int32(
+        bench_instances, 0,
+        "number of model instances to measure throughput and latency of "
+        "concurrent requests, 0 to run the model normally");
+DEFINE_int32(
+        bench_threads, 0,
+        "number of threads sending requests to the model instances, 0 for "
+        "the number of instances");
+DEFINE_int32(bench_requests, 1000, "number of requests to measure");
+DEFINE_int32(
+        bench_warmup_requests, 100,
+        "number of requests run concurrently before the measurement, which "
+        "are not counted");
+DEFINE_double(
+        bench_arrival_rate, 0,
+        "requests per second arrived as a Poisson process (open loop), 0 for "
+        "sending a new request when the last one of the thread is finished "
+        "(closed loop)");
+DEFINE_string(
+        bench_core_ids, "",
+        "comma separated cores which the runtime threads of the instances are "
+        "bound to in turn; each instance takes as many cores as its threads");
@@ -7,18 +7,409 @@
  * \copyright Copyright (c) 2020-2021 Megvii Inc. All rights reserved.
  */
 
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include "lite/global.h"
+#include "lite/pack_model.h"
+#include "megbrain/common.h"
+#include "megbrain/utils/infile_persistent_cache.h"
+#include "megbrain/utils/timer.h"
+#include "megbrain/version.h"
+#include "megdnn/version.h"
+#include "misc.h"
+#include "options/fastrun_options.h"
+#include "options/strategy_options.h"
 #include "strategy.h"
+
 using namespace lar;
 
-FittingStrategy::FittingStrategy(std::string) {
-    mgb_assert("this version don't support Fitting Strategy");
+namespace {
+using FlagValues = FittingStrategy::FlagValues;
+
+//! a dimension of the option space, each choice sets some gflags
+struct Dimension {
+    std::string name;
+    std::vector<FlagValues> choices;
 };
 
+bool has_flag(const std::string& name) {
+    gflags::CommandLineFlagInfo info;
+    return gflags::GetCommandLineFlagInfo(name.c_str(), &info);
+}
+
+std::string get_flag(const std::string& name) {
+    std::string value;
+    gflags::GetCommandLineOption(name.c_str(), &value);
+    return value;
+}
+
+bool flag_is_true(const FlagValues& flags, const std::string& name) {
+    auto iter = flags.find(name);
+    return iter != flags.end() && iter->second == "true";
+}
+
+std::string to_string(const FlagValues& flags) {
+    std::string ret;
+    for (auto&& i : flags) {
+        ret += (ret.empty() ? "--" : " --") + i.first + "=" + i.second;
+    }
+    return ret;
+}
+
+//! the flags of a choice which are not registered are dropped
+void add_choice(Dimension& dim, const FlagValues& choice) {
+    FlagValues flags;
+    for (auto&& i : choice) {
+        if (has_flag(i.first)) {
+            flags.insert(i);
+        }
+    }
+    if (!flags.empty()) {
+        dim.choices.push_back(flags);
+    }
+}
+
+const std::vector<std::string> cpu_layouts = {
+        "enable_nchw44", "enable_nchw44_dot", "enable_nchw88"};
+const std::vector<std::string> cuda_layouts = {
+        "enable_nchw4", "enable_chwn4", "enable_nchw32", "enable_nchw64"};
+
+std::vector<Dimension> make_option_space(bool on_cuda) {
+    std::vector<Dimension> space;
+
+    //! threads of the CPU device, unless they are given by user
+    bool threads_given = get_flag("cpu_default") == "true" ||
+                         std::stoi(get_flag("multithread")) >= 0 ||
+                         std::stoi(get_flag("multithread_default")) >= 0 ||
+                         !get_flag("multi_thread_core_ids").empty();
+    if (!on_cuda && !threads_given) {
+        Dimension dim{"threads", {}};
+        add_choice(dim, {{"cpu", "true"}, {"multithread", "-1"}});
+#if MGB_HAVE_THREAD
+        size_t nr_cores = std::thread::hardware_concurrency();
+        for (size_t nr_threads = 2; nr_threads <= nr_cores; nr_threads *= 2) {
+            add_choice(
+                    dim, {{"cpu", "false"}, {"multithread", std::to_string(nr_threads)}});
+        }
+        if (nr_cores > 2 && (nr_cores & (nr_cores - 1))) {
+            add_choice(
+                    dim, {{"cpu", "false"}, {"multithread", std::to_string(nr_cores)}});
+        }
+#endif
+        space.push_back(dim);
+    }
+
+    {
+        Dimension dim{"layout", {}};
+        FlagValues none;
+        for (auto&& i : cpu_layouts) {
+            none[i] = "false";
+        }
+        for (auto&& i : cuda_layouts) {
+            none[i] = "false";
+        }
+        add_choice(dim, none);
+        if (on_cuda) {
+            for (auto&& i : cuda_layouts) {
+                auto choice = none;
+                choice[i] = "true";
+                add_choice(dim, choice);
+            }
+        } else {
+            for (auto&& i : cpu_layouts) {
+                auto choice = none;
+                choice[i] = "true";
+                add_choice(dim, choice);
+            }
+        }
+        space.push_back(dim);
+    }
+
+    {
+        Dimension dim{"algo_policy", {}};
+        add_choice(dim, {{"fast_run", "false"}, {"full_run", "false"}});
+        add_choice(dim, {{"fast_run", "true"}, {"full_run", "false"}});
+        space.push_back(dim);
+    }
+
+    for (auto name : {"weight_preprocess", "enable_fuse_preprocess"}) {
+        Dimension dim{name, {}};
+        add_choice(dim, {{name, "false"}});
+        add_choice(dim, {{name, "true"}});
+        space.push_back(dim);
+    }
+
+    {
+        Dimension dim{"record_level", {}};
+        add_choice(dim, {{"record_comp_seq", "false"}, {"record_comp_seq2", "false"}});
+        add_choice(dim, {{"record_comp_seq", "true"}, {"record_comp_seq2", "false"}});
+        add_choice(
+                dim, {{"record_comp_seq", "false"},
+                      {"record_comp_seq2", "true"},
+                      {"no_sanity_check", "true"}});
+        space.push_back(dim);
+    }
+
+    //! a dimension with only one choice needs no measurement
+    space.erase(
+            std::remove_if(
+                    space.begin(), space.end(),
+                    [](const Dimension& dim) { return dim.choices.size() < 2; }),
+            space.end());
+    return space;
+}
+
+bool is_packed_model(const std::string& model_path) {
+    const char tag[] = "packed_model";
+    char buf[sizeof(tag) - 1];
+    FILE* fin = fopen(model_path.c_str(), "rb");
+    mgb_assert(fin, "failed to open %s: %s", model_path.c_str(), strerror(errno));
+    bool packed = fread(buf, 1, sizeof(buf), fin) == sizeof(buf) &&
+                  !memcmp(buf, tag, sizeof(buf));
+    fclose(fin);
+    return packed;
+}
+
+//! json info of the packed model, see lite/src/parse_info/default_parse.h
+std::string make_model_info(
+        const FlagValues& best, const std::string& model_name, bool on_cuda) {
+    int major, minor, patch;
+    lite::get_version(major, minor, patch);
+    std::string device = on_cuda ? R"("type": "CUDA")" : R"("type": "CPU")";
+    auto multithread = best.find("multithread");
+    if (multithread != best.end() && std::stoi(multithread->second) > 1) {
+        device += R"(, "number_threads": )" + multithread->second;
+    }
+
+    std::string options = mgb::ssprintf(
+            R"("weight_preprocess": %s, "fuse_preprocess": %s)",
+            flag_is_true(best, "weight_preprocess") ? "true" : "false",
+            flag_is_true(best, "enable_fuse_preprocess") ? "true" : "false");
+    for (auto layouts : {&cpu_layouts, &cuda_layouts}) {
+        for (auto&& i : *layouts) {
+            if (flag_is_true(best, i)) {
+                options += mgb::ssprintf(R"(, "%s": true)", i.c_str());
+            }
+        }
+    }
+    if (flag_is_true(best, "record_comp_seq2")) {
+        options += R"(, "comp_node_seq_record_level": 2)";
+        options += R"(, "var_sanity_check_first_run": false)";
+    } else if (flag_is_true(best, "record_comp_seq")) {
+        options += R"(, "comp_node_seq_record_level": 1)";
+    }
+
+    return mgb::ssprintf(
+            R"({"valid": true, "name": "%s", "version": "%d.%d.%d", )"
+            R"("device": {%s}, "options": {%s}})",
+            model_name.c_str(), major, minor, patch, device.c_str(), options.c_str());
+}
+}  // namespace
+
+FittingStrategy::FittingStrategy(std::string model_path) {
+    //! options of each candidate print warnings, which are too many to read
+    mgb::set_log_level(mgb::LogLevel::ERROR);
+    lite::set_log_level(LiteLogLevel::ERROR);
+    m_model_path = model_path;
+}
+
+double FittingStrategy::run_model(size_t run_iter) {
+    //! options are created again to get the flags of the candidate
+    m_options.clear();
+    auto option_creator_map = OptionFactory::get_Instance().get_option_creator_map();
+    for (auto& creator : *option_creator_map) {
+        auto option = creator.second();
+        if (option) {
+            m_options.insert({creator.first, option});
+        }
+    }
+
+    auto model = ModelBase::create_model(m_model_path);
+    mgb_assert(model != nullptr, "create model failed!!");
+    auto stage_config_model = [&](RunStage stage) {
+        m_runtime_param.stage = stage;
+        for (auto& option : m_options) {
+            option.second->config_model(m_runtime_param, model);
+        }
+    };
+
+    stage_config_model(RunStage::BEFORE_MODEL_LOAD);
+    model->load_model();
+    for (auto stage :
+         {RunStage::AFTER_MODEL_LOAD, RunStage::GLOBAL_OPTIMIZATION,
+          RunStage::BEFORE_OUTSPEC_SET, RunStage::AFTER_OUTSPEC_SET,
+          RunStage::MODEL_RUNNING}) {
+        stage_config_model(stage);
+    }
+
+    //! algos are profiled in the first run if fast-run is enabled
+    size_t warmup_iter = std::max<size_t>(m_runtime_param.warmup_iter, 1);
+    for (size_t i = 0; i < warmup_iter; ++i) {
+        model->run_model();
+        model->wait();
+        stage_config_model(RunStage::AFTER_RUNNING_WAIT);
+    }
+
+    mgb::RealTimer timer;
+    double time_sum = 0;
+    for (size_t i = 0; i < run_iter; ++i) {
+        timer.reset();
+        model->run_model();
+        model->wait();
+        time_sum += timer.get_msecs();
+        stage_config_model(RunStage::AFTER_RUNNING_WAIT);
+    }
+
+    stage_config_model(RunStage::AFTER_RUNNING_ITER);
+    stage_config_model(RunStage::AFTER_MODEL_RUNNING);
+    return time_sum / run_iter;
+}
+
+double FittingStrategy::profile(const FlagValues& flags, size_t run_iter) {
+    for (auto&& i : flags) {
+        auto ret = gflags::SetCommandLineOption(i.first.c_str(), i.second.c_str());
+        mgb_assert(!ret.empty(), "failed to set --%s=%s", i.first.c_str(),
+                   i.second.c_str());
+    }
+    double time = std::numeric_limits<double>::infinity();
+    MGB_TRY { time = run_model(run_iter); }
+    MGB_CATCH(std::exception & exc, {
+        printf("skip options %s: %s\n", to_string(flags).c_str(), exc.what());
+        return time;
+    });
+    printf("%s: %.3fms (%zu iters)\n", to_string(flags).c_str(), time, run_iter);
+    fflush(stdout);
+    return time;
+}
+
+FittingStrategy::FlagValues FittingStrategy::select(
+        const std::vector<FlagValues>& candidates) {
+    std::vector<size_t> alive(candidates.size());
+    for (size_t i = 0; i < alive.size(); ++i) {
+        alive[i] = i;
+    }
+    std::vector<double> times(candidates.size());
+    size_t run_iter = std::max(FLAGS_fitting_iter, 1);
+    for (;;) {
+        for (auto idx : alive) {
+            times[idx] = profile(candidates[idx], run_iter);
+        }
+        std::stable_sort(alive.begin(), alive.end(), [&](size_t lhs, size_t rhs) {
+            return times[lhs] < times[rhs];
+        });
+        while (!alive.empty() && std::isinf(times[alive.back()])) {
+            alive.pop_back();
+        }
+        mgb_assert(!alive.empty(), "all options failed, last: %s",
+                   to_string(candidates.back()).c_str());
+        if (alive.size() == 1) {
+            return candidates[alive[0]];
+        }
+        //! keep the faster half and measure them more precisely
+        alive.resize((alive.size() + 1) / 2);
+        run_iter *= 2;
+    }
+}
+
+void FittingStrategy::dump_best(const FlagValues& best) {
+    bool on_cuda = get_flag("cuda") == "true";
+    bool use_cache = flag_is_true(best, "fast_run");
+    std::string cache_path = FLAGS_fitting_output + ".cache";
+    std::string flag_path = FLAGS_fitting_output + ".flags";
+    std::string packed_model_path = FLAGS_fitting_output + ".lite";
+
+    if (use_cache) {
+        static_cast<mgb::InFilePersistentCache&>(mgb::PersistentCache::inst())
+                .dump_cache(cache_path.c_str());
+        printf("algo cache: %s\n", cache_path.c_str());
+    }
+
+    //! used by --flagfile, the algos in the cache are not profiled again
+    FILE* fout = fopen(flag_path.c_str(), "w");
+    mgb_assert(fout, "failed to open %s: %s", flag_path.c_str(), strerror(errno));
+    for (auto&& i : best) {
+        if (i.first != "fast_run_algo_policy") {
+            fprintf(fout, "--%s=%s\n", i.first.c_str(), i.second.c_str());
+        }
+    }
+    if (use_cache) {
+        fprintf(fout, "--fast_run_algo_policy=%s\n", cache_path.c_str());
+    }
+    fclose(fout);
+    printf("option file: %s\n", flag_path.c_str());
+
+    if (is_packed_model(m_model_path)) {
+        printf("%s is packed already, the packed model is not dumped\n",
+               m_model_path.c_str());
+        return;
+    }
+    auto model_name = m_model_path.substr(m_model_path.find_last_of("/\\") + 1);
+    lite::ModelPacker packer{m_model_path, model_name};
+    packer.set_info(make_model_info(best, model_name, on_cuda));
+    if (use_cache) {
+        packer.set_algo_cache(cache_path);
+    }
+    packer.pack(packed_model_path);
+    printf("packed model: %s\n", packed_model_path.c_str());
+}
+
 void FittingStrategy::run() {
-    mgb_assert("this version don't support Fitting Strategy");
-};
+    auto v0 = mgb::get_version();
+    auto v1 = megdnn::get_version();
+    printf("megbrain/lite/load_and_run:\nusing MegBrain "
+           "%d.%d.%d(%d) and MegDNN %d.%d.%d\n",
+           v0.major, v0.minor, v0.patch, v0.is_dev, v1.major, v1.minor, v1.patch);
+
+    //! the algos profiled by all candidates are kept in the cache, which
+    //! starts from the cache given by user
+    std::shared_ptr<mgb::InFilePersistentCache> cache;
+    if (!FLAGS_fast_run_algo_policy.empty()) {
+        cache = std::make_shared<mgb::InFilePersistentCache>(
+                FLAGS_fast_run_algo_policy.c_str());
+    } else {
+        cache = std::make_shared<mgb::InFilePersistentCache>();
+    }
+    mgb::PersistentCache::set_impl(cache);
+
+    bool on_cuda = get_flag("cuda") == "true";
+    auto space = make_option_space(on_cuda);
+    FlagValues best{{"fast_run_algo_policy", ""}};
+    for (auto&& dim : space) {
+        printf("\n=== fitting %s\n", dim.name.c_str());
+        std::vector<FlagValues> candidates;
+        for (auto&& choice : dim.choices) {
+            auto flags = best;
+            for (auto&& i : choice) {
+                flags[i.first] = i.second;
+            }
+            candidates.push_back(flags);
+        }
+        best = select(candidates);
+    }
+
+    //! run the best options with a clean cache, so only the algos used by
+    //! them are dumped
+    printf("\n=== best options\n");
+    mgb::PersistentCache::set_impl(std::make_shared<mgb::InFilePersistentCache>());
+    auto time = profile(best, std::max(FLAGS_iter, 1));
+    mgb_assert(!std::isinf(time), "the best options failed when run again");
+    dump_best(best);
+}
 
 DEFINE_bool(
         fitting, false,
         "whether to use the fitting model, which will auto profile and get "
-        "the best option set!");
\ No newline at end of file
+        "the best option set!");
+DEFINE_string(
+        fitting_output, "fitting_best",
+        "path prefix of the outputs of fitting: <prefix>.flags is the option "
+        "file for --flagfile, <prefix>.cache is the fast-run algo cache and "
+        "<prefix>.lite is the model packed with the options and the cache");
+DEFINE_int32(
+        fitting_iter, 3,
+        "iteration number to measure each option set in the first round of "
+        "fitting, which is doubled for the faster half in the next round");
@@ -13,6 +13,7 @@
 #include "megbrain/version.h"
 #include "megdnn/version.h"
 #include "misc.h"
+#include "options/plugin_options.h"
 #include "strategy.h"
 
 using namespace lar;
@@ -52,9 +53,15 @@ void NormalStrategy::run_subline() {
     m_runtime_param.stage = RunStage::BEFORE_MODEL_LOAD;
     stage_config_model();
 
+    BenchReport::Run* report_run = m_report ? &m_report->new_run() : nullptr;
+
     mgb::RealTimer timer;
     model->load_model();
-    printf("load model: %.3fms\n", timer.get_msecs_reset());
+    auto load_time = timer.get_msecs_reset();
+    printf("load model: %.3fms\n", load_time);
+    if (report_run) {
+        report_run->load_ms = load_time;
+    }
 
     //! after load configure
     m_runtime_param.stage = RunStage::AFTER_MODEL_LOAD;
@@ -73,10 +80,18 @@ void NormalStrategy::run_subline() {
     auto warm_up = [&]() {
         auto warmup_num = m_runtime_param.warmup_iter;
         for (size_t i = 0; i < warmup_num; i++) {
-            printf("=== prepare: %.3fms; going to warmup\n\n", timer.get_msecs_reset());
+            auto prepare_time = timer.get_msecs_reset();
+            printf("=== prepare: %.3fms; going to warmup\n\n", prepare_time);
             model->run_model();
             model->wait();
-            printf("warm up %lu  %.3fms\n", i, timer.get_msecs_reset());
+            auto warmup_time = timer.get_msecs_reset();
+            printf("warm up %lu  %.3fms\n", i, warmup_time);
+            if (report_run) {
+                if (!i) {
+                    report_run->prepare_ms = prepare_time;
+                }
+                report_run->warmup_ms.push_back(warmup_time);
+            }
             m_runtime_param.stage = RunStage::AFTER_RUNNING_WAIT;
             stage_config_model();
         }
@@ -86,6 +101,9 @@ void NormalStrategy::run_subline() {
         double time_sqrsum = 0, time_sum = 0,
                min_time = std::numeric_limits<double>::max(), max_time = 0;
         auto run_num = m_runtime_param.run_iter;
+        if (report_run) {
+            report_run->testcases.emplace_back();
+        }
         for (size_t i = 0; i < run_num; i++) {
             timer.reset();
             model->run_model();
@@ -95,6 +113,9 @@ void NormalStrategy::run_subline() {
             stage_config_model();
             auto cur = timer.get_msecs();
             printf("iter %lu/%lu: %.3fms (exec=%.3fms)\n", i, run_num, cur, exec_time);
+            if (report_run) {
+                report_run->testcases.back().emplace_back(cur, exec_time);
+            }
             time_sum += cur;
             time_sqrsum += cur * cur;
             fflush(stdout);
@@ -144,6 +165,9 @@ void NormalStrategy::run() {
            v0.major, v0.minor, v0.patch, v0.is_dev, v1.major, v1.minor, v1.patch);
 
     size_t thread_num = m_runtime_param.threads;
+    if (BenchReport::is_enabled()) {
+        m_report = std::make_unique<BenchReport>(m_model_path, thread_num);
+    }
     auto run_sub = [&]() { run_subline(); };
     if (thread_num == 1) {
         run_sub();
@@ -166,5 +190,16 @@ void NormalStrategy::run() {
     } else {
         mgb_assert(false, "--thread must input a positive number!!");
     }
+    if (m_report) {
+#if MGB_ENABLE_JSON
+        //! the profiling result has been written when the model finished
+        auto profile_path =
+                FLAGS_profile_host.empty() ? FLAGS_profile : FLAGS_profile_host;
+        if (!profile_path.empty()) {
+            m_report->load_profile(profile_path);
+        }
+#endif
+        m_report->write();
+    }
     //! execute before run
 }
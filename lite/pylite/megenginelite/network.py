@@ -356,6 +356,7 @@ class _NetworkAPI(_LiteCObjBase):
         ("LITE_set_network_algo_workspace_limit", [_Cnetwork, c_size_t]),
         ("LITE_share_runtime_memroy", [_Cnetwork, _Cnetwork]),
         ("LITE_enable_profile_performance", [_Cnetwork, c_char_p]),
+        ("LITE_enable_profile_roofline", [_Cnetwork, c_char_p]),
         ("LITE_enable_io_txt_dump", [_Cnetwork, c_char_p]),
         ("LITE_enable_io_bin_dump", [_Cnetwork, c_char_p]),
         ("LITE_set_async_callback", [_Cnetwork, LiteAsyncCallback]),
@@ -580,6 +581,10 @@ class LiteNetwork(object):
         c_file = profile_file.encode("utf-8")
         self._api.LITE_enable_profile_performance(self._network, c_file)
 
+    def enable_profile_roofline(self, roofline_file):
+        c_file = roofline_file.encode("utf-8")
+        self._api.LITE_enable_profile_roofline(self._network, c_file)
+
     def set_network_algo_workspace_limit(self, size_limit):
         self._api.LITE_set_network_algo_workspace_limit(self._network, size_limit)
 
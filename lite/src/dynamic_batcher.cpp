@@ -0,0 +1,326 @@
+/**
+ * \file src/dynamic_batcher.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "lite/dynamic_batcher.h"
+#include "misc.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+using namespace lite;
+
+/*********************** DynamicBatcher::Impl ***************/
+class DynamicBatcher::Impl {
+    struct Plan {
+        size_t batch;
+        std::shared_ptr<Network> network;
+        //! zero tensors of each input with batch size of the plan
+        std::vector<std::shared_ptr<Tensor>> paddings;
+        //! merged inputs of the running batch, whose memory is used by the
+        //! network inputs
+        std::vector<std::shared_ptr<Tensor>> merged_inputs;
+    };
+
+    struct Request {
+        std::vector<std::shared_ptr<Tensor>> inputs;
+        size_t nr_sample;
+        std::promise<Outputs> promise;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    const Options m_options;
+    size_t m_max_batch, m_nr_input, m_nr_output;
+    std::vector<std::shared_ptr<Plan>> m_plans;
+
+    mutable std::mutex m_mtx;
+    std::condition_variable m_cv;
+    std::deque<Request> m_queue;
+    size_t m_nr_queued_sample = 0;
+    bool m_stop = false;
+    Stats m_stats;
+    std::thread m_dispatcher;
+
+    void dispatch();
+    void run_batch(std::vector<Request>& batch, size_t nr_sample);
+
+public:
+    Impl(const std::string& model_path, const Options& options, const Config& config,
+         const NetworkIO& network_io);
+    ~Impl();
+
+    std::future<Outputs> submit(std::vector<std::shared_ptr<Tensor>> inputs);
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> lock{m_mtx};
+        return m_stats;
+    }
+
+    std::shared_ptr<Network> plan_network(size_t batch_size) const {
+        for (auto&& i : m_plans) {
+            if (i->batch == batch_size) {
+                return i->network;
+            }
+        }
+        LITE_THROW(ssprintf("no plan with batch size %zu.", batch_size));
+    }
+};
+
+DynamicBatcher::Impl::Impl(
+        const std::string& model_path, const Options& options, const Config& config,
+        const NetworkIO& network_io)
+        : m_options{options} {
+    auto batch_sizes = options.batch_sizes;
+    std::sort(batch_sizes.begin(), batch_sizes.end());
+    batch_sizes.erase(
+            std::unique(batch_sizes.begin(), batch_sizes.end()), batch_sizes.end());
+    LITE_ASSERT(
+            !batch_sizes.empty() && batch_sizes[0] > 0,
+            "DynamicBatcher needs positive batch sizes.");
+    m_max_batch = batch_sizes.back();
+
+    for (auto batch : batch_sizes) {
+        auto plan = std::make_shared<Plan>();
+        plan->batch = batch;
+        plan->network = std::make_shared<Network>(config, network_io);
+        if (m_plans.empty()) {
+            plan->network->load_model(model_path);
+        } else {
+            Runtime::shared_weight_with_network(plan->network, m_plans[0]->network);
+        }
+        m_plans.push_back(plan);
+    }
+    m_nr_input = m_plans[0]->network->get_all_input_name().size();
+    m_nr_output = m_plans[0]->network->get_all_output_name().size();
+
+    for (auto&& plan : m_plans) {
+        auto&& network = plan->network;
+        plan->merged_inputs.resize(m_nr_input);
+        for (size_t i = 0; i < m_nr_input; ++i) {
+            auto layout = network->get_input_tensor(i)->get_layout();
+            LITE_ASSERT(layout.ndim >= 1, "DynamicBatcher needs batched inputs.");
+            layout.shapes[0] = plan->batch;
+            // on the device of the network input, which the batch is merged to
+            auto input = network->get_input_tensor(i);
+            auto padding = std::make_shared<Tensor>(
+                    input->get_device_id(), input->get_device_type(), layout,
+                    input->is_pinned_host());
+            padding->fill_zero();
+            plan->paddings.push_back(padding);
+            if (options.warmup) {
+                network->get_input_tensor(i)->reset(padding->get_memory_ptr(), layout);
+            }
+        }
+        if (options.warmup) {
+            network->forward();
+            network->wait();
+        }
+    }
+
+    m_dispatcher = std::thread{[this]() { dispatch(); }};
+}
+
+DynamicBatcher::Impl::~Impl() {
+    {
+        std::lock_guard<std::mutex> lock{m_mtx};
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    m_dispatcher.join();
+}
+
+std::future<DynamicBatcher::Outputs> DynamicBatcher::Impl::submit(
+        std::vector<std::shared_ptr<Tensor>> inputs) {
+    LITE_ASSERT(
+            inputs.size() == m_nr_input, "expect %zu inputs, got %zu.", m_nr_input,
+            inputs.size());
+    size_t nr_sample = 0;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        auto layout = inputs[i]->get_layout();
+        LITE_ASSERT(layout.ndim >= 1, "DynamicBatcher needs batched inputs.");
+        if (!i) {
+            nr_sample = layout.shapes[0];
+        }
+        LITE_ASSERT(
+                layout.shapes[0] == nr_sample,
+                "inputs of a request have different batch sizes.");
+    }
+    LITE_ASSERT(
+            nr_sample >= 1 && nr_sample <= m_max_batch,
+            "batch size %zu of the request is not in [1, %zu].", nr_sample,
+            m_max_batch);
+
+    Request req;
+    req.inputs = std::move(inputs);
+    req.nr_sample = nr_sample;
+    req.time = std::chrono::steady_clock::now();
+    auto future = req.promise.get_future();
+    {
+        std::lock_guard<std::mutex> lock{m_mtx};
+        m_queue.push_back(std::move(req));
+        m_nr_queued_sample += nr_sample;
+    }
+    m_cv.notify_all();
+    return future;
+}
+
+void DynamicBatcher::Impl::dispatch() {
+    std::unique_lock<std::mutex> lock{m_mtx};
+    for (;;) {
+        m_cv.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+        if (m_queue.empty()) {
+            return;
+        }
+        auto deadline = m_queue.front().time +
+                        std::chrono::microseconds(m_options.timeout_us);
+        m_cv.wait_until(lock, deadline, [this]() {
+            return m_stop || m_nr_queued_sample >= m_max_batch;
+        });
+
+        std::vector<Request> batch;
+        size_t nr_sample = 0;
+        while (!m_queue.empty() &&
+               nr_sample + m_queue.front().nr_sample <= m_max_batch) {
+            nr_sample += m_queue.front().nr_sample;
+            batch.push_back(std::move(m_queue.front()));
+            m_queue.pop_front();
+        }
+        m_nr_queued_sample -= nr_sample;
+
+        lock.unlock();
+        run_batch(batch, nr_sample);
+        lock.lock();
+    }
+}
+
+void DynamicBatcher::Impl::run_batch(std::vector<Request>& batch, size_t nr_sample) {
+    auto plan_iter = std::find_if(
+            m_plans.begin(), m_plans.end(),
+            [nr_sample](const std::shared_ptr<Plan>& p) { return p->batch >= nr_sample; });
+    LITE_ASSERT(plan_iter != m_plans.end(), "no plan for %zu samples.", nr_sample);
+    auto plan = *plan_iter;
+
+#if LITE_ENABLE_EXCEPTION || __cpp_exceptions || __EXCEPTIONS
+    try {
+#endif
+        auto&& network = plan->network;
+        for (size_t i = 0; i < m_nr_input; ++i) {
+            std::vector<Tensor> parts;
+            for (auto&& req : batch) {
+                parts.push_back(*req.inputs[i]);
+            }
+            if (nr_sample < plan->batch) {
+                parts.push_back(*plan->paddings[i]->slice({0}, {plan->batch - nr_sample}));
+            }
+            auto input = network->get_input_tensor(i);
+            auto merged = TensorUtils::concat(
+                    parts, 0, input->get_device_type(), input->get_device_id());
+            input->reset(merged->get_memory_ptr(), merged->get_layout());
+            plan->merged_inputs[i] = std::move(merged);
+        }
+
+        // the network writes each output to a new buffer, and callers get
+        // slices of it, so the dispatcher never waits for them to release the
+        // memory; the layout is unknown before the first run without warmup
+        std::vector<std::shared_ptr<Tensor>> out_bufs(m_nr_output);
+        for (size_t i = 0; i < m_nr_output; ++i) {
+            auto output = network->get_output_tensor(i);
+            auto layout = output->get_layout();
+            if (layout.ndim) {
+                out_bufs[i] = std::make_shared<Tensor>(
+                        output->get_device_id(), output->get_device_type(), layout,
+                        output->is_pinned_host());
+                output->reset(out_bufs[i]->get_memory_ptr(), layout);
+            }
+        }
+        network->forward();
+        network->wait();
+
+        std::vector<Outputs> outputs(batch.size());
+        for (size_t i = 0; i < m_nr_output; ++i) {
+            auto output = network->get_output_tensor(i);
+            auto layout = output->get_layout();
+            LITE_ASSERT(
+                    layout.ndim >= 1 && layout.shapes[0] == plan->batch,
+                    "output %zu is not batched on dim 0.", i);
+            auto&& buf = out_bufs[i];
+            if (!buf || buf->get_memory_ptr() != output->get_memory_ptr()) {
+                // the output was not written to the buffer, e.g. its layout
+                // changed; copy it out
+                buf = std::make_shared<Tensor>(
+                        output->get_device_id(), output->get_device_type(), layout,
+                        output->is_pinned_host());
+                buf->copy_from(*output);
+            }
+            size_t offset = 0;
+            for (size_t j = 0; j < batch.size(); ++j) {
+                outputs[j].push_back(
+                        buf->slice({offset}, {offset + batch[j].nr_sample}));
+                offset += batch[j].nr_sample;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock{m_mtx};
+            m_stats.nr_request += batch.size();
+            ++m_stats.nr_batch;
+            m_stats.nr_sample += nr_sample;
+            m_stats.nr_padded += plan->batch - nr_sample;
+        }
+        for (size_t i = 0; i < batch.size(); ++i) {
+            batch[i].promise.set_value(std::move(outputs[i]));
+        }
+#if LITE_ENABLE_EXCEPTION
+    } catch (...) {
+        for (auto&& req : batch) {
+            req.promise.set_exception(std::current_exception());
+        }
+    }
+#elif __cpp_exceptions || __EXCEPTIONS
+    } catch (const std::exception& exc) {
+        // the error can not be passed to the callers, so abort instead of
+        // leaving them waiting forever
+        LITE_THROW(ssprintf("DynamicBatcher failed to run a batch: %s", exc.what()));
+    }
+#endif
+}
+
+/*********************** DynamicBatcher ***************/
+DynamicBatcher::DynamicBatcher(
+        const std::string& model_path, const Options& options, const Config& config,
+        const NetworkIO& network_io) {
+    LITE_ERROR_HANDLER_BEGIN
+    m_impl = std::make_unique<Impl>(model_path, options, config, network_io);
+    LITE_ERROR_HANDLER_END
+}
+
+DynamicBatcher::~DynamicBatcher() = default;
+
+std::future<DynamicBatcher::Outputs> DynamicBatcher::submit(
+        std::vector<std::shared_ptr<Tensor>> inputs) {
+    LITE_ERROR_HANDLER_BEGIN
+    return m_impl->submit(std::move(inputs));
+    LITE_ERROR_HANDLER_END
+}
+
+DynamicBatcher::Stats DynamicBatcher::stats() const {
+    return m_impl->stats();
+}
+
+std::shared_ptr<Network> DynamicBatcher::plan_network(size_t batch_size) const {
+    LITE_ERROR_HANDLER_BEGIN
+    return m_impl->plan_network(batch_size);
+    LITE_ERROR_HANDLER_END
+}
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -25,6 +25,7 @@
 #include "megbrain/serialization/extern_c_opr.h"
 #include "megbrain/version.h"
 #include "megbrain/utils/infile_persistent_cache.h"
+#include "megbrain/utils/thread_pool.h"
 #include "mge/common.h"
 #if MGB_ENABLE_TENSOR_RT
 #include "megbrain/tensorrt/tensorrt_engine_cache.h"
@@ -148,6 +149,21 @@ void lite::try_coalesce_all_free_memory() {
     mgb::CompNode::try_coalesce_all_free_memory();
 }
 
+void lite::set_shared_cpu_worker_pool(size_t nr_threads, size_t max_concurrency) {
+#if MGB_HAVE_THREAD
+    if (nr_threads) {
+        mgb::SharedThreadPool::set_global(
+                std::make_shared<mgb::SharedThreadPool>(nr_threads, max_concurrency));
+    } else {
+        mgb::SharedThreadPool::set_global(nullptr);
+    }
+#else
+    LITE_MARK_USED_VAR(nr_threads);
+    LITE_MARK_USED_VAR(max_concurrency);
+    LITE_THROW("thread is disabled at build time.");
+#endif
+}
+
 void lite::set_loader_lib_path(const std::string& loader_path) {
     const char* lib_path = loader_path.c_str();
     LITE_LOG("load a device loader of path %s.", lib_path);
@@ -183,6 +199,13 @@ void lite::dump_persistent_cache(const std::string& cache_path) {
             .dump_cache(cache_path.c_str());
 }
 
+void lite::merge_persistent_cache(const void* cache_data, size_t size) {
+    LITE_LOCK_GUARD(cache_control.cache_mutex);
+    LITE_ASSERT(cache_data && size, "the algo policy cache to merge is empty.");
+    mgb::InFilePersistentCache cache(static_cast<const uint8_t*>(cache_data), size);
+    cache.put_to(mgb::PersistentCache::inst());
+}
+
 //! Set the TensorRT engine cache path for serialized prebuilt ICudaEngine
 void lite::set_tensor_rt_cache(std::string tensorrt_cache_path) {
 #if MGB_ENABLE_TENSOR_RT
@@ -235,6 +258,10 @@ bool lite::clear_memory_pair(
 #else  // LITE_BUILD_WITH_MGE
 void lite::try_coalesce_all_free_memory() {}
 
+void lite::set_shared_cpu_worker_pool(size_t, size_t) {
+    LITE_THROW("mge is disbale at build time, please build with mge");
+}
+
 void lite::set_loader_lib_path(const std::string&) {
     LITE_THROW("mge is disbale at build time, please build with mge");
 }
@@ -247,6 +274,10 @@ void lite::dump_persistent_cache(const std::string&) {
     LITE_THROW("mge is disbale at build time, please build with mge");
 }
 
+void lite::merge_persistent_cache(const void*, size_t) {
+    LITE_THROW("mge is disbale at build time, please build with mge");
+}
+
 //! Set the TensorRT engine cache path for serialized prebuilt ICudaEngine
 void lite::set_tensor_rt_cache(std::string) {
     LITE_THROW("mge is disbale at build time, please build with mge");
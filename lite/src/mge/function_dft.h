@@ -109,6 +109,10 @@ inline void call_func<NetworkImplDft, void>(
         CALL_FUNC(set_cpu_threads_number, num);
     } else if (func_name == "set_network_algo_workspace_limit") {
         CALL_FUNC(set_network_algo_workspace_limit, num);
+    } else if (func_name == "set_cpu_worker_weight") {
+        CALL_FUNC(set_cpu_worker_weight, num);
+    } else if (func_name == "set_memory_budget") {
+        CALL_FUNC(set_memory_budget, num);
     } else {
         THROW_FUNC_ERROR(func_name);
     }
@@ -133,6 +137,8 @@ inline size_t call_func<NetworkImplDft, size_t>(
         std::string func_name, Network::NetworkImplBase* network_impl) {
     if (func_name == "get_cpu_threads_number") {
         return CALL_FUNC(get_cpu_threads_number);
+    } else if (func_name == "get_peak_memory_usage") {
+        return CALL_FUNC(get_peak_memory_usage);
     }
     THROW_FUNC_ERROR(func_name);
 }
@@ -20,6 +20,8 @@
 
 #include "megbrain/graph/cg.h"
 
+#include <atomic>
+
 namespace lite {
 
 class UserStaticMemAlloc final : public mgb::cg::DeviceMemoryAllocator {
@@ -62,6 +64,79 @@ public:
     }
 };
 
+/*!
+ * \brief track the peak of the memory allocated for running a graph
+ *
+ * The static and dynamic allocations are forwarded to the given allocator, or
+ * to the comp node if it is nullptr, and counted until the storage is freed.
+ */
+class PeakMemTracker final : public mgb::cg::DeviceMemoryAllocator {
+    struct Counter {
+        std::atomic_size_t used{0}, peak{0};
+    };
+    std::shared_ptr<mgb::cg::DeviceMemoryAllocator> m_allocator;
+    std::shared_ptr<Counter> m_counter = std::make_shared<Counter>();
+
+    //! allocate by \p fill into a new storage and count it in dest
+    template <typename Fill>
+    void alloc(LDeviceTensorStorage& dest, size_t size, Fill&& fill) {
+        auto cn = dest.comp_node_allow_invalid();
+        LITE_ASSERT(cn.valid(), "The compnode is invalid when alloc memory.");
+        LDeviceTensorStorage storage{cn};
+        if (m_allocator) {
+            fill(storage);
+        } else {
+            storage.ensure_size(size);
+        }
+        auto raw = storage.raw_storage();
+        auto used = m_counter->used.fetch_add(size) + size;
+        auto peak = m_counter->peak.load();
+        while (peak < used && !m_counter->peak.compare_exchange_weak(peak, used))
+            ;
+        dest.reset(
+                cn, size,
+                {raw.get(), [raw, size, counter = m_counter](mgb::dt_byte*) {
+                     counter->used.fetch_sub(size);
+                 }});
+    }
+
+public:
+    PeakMemTracker(std::shared_ptr<mgb::cg::DeviceMemoryAllocator> allocator)
+            : m_allocator{std::move(allocator)} {}
+
+    void alloc_static(
+            LComputingGraph* graph, LDeviceTensorStorage& dest, size_t size) override {
+        if (size <= dest.size()) {
+            return;
+        }
+        alloc(dest, size, [&](LDeviceTensorStorage& storage) {
+            m_allocator->alloc_static(graph, storage, size);
+        });
+    }
+
+    void alloc_dynamic(
+            mgb::VarNode* var, mgb::DeviceTensorStorage& dest, size_t size) override {
+        alloc(dest, size, [&](LDeviceTensorStorage& storage) {
+            m_allocator->alloc_dynamic(var, storage, size);
+        });
+    }
+
+    void defrag_prealloc_contig(
+            mgb::ComputingGraph* graph, mgb::CompNode comp_node,
+            size_t size) override {
+        if (m_allocator) {
+            m_allocator->defrag_prealloc_contig(graph, comp_node, size);
+        } else {
+            DeviceMemoryAllocator::defrag_prealloc_contig(graph, comp_node, size);
+        }
+    }
+
+    //! peak of the memory in use since the last reset_peak()
+    size_t peak() const { return m_counter->peak; }
+
+    void reset_peak() { m_counter->peak = m_counter->used.load(); }
+};
+
 }  // namespace lite
 #endif
 
@@ -62,6 +62,10 @@ void NetworkImplDft::shared_weight_with(const NetworkImplBase* src_network) {
 
     //! replace the IO when there is device input or output
     compile_graph();
+
+    if (m_memory_budget) {
+        fit_memory_budget();
+    }
 }
 
 void NetworkImplDft::application_config() {
@@ -138,6 +142,96 @@ void NetworkImplDft::set_memory_allocator(std::shared_ptr<Allocator> user_alloca
     auto allocator = std::make_shared<UserStaticMemAlloc>(user_allocator);
     LITE_ASSERT(m_load_config.comp_graph);
     m_load_config.comp_graph->set_device_memory_allocator(allocator);
+    m_user_mem_allocator = allocator;
+}
+
+void NetworkImplDft::set_memory_budget(size_t budget) {
+    LITE_ASSERT(budget > 0, "the memory budget must be positive.");
+    m_memory_budget = budget;
+}
+
+size_t NetworkImplDft::get_peak_memory_usage() const {
+    LITE_ASSERT(
+            m_peak_mem_tracker,
+            "the peak memory is only tracked when the memory budget is set.");
+    return m_peak_mem_tracker->peak();
+}
+
+void NetworkImplDft::fit_memory_budget() {
+    m_peak_mem_tracker = std::make_shared<PeakMemTracker>(m_user_mem_allocator);
+    m_load_config.comp_graph->set_device_memory_allocator(m_peak_mem_tracker);
+
+    auto&& options = m_load_config.comp_graph->options();
+    size_t size = 0;
+    auto fits = [&](const char* step) {
+        size = 0;
+        for (auto&& i : m_execute_func->update_static_alloc_plan_and_get_size()) {
+            size += i.second;
+        }
+        LITE_LOG(
+                "static memory of the network is %zu bytes with %s, budget is %zu "
+                "bytes",
+                size, step, m_memory_budget);
+        return size <= m_memory_budget;
+    };
+    auto recompile = [this]() {
+        m_execute_func = m_load_result.graph_compile(m_output_spec);
+    };
+    if (fits("the default options")) {
+        return;
+    }
+
+    //! 1. choose algos with smaller workspace
+    for (size_t limit : {m_memory_budget / 4, m_memory_budget / 16, size_t(0)}) {
+        set_network_algo_workspace_limit(limit);
+        recompile();
+        if (fits("limited algo workspace")) {
+            return;
+        }
+    }
+
+    //! the workspace limit stays 0 for the steps below, and the budget left
+    //! after a step fits is given back to the algo workspace if possible
+    auto fits_relaxed = [&](const char* step) {
+        if (!fits(step)) {
+            return false;
+        }
+        if (size == m_memory_budget) {
+            return true;
+        }
+        set_network_algo_workspace_limit(m_memory_budget - size);
+        recompile();
+        if (fits("algo workspace in the remaining budget")) {
+            return true;
+        }
+        set_network_algo_workspace_limit(0);
+        recompile();
+        return fits(step);
+    };
+
+#if MGB_ENABLE_SUBLINEAR
+    //! 2. recompute vars instead of keeping them alive, the memory below the
+    //! budget is used to recompute less
+    options.enable_sublinear_memory_opt = true;
+    options.sublinear_mem_config.lb_memory_mb =
+            static_cast<int>(m_memory_budget >> 20);
+    recompile();
+    if (fits_relaxed("sublinear memory optimization")) {
+        return;
+    }
+#endif
+
+    //! 3. spend more time on planning the static memory
+    options.seq_opt.enable_mem_alloc_algo_search = true;
+    recompile();
+    if (fits_relaxed("static memory allocation algo search")) {
+        return;
+    }
+
+    LITE_THROW(ssprintf(
+            "the network needs %zu bytes of static memory, which exceeds the "
+            "memory budget of %zu bytes.",
+            size, m_memory_budget));
 }
 
 //! share the runtime memory with other network, the weights is not shared
@@ -191,6 +285,19 @@ void NetworkImplDft::set_runtime_thread_affinity(
     }
 }
 
+void NetworkImplDft::set_cpu_worker_weight(size_t weight) {
+    LITE_ASSERT(
+            m_user_config->device_type == LiteDeviceType::LITE_CPU,
+            "multi threads mode is only avaliable in CPU.");
+    LITE_ASSERT(weight >= 1, "the cpu worker weight must be positive.");
+    if (m_nr_threads > 1) {
+        mgb::CompNode::Locator loc;
+        m_load_config.comp_node_mapper(loc);
+        auto cn = mgb::CompNode::load(loc);
+        mgb::CompNodeEnv::from_comp_node(cn).cpu_env().set_thread_pool_weight(weight);
+    }
+}
+
 void NetworkImplDft::set_device_id(int device_id) {
     m_compnode_locator.device = device_id;
     m_user_config->device_id = device_id;
@@ -405,6 +512,13 @@ void NetworkImplDft::load_model(
         separate_config_map["use_tensorrt"].safe_cast<bool>()) {
         use_tensorrt();
     }
+    if (separate_config_map.find("use_algo_cache") != separate_config_map.end() &&
+        separate_config_map["use_algo_cache"].safe_cast<bool>() &&
+        !static_cast<uint32_t>(m_execution_policy)) {
+        //! choose algos from the packed cache first, then by heuristic
+        using S = megdnn::param::ExecutionPolicy::Strategy;
+        m_execution_policy = S::PROFILE | S::HEURISTIC;
+    }
 
     m_load_result = m_loader->load(m_load_config, true);
 
@@ -419,6 +533,10 @@ void NetworkImplDft::load_model(
 
     //! replace the IO when there is device input or output
     compile_graph();
+
+    if (m_memory_budget) {
+        fit_memory_budget();
+    }
 }
 
 void NetworkImplDft::compile_graph() {
@@ -863,6 +981,20 @@ void NetworkImplDft::enable_profile_performance(std::string profile_json_file) {
 #endif
 }
 
+void NetworkImplDft::enable_profile_roofline(std::string roofline_json_file) {
+#if MGB_ENABLE_JSON
+    // the profiler is shared with enable_profile_performance
+    if (!m_profiler) {
+        m_profiler =
+                std::make_unique<mgb::GraphProfiler>(m_load_config.comp_graph.get());
+    }
+    m_roofline_output_file = roofline_json_file;
+#else
+    LITE_MARK_USED_VAR(roofline_json_file);
+    LITE_THROW("JSON is disable at compile time.");
+#endif
+}
+
 void NetworkImplDft::enable_io_txt_dump(std::string io_txt_out_file) {
     auto iodump = std::make_unique<mgb::TextOprIODump>(
             m_load_config.comp_graph.get(), io_txt_out_file.c_str());
@@ -878,8 +1010,18 @@ void NetworkImplDft::enable_io_bin_dump(std::string io_bin_out_dir) {
 void inline NetworkImplDft::output_plugin_result() const {
 #if MGB_ENABLE_JSON
     if (m_profiler && m_execute_func) {
-        m_profiler->to_json_full(m_execute_func.get())
-                ->writeto_fpath(m_profiler_output_file);
+        if (!m_profiler_output_file.empty()) {
+            m_profiler->to_json_full(m_execute_func.get())
+                    ->writeto_fpath(m_profiler_output_file);
+        }
+        if (!m_roofline_output_file.empty()) {
+            if (!m_roofline_peak.valid()) {
+                m_roofline_peak = mgb::RooflinePeak::measure(
+                        mgb::CompNode::load(m_compnode_locator));
+            }
+            m_profiler->roofline_json(m_roofline_peak.val())
+                    ->writeto_fpath(m_roofline_output_file);
+        }
     }
 #endif
 }
@@ -33,6 +33,8 @@
 
 namespace lite {
 
+class PeakMemTracker;
+
 /*!
  * \brief implement the Network, contain the mgb related member
  */
@@ -136,6 +138,9 @@ public:
     //! enable profile the network, a JSON format file will be generated
     void enable_profile_performance(std::string profile_json_file_path) override;
 
+    //! enable roofline analysis, a JSON format file will be generated
+    void enable_profile_roofline(std::string roofline_json_file_path) override;
+
     /********************** mge special function ************************/
     //! load a new network which will share weights with src network
     void shared_weight_with(const NetworkImplBase* src_network);
@@ -146,9 +151,18 @@ public:
     void set_runtime_thread_affinity(
             const ThreadAffinityCallback& thread_affinity_callback);
 
+    //! set the weight of the network in the shared cpu worker pool
+    void set_cpu_worker_weight(size_t weight);
+
     //! set the network memroy allocator, the allocator is defined by user
     void set_memory_allocator(std::shared_ptr<Allocator> user_allocator);
 
+    //! set the budget in bytes of the memory used by running the network
+    void set_memory_budget(size_t budget);
+
+    //! get the peak of the memory used by running the network
+    size_t get_peak_memory_usage() const;
+
     //! set opr algorithm selection strategy in the network
     void set_network_algo_policy(
             LiteAlgoSelectStrategy strategy, uint32_t shared_batch_size,
@@ -226,6 +240,10 @@ private:
     //! adapt option valid, it should call after update_io
     void adapt_option_valid();
 
+    //! make the static memory of the network fit in m_memory_budget, by
+    //! trading speed for memory step by step
+    void fit_memory_budget();
+
 private:
     bool m_async = false;
     bool m_is_cpu_inplace_mode = false;
@@ -233,6 +251,7 @@ private:
     size_t m_nr_threads = 1;
     bool m_compute_configured_output_only = false;
     bool m_set_layout_transform = false;
+    size_t m_memory_budget = 0;
     mgb::CompNode::Locator m_compnode_locator;
 
     AsyncCallback m_async_callback = nullptr;
@@ -251,6 +270,11 @@ private:
     mgb::ComputingGraph::OutputSpec m_output_spec;
     std::shared_ptr<mgb::serialization::GraphLoader> m_loader;
 
+    //! allocator set by set_memory_allocator and the tracker wrapping it in
+    //! memory budget mode
+    std::shared_ptr<mgb::cg::DeviceMemoryAllocator> m_user_mem_allocator;
+    std::shared_ptr<PeakMemTracker> m_peak_mem_tracker;
+
     //! start and finish callback
     StartCallback m_start_callback = nullptr;
     FinishCallback m_finish_callback = nullptr;
@@ -259,6 +283,9 @@ private:
 #if MGB_ENABLE_JSON
     std::unique_ptr<mgb::GraphProfiler> m_profiler;
     std::string m_profiler_output_file;
+    std::string m_roofline_output_file;
+    //! peaks of the device, measured at the first output of roofline
+    mutable mgb::Maybe<mgb::RooflinePeak> m_roofline_peak;
 #endif
     std::unique_ptr<mgb::OprIODumpBase> m_iodump;
 };
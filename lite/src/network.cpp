@@ -100,6 +100,10 @@ void Network::prase_model(std::shared_ptr<void> model_data, size_t size) {
         m_impl->set_config(m_config);
         m_impl->set_io(m_network_io);
     }
+    //! the algo policy cache packed with the model is used when choosing algos
+    if (model_parser.parse_algo_cache()) {
+        separate_config_map["use_algo_cache"] = true;
+    }
     //! decryption the model
     size_t model_length;
     auto&& model_shared_ptr = model_parser.parse_model(model_length, m_config);
@@ -275,6 +279,12 @@ void Network::enable_profile_performance(std::string profile_file_path) {
     LITE_ERROR_HANDLER_END
 }
 
+void Network::enable_profile_roofline(std::string roofline_file_path) {
+    LITE_ERROR_HANDLER_BEGIN
+    m_impl->enable_profile_roofline(roofline_file_path);
+    LITE_ERROR_HANDLER_END
+}
+
 const std::string& Network::get_model_extra_info() {
     LITE_ERROR_HANDLER_BEGIN
     return m_extra_info;
@@ -363,6 +373,20 @@ void Runtime::set_runtime_thread_affinity(
     LITE_ERROR_HANDLER_END
 }
 
+void Runtime::set_cpu_worker_weight(std::shared_ptr<Network> network, size_t weight) {
+    LITE_ERROR_HANDLER_BEGIN
+    auto network_impl = NetworkHelper::implement(network);
+    if (network_impl->get_backend_type() == LiteBackend::LITE_DEFAULT) {
+        LITE_ASSERT(
+                NetworkHelper::loaded(network),
+                "set_cpu_worker_weight should be used after model loaded.");
+        call_func<NetworkImplDft, void>("set_cpu_worker_weight", network_impl, weight);
+        return;
+    }
+    LITE_THROW("set_cpu_worker_weight is not aviliable in the backend.");
+    LITE_ERROR_HANDLER_END
+}
+
 void Runtime::set_cpu_inplace_mode(std::shared_ptr<Network> network) {
     LITE_ERROR_HANDLER_BEGIN
     auto network_impl = NetworkHelper::implement(network);
@@ -440,6 +464,31 @@ void Runtime::set_memory_allocator(
     LITE_ERROR_HANDLER_END
 }
 
+void Runtime::set_memory_budget(std::shared_ptr<Network> network, size_t budget) {
+    LITE_ERROR_HANDLER_BEGIN
+    auto network_impl = NetworkHelper::implement(network);
+    if (network_impl->get_backend_type() == LiteBackend::LITE_DEFAULT) {
+        LITE_ASSERT(
+                !NetworkHelper::loaded(network),
+                "set_memory_budget should be used before model loaded.");
+        call_func<NetworkImplDft, void>("set_memory_budget", network_impl, budget);
+        return;
+    }
+    LITE_THROW("set_memory_budget is not aviliable in the backend.");
+    LITE_ERROR_HANDLER_END
+}
+
+size_t Runtime::get_peak_memory_usage(std::shared_ptr<Network> network) {
+    LITE_ERROR_HANDLER_BEGIN
+    auto network_impl = NetworkHelper::implement(network);
+    if (network_impl->get_backend_type() == LiteBackend::LITE_DEFAULT) {
+        return call_func<NetworkImplDft, size_t>(
+                "get_peak_memory_usage", network_impl);
+    }
+    LITE_THROW("get_peak_memory_usage is not aviliable in the backend.");
+    LITE_ERROR_HANDLER_END
+}
+
 void Runtime::share_runtime_memory_with(
         std::shared_ptr<Network> dst_network, std::shared_ptr<Network> src_network) {
     LITE_ERROR_HANDLER_BEGIN
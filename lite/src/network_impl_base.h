@@ -126,6 +126,14 @@ public:
     //! enable profile the network, a file will be generated
     virtual void enable_profile_performance(std::string profile_file_path) = 0;
 
+    //! enable roofline analysis of the network, a file will be generated
+    virtual void enable_profile_roofline(std::string roofline_file_path) {
+        LITE_MARK_USED_VAR(roofline_file_path);
+        LITE_THROW(
+                "This nerworkimpl doesn't support enable_profile_roofline() "
+                "function.");
+    }
+
     //! get static peak memory info showed by Graph visualization
     virtual void get_static_memory_alloc_info(const std::string& log_dir) const {
         LITE_MARK_USED_VAR(log_dir);
@@ -0,0 +1,190 @@
+/**
+ * \file src/network_pool.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "lite/network_pool.h"
+#include "misc.h"
+
+#include <algorithm>
+#include <future>
+
+using namespace lite;
+
+/*********************** NetworkPool::FreeList ***************/
+void NetworkPool::FreeList::init(size_t size) {
+    m_next.reset(new std::atomic<uint32_t>[size]);
+    for (size_t i = 0; i < size; ++i) {
+        m_next[i] = 0;
+    }
+    m_head = 0;
+}
+
+void NetworkPool::FreeList::push(uint32_t idx) {
+    uint64_t head = m_head.load(), new_head;
+    do {
+        m_next[idx] = static_cast<uint32_t>(head);
+        new_head = (((head >> 32) + 1) << 32) | (idx + 1);
+    } while (!m_head.compare_exchange_weak(head, new_head));
+}
+
+int64_t NetworkPool::FreeList::pop() {
+    uint64_t head = m_head.load(), new_head;
+    uint32_t top;
+    do {
+        top = static_cast<uint32_t>(head);
+        if (!top) {
+            return -1;
+        }
+        // m_next may be stale if the top has been popped and pushed again
+        // concurrently, in which case the tag makes the CAS fail
+        new_head = (((head >> 32) + 1) << 32) | m_next[top - 1];
+    } while (!m_head.compare_exchange_weak(head, new_head));
+    return top - 1;
+}
+
+/*********************** NetworkPool ***************/
+std::shared_ptr<NetworkPool> NetworkPool::make(
+        const std::string& model_path, const Options& options, const Config& config,
+        const NetworkIO& network_io) {
+    LITE_ERROR_HANDLER_BEGIN
+    size_t nr_instance = options.nr_instance;
+    LITE_ASSERT(nr_instance >= 1, "NetworkPool needs at least one instance.");
+    bool is_cpu = config.device_type == LiteDeviceType::LITE_CPU;
+    LITE_ASSERT(
+            is_cpu || !options.nr_total_threads,
+            "thread budget of NetworkPool is only available on CPU.");
+
+    std::shared_ptr<NetworkPool> pool{new NetworkPool};
+    for (size_t i = 0; i < nr_instance; ++i) {
+        size_t nr_threads = 1;
+        if (options.nr_total_threads) {
+            nr_threads = options.nr_total_threads / nr_instance +
+                         (i < options.nr_total_threads % nr_instance);
+            nr_threads = std::max<size_t>(nr_threads, 1);
+        }
+        // instances use separate comp nodes to run concurrently
+        auto instance_config = config;
+        if (is_cpu) {
+            instance_config.device_id = config.device_id + i;
+        }
+        auto network = std::make_shared<Network>(instance_config, network_io);
+        if (!is_cpu) {
+            network->set_stream_id(i);
+        } else if (nr_threads > 1) {
+            Runtime::set_cpu_threads_number(network, nr_threads);
+        }
+        if (!i) {
+            network->load_model(model_path);
+        } else {
+            Runtime::shared_weight_with_network(network, pool->m_instances[0]);
+        }
+        pool->m_instances.push_back(std::move(network));
+        pool->m_nr_threads.push_back(nr_threads);
+    }
+
+    pool->m_free_list.init(nr_instance);
+    for (size_t i = nr_instance; i; --i) {
+        pool->m_free_list.push(i - 1);
+    }
+    return pool;
+    LITE_ERROR_HANDLER_END
+}
+
+NetworkPool::~NetworkPool() = default;
+
+std::shared_ptr<Network> NetworkPool::lease(size_t idx) {
+    auto self = shared_from_this();
+    return {m_instances[idx].get(), [self, idx](Network*) { self->release(idx); }};
+}
+
+void NetworkPool::release(size_t idx) {
+    if (m_nr_pending.load()) {
+        std::unique_lock<std::mutex> lock{m_pending_mtx};
+        if (!m_pending.empty()) {
+            auto callback = std::move(m_pending.front());
+            m_pending.pop_front();
+            --m_nr_pending;
+            lock.unlock();
+            callback(lease(idx));
+            return;
+        }
+    }
+    m_free_list.push(idx);
+    // a request may have been queued after the check above and found the free
+    // list empty; both the push and the counter are seq_cst, so either that
+    // request sees the instance or we see the request here
+    if (m_nr_pending.load()) {
+        serve_pending();
+    }
+}
+
+void NetworkPool::serve_pending() {
+    for (;;) {
+        std::unique_lock<std::mutex> lock{m_pending_mtx};
+        if (m_pending.empty()) {
+            return;
+        }
+        auto idx = m_free_list.pop();
+        if (idx < 0) {
+            return;
+        }
+        auto callback = std::move(m_pending.front());
+        m_pending.pop_front();
+        --m_nr_pending;
+        lock.unlock();
+        callback(lease(idx));
+    }
+}
+
+std::shared_ptr<Network> NetworkPool::try_acquire() {
+    auto idx = m_free_list.pop();
+    if (idx < 0) {
+        return {};
+    }
+    return lease(idx);
+}
+
+void NetworkPool::acquire_async(AcquireCallback callback) {
+    LITE_ERROR_HANDLER_BEGIN
+    LITE_ASSERT(callback, "acquire_async needs a callback.");
+    // do not overtake earlier pending requests
+    if (!m_nr_pending.load()) {
+        if (auto network = try_acquire()) {
+            callback(std::move(network));
+            return;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock{m_pending_mtx};
+        m_pending.push_back(std::move(callback));
+        ++m_nr_pending;
+    }
+    // an instance may have been released before the callback is queued
+    serve_pending();
+    LITE_ERROR_HANDLER_END
+}
+
+std::shared_ptr<Network> NetworkPool::acquire() {
+    LITE_ERROR_HANDLER_BEGIN
+    if (!m_nr_pending.load()) {
+        if (auto network = try_acquire()) {
+            return network;
+        }
+    }
+    std::promise<std::shared_ptr<Network>> promise;
+    auto future = promise.get_future();
+    acquire_async([&promise](std::shared_ptr<Network> network) {
+        promise.set_value(std::move(network));
+    });
+    return future.get();
+    LITE_ERROR_HANDLER_END
+}
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -128,6 +128,20 @@ bool default_parse_info(
             config.options.graph_opt_level = options["graph_opt_level"];
         if (options.contains("async_exec_level"))
             config.options.async_exec_level = options["async_exec_level"];
+        if (options.contains("enable_nchw44"))
+            config.options.enable_nchw44 = options["enable_nchw44"];
+        if (options.contains("enable_nchw44_dot"))
+            config.options.enable_nchw44_dot = options["enable_nchw44_dot"];
+        if (options.contains("enable_nchw88"))
+            config.options.enable_nchw88 = options["enable_nchw88"];
+        if (options.contains("enable_nhwcd4"))
+            config.options.enable_nhwcd4 = options["enable_nhwcd4"];
+        if (options.contains("enable_nchw4"))
+            config.options.enable_nchw4 = options["enable_nchw4"];
+        if (options.contains("enable_nchw32"))
+            config.options.enable_nchw32 = options["enable_nchw32"];
+        if (options.contains("enable_nchw64"))
+            config.options.enable_nchw64 = options["enable_nchw64"];
     }
     //! IO
     auto get_io_type = [](std::string type) -> LiteIOType {
@@ -0,0 +1,90 @@
+/**
+ * \file src/parse_model/model_packer.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "lite/pack_model.h"
+#include "../misc.h"
+#include "model_parser.h"
+
+#include <string.h>
+
+using namespace lite;
+using namespace model_parse;
+
+namespace {
+std::vector<uint8_t> read_file(const std::string& path) {
+    FILE* fin = fopen(path.c_str(), "rb");
+    LITE_ASSERT(fin, "failed to open %s: %s", path.c_str(), strerror(errno));
+    fseek(fin, 0, SEEK_END);
+    size_t size = ftell(fin);
+    fseek(fin, 0, SEEK_SET);
+    std::vector<uint8_t> buf(size);
+    auto nr = fread(buf.data(), 1, size, fin);
+    fclose(fin);
+    LITE_ASSERT(nr == size, "failed to read %s.", path.c_str());
+    return buf;
+}
+}  // namespace
+
+ModelPacker::ModelPacker(const std::string& model_path, const std::string& model_name)
+        : m_model_name{model_name} {
+    LITE_ERROR_HANDLER_BEGIN
+    m_model = read_file(model_path);
+    auto&& tag = ModelParser::model_tag();
+    LITE_ASSERT(
+            m_model.size() < tag.size() || memcmp(m_model.data(), tag.data(), tag.size()),
+            "%s is packed already.", model_path.c_str());
+    LITE_ERROR_HANDLER_END
+}
+
+void ModelPacker::set_info(const std::string& info, const std::string& parse_method) {
+    m_info = info;
+    m_info_parse_method = parse_method;
+}
+
+void ModelPacker::set_algo_cache(const std::string& cache_path) {
+    LITE_ERROR_HANDLER_BEGIN
+    m_algo_cache = read_file(cache_path);
+    LITE_ERROR_HANDLER_END
+}
+
+void ModelPacker::pack(const std::string& packed_model_path) const {
+    LITE_ERROR_HANDLER_BEGIN
+    flatbuffers::FlatBufferBuilder builder;
+    auto info_parse_method = m_info.empty() ? "NONE" : m_info_parse_method.c_str();
+    auto header = CreateModelHeaderDirect(
+            builder, m_model_name.c_str(), "NONE", info_parse_method, "NONE");
+    flatbuffers::Offset<ModelInfo> info;
+    if (!m_info.empty()) {
+        std::vector<uint8_t> info_data(m_info.begin(), m_info.end());
+        info = CreateModelInfoDirect(builder, &info_data);
+    }
+    auto data = CreateModelDataDirect(builder, &m_model);
+    flatbuffers::Offset<ModelAlgoCache> algo_cache;
+    if (!m_algo_cache.empty()) {
+        algo_cache = CreateModelAlgoCacheDirect(builder, &m_algo_cache);
+    }
+    std::vector<flatbuffers::Offset<Model>> models{
+            CreateModel(builder, header, info, data, algo_cache)};
+    builder.Finish(CreatePackModelDirect(builder, &models));
+
+    FILE* fout = fopen(packed_model_path.c_str(), "wb");
+    LITE_ASSERT(
+            fout, "failed to open %s: %s", packed_model_path.c_str(), strerror(errno));
+    auto&& tag = ModelParser::model_tag();
+    bool ok = fwrite(tag.data(), 1, tag.size(), fout) == tag.size();
+    ok = ok && fwrite(builder.GetBufferPointer(), 1, builder.GetSize(), fout) ==
+                       builder.GetSize();
+    fclose(fout);
+    LITE_ASSERT(ok, "failed to write %s.", packed_model_path.c_str());
+    LITE_ERROR_HANDLER_END
+}
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
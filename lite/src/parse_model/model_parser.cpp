@@ -44,6 +44,7 @@ void ModelParser::parse_header() {
 
     m_info = model->info();
     m_model_data = model->data();
+    m_algo_cache = model->algo_cache();
 }
 
 bool ModelParser::parse_model_info(
@@ -103,6 +104,15 @@ std::shared_ptr<void> ModelParser::parse_model(
             model_data, model_length, m_model_decryption_name, model_length);
 }
 
+bool ModelParser::parse_algo_cache() const {
+    if (m_is_bare_model || !m_algo_cache || !m_algo_cache->data() ||
+        !m_algo_cache->data()->size()) {
+        return false;
+    }
+    merge_persistent_cache(m_algo_cache->data()->Data(), m_algo_cache->data()->size());
+    return true;
+}
+
 std::shared_ptr<void> ModelParser::decrypt_memory(
         const uint8_t* data, size_t length, const std::string decryption_name,
         size_t& result_length) const {
@@ -41,6 +41,13 @@ public:
     //! parse the model and decrypt the model
     std::shared_ptr<void> parse_model(size_t& model_length, const Config& config) const;
 
+    //! the tag at the beginning of a packed model
+    static const std::string& model_tag() { return sm_model_tag; }
+
+    //! merge the algo policy cache packed with the model into the
+    //! PersistentCache, return false if there is no cache packed
+    bool parse_algo_cache() const;
+
 private:
     //! parse the header of the model and store the model related information
     //! to the menber data
@@ -66,6 +73,7 @@ private:
 
     const model_parse::ModelInfo* m_info = nullptr;
     const model_parse::ModelData* m_model_data = nullptr;
+    const model_parse::ModelAlgoCache* m_algo_cache = nullptr;
 
     std::shared_ptr<void> m_model;
     size_t m_total_length;
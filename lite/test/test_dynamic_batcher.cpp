@@ -0,0 +1,111 @@
+/**
+ * \file test/test_dynamic_batcher.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "lite_build_config.h"
+
+#if LITE_BUILD_WITH_MGE
+#include "./test_common.h"
+#include "lite/dynamic_batcher.h"
+
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace lite;
+
+TEST(TestDynamicBatcher, MergeRequests) {
+    Config config;
+    auto lite_tensor = get_input_data("./input_data.npy");
+    std::string model_path = "./shufflenet.mge";
+    auto result_mgb = mgb_lar(model_path, config, "data", lite_tensor);
+
+    DynamicBatcher::Options options;
+    options.batch_sizes = {2, 4};
+    // long enough for both requests to be merged
+    options.timeout_us = 1000 * 1000;
+    DynamicBatcher batcher{model_path, options, config};
+    auto f0 = batcher.submit({lite_tensor});
+    auto f1 = batcher.submit({lite_tensor});
+    auto out0 = f0.get(), out1 = f1.get();
+    ASSERT_EQ(1u, out0.size());
+    ASSERT_EQ(1u, out1.size());
+    compare_lite_tensor<float>(out0[0], result_mgb);
+    compare_lite_tensor<float>(out1[0], result_mgb);
+
+    auto stats = batcher.stats();
+    ASSERT_EQ(2u, stats.nr_request);
+    ASSERT_EQ(1u, stats.nr_batch);
+    ASSERT_EQ(0u, stats.nr_padded);
+
+    // holding the outputs does not block the next batch on the same plan
+    auto f2 = batcher.submit({lite_tensor});
+    auto f3 = batcher.submit({lite_tensor});
+    compare_lite_tensor<float>(f2.get()[0], result_mgb);
+    compare_lite_tensor<float>(f3.get()[0], result_mgb);
+    compare_lite_tensor<float>(out0[0], result_mgb);
+}
+
+TEST(TestDynamicBatcher, Padding) {
+    Config config;
+    auto lite_tensor = get_input_data("./input_data.npy");
+    std::string model_path = "./shufflenet.mge";
+    auto result_mgb = mgb_lar(model_path, config, "data", lite_tensor);
+
+    DynamicBatcher::Options options;
+    options.batch_sizes = {4};
+    options.timeout_us = 100;
+    DynamicBatcher batcher{model_path, options, config};
+    auto out = batcher.run({lite_tensor});
+    compare_lite_tensor<float>(out[0], result_mgb);
+    auto stats = batcher.stats();
+    ASSERT_EQ(1u, stats.nr_batch);
+    ASSERT_EQ(3u, stats.nr_padded);
+}
+
+TEST(TestDynamicBatcher, SyntheticLoad) {
+    Config config;
+    auto lite_tensor = get_input_data("./input_data.npy");
+    std::string model_path = "./shufflenet.mge";
+    auto result_mgb = mgb_lar(model_path, config, "data", lite_tensor);
+
+    DynamicBatcher::Options options;
+    options.batch_sizes = {1, 2, 4, 8};
+    options.timeout_us = 500;
+    DynamicBatcher batcher{model_path, options, config};
+
+    // clients sending batch-1 requests with random intervals
+    constexpr size_t NR_CLIENT = 8, NR_REQUEST = 5;
+    std::vector<std::thread> clients;
+    for (size_t i = 0; i < NR_CLIENT; ++i) {
+        clients.emplace_back([&, i]() {
+            std::mt19937 rng(i);
+            std::uniform_int_distribution<int> interval_us(0, 1000);
+            for (size_t j = 0; j < NR_REQUEST; ++j) {
+                std::this_thread::sleep_for(std::chrono::microseconds(interval_us(rng)));
+                auto out = batcher.run({lite_tensor});
+                compare_lite_tensor<float>(out[0], result_mgb);
+            }
+        });
+    }
+    for (auto&& i : clients) {
+        i.join();
+    }
+
+    auto stats = batcher.stats();
+    ASSERT_EQ(NR_CLIENT * NR_REQUEST, stats.nr_request);
+    ASSERT_EQ(NR_CLIENT * NR_REQUEST, stats.nr_sample);
+    ASSERT_LE(stats.nr_batch, stats.nr_request);
+}
+
+#endif
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -13,6 +13,8 @@
 
 #if LITE_BUILD_WITH_MGE
 #include "./test_common.h"
+#include "lite/global.h"
+#include "lite/pack_model.h"
 #include "megbrain/tensor.h"
 
 #ifndef WIN32
@@ -22,7 +24,10 @@
 
 #include <chrono>
 #include <memory>
+#include <mutex>
 #include <random>
+#include <set>
+#include <thread>
 #include <unordered_map>
 using namespace lite;
 
@@ -296,6 +301,88 @@ TEST(TestNetWork, ThreadAffinity) {
     compare_lite_tensor<float>(output_tensor, result_mgb);
 }
 
+TEST(TestNetWork, SharedCpuWorkerPool) {
+    Config config;
+    auto lite_tensor = get_input_data("./input_data.npy");
+    std::string model_path = "./shufflenet.mge";
+    auto result_mgb = mgb_lar(model_path, config, "data", lite_tensor);
+
+    constexpr size_t NR_NETWORK = 3, NR_SHARED_THREAD = 2;
+    set_shared_cpu_worker_pool(NR_SHARED_THREAD);
+    std::vector<std::shared_ptr<Network>> networks;
+    for (size_t i = 0; i < NR_NETWORK; ++i) {
+        // comp nodes are cached, so use device ids not loaded by other cases
+        config.device_id = 17 + i;
+        auto network = std::make_shared<Network>(config);
+        Runtime::set_cpu_threads_number(network, 4);
+        network->load_model(model_path);
+        Runtime::set_cpu_worker_weight(network, i + 1);
+        networks.push_back(network);
+    }
+    set_shared_cpu_worker_pool(0);
+
+    std::mutex mtx;
+    std::set<std::thread::id> worker_ids;
+    Runtime::set_runtime_thread_affinity(networks[0], [&](int id) {
+        if (static_cast<size_t>(id) < NR_SHARED_THREAD) {
+            std::lock_guard<std::mutex> lock{mtx};
+            worker_ids.insert(std::this_thread::get_id());
+        }
+    });
+
+    std::vector<std::thread> threads;
+    for (auto&& network : networks) {
+        threads.emplace_back([&, network]() {
+            for (int run = 0; run < 3; ++run) {
+                auto input_tensor = network->get_input_tensor(0);
+                input_tensor->reset(
+                        lite_tensor->get_memory_ptr(), lite_tensor->get_layout());
+                network->forward();
+                network->wait();
+                compare_lite_tensor<float>(network->get_output_tensor(0), result_mgb);
+            }
+        });
+    }
+    for (auto&& i : threads) {
+        i.join();
+    }
+    // the affinity set on one network binds the workers shared by all
+    std::lock_guard<std::mutex> lock{mtx};
+    ASSERT_EQ(NR_SHARED_THREAD, worker_ids.size());
+}
+
+TEST(TestNetWork, MemoryBudget) {
+    Config config;
+    auto lite_tensor = get_input_data("./input_data.npy");
+    std::string model_path = "./shufflenet.mge";
+    auto result_mgb = mgb_lar(model_path, config, "data", lite_tensor);
+
+    auto run = [&](size_t budget) {
+        auto network = std::make_shared<Network>(config);
+        Runtime::set_memory_budget(network, budget);
+        network->load_model(model_path);
+        auto input_tensor = network->get_input_tensor(0);
+        input_tensor->reset(lite_tensor->get_memory_ptr(), lite_tensor->get_layout());
+        network->forward();
+        network->wait();
+        compare_lite_tensor<float>(network->get_output_tensor(0), result_mgb);
+        return Runtime::get_peak_memory_usage(network);
+    };
+
+    size_t budget = 1024 * 1024 * 1024;
+    auto peak = run(budget);
+    ASSERT_GT(peak, 0u);
+    ASSERT_LE(peak, budget);
+
+    // the achieved peak is a budget that can be met
+    ASSERT_LE(run(peak), peak);
+
+    // fail on loading if the budget can not be met
+    auto network = std::make_shared<Network>(config);
+    Runtime::set_memory_budget(network, 1);
+    ASSERT_THROW(network->load_model(model_path), std::exception);
+}
+
 TEST(TestNetWork, BasicCryptAes) {
     Config config;
     auto lite_tensor = get_input_data("./input_data.npy");
@@ -890,6 +977,29 @@ TEST(TestNetWork, ProfileIOdump) {
     ASSERT_TRUE(fopen("./io_txt_dump.txt", "r"));
 }
 
+TEST(TestNetWork, ProfileRoofline) {
+    auto tensor = get_input_data("./input_data.npy");
+    std::string model_path = "./shufflenet.mge";
+    std::string input_name = "data";
+
+    NetworkIO IO;
+    Config config;
+    std::shared_ptr<Network> network = std::make_shared<Network>(config, IO);
+    network->enable_profile_performance("./profile.json");
+    network->enable_profile_roofline("./roofline.json");
+    network->load_model(model_path);
+    std::shared_ptr<Tensor> input_tensor = network->get_io_tensor(input_name);
+
+    auto src_ptr = tensor->get_memory_ptr();
+    auto src_layout = tensor->get_layout();
+    input_tensor->reset(src_ptr, src_layout);
+
+    network->forward();
+    network->wait();
+    ASSERT_TRUE(fopen("./profile.json", "r"));
+    ASSERT_TRUE(fopen("./roofline.json", "r"));
+}
+
 TEST(TestNetWork, LoadPackedModel) {
     auto tensor = get_input_data("./input_data.npy");
     std::string model_path = "./test_packed_model.lite";
@@ -909,6 +1019,64 @@ TEST(TestNetWork, LoadPackedModel) {
     network->wait();
 }
 
+TEST(TestNetWork, PackModelWithAlgoCache) {
+    auto tensor = get_input_data("./input_data.npy");
+    std::string model_path = "./shufflenet.mge";
+    std::string input_name = "data";
+    std::string cache_path = "./shufflenet_algo_cache.bin";
+    std::string packed_model_path = "./shufflenet_packed.lite";
+    Config config;
+    auto result_mgb = mgb_lar(model_path, config, input_name, tensor);
+
+    auto run = [&](std::shared_ptr<Network> network) {
+        auto input_tensor = network->get_io_tensor(input_name);
+        input_tensor->reset(tensor->get_memory_ptr(), tensor->get_layout());
+        network->forward();
+        network->wait();
+        compare_lite_tensor<float>(network->get_output_tensor(0), result_mgb);
+    };
+
+    set_persistent_cache(cache_path);
+    {
+        std::shared_ptr<Network> network = std::make_shared<Network>(config);
+        network->load_model(model_path);
+        Runtime::set_network_algo_policy(
+                network, LiteAlgoSelectStrategy::LITE_ALGO_PROFILE |
+                                 LiteAlgoSelectStrategy::LITE_ALGO_OPTIMIZED);
+        run(network);
+    }
+    dump_persistent_cache(cache_path);
+
+    int major, minor, patch;
+    get_version(major, minor, patch);
+    ModelPacker packer{model_path, "shufflenet"};
+    packer.set_info(ssprintf(
+            R"({"valid": true, "name": "shufflenet", "version": "%d.%d.%d"})",
+            major, minor, patch));
+    packer.set_algo_cache(cache_path);
+    packer.pack(packed_model_path);
+
+    //! the packed cache is put into an empty cache and used by the network
+    set_persistent_cache("./non_exist_algo_cache.bin");
+    std::shared_ptr<Network> network = std::make_shared<Network>(config);
+    network->load_model(packed_model_path);
+    run(network);
+    std::string merged_cache_path = "./shufflenet_merged_cache.bin";
+    dump_persistent_cache(merged_cache_path);
+    auto file_size = [](const std::string& path) {
+        FILE* fin = fopen(path.c_str(), "rb");
+        fseek(fin, 0, SEEK_END);
+        auto size = ftell(fin);
+        fclose(fin);
+        return size;
+    };
+    ASSERT_EQ(file_size(cache_path), file_size(merged_cache_path));
+
+    remove(cache_path.c_str());
+    remove(merged_cache_path.c_str());
+    remove(packed_model_path.c_str());
+}
+
 TEST(TestNetWork, GlabalLayoutTransform) {
     auto tensor = get_input_data("./input_data.npy");
     std::string model_path = "./shufflenet.mge";
@@ -0,0 +1,128 @@
+/**
+ * \file test/test_network_pool.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "lite_build_config.h"
+
+#if LITE_BUILD_WITH_MGE
+#include "./test_common.h"
+#include "lite/network_pool.h"
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace lite;
+
+namespace {
+void run_and_check(
+        std::shared_ptr<Network> network, std::shared_ptr<Tensor> input,
+        std::shared_ptr<Tensor> result_mgb) {
+    auto input_tensor = network->get_input_tensor(0);
+    input_tensor->reset(input->get_memory_ptr(), input->get_layout());
+    network->forward();
+    network->wait();
+    compare_lite_tensor<float>(network->get_output_tensor(0), result_mgb);
+}
+}  // namespace
+
+TEST(TestNetworkPool, ThreadBudget) {
+    Config config;
+    std::string model_path = "./shufflenet.mge";
+    NetworkPool::Options options;
+    options.nr_instance = 3;
+    options.nr_total_threads = 4;
+    auto pool = NetworkPool::make(model_path, options, config);
+    ASSERT_EQ(3u, pool->size());
+    size_t tot = 0;
+    for (size_t i = 0; i < pool->size(); ++i) {
+        auto nr = pool->nr_threads_per_instance(i);
+        ASSERT_GE(nr, 1u);
+        ASSERT_LE(nr, 2u);
+        tot += nr;
+    }
+    ASSERT_EQ(4u, tot);
+}
+
+TEST(TestNetworkPool, Acquire) {
+    Config config;
+    auto lite_tensor = get_input_data("./input_data.npy");
+    std::string model_path = "./shufflenet.mge";
+    auto result_mgb = mgb_lar(model_path, config, "data", lite_tensor);
+
+    NetworkPool::Options options;
+    options.nr_instance = 2;
+    auto pool = NetworkPool::make(model_path, options, config);
+
+    auto net0 = pool->try_acquire();
+    auto net1 = pool->try_acquire();
+    ASSERT_TRUE(net0 && net1);
+    ASSERT_NE(net0.get(), net1.get());
+    ASSERT_FALSE(pool->try_acquire());
+
+    // a pending async request is served when an instance is released
+    std::shared_ptr<Network> async_net;
+    pool->acquire_async([&](std::shared_ptr<Network> net) { async_net = net; });
+    ASSERT_FALSE(async_net);
+    auto net0_ptr = net0.get();
+    run_and_check(net0, lite_tensor, result_mgb);
+    net0.reset();
+    ASSERT_EQ(net0_ptr, async_net.get());
+    run_and_check(async_net, lite_tensor, result_mgb);
+    run_and_check(net1, lite_tensor, result_mgb);
+
+    async_net.reset();
+    net1.reset();
+    ASSERT_TRUE(pool->try_acquire());
+}
+
+TEST(TestNetworkPool, Concurrent) {
+    Config config;
+    auto lite_tensor = get_input_data("./input_data.npy");
+    std::string model_path = "./shufflenet.mge";
+    auto result_mgb = mgb_lar(model_path, config, "data", lite_tensor);
+
+    NetworkPool::Options options;
+    options.nr_instance = 2;
+    options.nr_total_threads = 2;
+    auto pool = NetworkPool::make(model_path, options, config);
+
+    constexpr size_t NR_WORKER = 4, NR_RUN = 3;
+    std::atomic_size_t nr_in_use{0};
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < NR_WORKER; ++i) {
+        workers.emplace_back([&, i]() {
+            for (size_t j = 0; j < NR_RUN; ++j) {
+                std::shared_ptr<Network> network;
+                if ((i + j) % 2) {
+                    network = pool->acquire();
+                } else {
+                    std::promise<std::shared_ptr<Network>> promise;
+                    pool->acquire_async([&](std::shared_ptr<Network> net) {
+                        promise.set_value(net);
+                    });
+                    network = promise.get_future().get();
+                }
+                ASSERT_LE(++nr_in_use, 2u);
+                run_and_check(network, lite_tensor, result_mgb);
+                --nr_in_use;
+            }
+        });
+    }
+    for (auto&& i : workers) {
+        i.join();
+    }
+}
+
+#endif
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
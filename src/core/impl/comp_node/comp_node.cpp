@@ -23,6 +23,7 @@
 
 #include <atomic>
 #include <cstring>
+#include <limits>
 
 using namespace mgb;
 
@@ -134,6 +135,27 @@ CompNode::Locator CompNode::Locator::parse(const std::string& id) {
     };
     if (id.size() < 3)
         err();
+    auto numa_pos = id.find('@');
+    if (numa_pos != std::string::npos) {
+        auto suffix = id.substr(numa_pos + 1);
+        if (suffix.size() <= 4 || suffix.compare(0, 4, "numa") ||
+            suffix.find_first_not_of("0123456789", 4) != std::string::npos) {
+            err();
+        }
+        auto ret = parse(id.substr(0, numa_pos));
+        if (ret.type != DeviceType::CPU && ret.type != DeviceType::MULTITHREAD) {
+            err();
+        }
+        int node = 0;
+        for (size_t i = 4; i < suffix.size(); ++i) {
+            if (node > (std::numeric_limits<int>::max() - 9) / 10) {
+                err();
+            }
+            node = node * 10 + (suffix[i] - '0');
+        }
+        ret.numa_node = node;
+        return ret;
+    }
     // current parsing location
     const char* ptr = id.data();
     if (id == "cpu:default") {
@@ -288,10 +310,17 @@ CompNode::Locator CompNode::Locator::to_physical() const {
             stream_physical = 1023;
         }
     }
-    return {type_physical, device_physical, {stream_physical}};
+    Locator ret{type_physical, device_physical, {stream_physical}};
+    ret.numa_node = numa_node;
+    return ret;
 }
 
 std::string CompNode::Locator::to_string() const {
+    if (numa_node >= 0) {
+        Locator no_numa = *this;
+        no_numa.numa_node = -1;
+        return ssprintf("%s@numa%d", no_numa.to_string().c_str(), numa_node);
+    }
     if (device == DEVICE_CPU_DEFAULT) {
         return "cpu:default";
     } else if (device == DEVICE_MULTITHREAD_DEFAULT) {
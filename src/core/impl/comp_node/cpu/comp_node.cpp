@@ -54,7 +54,12 @@ class CpuCompNode::WorkerQueue final : public AsyncQueueSC<TaskElem, WorkerQueue
 
     void on_async_queue_worker_thread_start() override {
         mgb_assert(m_locator.device >= 0);
-        if (enable_affinity) {
+        if (m_locator.numa_node >= 0) {
+            auto cpus = sys::get_numa_node_cpus(m_locator.numa_node);
+            if (!cpus.empty()) {
+                sys::set_cpu_affinity(cpus);
+            }
+        } else if (enable_affinity) {
 #if !defined(ANDROID) && !defined(__ANDROID__)
             sys::set_cpu_affinity({m_locator.device});
 #endif
@@ -100,9 +105,20 @@ class CpuCompNode::SeqRecorderImpl final : public CompNodeSeqRecorder {
     using CpuEnv = CompNodeEnv::CpuEnv;
     bool m_fake_exec = false, m_synchronized = false, m_stopped = false,
          m_first_replay = true;
+    //! whether any recorded task has nr_parallelism > 1; if not, the thread
+    //! pool is not woken up during replay
+    bool m_has_parallel_task = false;
     SeqRecorderImpl** const m_self_pointer;
 
-    std::vector<TaskElem> m_tasks;
+    //! set in m_order for the indices into m_parallel_tasks
+    static constexpr uint32_t PARALLEL_BIT = 1u << 31;
+    //! single-threaded tasks, called directly during replay
+    std::vector<Task> m_single_tasks;
+    //! multi-threaded tasks, handed to the thread pool without wrapping
+    std::vector<TaskElem> m_parallel_tasks;
+    //! indices of the tasks in dispatch order, so that replay walks a flat
+    //! array and each task is stored once without an empty counterpart
+    std::vector<uint32_t> m_order;
     std::shared_ptr<ThreadPool> m_thread_pool = nullptr;
     const CompNode m_record_compnode;
     /*!
@@ -145,7 +161,7 @@ public:
     void exit_fake_exec(const CompNode& comp_node) override {
         check_the_same_comp_node(comp_node);
         mgb_assert(!m_stopped && m_fake_exec);
-        mgb_assert(m_tasks.empty());
+        mgb_assert(m_order.empty());
         m_fake_exec = false;
         m_synchronized = false;
     }
@@ -155,6 +171,11 @@ public:
         mgb_assert(*m_self_pointer == this);
         mgb_assert(!m_fake_exec);
         *m_self_pointer = nullptr;
+        if (!m_stopped) {
+            m_single_tasks.shrink_to_fit();
+            m_parallel_tasks.shrink_to_fit();
+            m_order.shrink_to_fit();
+        }
         m_stopped = true;
     }
 
@@ -169,16 +190,25 @@ public:
             *m_self_pointer = this;
         }
         MGB_TRY {
-            if (m_thread_pool) {
+            if (m_thread_pool && m_has_parallel_task) {
                 m_thread_pool->active();
-                for (auto&& i : m_tasks) {
-                    m_thread_pool->add_task(i);
+                for (auto i : m_order) {
+                    if (i & PARALLEL_BIT) {
+                        m_thread_pool->add_task(m_parallel_tasks[i & ~PARALLEL_BIT]);
+                    } else {
+                        m_single_tasks[i]();
+                    }
                 }
                 m_thread_pool->deactive();
             } else {
-                for (auto&& task : m_tasks) {
-                    for (size_t i = 0; i < task.nr_parallelism; i++) {
-                        task.task(i, 0);
+                for (auto i : m_order) {
+                    if (i & PARALLEL_BIT) {
+                        auto&& elem = m_parallel_tasks[i & ~PARALLEL_BIT];
+                        for (size_t j = 0; j < elem.nr_parallelism; j++) {
+                            elem.task(j, 0);
+                        }
+                    } else {
+                        m_single_tasks[i]();
                     }
                 }
             }
@@ -210,17 +240,16 @@ public:
         mgb_assert(
                 !m_synchronized,
                 "no more tasks should be dispatched after synchronization");
-        auto kern = [task](size_t, size_t) { task(); };
-        dispatch_allow_after_sync(
-                {std::move(kern), static_cast<size_t>(1_z)}, comp_node);
+        dispatch_allow_after_sync(std::move(task), comp_node);
     }
     void dispatch_allow_after_sync(Task&& task, const CompNode& comp_node) {
         check_the_same_comp_node(comp_node);
         mgb_assert(
                 !m_stopped, "dispatch should not be called after recording is stopped");
         if (!m_fake_exec) {
-            auto kern = [task](size_t, size_t) { task(); };
-            m_tasks.push_back({std::move(kern), static_cast<size_t>(1_z)});
+            mgb_assert(m_single_tasks.size() < PARALLEL_BIT);
+            m_order.push_back(static_cast<uint32_t>(m_single_tasks.size()));
+            m_single_tasks.push_back(std::move(task));
         }
     }
     void dispatch(TaskElem&& task_elem, const CompNode& comp_node) {
@@ -234,7 +263,11 @@ public:
         mgb_assert(
                 !m_stopped, "dispatch should not be called after recording is stopped");
         if (!m_fake_exec) {
-            m_tasks.push_back(task_elem);
+            m_has_parallel_task |= task_elem.nr_parallelism > 1;
+            mgb_assert(m_parallel_tasks.size() < PARALLEL_BIT);
+            m_order.push_back(
+                    static_cast<uint32_t>(m_parallel_tasks.size()) | PARALLEL_BIT);
+            m_parallel_tasks.push_back(std::move(task_elem));
         }
     }
     size_t nr_threads(const CompNode& comp_node) {
@@ -286,7 +319,15 @@ public:
 #endif
     }
 
-    void* alloc_device(size_t size) override { return mgb_aligned_alloc(size); }
+    void* alloc_device(size_t size) override {
+        auto ptr = mgb_aligned_alloc(size);
+        if (m_locator.numa_node >= 0) {
+            // the memory may be recycled by the heap and touched already, in
+            // which case its pages are migrated to the numa node
+            sys::bind_mem_to_numa_node(ptr, size, m_locator.numa_node);
+        }
+        return ptr;
+    }
 
     void* alloc_host(size_t size) override { return mgb_aligned_alloc(size); }
 
@@ -420,6 +461,12 @@ public:
             m_queue->add_task({affinity_run, 1_z});
         }
     }
+
+    void set_thread_pool_weight(size_t weight) override {
+        if (auto thread_pool = m_queue->get_thread_pool()) {
+            thread_pool->set_weight(weight);
+        }
+    }
 };
 
 //! implementation of InplaceCPUDispatcher
@@ -486,6 +533,12 @@ public:
             affinity_cb(0);
         }
     }
+
+    void set_thread_pool_weight(size_t weight) override {
+        if (m_thread_pool) {
+            m_thread_pool->set_weight(weight);
+        }
+    }
 };
 
 //! ==================== CompNodeDefaultImpl ======================
@@ -646,9 +699,25 @@ public:
               m_worker_queue(worker_queue) {
         auto cn = make_comp_node_from_impl(this);
         if (locator.type == DeviceType::MULTITHREAD) {
-            m_thread_pool = std::shared_ptr<ThreadPool>(
-                    new ThreadPool(static_cast<size_t>(locator.nr_threads)));
+#if MGB_HAVE_THREAD
+            if (auto shared_pool = SharedThreadPool::global()) {
+                m_thread_pool = std::make_shared<ThreadPool>(
+                        static_cast<size_t>(locator.nr_threads), shared_pool);
+            }
+#endif
+            if (!m_thread_pool) {
+                m_thread_pool = std::shared_ptr<ThreadPool>(
+                        new ThreadPool(static_cast<size_t>(locator.nr_threads)));
+            }
             mgb_assert(m_thread_pool, "ThradPool create failed");
+            // the shared workers are bound by SharedThreadPool::set_affinity
+            if (locator.numa_node >= 0 && !m_thread_pool->shared_pool()) {
+                auto cpus = sys::get_numa_node_cpus(locator.numa_node);
+                if (!cpus.empty()) {
+                    m_thread_pool->set_affinity(
+                            [cpus](size_t) { sys::set_cpu_affinity(cpus); });
+                }
+            }
         }
         if (locator.type == DeviceType::CPU) {
             if (locator.device == Locator::DEVICE_CPU_DEFAULT) {
@@ -922,14 +991,18 @@ struct CpuCompNode::Pool {
             std::unique_ptr<CompNodeRecorderImpl, CompNodeRecorderImplDeleter>,
             CompNode::LocatorPairHashKey::Hash>
             locator2impl;
-    ThinHashMap<std::pair<int, int>, std::weak_ptr<WorkerQueue>> physical2queue;
+    //! queues are keyed by the physical locator, so comp nodes on different
+    //! numa nodes do not share worker threads
+    using Locator2Queue = std::unordered_map<
+            CompNode::Locator, std::weak_ptr<WorkerQueue>,
+            StdHashAdaptor<CompNode::Locator>>;
+    Locator2Queue physical2queue;
     std::unordered_map<
             CompNode::LocatorPairHashKey,
             std::unique_ptr<CompNodeRecorderImpl, CompNodeRecorderImplDeleter>,
             CompNode::LocatorPairHashKey::Hash>
             locator2impl_multi_thread;
-    ThinHashMap<std::pair<int, int>, std::weak_ptr<WorkerQueue>>
-            physical2queue_multithead;
+    Locator2Queue physical2queue_multithead;
 };
 CpuCompNode::Pool* CpuCompNode::sm_pool;
 Spinlock CpuCompNode::sm_pool_mtx;
@@ -988,6 +1061,10 @@ CpuCompNode::Impl* CpuCompNode::load_cpu(Locator locator, Locator locator_logica
                     locator.device == Locator::DEVICE_MULTITHREAD_DEFAULT,
             "failed to load cpu for device:%d stream:%d", locator.device,
             locator.stream);
+    mgb_assert(
+            locator.numa_node < sys::get_numa_node_count(),
+            "invalid numa node %d: only %d numa nodes available", locator.numa_node,
+            sys::get_numa_node_count());
     MGB_LOCK_GUARD(sm_pool->mtx);
 
     // encode both device ID and type into a int
@@ -1000,7 +1077,7 @@ CpuCompNode::Impl* CpuCompNode::load_cpu(Locator locator, Locator locator_logica
                 locator_logical.type == CompNode::DeviceType::MULTITHREAD);
     }
     if (locator.type == DeviceType::CPU) {
-        auto&& pqueue_weak = sm_pool->physical2queue[{locator.device, locator.stream}];
+        auto&& pqueue_weak = sm_pool->physical2queue[locator];
         auto pqueue = pqueue_weak.lock();
         if (!pqueue) {
             pqueue = std::make_shared<WorkerQueue>(locator);
@@ -1018,8 +1095,7 @@ CpuCompNode::Impl* CpuCompNode::load_cpu(Locator locator, Locator locator_logica
         return pimpl.get();
     } else {
         mgb_assert(locator.type == DeviceType::MULTITHREAD);
-        auto&& pqueue_weak = sm_pool->physical2queue_multithead[{
-                locator.device, locator.nr_threads}];
+        auto&& pqueue_weak = sm_pool->physical2queue_multithead[locator];
         auto pqueue = pqueue_weak.lock();
         if (!pqueue) {
             pqueue = std::make_shared<WorkerQueue>(locator);
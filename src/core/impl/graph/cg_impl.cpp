@@ -22,6 +22,7 @@
 #include "megbrain/graph/exc_extra_info.h"
 #include "megbrain/graph/helper.h"
 #include "megbrain/opr/utility.h"
+#include "megbrain/utils/timer.h"
 
 #if MGB_ENABLE_TENSOR_RT
 #include "megbrain/tensorrt/opr_replace.h"
@@ -517,6 +518,8 @@ ComputingGraphImpl::CompileState ComputingGraphImpl::compile_prepare(
     topo_sorter().restore_opr_prop();
     cmpnt.seq_comp_node_opt.restore_comp_nodes();
 
+    RealTimer timer;
+    AsyncExecutable::CompilePhaseTime phase_time;
     SpecialOprStat sopr_stat;
     auto dest_vars = get_dest_vars_from_out_spec(out_spec, sopr_stat);
 
@@ -617,6 +620,8 @@ ComputingGraphImpl::CompileState ComputingGraphImpl::compile_prepare(
         opt.apply_inplace(dest_vars);
     }
 
+    phase_time.graph_opt = timer.get_secs_reset();
+
     const OprNodeArray* opr_seq = nullptr;
     CompSeqExtraInfo extra_info;
     cmpnt.seq_comp_node_opt.optimize_comp_nodes(dest_vars);
@@ -711,13 +716,17 @@ ComputingGraphImpl::CompileState ComputingGraphImpl::compile_prepare(
     if (!init_flag) {
         init_opr_seq();
     }
+    phase_time.opr_seq = timer.get_secs();
 
-    return {std::move(extra_info), opr_seq, std::move(dest_vars)};
+    return {std::move(extra_info), opr_seq, std::move(dest_vars), phase_time};
 }
 
 std::unique_ptr<AsyncExecutable> ComputingGraphImpl::compile_commit(
         CompileState state) {
+    RealTimer timer;
     auto comp_seq = std::make_unique<ComputingSequence>(shared_from_this());
+    auto&& phase_time = comp_seq->compile_phase_time();
+    phase_time = state.phase_time;
     comp_seq->extra_info = std::move(state.extra_info);
     comp_seq->set_output_vars(state.dest_vars);
     auto opr_seq = state.opr_seq;
@@ -737,9 +746,10 @@ std::unique_ptr<AsyncExecutable> ComputingGraphImpl::compile_commit(
         var_node_mem_manager().reset_opr_seq(comp_seq->extra_info, opr_seq);
         static_infer_comp_seq_manager().reset_dest(comp_seq->extra_info);
         cmpnt.seq_comp_node_opt.init_ready_event(comp_seq->extra_info, *opr_seq);
+        phase_time.seq_init = timer.get_secs();
 
         if (options().allocate_static_mem_after_graph_compile)
-            var_node_mem_manager().alloc_var_node_mem_static();
+            var_node_mem_manager().alloc_var_node_mem_static(&phase_time);
     }
     MGB_FINALLY({ var_node_mem_manager().on_graph_compile_finished(); });
 
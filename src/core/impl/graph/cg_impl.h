@@ -40,6 +40,7 @@ class ComputingGraphImpl final : public ComputingGraph {
         CompSeqExtraInfo extra_info;
         const OprNodeArray* opr_seq = nullptr;
         VarNodeArray dest_vars;
+        AsyncExecutable::CompilePhaseTime phase_time;
     };
 
     struct CallbackCallerKey {
@@ -311,8 +311,16 @@ void ComputingGraphImpl::ComputingSequence::preprocess(ExecContext* ctx) {
     ++m_run_id;
     m_prev_exec_time = None;
 
+    // static memory is planned lazily on the first execution, which is
+    // accounted as a part of graph compiling
+    CompilePhaseTime* phase_time = nullptr;
+    if (m_first_exec &&
+        !m_owner_graph->options().allocate_static_mem_after_graph_compile) {
+        phase_time = &compile_phase_time();
+    }
     ctx->m_mem_reallocated =
-            m_owner_graph->var_node_mem_manager().alloc_var_node_mem_static();
+            m_owner_graph->var_node_mem_manager().alloc_var_node_mem_static(
+                    phase_time);
 
     bool first_exec = m_first_exec;
 #if !__DEPLOY_ON_XP_SP2__
@@ -735,6 +743,7 @@ std::unique_ptr<ComputingGraphImpl::RecordedComputingSequence> ComputingGraphImp
     m_wait_finished = true;
 
     auto ret = std::make_unique<RecordedComputingSequence>(m_owner_graph);
+    ret->compile_phase_time() = compile_phase_time();
     m_owner_graph->m_recorded_seq_level2_dtor_chk.reset(
             new MegDNNDtorCheck{comp_node, ret.get()});
 
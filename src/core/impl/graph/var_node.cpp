@@ -245,6 +245,15 @@ VarNode& VarNode::set_fwd_in2out_writable_force(VarNode* input) {
     return *this;
 }
 
+bool VarNode::set_fwd_out2in_writable(VarNode* output, const SubTensorSpec& sub) {
+    if (owner_graph()->options().imperative_proxy_graph) {
+        return false;
+    }
+    return ComputingGraphImpl::downcast(owner_graph())
+            ->var_node_mem_manager()
+            .fwd_out2in_writable(output, sub, this);
+}
+
 VarNode& VarNode::add_layout_constraint(LayoutConstraintCallback callback) {
     ComputingGraphImpl::downcast(owner_graph())
             ->var_node_mem_manager()
@@ -307,6 +307,7 @@ VarNodeMemManager::~VarNodeMemManager() noexcept = default;
 
 void VarNodeMemManager::VarNodeMemTrait::clear_opt_status() {
     readonly_src = nullptr;
+    fwd_out2in_dest = nullptr;
 }
 
 bool VarNodeMemManager::DynamicAllocOprInfo::check_if_mem_status_change() {
@@ -362,16 +363,25 @@ VarNodeMemManager::DynamicAllocOprInfo::DynamicAllocOprInfo(OperatorNodeBase* op
     has_dynamic_storage_input = !is_all_input_static_storage(opr);
 }
 
-bool VarNodeMemManager::alloc_var_node_mem_static() {
+bool VarNodeMemManager::alloc_var_node_mem_static(
+        AsyncExecutable::CompilePhaseTime* phase_time) {
     RealTimer timer;
 
-    if (!update_static_alloc_plan()) {
+    if (!update_static_alloc_plan(phase_time)) {
         // mem plan unchanged, just do the actual allocation
-        return make_static_var_tensor_from_alloc_plan();
+        RealTimer alloc_timer;
+        auto ret = make_static_var_tensor_from_alloc_plan();
+        if (phase_time) {
+            phase_time->static_mem_alloc = alloc_timer.get_secs();
+        }
+        return ret;
     }
 
     auto time0 = timer.get_msecs();
     make_static_var_tensor_from_alloc_plan();
+    if (phase_time) {
+        phase_time->static_mem_alloc = (timer.get_msecs() - time0) / 1e3;
+    }
 
     MGB_MARK_USED_VAR(time0);
     if (m_owner_graph->options().log_level) {
@@ -387,12 +397,18 @@ bool VarNodeMemManager::alloc_var_node_mem_static() {
     return true;
 }
 
-bool VarNodeMemManager::update_static_alloc_plan() {
+bool VarNodeMemManager::update_static_alloc_plan(
+        AsyncExecutable::CompilePhaseTime* phase_time) {
+    RealTimer timer;
     // check whether unchanged
     bool free_no_need_memory = free_combine_memory_no_need_var();
-    if (!m_owner_graph->static_infer_comp_seq_manager()
-                 .update_static_check_shape_change() &&
-        !m_first_static_plan_run && !m_impure_mem_plan_mgr.check_need_realloc()) {
+    bool shape_changed = m_owner_graph->static_infer_comp_seq_manager()
+                                 .update_static_check_shape_change();
+    if (phase_time) {
+        phase_time->static_infer = timer.get_secs_reset();
+    }
+    if (!shape_changed && !m_first_static_plan_run &&
+        !m_impure_mem_plan_mgr.check_need_realloc()) {
         return false || free_no_need_memory;
     }
 
@@ -428,6 +444,9 @@ bool VarNodeMemManager::update_static_alloc_plan() {
                 .update_static_check_shape_change();
     }
     m_first_static_plan_run = false;
+    if (phase_time) {
+        phase_time->static_mem_plan = timer.get_secs();
+    }
     // ensure that next call to make_static_var_tensor_from_alloc_plan() would
     // be effective
     m_static_mem_refholder_dev_mem_mgr_version = DeviceMemoryAllocator::VERSION_INVALID;
@@ -1092,6 +1111,10 @@ bool VarNodeMemManager::fwd_in2out_readonly(
     }
 
     auto&& dest_spec = m_node_mem_trait.at(dest);
+    if (dest_spec.fwd_out2in_dest) {
+        // dest has been placed in the output buffer of its reader
+        return false;
+    }
     if (dest_spec.readonly_src) {
         // multiple calls may happen when an opr has multiple outputs containing
         // both static and dynamic storage, and it tries to forward static
@@ -1203,6 +1226,8 @@ void VarNodeMemManager::fwd_in2out_writable(VarNode* src, VarNode* dest) {
         return;
     assert_in_mem_opt_phase(SeqMemOptimizer::Status::ALLOW_FWD_IN2OUT_WRITABLE);
     auto&& dest_spec = m_node_mem_trait.at(dest);
+    if (dest_spec.fwd_out2in_dest)
+        return;
     mgb_assert(!dest_spec.readonly_src, "already readonly forwarded from other var");
 
     MemAllocPlan* plan0 = &src->m_mem_plan;
@@ -1237,6 +1262,61 @@ void VarNodeMemManager::fwd_in2out_writable_force(VarNode* src, VarNode* dest) {
     dest_spec.force_update_src = src;
 }
 
+bool VarNodeMemManager::fwd_out2in_writable(
+        VarNode* src, const SubTensorSpec& sub, VarNode* dest) {
+    /*
+     * src is an output of the opr that reads dest; dest shares the chunk of
+     * src, so the owner opr of dest writes directly into src's buffer and
+     * the chunk lifetime is extended to begin at dest's owner opr
+     */
+
+    assert_in_mem_opt_phase(SeqMemOptimizer::Status::ALLOW_FWD_OUT2IN_WRITABLE);
+
+    if (!m_owner_graph->options().seq_opt.enable_mem_plan_opt ||
+        m_owner_graph->eager_eval_manager().enabled())
+        return false;
+
+    if (src == dest || src->comp_node() != dest->comp_node() ||
+        !m_sys_alloc_static_vars.count(src) || !m_sys_alloc_static_vars.count(dest))
+        return false;
+
+    if (src->dtype() != dest->dtype() || !src->format().is_default() ||
+        !dest->format().is_default())
+        return false;
+
+    auto&& src_plan = src->m_mem_plan;
+    auto&& dest_plan = dest->m_mem_plan;
+    if (!src_plan.valid() || !dest_plan.valid())
+        return false;
+
+    // both chunks must be waiting for static allocation, and dest must still
+    // own a private chunk that no other var has been forwarded from
+    auto&& dest_chk = dest_plan.chunk();
+    if (dest_chk.owner_var != dest || !dest_chk.size() ||
+        !dest_chk.mem_alloc_status.is_invalid() ||
+        !src_plan.chunk().mem_alloc_status.is_invalid() ||
+        dest_plan.next_readonly_fwd_reader())
+        return false;
+
+    auto&& src_spec = m_node_mem_trait.at(src);
+    auto&& dest_spec = m_node_mem_trait.at(dest);
+    if (dest_spec.fwd_out2in_dest || dest_spec.readonly_src ||
+        dest_spec.force_update_src || dest_spec.seq_force_update_dest ||
+        src_spec.seq_force_update_dest)
+        return false;
+
+    // the owner opr of dest assumes its output to be contiguous and aligned
+    if (!sub.layout().is_contiguous() || !dest_spec.check_layout(sub.layout()))
+        return false;
+    auto offset = src_plan.offset_in_chunk_byte() + sub.offset_byte();
+    if (offset % src->comp_node().get_mem_addr_alignment())
+        return false;
+
+    dest_spec.fwd_out2in_dest = src;
+    dest_plan.assign_for_forward(src_plan, sub);
+    return true;
+}
+
 void VarNodeMemManager::add_layout_constraint(
         VarNode* dest, VarNode::LayoutConstraintCallback callback) {
     auto&& trait = m_node_mem_trait[dest].layout_constraint;
@@ -133,6 +133,13 @@ public:
          */
         VarNode *force_update_src = nullptr, *seq_force_update_dest = nullptr;
 
+        /*!
+         * if b is an output of the reader opr of a, and a is computed
+         * directly into b (i.e. a->set_fwd_out2in_writable(b, sub) is
+         * called), then we have a.fwd_out2in_dest == b
+         */
+        VarNode* fwd_out2in_dest = nullptr;
+
         LayoutConstraint layout_constraint;
 
         bool check_layout(const TensorLayout& layout) const;
@@ -165,9 +172,12 @@ public:
      * \brief allocate static var node memory; should be called before graph
      *      execution
      *
+     * \param[out] phase_time if not null, time spent on static inference,
+     *      planning and allocation would be written to it
      * \return whether memory is reallocated
      */
-    bool alloc_var_node_mem_static();
+    bool alloc_var_node_mem_static(
+            AsyncExecutable::CompilePhaseTime* phase_time = nullptr);
 
     /*!
      * \brief free the memory of var with MEMORY_NO_NEED flag
@@ -183,9 +193,11 @@ public:
      * This can be used with custom StaticDeviceMemoryAllocator so static
      * memory storage can be controled.
      *
+     * \param[out] phase_time see alloc_var_node_mem_static()
      * \return whether allocation plan changes
      */
-    bool update_static_alloc_plan();
+    bool update_static_alloc_plan(
+            AsyncExecutable::CompilePhaseTime* phase_time = nullptr);
 
     /*!
      * \brief get static memory usage on each comp node
@@ -288,6 +300,11 @@ public:
      */
     void fwd_in2out_writable_force(VarNode* src, VarNode* dest);
 
+    /*!
+     * \brief see VarNode::set_fwd_out2in_writable
+     */
+    bool fwd_out2in_writable(VarNode* src, const SubTensorSpec& sub, VarNode* dest);
+
     void add_layout_constraint(
             VarNode* dest, VarNode::LayoutConstraintCallback callback);
 
@@ -17,13 +17,163 @@
 #include "megbrain/graph/exc_extra_info.h"
 #include "megbrain/graph/helper.h"
 #include "megbrain/utils/arith_helper.h"
+#include "megbrain/utils/hash.h"
 #include "megbrain/utils/metahelper.h"
+#include "megbrain/utils/persistent_cache.h"
+#include "megbrain/utils/thread_pool.h"
+
+#include <array>
+#include <cstring>
 
 using namespace mgb;
 using namespace cg;
 
 constexpr double BYTE2MB = 1.0 / 1024.0 / 1024;
 
+namespace {
+/*!
+ * \brief run task(0), ..., task(nr_task - 1) on at most nr_threads threads
+ *
+ * Exceptions thrown by the tasks are rethrown on the caller thread.
+ */
+void run_tasks_concurrently(
+        size_t nr_task, size_t nr_threads, const thin_function<void(size_t)>& task) {
+    nr_threads = std::min(nr_threads, nr_task);
+    if (nr_threads <= 1) {
+        for (size_t i = 0; i < nr_task; ++i) {
+            task(i);
+        }
+        return;
+    }
+    std::exception_ptr exc;
+    std::mutex exc_mtx;
+    MGB_MARK_USED_VAR(exc_mtx);
+    auto worker = [&](size_t idx, size_t) {
+        MGB_TRY { task(idx); }
+        MGB_CATCH(..., {
+            MGB_LOCK_GUARD(exc_mtx);
+            if (!exc) {
+                exc = std::current_exception();
+            }
+        });
+    };
+    ThreadPool pool{nr_threads};
+    pool.add_task({worker, nr_task});
+    pool.deactive();
+    if (exc) {
+        std::rethrow_exception(exc);
+    }
+}
+
+/*!
+ * \brief StaticMemAlloc that replays a plan loaded from PersistentCache
+ *
+ * Intervals must be added in the same order as the solved problem.
+ */
+class CachedStaticMemAlloc final : public StaticMemAlloc {
+    size_t m_tot_alloc, m_tot_alloc_lb;
+    std::vector<size_t> m_offset;
+    ThinHashMap<UserKeyType, size_t> m_key2offset;
+
+public:
+    CachedStaticMemAlloc(
+            size_t tot_alloc, size_t tot_alloc_lb, std::vector<size_t> offset)
+            : m_tot_alloc{tot_alloc},
+              m_tot_alloc_lb{tot_alloc_lb},
+              m_offset(std::move(offset)) {}
+
+    size_t add(size_t, size_t, size_t, UserKeyType key) override {
+        size_t id = m_key2offset.size();
+        mgb_assert(id < m_offset.size());
+        m_key2offset[key] = m_offset[id];
+        return id;
+    }
+
+    StaticMemAlloc& add_overwrite_spec(size_t, size_t, size_t) override {
+        return *this;
+    }
+
+    StaticMemAlloc& solve() override {
+        mgb_assert(m_key2offset.size() == m_offset.size());
+        return *this;
+    }
+
+    size_t tot_alloc() const override { return m_tot_alloc; }
+
+    size_t tot_alloc_lower_bound() const override { return m_tot_alloc_lb; }
+
+    size_t get_start_addr(UserKeyType key) const override {
+        return m_key2offset.at(key);
+    }
+
+    StaticMemAlloc& alignment(size_t) override { return *this; }
+
+    StaticMemAlloc& padding(size_t) override { return *this; }
+};
+
+/*!
+ * \brief memory plans stored in PersistentCache
+ *
+ * The key is the digest of the complete allocation problem, i.e. chunk sizes,
+ * life intervals, overwrite specs, alignment and padding; the value is the
+ * peak usage, the offsets and the problem itself, which is compared on a hit
+ * so that a digest collision can not apply the plan to another problem.
+ */
+class StaticMemPlanCache {
+    static constexpr const char* CATEGORY = "static_mem_plan";
+    //! tot_alloc, tot_alloc_lb, nr_chunk, nr_problem_word
+    static constexpr size_t NR_HEADER = 4;
+    std::vector<uint64_t> m_problem;
+
+    uint64_t digest() const {
+        return XXHash{}
+                .update(m_problem.data(), m_problem.size() * sizeof(uint64_t))
+                .digest();
+    }
+
+public:
+    void append(size_t v) { m_problem.push_back(v); }
+
+    std::unique_ptr<StaticMemAlloc> get(size_t nr_chunk) const {
+        auto key = digest();
+        auto val = PersistentCache::inst().get(CATEGORY, {&key, sizeof(key)});
+        if (!val.valid()) {
+            return {};
+        }
+        auto ptr = static_cast<const uint64_t*>(val->ptr);
+        if (val->size < sizeof(uint64_t) * NR_HEADER ||
+            val->size != sizeof(uint64_t) * (NR_HEADER + ptr[2] + ptr[3])) {
+            mgb_log_warn("ignore corrupted static memory plan in persistent cache");
+            return {};
+        }
+        auto problem = ptr + NR_HEADER + ptr[2];
+        if (ptr[2] != nr_chunk || ptr[3] != m_problem.size() ||
+            memcmp(problem, m_problem.data(), m_problem.size() * sizeof(uint64_t))) {
+            // digest collision; the plan would be overwritten after solving
+            return {};
+        }
+        std::vector<size_t> offset(ptr + NR_HEADER, ptr + NR_HEADER + nr_chunk);
+        return std::make_unique<CachedStaticMemAlloc>(
+                ptr[0], ptr[1], std::move(offset));
+    }
+
+    template <typename KeyIter>
+    void put(const StaticMemAlloc& allocator, KeyIter begin, KeyIter end) const {
+        std::vector<uint64_t> val{
+                allocator.tot_alloc(), allocator.tot_alloc_lower_bound(),
+                static_cast<uint64_t>(end - begin), m_problem.size()};
+        for (auto i = begin; i != end; ++i) {
+            val.push_back(allocator.get_start_addr(&*i));
+        }
+        val.insert(val.end(), m_problem.begin(), m_problem.end());
+        auto key = digest();
+        PersistentCache::inst().put(
+                CATEGORY, {&key, sizeof(key)},
+                {val.data(), val.size() * sizeof(uint64_t)});
+    }
+};
+}  // anonymous namespace
+
 class SeqMemOptimizer::StaticMemAllocLogger {
 public:
     virtual ~StaticMemAllocLogger() = default;
@@ -88,18 +238,30 @@ void SeqMemOptimizer::optimize_mem_plan() {
     OperatorNodeBase* opr = nullptr;
     MGB_TRY {
         m_writable_fwd_mem_plans.clear();
-        m_status = Status::ALLOW_FWD_IN2OUT_READONLY;
         OprNodeArray oprs_to_run;
         for (auto i : *m_cur_seq_sys_alloc) {
-            opr = i;
-            if (is_all_input_static_storage(opr)) {
-                // if there are dynamic input vars, opr forwarding may not work
-                // property (we have assumed shapes to be available in
-                // mem_plan_fwd_in2out_readonly to make subspec)
-                opr->mem_plan_fwd_in2out_readonly();
-                oprs_to_run.push_back(opr);
+            // if there are dynamic input vars, opr forwarding may not work
+            // property (we have assumed shapes to be available in
+            // mem_plan_fwd_in2out_readonly to make subspec)
+            if (is_all_input_static_storage(i)) {
+                oprs_to_run.push_back(i);
             }
         }
+
+        // out2in forwarding runs first and in reversed order, so the inputs
+        // of nested oprs (e.g. concat of concat) can be placed in the final
+        // buffer, and readonly forwarding would not be applied on its inputs
+        m_status = Status::ALLOW_FWD_OUT2IN_WRITABLE;
+        for (auto iter = oprs_to_run.rbegin(); iter != oprs_to_run.rend(); ++iter) {
+            opr = *iter;
+            opr->mem_plan_fwd_out2in_writable();
+        }
+        opr = nullptr;
+        m_status = Status::ALLOW_FWD_IN2OUT_READONLY;
+        for (auto i : oprs_to_run) {
+            opr = i;
+            opr->mem_plan_fwd_in2out_readonly();
+        }
         opr = nullptr;
         m_status = Status::ALLOW_FWD_IN2OUT_WRITABLE;
         for (auto i : oprs_to_run) {
@@ -172,6 +334,7 @@ bool SeqMemOptimizer::run_static_mem_alloc() {
     // multiple var nodes share the same chunk pointer by readonly memory
     // forwarding
     ThinHashMap<MemAllocPlan::Chunk*, MemChunkLifeInterval> chk2interval;
+    auto&& var_mem_mgr = m_graph->var_node_mem_manager();
 
     // get all memory chunks
 #ifndef __IN_TEE_ENV__
@@ -202,12 +365,15 @@ bool SeqMemOptimizer::run_static_mem_alloc() {
                     dest.begin = idx;
                     dest.chunk = cur_chk;
                     dest.comp_node = i->comp_node();
-                    mgb_assert(cur_chk->owner_var == i);
-                } else {
-                    // forwarded from another var
+                    // for out2in forwarding, the chunk life starts at the
+                    // owner opr of the input var rather than the owner var
                     mgb_assert(
-                            i->comp_node() == dest.comp_node &&
-                            cur_chk->owner_var != i);
+                            cur_chk->owner_var == i ||
+                            var_mem_mgr.get_var_node_mem_trait_at(i).fwd_out2in_dest);
+                } else {
+                    // forwarded from another var, or the owner var of a chunk
+                    // that has been forwarded to its inputs
+                    mgb_assert(i->comp_node() == dest.comp_node);
                 }
 
                 if (i->contain_flag(VarNode::Flag::NO_MEM_RECLAIM)) {
@@ -267,14 +433,36 @@ bool SeqMemOptimizer::run_static_mem_alloc() {
     StaticMemAllocLogger* logger = &fake_logger;
 #endif
 
-    bool ret = false;
+    SmallVector<std::pair<CompNode, std::vector<MemChunkLifeInterval>*>> groups;
     for (auto&& i : group_by_cn) {
+        groups.emplace_back(i.first, &i.second);
+    }
+
+    // solving on different comp nodes is independent; the solvers are run
+    // concurrently and their results are committed sequentially
+    size_t nr_threads = m_graph->options().nr_mem_plan_threads;
+#ifndef __IN_TEE_ENV__
+    if (StaticMemRecorder::Instance().valid()) {
+        // the recorder is a global object updated by the solvers
+        nr_threads = 1;
+    }
+#endif
+    std::vector<std::unique_ptr<StaticMemAlloc>> allocators(groups.size());
+    auto solve = [&](size_t idx) {
         auto cmp = [](const MemChunkLifeInterval& a, const MemChunkLifeInterval& b) {
             return a.begin < b.begin || (a.begin == b.begin && a.end < b.end);
         };
+        auto&& grp = groups[idx];
         // sort for stable order
-        std::sort(i.second.begin(), i.second.end(), cmp);
-        ret |= run_static_mem_alloc_on_comp_node(i.first, i.second, *logger);
+        std::sort(grp.second->begin(), grp.second->end(), cmp);
+        allocators[idx] = solve_static_mem_alloc_on_comp_node(grp.first, *grp.second);
+    };
+    run_tasks_concurrently(groups.size(), nr_threads, solve);
+
+    bool ret = false;
+    for (size_t i = 0; i < groups.size(); ++i) {
+        ret |= run_static_mem_alloc_on_comp_node(
+                groups[i].first, *groups[i].second, *allocators[i], *logger);
     }
     logger->flush();
 
@@ -294,46 +482,111 @@ bool SeqMemOptimizer::run_static_mem_alloc() {
     return ret;
 }
 
-bool SeqMemOptimizer::run_static_mem_alloc_on_comp_node(
-        CompNode comp_node, const std::vector<MemChunkLifeInterval>& chunks,
-        StaticMemAllocLogger& static_mem_alloc_logger) {
-    size_t size_ub = 0;
-
-    auto allocator = StaticMemAlloc::make(StaticMemAlloc::AllocatorAlgo::PUSHDOWN);
-    allocator->alignment(comp_node.get_mem_addr_alignment());
-    allocator->padding(comp_node.get_mem_padding());
-#if MGB_ENABLE_DEBUG_UTIL
-    allocator->dbg_key2varnode = [](StaticMemAlloc::UserKeyType key) {
-        return static_cast<const MemChunkLifeInterval*>(key)->chunk->owner_var;
-    };
-#endif
-    ThinHashMap<MemAllocPlan::Chunk*, size_t> chunk2allocatorid;
-    for (auto&& chk : chunks) {
-        auto id = allocator->add(chk.begin, chk.end, chk.chunk->size(), &chk);
-        auto ins_rst = chunk2allocatorid.emplace(chk.chunk, id);
+std::unique_ptr<StaticMemAlloc> SeqMemOptimizer::solve_static_mem_alloc_on_comp_node(
+        CompNode comp_node, const std::vector<MemChunkLifeInterval>& chunks) {
+    ThinHashMap<MemAllocPlan::Chunk*, size_t> chunk2id;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        auto ins_rst = chunk2id.emplace(chunks[i].chunk, i);
         mgb_assert(ins_rst.second);
-        size_ub += chk.chunk->size();
     }
-
+    // (src, dest, offset) of overwrite specs
+    std::vector<std::array<size_t, 3>> overwrite_specs;
     for (auto&& i : m_writable_fwd_mem_plans) {
-        auto from_iter = chunk2allocatorid.find(&i.first->chunk()),
-             to_iter = chunk2allocatorid.find(&i.second->chunk());
+        auto from_iter = chunk2id.find(&i.first->chunk()),
+             to_iter = chunk2id.find(&i.second->chunk());
 
         // ignore mem fwd specs that involve other chunks
-        if (from_iter != chunk2allocatorid.end() &&
-            to_iter != chunk2allocatorid.end()) {
-            allocator->add_overwrite_spec(
-                    to_iter->second, from_iter->second,
-                    i.first->offset_in_chunk_byte());
+        if (from_iter != chunk2id.end() && to_iter != chunk2id.end()) {
+            overwrite_specs.push_back(
+                    {to_iter->second, from_iter->second,
+                     i.first->offset_in_chunk_byte()});
         }
     }
     {
-        decltype(chunk2allocatorid) v;
-        chunk2allocatorid.swap(v);
+        decltype(chunk2id) v;
+        chunk2id.swap(v);
     }
 
-    allocator->solve();
-    size_t size = allocator->tot_alloc(), size_lb = allocator->tot_alloc_lower_bound();
+    auto alignment = comp_node.get_mem_addr_alignment(),
+         padding = comp_node.get_mem_padding();
+
+    bool algo_search = m_graph->options().seq_opt.enable_mem_alloc_algo_search;
+    bool use_cache = m_graph->options().cache_static_mem_plan;
+#ifndef __IN_TEE_ENV__
+    // the recorder needs details from the solver
+    use_cache &= !StaticMemRecorder::Instance().valid();
+#endif
+    StaticMemPlanCache cache;
+    if (use_cache) {
+        cache.append(alignment);
+        cache.append(padding);
+        cache.append(algo_search);
+        cache.append(chunks.size());
+        for (auto&& chk : chunks) {
+            cache.append(chk.begin);
+            cache.append(chk.end);
+            cache.append(chk.chunk->size());
+        }
+        for (auto&& i : overwrite_specs) {
+            for (auto j : i) {
+                cache.append(j);
+            }
+        }
+        if (auto allocator = cache.get(chunks.size())) {
+            for (auto&& chk : chunks) {
+                allocator->add(chk.begin, chk.end, chk.chunk->size(), &chk);
+            }
+            allocator->solve();
+            return allocator;
+        }
+    }
+
+    auto solve = [&](StaticMemAlloc::AllocatorAlgo algo) {
+        auto allocator = StaticMemAlloc::make(algo);
+        allocator->alignment(alignment);
+        allocator->padding(padding);
+#if MGB_ENABLE_DEBUG_UTIL
+        allocator->dbg_key2varnode = [](StaticMemAlloc::UserKeyType key) {
+            return static_cast<const MemChunkLifeInterval*>(key)->chunk->owner_var;
+        };
+#endif
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            auto&& chk = chunks[i];
+            auto id = allocator->add(chk.begin, chk.end, chk.chunk->size(), &chk);
+            mgb_assert(id == i);
+        }
+        for (auto&& i : overwrite_specs) {
+            allocator->add_overwrite_spec(i[0], i[1], i[2]);
+        }
+        allocator->solve();
+        return allocator;
+    };
+
+    auto allocator = solve(StaticMemAlloc::AllocatorAlgo::PUSHDOWN);
+    if (algo_search) {
+        for (auto algo :
+             {StaticMemAlloc::AllocatorAlgo::BEST_FIT,
+              StaticMemAlloc::AllocatorAlgo::INTERVAL_MOVE}) {
+            auto cur = solve(algo);
+            if (cur->tot_alloc() < allocator->tot_alloc()) {
+                allocator = std::move(cur);
+            }
+        }
+    }
+    if (use_cache) {
+        cache.put(*allocator, chunks.begin(), chunks.end());
+    }
+    return allocator;
+}
+
+bool SeqMemOptimizer::run_static_mem_alloc_on_comp_node(
+        CompNode comp_node, const std::vector<MemChunkLifeInterval>& chunks,
+        StaticMemAlloc& allocator, StaticMemAllocLogger& static_mem_alloc_logger) {
+    size_t size_ub = 0;
+    for (auto&& chk : chunks) {
+        size_ub += chk.chunk->size();
+    }
+    size_t size = allocator.tot_alloc(), size_lb = allocator.tot_alloc_lower_bound();
 
     static_mem_alloc_logger.push(comp_node, size, size_lb, size_ub);
 
@@ -345,7 +598,7 @@ bool SeqMemOptimizer::run_static_mem_alloc_on_comp_node(
         m_static_mem_usage.val()[comp_node] = size;
         for (auto&& chk : chunks) {
             chk.chunk->mem_alloc_status.set_static_offset(
-                    allocator->get_start_addr(&chk));
+                    allocator.get_start_addr(&chk));
         }
 #ifndef __IN_TEE_ENV__
         auto& recorder = StaticMemRecorder::Instance();
@@ -137,6 +137,113 @@ std::pair<size_t, size_t> sys::get_ram_status_bytes() {
 }
 #endif  // WIN32
 
+#if defined(__linux__) && !defined(ANDROID) && !defined(__ANDROID__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+
+namespace {
+std::string numa_node_sysfs_path(int node) {
+    return ssprintf("/sys/devices/system/node/node%d", node);
+}
+}  // anonymous namespace
+
+int sys::get_numa_node_count() {
+    static int ret = [] {
+        int nr = 0;
+        while (!access(numa_node_sysfs_path(nr).c_str(), F_OK)) {
+            ++nr;
+        }
+        return std::max(nr, 1);
+    }();
+    return ret;
+}
+
+std::vector<int> sys::get_numa_node_cpus(int node) {
+    // the cpulist file contains ranges like 0-17,36-53
+    std::ifstream fin{numa_node_sysfs_path(node) + "/cpulist"};
+    std::string line;
+    std::vector<int> ret;
+    if (!fin || !std::getline(fin, line)) {
+        return ret;
+    }
+    const char* ptr = line.c_str();
+    while (*ptr) {
+        char* end;
+        long begin = strtol(ptr, &end, 10);
+        if (end == ptr) {
+            break;
+        }
+        long last = begin;
+        ptr = end;
+        if (*ptr == '-') {
+            last = strtol(ptr + 1, &end, 10);
+            ptr = end;
+        }
+        for (long i = begin; i <= last; ++i) {
+            ret.push_back(static_cast<int>(i));
+        }
+        if (*ptr == ',') {
+            ++ptr;
+        } else {
+            break;
+        }
+    }
+    return ret;
+}
+
+bool sys::bind_mem_to_numa_node(void* ptr, size_t size, int node) {
+#ifdef SYS_mbind
+    // see mempolicy.h; defined here to avoid depending on libnuma
+    constexpr int MPOL_PREFERRED_MODE = 1;
+    constexpr unsigned MPOL_MF_MOVE_FLAG = 1u << 1;
+    constexpr size_t NR_MASK_BITS = sizeof(unsigned long) * 8;
+    mgb_assert(node >= 0);
+    static const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    auto begin = (reinterpret_cast<uintptr_t>(ptr) + page_size - 1) / page_size *
+                 page_size,
+         end = (reinterpret_cast<uintptr_t>(ptr) + size) / page_size * page_size;
+    if (begin >= end) {
+        return false;
+    }
+    std::vector<unsigned long> mask(node / NR_MASK_BITS + 1, 0);
+    mask[node / NR_MASK_BITS] = 1ul << (node % NR_MASK_BITS);
+    // heap memory may be recycled and already touched, so the pages that
+    // exist are moved, rather than only the policy of new pages being set
+    auto err = syscall(
+            SYS_mbind, reinterpret_cast<void*>(begin), end - begin,
+            MPOL_PREFERRED_MODE, mask.data(), mask.size() * NR_MASK_BITS + 1,
+            MPOL_MF_MOVE_FLAG);
+    if (err) {
+        mgb_log_debug(
+                "failed to mbind to numa node %d: %s (error ignored)", node,
+                strerror(errno));
+        return false;
+    }
+    return true;
+#else
+    MGB_MARK_USED_VAR(ptr);
+    MGB_MARK_USED_VAR(size);
+    MGB_MARK_USED_VAR(node);
+    return false;
+#endif
+}
+#else
+int sys::get_numa_node_count() {
+    return 1;
+}
+
+std::vector<int> sys::get_numa_node_cpus(int) {
+    return {};
+}
+
+bool sys::bind_mem_to_numa_node(void*, size_t, int) {
+    return false;
+}
+#endif
+
 #if !MGB_BUILD_SLIM_SERVING && defined(__linux)
 #include <unistd.h>
 bool sys::stderr_ansi_color() {
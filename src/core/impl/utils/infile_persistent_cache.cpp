@@ -216,6 +216,16 @@ void InFilePersistentCache::dump_cache(OutputFile* out_file) {
         }
     }
 }
+
+void InFilePersistentCache::put_to(PersistentCache& dest) {
+    MGB_LOCK_GUARD(m_mtx);
+    for (auto&& category : m_cache) {
+        for (auto&& item : category.second) {
+            dest.put(category.first, item.first, item.second);
+        }
+    }
+}
+
 Maybe<InFilePersistentCache::Blob> InFilePersistentCache::get(
         const std::string& category, const Blob& key) {
     decltype(m_cache.begin()) iter0;
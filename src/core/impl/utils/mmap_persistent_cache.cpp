@@ -0,0 +1,285 @@
+/**
+ * \file src/core/impl/utils/mmap_persistent_cache.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "megbrain/utils/mmap_persistent_cache.h"
+#include "megbrain/utils/hash.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace mgb;
+
+#if defined(_WIN32)
+
+MmapPersistentCache::MmapPersistentCache(const char*, uint32_t) {
+    mgb_throw(MegBrainError, "MmapPersistentCache is not supported on windows");
+}
+
+MmapPersistentCache::~MmapPersistentCache() = default;
+
+Maybe<PersistentCache::Blob> MmapPersistentCache::get(
+        const std::string&, const Blob&) {
+    return None;
+}
+
+void MmapPersistentCache::put(const std::string&, const Blob&, const Blob&) {}
+
+#else
+
+namespace {
+constexpr char MAGIC[8] = {'M', 'G', 'B', 'P', 'C', 'I', 'D', 'X'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t ALIGN = sizeof(uint64_t);
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t nr_bucket;
+};
+static_assert(sizeof(Header) % ALIGN == 0, "bad header size");
+
+//! exclusive lock on the whole file, held by this process
+class FileLock : public NonCopyableObj {
+    int m_fd;
+
+public:
+    explicit FileLock(int fd) : m_fd{fd} {
+        int ret;
+        while ((ret = flock(m_fd, LOCK_EX)) && errno == EINTR)
+            ;
+        mgb_assert(!ret, "failed to lock cache file: %s", strerror(errno));
+    }
+
+    ~FileLock() { flock(m_fd, LOCK_UN); }
+};
+
+size_t file_size(int fd) {
+    struct stat st;
+    mgb_assert(!fstat(fd, &st), "failed to stat cache file: %s", strerror(errno));
+    return st.st_size;
+}
+
+void pwrite_all(int fd, const void* buf, size_t size, size_t offset) {
+    auto ptr = static_cast<const uint8_t*>(buf);
+    while (size) {
+        auto ret = pwrite(fd, ptr, size, offset);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        mgb_assert(ret > 0, "failed to write cache file: %s", strerror(errno));
+        ptr += ret;
+        offset += ret;
+        size -= ret;
+    }
+}
+}  // anonymous namespace
+
+struct MmapPersistentCache::Record {
+    uint64_t next, hash;
+    uint32_t category_size, key_size, value_size, reserved;
+
+    const uint8_t* data() const { return reinterpret_cast<const uint8_t*>(this + 1); }
+
+    size_t total_size() const {
+        return sizeof(Record) + category_size + key_size + value_size;
+    }
+};
+
+MmapPersistentCache::MmapPersistentCache(const char* path, uint32_t nr_bucket) {
+    static_assert(sizeof(Record) % ALIGN == 0, "bad record size");
+    mgb_assert(nr_bucket);
+    m_fd = open(path, O_RDWR | O_CREAT, 0644);
+    mgb_assert(m_fd >= 0, "failed to open %s: %s", path, strerror(errno));
+    {
+        FileLock lock{m_fd};
+        Header header;
+        if (!file_size(m_fd)) {
+            memcpy(header.magic, MAGIC, sizeof(MAGIC));
+            header.version = VERSION;
+            header.nr_bucket = nr_bucket;
+            std::vector<uint64_t> buckets(nr_bucket, 0);
+            pwrite_all(
+                    m_fd, buckets.data(), buckets.size() * sizeof(uint64_t),
+                    sizeof(Header));
+            // write header last so a partially initialized file is rejected
+            pwrite_all(m_fd, &header, sizeof(header), 0);
+        } else {
+            auto ret = pread(m_fd, &header, sizeof(header), 0);
+            mgb_assert(
+                    ret == static_cast<ssize_t>(sizeof(header)) &&
+                            !memcmp(header.magic, MAGIC, sizeof(MAGIC)),
+                    "%s is not a valid persistent cache file", path);
+            mgb_assert(
+                    header.version == VERSION,
+                    "unsupported persistent cache version %u in %s", header.version,
+                    path);
+        }
+        m_nr_bucket = header.nr_bucket;
+        mgb_assert(
+                file_size(m_fd) >= sizeof(Header) + m_nr_bucket * sizeof(uint64_t),
+                "truncated persistent cache file %s", path);
+    }
+    update_mapping();
+}
+
+MmapPersistentCache::~MmapPersistentCache() {
+    for (auto&& i : m_old_maps) {
+        munmap(i.ptr, i.capacity);
+    }
+    if (m_map.ptr) {
+        munmap(m_map.ptr, m_map.capacity);
+    }
+    close(m_fd);
+}
+
+void MmapPersistentCache::update_mapping() {
+    auto size = file_size(m_fd);
+    std::unique_lock<std::shared_timed_mutex> lock{m_map_mtx};
+    if (size <= m_map.size) {
+        return;
+    }
+    if (size <= m_map.capacity) {
+        // the reserved range already covers the appended records
+        m_map.size = size;
+        return;
+    }
+    // reserve twice the file size, so the file is remapped only when it has
+    // doubled since the last mapping
+    size_t page = sysconf(_SC_PAGESIZE);
+    auto capacity = std::max(size * 2, size_t(MIN_MAP_CAPACITY));
+    capacity = (capacity + page - 1) / page * page;
+    // pages beyond the end of file are reserved to absorb later growth, but
+    // never accessed before the file covers them
+    auto addr = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    mgb_assert(addr != MAP_FAILED, "failed to mmap cache file: %s", strerror(errno));
+    if (m_map.ptr) {
+        m_old_maps.push_back(m_map);
+    }
+    m_map = {static_cast<uint8_t*>(addr), size, capacity};
+}
+
+uint64_t* MmapPersistentCache::bucket(uint64_t hash) const {
+    return reinterpret_cast<uint64_t*>(m_map.ptr + sizeof(Header)) +
+           hash % m_nr_bucket;
+}
+
+uint64_t MmapPersistentCache::hash(const std::string& category, const Blob& key) {
+    uint64_t category_size = category.size();
+    return XXHash{}
+            .update(&category_size, sizeof(category_size))
+            .update(category.data(), category.size())
+            .update(key.ptr, key.size)
+            .digest();
+}
+
+const MmapPersistentCache::Record* MmapPersistentCache::find(
+        uint64_t hash, const std::string& category, const Blob& key,
+        bool* need_remap) const {
+    auto offset = __atomic_load_n(bucket(hash), __ATOMIC_ACQUIRE);
+    while (offset) {
+        auto rec = reinterpret_cast<const Record*>(m_map.ptr + offset);
+        if (offset + sizeof(Record) > m_map.size ||
+            offset + rec->total_size() > m_map.size) {
+            *need_remap = true;
+            return nullptr;
+        }
+        if (rec->hash == hash && rec->category_size == category.size() &&
+            rec->key_size == key.size &&
+            !memcmp(rec->data(), category.data(), category.size()) &&
+            !memcmp(rec->data() + category.size(), key.ptr, key.size)) {
+            return rec;
+        }
+        // records are only linked to older ones
+        mgb_assert(rec->next < offset, "corrupted persistent cache file");
+        offset = rec->next;
+    }
+    return nullptr;
+}
+
+Maybe<PersistentCache::Blob> MmapPersistentCache::get(
+        const std::string& category, const Blob& key) {
+    auto h = hash(category, key);
+    for (;;) {
+        bool need_remap = false;
+        size_t mapped_size;
+        {
+            std::shared_lock<std::shared_timed_mutex> lock{m_map_mtx};
+            mapped_size = m_map.size;
+            if (auto rec = find(h, category, key, &need_remap)) {
+                return Blob{
+                        rec->data() + rec->category_size + rec->key_size,
+                        rec->value_size};
+            }
+        }
+        if (!need_remap) {
+            return None;
+        }
+        // the record has been put by another process after our last mapping
+        update_mapping();
+        std::shared_lock<std::shared_timed_mutex> lock{m_map_mtx};
+        mgb_assert(m_map.size > mapped_size, "corrupted persistent cache file");
+    }
+}
+
+void MmapPersistentCache::put(
+        const std::string& category, const Blob& key, const Blob& value) {
+    auto h = hash(category, key);
+    MGB_LOCK_GUARD(m_write_mtx);
+    FileLock file_lock{m_fd};
+    update_mapping();
+
+    std::shared_lock<std::shared_timed_mutex> lock{m_map_mtx};
+    bool need_remap = false;
+    auto old = find(h, category, key, &need_remap);
+    mgb_assert(!need_remap, "corrupted persistent cache file");
+    if (old && old->value_size == value.size &&
+        !memcmp(old->data() + old->category_size + old->key_size, value.ptr,
+                value.size)) {
+        return;
+    }
+
+    auto head = bucket(h);
+    Record rec;
+    rec.next = *head;
+    rec.hash = h;
+    rec.category_size = category.size();
+    rec.key_size = key.size;
+    rec.value_size = value.size;
+    rec.reserved = 0;
+    std::vector<uint8_t> buf(
+            (rec.total_size() + ALIGN - 1) / ALIGN * ALIGN, 0);
+    auto ptr = buf.data();
+    memcpy(ptr, &rec, sizeof(rec));
+    ptr += sizeof(rec);
+    memcpy(ptr, category.data(), category.size());
+    ptr += category.size();
+    memcpy(ptr, key.ptr, key.size);
+    ptr += key.size;
+    memcpy(ptr, value.ptr, value.size);
+
+    // a record left by an interrupted writer may make the size unaligned
+    auto offset = (file_size(m_fd) + ALIGN - 1) / ALIGN * ALIGN;
+    pwrite_all(m_fd, buf.data(), buf.size(), offset);
+    // link the record only after it has been completely written
+    __atomic_store_n(head, static_cast<uint64_t>(offset), __ATOMIC_RELEASE);
+}
+
+#endif  // _WIN32
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
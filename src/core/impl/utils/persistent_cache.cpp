@@ -144,15 +144,20 @@ Maybe<AlgoChooserProfileCache::Result> AlgoChooserProfileCache::get(const Key& k
     auto raw_buf = PersistentCache::inst().get(m_category, key.build_blob());
     if (!raw_buf.valid())
         return None;
+    return deserialize_result(raw_buf.val());
+}
+
+AlgoChooserProfileCache::Result AlgoChooserProfileCache::deserialize_result(
+        const PersistentCache::Blob& raw_buf) {
     mgb_assert(
-            raw_buf->size <= 1024 * 1024,
-            "buf size too large, maybe corrupted data: %p %zu", raw_buf->ptr,
-            raw_buf->size);
-    auto buf = static_cast<const uint8_t*>(raw_buf->ptr), buf_end = buf + raw_buf->size;
+            raw_buf.size <= 1024 * 1024,
+            "buf size too large, maybe corrupted data: %p %zu", raw_buf.ptr,
+            raw_buf.size);
+    auto buf = static_cast<const uint8_t*>(raw_buf.ptr), buf_end = buf + raw_buf.size;
     mgb_assert(
             buf && buf < buf_end,
-            "PersistentCache returned invalid value: ptr=%p size=%zu", raw_buf->ptr,
-            raw_buf->size);
+            "PersistentCache returned invalid value: ptr=%p size=%zu", raw_buf.ptr,
+            raw_buf.size);
     auto read_uint32 = [&]() {
         auto next = buf + sizeof(uint32_t);
         mgb_assert(next <= buf_end);
@@ -10,11 +10,225 @@
  */
 
 #include "megbrain/utils/thread_pool.h"
+#include "megbrain/utils/small_vector.h"
+#include <algorithm>
 #include <chrono>
 
 using namespace mgb;
 
 #if MGB_HAVE_THREAD
+/* ======================== SharedThreadPool ======================== */
+struct SharedThreadPool::Job {
+    const MultiThreadingTask* task;
+    size_t nr_parallelism;
+    std::atomic_int task_iter;
+    //! number of granted workers not finished
+    std::atomic_size_t nr_unfinished;
+};
+
+struct SharedThreadPool::Worker {
+    std::thread thread;
+    //! the job granted to the worker; reset by the worker when finished
+    std::atomic<Job*> job{nullptr};
+    //! thread id passed to the task, set before the job
+    size_t thread_id = 0;
+    std::atomic_bool affinity_flag{false};
+};
+
+namespace {
+std::mutex g_shared_thread_pool_mtx;
+std::shared_ptr<SharedThreadPool> g_shared_thread_pool;
+}  // anonymous namespace
+
+SharedThreadPool::SharedThreadPool(size_t nr_threads, size_t max_concurrency)
+        : m_max_concurrency{max_concurrency} {
+    mgb_assert(nr_threads >= 1, "SharedThreadPool needs at least one thread");
+    if (nr_threads > static_cast<size_t>(sys::get_cpu_count())) {
+        mgb_log_debug(
+                "The number of shared threads is bigger than number of "
+                "physical cpu cores, got: %zu core_number: %zu",
+                nr_threads, static_cast<size_t>(sys::get_cpu_count()));
+    }
+    for (size_t i = 0; i < nr_threads; ++i) {
+        m_workers.emplace_back(new Worker);
+        m_idle.push_back(i);
+    }
+    // start the threads after all the workers are created, as they are
+    // accessed by index
+    for (size_t i = 0; i < nr_threads; ++i) {
+        m_workers[i]->thread = std::thread{[this, i]() { worker_loop(i); }};
+    }
+}
+
+SharedThreadPool::~SharedThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock{m_wake_mtx};
+        m_stop = true;
+    }
+    m_wake_cv.notify_all();
+    for (auto&& i : m_workers) {
+        i->thread.join();
+    }
+}
+
+void SharedThreadPool::worker_loop(size_t idx) {
+    auto&& worker = *m_workers[idx];
+    while (!m_stop) {
+        if (worker.affinity_flag.load(std::memory_order_acquire)) {
+            worker.affinity_flag = false;
+            AffinityCallBack cb;
+            {
+                std::lock_guard<std::mutex> lock{m_mtx};
+                cb = m_core_binding_function;
+            }
+            if (cb) {
+                cb(idx);
+            }
+        }
+        if (auto job = worker.job.load(std::memory_order_acquire)) {
+            int index = -1;
+            while ((index = job->task_iter.fetch_sub(1, std::memory_order_acq_rel)) &&
+                   index > 0) {
+                (*job->task)(
+                        static_cast<size_t>(job->nr_parallelism - index),
+                        worker.thread_id);
+            }
+            worker.job.store(nullptr, std::memory_order_relaxed);
+            //! the job lives on the stack of the caller, which returns after
+            //! this, so it must not be accessed any more
+            job->nr_unfinished.fetch_sub(1, std::memory_order_release);
+            continue;
+        }
+        if (m_nr_active.load(std::memory_order_acquire)) {
+            //! Wait next task coming
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock{m_wake_mtx};
+        m_wake_cv.wait(lock, [this, &worker]() {
+            return m_stop || m_nr_active.load() || worker.job.load() ||
+                   worker.affinity_flag.load();
+        });
+    }
+}
+
+void SharedThreadPool::add_task(
+        const TaskElem& task_elem, size_t nr_threads, size_t weight) {
+    size_t parallelism = task_elem.nr_parallelism;
+    mgb_assert(nr_threads >= 1 && weight >= 1);
+    if (parallelism == 1 || nr_threads == 1) {
+        for (size_t i = 0; i < parallelism; i++) {
+            task_elem.task(i, 0);
+        }
+        return;
+    }
+
+    SmallVector<size_t, 16> granted;
+    {
+        std::unique_lock<std::mutex> lock{m_mtx};
+        if (m_max_concurrency) {
+            m_cv.wait(lock, [this]() { return m_nr_running < m_max_concurrency; });
+        }
+        ++m_nr_running;
+        m_running_weight += weight;
+        size_t quota = m_workers.size() * weight / m_running_weight;
+        size_t nr = std::min({nr_threads - 1, parallelism - 1, quota, m_idle.size()});
+        for (size_t i = 0; i < nr; ++i) {
+            granted.push_back(m_idle.back());
+            m_idle.pop_back();
+        }
+    }
+
+    Job job;
+    job.task = &task_elem.task;
+    job.nr_parallelism = parallelism;
+    job.task_iter.store(parallelism, std::memory_order_relaxed);
+    job.nr_unfinished.store(granted.size(), std::memory_order_relaxed);
+    for (size_t i = 0; i < granted.size(); ++i) {
+        auto&& worker = *m_workers[granted[i]];
+        worker.thread_id = i;
+        worker.job.store(&job, std::memory_order_release);
+    }
+    if (!granted.empty() && !m_nr_active.load()) {
+        std::lock_guard<std::mutex> lock{m_wake_mtx};
+        m_wake_cv.notify_all();
+    }
+
+    //! the calling thread working
+    int index = -1;
+    while ((index = job.task_iter.fetch_sub(1, std::memory_order_acq_rel)) &&
+           index > 0) {
+        task_elem.task(static_cast<size_t>(parallelism - index), nr_threads - 1);
+    }
+    while (job.nr_unfinished.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{m_mtx};
+        m_idle.insert(m_idle.end(), granted.begin(), granted.end());
+        --m_nr_running;
+        m_running_weight -= weight;
+    }
+    if (m_max_concurrency) {
+        m_cv.notify_one();
+    }
+}
+
+void SharedThreadPool::set_affinity(AffinityCallBack affinity_cb) {
+    mgb_assert(affinity_cb, "The affinity callback must not be nullptr");
+    {
+        std::lock_guard<std::mutex> lock{m_mtx};
+        m_core_binding_function = affinity_cb;
+        ++m_affinity_version;
+    }
+    {
+        std::lock_guard<std::mutex> lock{m_wake_mtx};
+        for (auto&& i : m_workers) {
+            i->affinity_flag = true;
+        }
+    }
+    m_wake_cv.notify_all();
+}
+
+void SharedThreadPool::bind_caller(size_t& affinity_version) {
+    if (affinity_version == m_affinity_version.load()) {
+        return;
+    }
+    AffinityCallBack cb;
+    {
+        std::lock_guard<std::mutex> lock{m_mtx};
+        cb = m_core_binding_function;
+        affinity_version = m_affinity_version;
+    }
+    if (cb) {
+        cb(m_workers.size());
+    }
+}
+
+void SharedThreadPool::active() {
+    if (!m_nr_active.fetch_add(1)) {
+        std::lock_guard<std::mutex> lock{m_wake_mtx};
+        m_wake_cv.notify_all();
+    }
+}
+
+void SharedThreadPool::deactive() {
+    auto prev = m_nr_active.fetch_sub(1);
+    mgb_assert(prev, "unbalanced SharedThreadPool::deactive");
+}
+
+void SharedThreadPool::set_global(std::shared_ptr<SharedThreadPool> pool) {
+    std::lock_guard<std::mutex> lock{g_shared_thread_pool_mtx};
+    g_shared_thread_pool = std::move(pool);
+}
+
+std::shared_ptr<SharedThreadPool> SharedThreadPool::global() {
+    std::lock_guard<std::mutex> lock{g_shared_thread_pool_mtx};
+    return g_shared_thread_pool;
+}
+
+/* ======================== ThreadPool ======================== */
 ThreadPool::ThreadPool(size_t threads_num)
         : m_nr_threads(threads_num),
           m_main_affinity_flag{false},
@@ -49,8 +263,9 @@ ThreadPool::ThreadPool(size_t threads_num)
                                 //! index is decrease, use
                                 //! m_all_task_number - index to get the
                                 //! increase id which will pass to task
-                                m_task(static_cast<size_t>(m_nr_parallelism - index),
-                                       i);
+                                (*m_task)(
+                                        static_cast<size_t>(m_nr_parallelism - index),
+                                        i);
                             }
                             //! Flag worker is finished
                             m_workers[i]->work_flag.store(
@@ -70,7 +285,33 @@ ThreadPool::ThreadPool(size_t threads_num)
         }
     }
 }
+ThreadPool::ThreadPool(
+        size_t threads_num, std::shared_ptr<SharedThreadPool> shared_pool)
+        : m_nr_threads(threads_num),
+          m_main_affinity_flag{false},
+          m_stop{false},
+          m_active{false},
+          m_shared_pool{std::move(shared_pool)} {
+    mgb_assert(m_shared_pool);
+    m_nr_threads = std::max<size_t>(
+            std::min(m_nr_threads, m_shared_pool->nr_threads() + 1), 1);
+}
+
+void ThreadPool::set_weight(size_t weight) {
+    mgb_assert(weight >= 1, "the weight of ThreadPool must be positive");
+    m_weight = weight;
+}
+
 void ThreadPool::add_task(const TaskElem& task_elem) {
+    if (m_shared_pool) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex_task);
+            m_shared_pool->bind_caller(m_shared_affinity_version);
+        }
+        active();
+        m_shared_pool->add_task(task_elem, m_nr_threads, m_weight);
+        return;
+    }
     //! Make sure the main thread have bind
     if (m_main_affinity_flag && m_core_binding_function != nullptr) {
         std::lock_guard<std::mutex> lock(m_mutex_task);
@@ -93,9 +334,7 @@ void ThreadPool::add_task(const TaskElem& task_elem) {
         //! Set the task number, task iter and task
         m_nr_parallelism = parallelism;
         m_task_iter.exchange(parallelism, std::memory_order_relaxed);
-        m_task = [&task_elem](size_t index, size_t thread_id) {
-            task_elem.task(index, thread_id);
-        };
+        m_task = &task_elem.task;
         //! Set flag to start thread working
         for (uint32_t i = 0; i < m_nr_threads - 1; i++) {
             m_workers[i]->work_flag = true;
@@ -104,15 +343,20 @@ void ThreadPool::add_task(const TaskElem& task_elem) {
         int index = -1;
         while ((index = m_task_iter.fetch_sub(1, std::memory_order_acq_rel)) &&
                (index > 0)) {
-            m_task(static_cast<size_t>(m_nr_parallelism - index), m_nr_threads - 1);
+            (*m_task)(static_cast<size_t>(m_nr_parallelism - index), m_nr_threads - 1);
         }
         //! make sure all threads done
         sync();
+        m_task = nullptr;
     }
 }
 
 void ThreadPool::set_affinity(AffinityCallBack affinity_cb) {
     mgb_assert(affinity_cb, "The affinity callback must not be nullptr");
+    if (m_shared_pool) {
+        m_shared_pool->set_affinity(affinity_cb);
+        return;
+    }
     std::lock_guard<std::mutex> lock(m_mutex_task);
     m_core_binding_function = affinity_cb;
     for (size_t i = 0; i < m_nr_threads - 1; i++) {
@@ -126,6 +370,10 @@ size_t ThreadPool::nr_threads() const {
 }
 
 void ThreadPool::sync() {
+    if (m_shared_pool) {
+        //! tasks in the shared workers are finished in add_task()
+        return;
+    }
     bool no_finished = false;
     do {
         no_finished = false;
@@ -143,6 +391,9 @@ void ThreadPool::sync() {
 void ThreadPool::active() {
     if (!m_active) {
         std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_shared_pool && !m_active) {
+            m_shared_pool->active();
+        }
         m_active = true;
         m_cv.notify_all();
     }
@@ -150,9 +401,16 @@ void ThreadPool::active() {
 void ThreadPool::deactive() {
     std::lock_guard<std::mutex> lock_task(m_mutex_task);
     std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_shared_pool && m_active) {
+        m_shared_pool->deactive();
+    }
     m_active = false;
 }
 ThreadPool::~ThreadPool() {
+    if (m_shared_pool) {
+        deactive();
+        return;
+    }
     std::lock_guard<std::mutex> lock_task(m_mutex_task);
     {
         std::unique_lock<std::mutex> lock(m_mutex);
@@ -123,11 +123,19 @@ public:
             int nr_threads;
         };
 
+        /*!
+         * NUMA node that threads and memory of a cpu or multithread comp
+         * node are bound to; -1 means no NUMA binding
+         */
+        int numa_node = -1;
+
         /*!
          * \brief parse a string identifier
          *
          * currently supported ID format: (gpu|cpu)<n>[:m] where n is the
-         * device number, possibly with m as the stream id.
+         * device number, possibly with m as the stream id. A suffix of
+         * @numa<k> can be appended to cpu and multithread IDs to bind them
+         * to NUMA node k.
          */
         MGE_WIN_DECLSPEC_FUC static Locator parse(const std::string& id);
 
@@ -158,7 +166,8 @@ public:
         MGE_WIN_DECLSPEC_FUC std::string to_string() const;
 
         bool operator==(const Locator& rhs) const {
-            return type == rhs.type && device == rhs.device && stream == rhs.stream;
+            return type == rhs.type && device == rhs.device && stream == rhs.stream &&
+                   numa_node == rhs.numa_node;
         }
     };
 
@@ -751,7 +760,8 @@ template <>
 struct HashTrait<CompNode::Locator> {
     static size_t eval(const CompNode::Locator& val) {
         return static_cast<size_t>(val.device) + (static_cast<size_t>(val.type) << 4) +
-               (static_cast<size_t>(val.stream) << 8);
+               (static_cast<size_t>(val.stream) << 8) +
+               (static_cast<size_t>(val.numa_node + 1) << 24);
     }
 };
 
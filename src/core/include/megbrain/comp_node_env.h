@@ -230,6 +230,11 @@ public:
     virtual void set_affinity(AffinityCallBack&& /*affinity_cb*/) {
         mgb_assert(0, "The CompNode set_affinity is not implement");
     }
+    //! set the weight of the comp node when its thread pool runs in the
+    //! SharedThreadPool; ignored if the thread pool owns its workers
+    virtual void set_thread_pool_weight(size_t /*weight*/) {
+        mgb_assert(0, "The CompNode set_thread_pool_weight is not implement");
+    }
 };
 using AtlasDispatcher = CPUDispatcher;
 
@@ -532,6 +537,10 @@ public:
         void set_affinity(AffinityCallBack&& cb) const {
             dispatcher->set_affinity(std::move(cb));
         }
+
+        void set_thread_pool_weight(size_t weight) const {
+            dispatcher->set_thread_pool_weight(weight);
+        }
     };
 
     const CpuEnv& cpu_env() const {
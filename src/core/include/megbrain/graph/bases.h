@@ -116,7 +116,33 @@ public:
  * \brief an object that executes asynchronously
  */
 class AsyncExecutable : public json::Serializable, public CompNodeDepedentObject {
+public:
+    /*!
+     * \brief time in seconds spent on each phase of graph compiling
+     *
+     * Static shape inference (which also selects algorithms through
+     * workspace size inference) and static memory planning are performed
+     * on the first execution unless allocate_static_mem_after_graph_compile
+     * is set, and they would be filled after first call to execute() in
+     * such case.
+     */
+    struct CompilePhaseTime {
+        double graph_opt = 0;         //!< graph optimization passes
+        double opr_seq = 0;           //!< topological sorting
+        double seq_init = 0;          //!< mem manager and comp node seq setup
+        double static_infer = 0;      //!< static shape and workspace inference
+        double static_mem_plan = 0;   //!< mem forwarding and static allocation
+        double static_mem_alloc = 0;  //!< device memory allocation
+
+        double total() const {
+            return graph_opt + opr_seq + seq_init + static_infer + static_mem_plan +
+                   static_mem_alloc;
+        }
+    };
+
+private:
     UserDataContainer m_user_data;
+    CompilePhaseTime m_compile_phase_time;
 
 public:
     virtual ~AsyncExecutable() noexcept;
@@ -172,6 +198,13 @@ public:
     //! user data associated with a compiled executable
     UserDataContainer& user_data() { return m_user_data; }
 
+    //! time spent on compiling this executable
+    CompilePhaseTime& compile_phase_time() { return m_compile_phase_time; }
+
+    const CompilePhaseTime& compile_phase_time() const {
+        return m_compile_phase_time;
+    }
+
     void set_output_vars(const VarNodeArray& vars) {
         std::shared_ptr<OutputVarsUserData> ud = std::make_shared<OutputVarsUserData>();
         ud->set_output_vars(vars);
@@ -102,6 +102,10 @@ struct GraphCommonOptimizeOptions {
     bool weight_preprocess = false;
     //! fuse preprocess patten, like astype + pad_channel + dimshuffle
     bool fuse_preprocess = false;
+    //! fuse the decomposed scaled dot-product attention of transformers
+    bool fuse_attention = false;
+    //! fuse layer norm and gelu written in elemwise oprs
+    bool fuse_layer_norm_gelu = false;
     enum LayoutTransform : uint32_t {
         DEFAULT,
         NCHW4,       ///< compute using NCHW4 tensor format
@@ -135,6 +139,8 @@ struct GraphCommonOptimizeOptions {
     SET(fuse_conv_bias_with_z);
     SET(fuse_preprocess);
     SET(weight_preprocess);
+    SET(fuse_attention);
+    SET(fuse_layer_norm_gelu);
 #undef SET
 #define SET(_trans, _trans_capital)                                 \
     GraphCommonOptimizeOptions& enable_##_trans() {                 \
@@ -323,6 +329,11 @@ public:
             //! static memory allocation algorithm)
             bool enable_mem_reuse_alloc = true;
 
+            //! whether to solve the static memory allocation with all the
+            //! algorithms and use the one with the smallest footprint; this
+            //! makes planning slower
+            bool enable_mem_alloc_algo_search = false;
+
             //! whether to enable comp node optimization (e.g. using copy
             //! stream for I/O operators)
             bool enable_seq_comp_node_opt = true;
@@ -429,6 +440,26 @@ public:
         //! whether to allocate static memory just after compiling graph
         bool allocate_static_mem_after_graph_compile = false;
 
+        /*!
+         * number of threads to solve static memory plans of different comp
+         * nodes concurrently; graphs on a single comp node are not affected.
+         * Other phases of graph compiling are serial. Values less than 2
+         * disable multithreading.
+         */
+        size_t nr_mem_plan_threads = 1;
+
+        /*!
+         * whether to store solved static memory plans in PersistentCache
+         * and reuse them on later compiles. Plans are keyed by a digest of
+         * the whole allocation problem (chunk sizes, life intervals, memory
+         * forwarding, alignment and padding), which is compared in full on a
+         * hit, so it is effectively keyed by the optimized graph and input
+         * shapes. With
+         * an InFilePersistentCache it can be saved along with the profiled
+         * algorithms to skip planning in later processes.
+         */
+        bool cache_static_mem_plan = false;
+
         /*!
          * whether only to perform non-computing tasks (like memory
          * allocation and queue initialization) for next exec. This would be
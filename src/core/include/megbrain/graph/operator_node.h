@@ -610,6 +610,16 @@ public:
      */
     virtual void mem_plan_fwd_in2out_writable() {}
 
+    /*!
+     * \brief called by graph compiler to setup forwarding from output
+     *      memory to input vars (see VarNode::set_fwd_out2in_writable)
+     *
+     * This function is called before mem_plan_fwd_in2out_readonly(), in
+     * reversed topological order, and only if all inputs and outputs have
+     * static storage
+     */
+    virtual void mem_plan_fwd_out2in_writable() {}
+
     /* ===================== event callbacks ===================== */
     struct OprEventCallback;
 
@@ -315,6 +315,24 @@ public:
      */
     MGE_WIN_DECLSPEC_FUC VarNode& set_fwd_in2out_writable_force(VarNode* input);
 
+    /*!
+     * \brief request that this var be computed directly into a sub tensor
+     *      of an output var of its reader opr
+     *
+     * This is the reverse of set_fwd_in2out_readonly(): the memory of
+     * this var becomes a view of \p output described by \p sub, so its
+     * owner opr writes into the output buffer of the reader (e.g. Concat).
+     * Only statically allocated vars with contiguous sub layout are
+     * supported.
+     *
+     * Note that this function must be called from
+     *      OperatorNodeBase::mem_plan_fwd_out2in_writable.
+     *
+     * \return whether this request could be satisfied
+     */
+    MGE_WIN_DECLSPEC_FUC bool set_fwd_out2in_writable(
+            VarNode* output, const SubTensorSpec& sub);
+
     /* ===================== getter and setters =====================  */
 
     OperatorNodeBase* owner_opr() const { return m_owner; }
@@ -41,6 +41,24 @@ MGE_WIN_DECLSPEC_FUC int get_cpu_count();
 //! set cpu affinity for caller thread
 MGE_WIN_DECLSPEC_FUC void set_cpu_affinity(const std::vector<int>& cpuset);
 
+//! get number of NUMA nodes on this system; 1 if NUMA is not supported
+MGE_WIN_DECLSPEC_FUC int get_numa_node_count();
+
+//! get IDs of CPU cores belonging to given NUMA node; empty if unknown
+MGE_WIN_DECLSPEC_FUC std::vector<int> get_numa_node_cpus(int node);
+
+/*!
+ * \brief prefer to place physical pages of the memory region on given NUMA
+ *      node
+ *
+ * Only pages fully contained in [ptr, ptr + size) are affected. Pages
+ * touched before the call are migrated to the node, which is slower than
+ * binding untouched memory.
+ *
+ * \return whether the policy is successfully applied
+ */
+MGE_WIN_DECLSPEC_FUC bool bind_mem_to_numa_node(void* ptr, size_t size, int node);
+
 //! whether stderr supports ansi color code
 MGE_WIN_DECLSPEC_FUC bool stderr_ansi_color();
 
@@ -72,6 +72,9 @@ public:
     MGE_WIN_DECLSPEC_FUC void dump_cache(const char* path);
     MGE_WIN_DECLSPEC_FUC void dump_cache(OutputFile* out_file);
 
+    //! put all entries of this cache into \p dest
+    MGE_WIN_DECLSPEC_FUC void put_to(PersistentCache& dest);
+
     MGE_WIN_DECLSPEC_FUC Maybe<Blob> get(
             const std::string& category, const Blob& key) override;
     MGE_WIN_DECLSPEC_FUC void put(
@@ -0,0 +1,107 @@
+/**
+ * \file src/core/include/megbrain/utils/mmap_persistent_cache.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#pragma once
+
+#include "megbrain/utils/persistent_cache.h"
+
+#include <mutex>
+#include <shared_mutex>
+
+namespace mgb {
+
+/*!
+ * \brief persistent cache stored in a memory-mapped file with a hash index
+ *
+ * Unlike InFilePersistentCache, the file is not parsed into memory: lookups
+ * walk a hash chain in the mapped file, and each put() appends a record to
+ * the file at once. Writers are serialized by an exclusive file lock, so the
+ * file can be shared by multiple processes, and entries put by any of them
+ * are visible to the others without reloading.
+ *
+ * file format (all integers in local endian):
+ *
+ *  header: <magic|char[8]><version|uint32_t><nr_bucket|uint32_t>
+ *  bucket table: <offset of newest record|uint64_t>[nr_bucket]
+ *  records, each aligned to 8 bytes:
+ *      <next|uint64_t><hash|uint64_t><category_size|uint32_t>
+ *      <key_size|uint32_t><value_size|uint32_t><reserved|uint32_t>
+ *      <category><key><value>
+ *
+ * A record is fully written before it is linked into its bucket, and
+ * records are never modified afterwards, so readers need no lock. A later
+ * put() of an existing key shadows the older record.
+ *
+ * \warning only supported on platforms with mmap and flock
+ */
+class MmapPersistentCache final : public PersistentCache {
+    //! the mapped range covers \p capacity bytes, of which the first \p size
+    //! bytes are backed by the file
+    struct Mapping {
+        uint8_t* ptr = nullptr;
+        size_t size = 0, capacity = 0;
+    };
+
+    //! minimal reserved range of a mapping
+    static constexpr size_t MIN_MAP_CAPACITY = 1 << 20;
+
+    int m_fd = -1;
+    uint32_t m_nr_bucket = 0;
+    //! current mapping; readers hold m_map_mtx in shared mode
+    Mapping m_map;
+    /*!
+     * outdated mappings, kept alive since returned blobs may point to them;
+     * each remapping at least doubles the capacity, so they take less
+     * address space than the current one in total
+     */
+    std::vector<Mapping> m_old_maps;
+    std::shared_timed_mutex m_map_mtx;
+    //! serialize writers in this process; flock() serializes processes
+    std::mutex m_write_mtx;
+
+    struct Record;
+
+    //! remap the file if it has grown; m_map_mtx must not be held
+    void update_mapping();
+
+    uint64_t* bucket(uint64_t hash) const;
+
+    /*!
+     * \brief find a record in current mapping; m_map_mtx must be held
+     * \param[out] need_remap set to true if the chain leads beyond the
+     *      mapped range, and nullptr would be returned
+     */
+    const Record* find(
+            uint64_t hash, const std::string& category, const Blob& key,
+            bool* need_remap) const;
+
+    static uint64_t hash(const std::string& category, const Blob& key);
+
+public:
+    static constexpr uint32_t DEFAULT_NR_BUCKET = 1 << 14;
+
+    /*!
+     * \param path cache file, which is created if it does not exist
+     * \param nr_bucket number of hash buckets of a new file; ignored if the
+     *      file already exists
+     */
+    MGE_WIN_DECLSPEC_FUC MmapPersistentCache(
+            const char* path, uint32_t nr_bucket = DEFAULT_NR_BUCKET);
+    MGE_WIN_DECLSPEC_FUC ~MmapPersistentCache();
+
+    MGE_WIN_DECLSPEC_FUC Maybe<Blob> get(
+            const std::string& category, const Blob& key) override;
+    MGE_WIN_DECLSPEC_FUC void put(
+            const std::string& category, const Blob& key, const Blob& value) override;
+};
+
+}  // namespace mgb
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
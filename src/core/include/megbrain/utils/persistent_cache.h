@@ -103,6 +103,9 @@ class AlgoChooserProfileCache {
 public:
     AlgoChooserProfileCache(CompNode cn, const char* opr_type);
 
+    //! category of the entries in PersistentCache
+    const std::string& category() const { return m_category; }
+
     /*!
      * \brief key to identify a profiling run
      *
@@ -153,6 +156,9 @@ public:
      * removed.
      */
     void put(const Key& key, Result& result);
+
+    //! decode a result from the value stored in PersistentCache
+    static Result deserialize_result(const PersistentCache::Blob& blob);
 };
 
 }  // namespace mgb
@@ -17,6 +17,7 @@
 #include <atomic>
 #include <condition_variable>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <thread>
@@ -52,6 +53,84 @@ public:
     bool affinity_flag{false};
 };
 
+/**
+ * \brief worker threads shared by the ThreadPools of many comp nodes
+ *
+ * Each multithread comp node owns a ThreadPool with its own workers by
+ * default, so loading many multithread models oversubscribes the cores. A
+ * ThreadPool created on a SharedThreadPool has no worker of its own: each
+ * task is run by the calling thread and the idle shared workers it is granted.
+ *
+ * The workers are granted for one task at a time. When tasks from several
+ * ThreadPools run at the same time, the workers are divided in proportion to
+ * the weights of the ThreadPools; a task may run only on its calling thread if
+ * all the workers are busy. At most max_concurrency tasks run in the shared
+ * workers at the same time, and more tasks wait until one of them finishes.
+ *
+ * The affinity callback is called with id in [0, nr_threads()) on the workers,
+ * and with id nr_threads() on the calling threads.
+ */
+class SharedThreadPool : public NonCopyableObj {
+public:
+    //! \param max_concurrency max number of concurrent tasks; 0 for no limit
+    SharedThreadPool(size_t nr_threads, size_t max_concurrency = 0);
+    ~SharedThreadPool();
+
+    //! number of the shared workers, not including the calling threads
+    size_t nr_threads() const { return m_workers.size(); }
+
+    size_t max_concurrency() const { return m_max_concurrency; }
+
+    //! set the affinity of the workers and of the calling threads
+    void set_affinity(AffinityCallBack affinity_cb);
+
+    /*!
+     * \brief run a task on the calling thread and the granted workers
+     * \param nr_threads max number of threads used by the task, including the
+     *      calling thread, which is given the thread id nr_threads - 1
+     * \param weight weight of the caller when dividing the workers
+     */
+    void add_task(const TaskElem& task_elem, size_t nr_threads, size_t weight);
+
+    //! the workers keep spinning while any caller is active
+    void active();
+    void deactive();
+
+    //! bind the calling thread if set_affinity() is called after its last
+    //! binding
+    void bind_caller(size_t& affinity_version);
+
+    /*!
+     * \brief set the SharedThreadPool used by multithread comp nodes created
+     *      later; nullptr to make them own their workers again
+     */
+    static void set_global(std::shared_ptr<SharedThreadPool> pool);
+    static std::shared_ptr<SharedThreadPool> global();
+
+private:
+    struct Job;
+    struct Worker;
+
+    void worker_loop(size_t idx);
+
+    const size_t m_max_concurrency;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+
+    //! protects the fields of scheduling below and the affinity callback
+    std::mutex m_mtx;
+    std::condition_variable m_cv;
+    std::vector<size_t> m_idle;
+    size_t m_nr_running = 0, m_running_weight = 0;
+    AffinityCallBack m_core_binding_function{nullptr};
+    std::atomic_size_t m_affinity_version{0};
+
+    //! the workers sleep on m_wake_cv when there is no active caller
+    std::mutex m_wake_mtx;
+    std::condition_variable m_wake_cv;
+    std::atomic_size_t m_nr_active{0};
+    std::atomic_bool m_stop{false};
+};
+
 /**
  * \brief ThreadPool execute the task in multi-threads(nr_threads>1) mode , it
  * will fallback to single-thread mode if nr_thread is 1.
@@ -60,6 +139,16 @@ class ThreadPool : public NonCopyableObj {
 public:
     //! Create thread-pool nr_threads thread_pool
     ThreadPool(size_t nr_threads);
+
+    //! Create thread-pool running tasks in the shared workers, nr_threads is
+    //! limited by the number of shared workers
+    ThreadPool(size_t nr_threads, std::shared_ptr<SharedThreadPool> shared_pool);
+
+    //! weight of this thread-pool in the shared workers
+    void set_weight(size_t weight);
+    size_t weight() const { return m_weight; }
+
+    SharedThreadPool* shared_pool() const { return m_shared_pool.get(); }
     //! The main thread set the task, parallelism and worker flag to
     //! notify other thread.
     void add_task(const TaskElem& task_elem);
@@ -87,8 +176,9 @@ private:
     size_t m_nr_parallelism = 0;
     std::atomic_bool m_stop{false};
     std::atomic_bool m_active{false};
-    //! The executable funcition pointer
-    MultiThreadingTask m_task;
+    //! The executable function of current task, it points into the TaskElem
+    //! passed to add_task() so no closure is created for each task
+    const MultiThreadingTask* m_task = nullptr;
 
     std::vector<Worker*> m_workers;
     //! The task iter, when finished one, the m_all_task_iter sub 1
@@ -97,6 +187,11 @@ private:
     std::condition_variable m_cv;
     std::mutex m_mutex;
     std::mutex m_mutex_task;
+
+    std::shared_ptr<SharedThreadPool> m_shared_pool;
+    std::atomic_size_t m_weight{1};
+    //! affinity version of the shared pool the calling thread is bound with
+    size_t m_shared_affinity_version = 0;
 };
 #else
 /**
@@ -112,6 +207,9 @@ public:
     void sync() {}
     ~ThreadPool() {}
     size_t nr_threads() const { return 1_z; }
+    void set_weight(size_t) {}
+    size_t weight() const { return 1_z; }
+    void* shared_pool() const { return nullptr; }
 };
 
 #endif
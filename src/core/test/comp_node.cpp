@@ -62,6 +62,25 @@ TEST(TestCompNode, Parse) {
             L::parse("multithread:default:2"),
             make_lc(D::MULTITHREAD, L::DEVICE_MULTITHREAD_DEFAULT, 2));
 
+    {
+        auto numa_lc = [&](L lc, int node) {
+            lc.numa_node = node;
+            return lc;
+        };
+        ASSERT_EQ(L::parse("cpu2:3@numa1"), numa_lc(make_lc(D::CPU, 2, 3), 1));
+        ASSERT_EQ(
+                L::parse("multithread4:0@numa0"),
+                numa_lc(make_lc(D::MULTITHREAD, 0, 4), 0));
+        ASSERT_EQ(
+                L::parse("cpu:default@numa2"),
+                numa_lc(make_lc(D::CPU, L::DEVICE_CPU_DEFAULT, 0), 2));
+        ASSERT_FALSE(L::parse("cpu2:3@numa1") == L::parse("cpu2:3"));
+        ASSERT_EQ(L::parse("cpu2:3@numa1").to_string(), "cpu2:3@numa1");
+        ASSERT_EQ(
+                L::parse("multithread4:0@numa1").to_string(),
+                "multithread4:0@numa1");
+    }
+
     ASSERT_THROW(L::parse("apu"), MegBrainError);
     ASSERT_THROW(L::parse("fpgbx"), MegBrainError);
     ASSERT_THROW(L::parse("cab0"), MegBrainError);
@@ -77,6 +96,35 @@ TEST(TestCompNode, Parse) {
     ASSERT_THROW(L::parse("multithread1:"), MegBrainError);
     ASSERT_THROW(L::parse("multithread1:default"), MegBrainError);
     ASSERT_THROW(L::parse("multithread1:default:0"), MegBrainError);
+    ASSERT_THROW(L::parse("cpu0@numa"), MegBrainError);
+    ASSERT_THROW(L::parse("cpu0@numax"), MegBrainError);
+    ASSERT_THROW(L::parse("cpu0@numa-1"), MegBrainError);
+    ASSERT_THROW(L::parse("cpu0@numa99999999999"), MegBrainError);
+    ASSERT_THROW(L::parse("cpu0@node1"), MegBrainError);
+    ASSERT_THROW(L::parse("xpu0@numa0"), MegBrainError);
+}
+
+TEST(TestCompNode, LoadNuma) {
+    // numa node 0 is always available, even if numa is not supported
+    auto cn = CompNode::load("cpu1@numa0"),
+         cn_mt = CompNode::load("multithread2:1@numa0");
+    ASSERT_NE(CompNode::load("cpu1"), cn);
+    ASSERT_EQ(CompNode::load("cpu1@numa0"), cn);
+    ASSERT_EQ(0, cn.locator().numa_node);
+    ASSERT_EQ(0, cn_mt.locator().numa_node);
+    ASSERT_THROW(
+            CompNode::load(ssprintf("cpu1@numa%d", sys::get_numa_node_count())),
+            MegBrainError);
+
+    HostTensorGenerator<> gen;
+    auto host_x = gen({1024, 1024});
+    for (auto&& i : {cn, cn_mt}) {
+        DeviceTensorND dev_x;
+        dev_x.comp_node(i).copy_from(*host_x);
+        HostTensorND host_y;
+        host_y.copy_from(dev_x).sync();
+        MGB_ASSERT_TENSOR_EQ(*host_x, host_y);
+    }
 }
 
 TEST(TestCompNode, SetDefaultDev) {
@@ -25,6 +25,7 @@
 #include "megbrain/opr/tensor_manip.h"
 #include "megbrain/opr/utility.h"
 #include "megbrain/plugin/profiler.h"
+#include "megbrain/utils/persistent_cache.h"
 #include "megbrain/utils/timer.h"
 
 #include "megbrain/test/helper.h"
@@ -34,6 +35,7 @@
 #include <array>
 #include <atomic>
 #include <chrono>
+#include <cmath>
 #include <memory>
 
 using namespace mgb;
@@ -1748,6 +1750,127 @@ TEST(TestGraph, UpdateStaticAllocPlan) {
     func->execute();
 }
 
+TEST(TestGraph, CompilePhaseTimeConcurrentMemPlan) {
+    auto cns = load_multiple_xpus(2);
+    HostTensorGenerator<> gen;
+    auto host_x = gen({23}, cns[0]);
+    for (bool alloc_after_compile : {false, true}) {
+        auto graph = ComputingGraph::make();
+        graph->options().nr_mem_plan_threads = 2;
+        graph->options().allocate_static_mem_after_graph_compile =
+                alloc_after_compile;
+        auto x = opr::Host2DeviceCopy::make(*graph, host_x),
+             y = opr::Copy::make(x * 2, cns[1]) + 1,
+             z = opr::Copy::make(y * 3, cns[0]) - 1;
+        HostTensorND host_z;
+        auto func = graph->compile({make_callback_copy(z, host_z)});
+        if (alloc_after_compile) {
+            ASSERT_GT(func->compile_phase_time().static_mem_plan, 0);
+        }
+        func->execute();
+        auto&& phase_time = func->compile_phase_time();
+        ASSERT_GT(phase_time.opr_seq, 0);
+        ASSERT_GT(phase_time.static_mem_plan, 0);
+        ASSERT_GE(phase_time.total(), phase_time.static_infer);
+        for (size_t i = 0; i < 23; ++i) {
+            MGB_ASSERT_FLOAT_EQ(
+                    (host_x->ptr<float>()[i] * 2 + 1) * 3 - 1,
+                    host_z.ptr<float>()[i]);
+        }
+    }
+}
+
+TEST(TestGraph, CacheStaticMemPlan) {
+    class CountingCache final : public PersistentCache {
+        std::shared_ptr<PersistentCache> m_impl =
+                std::make_shared<InMemoryPersistentCache>();
+
+    public:
+        size_t nr_get = 0, nr_hit = 0, nr_put = 0;
+
+        Maybe<Blob> get(const std::string& category, const Blob& key) override {
+            auto ret = m_impl->get(category, key);
+            if (category == "static_mem_plan") {
+                ++nr_get;
+                nr_hit += ret.valid();
+            }
+            return ret;
+        }
+
+        void put(const std::string& category, const Blob& key, const Blob& value)
+                override {
+            nr_put += category == "static_mem_plan";
+            m_impl->put(category, key, value);
+        }
+    };
+    auto cache = std::make_shared<CountingCache>();
+    auto orig_cache = PersistentCache::set_impl(cache);
+
+    HostTensorGenerator<> gen;
+    auto host_x = gen({3, 5, 7});
+    auto run = [&](const TensorShape& shape) {
+        *host_x = *gen(shape);
+        auto graph = ComputingGraph::make();
+        graph->options().cache_static_mem_plan = true;
+        graph->options().graph_opt_level = 0;
+        auto x = opr::Host2DeviceCopy::make(*graph, host_x),
+             y = opr::exp(x * 2 + 1), z = (y - x) * (y + 3);
+        HostTensorND host_z;
+        auto func = graph->compile({make_callback_copy(z, host_z)});
+        auto size = func->update_static_alloc_plan_and_get_size();
+        func->execute();
+        auto px = host_x->ptr<float>(), pz = host_z.ptr<float>();
+        for (size_t i = 0, it = shape.total_nr_elems(); i < it; ++i) {
+            auto yv = std::exp(px[i] * 2 + 1);
+            MGB_ASSERT_FLOAT_EQ((yv - px[i]) * (yv + 3), pz[i]);
+        }
+        return size;
+    };
+
+    auto size0 = run({3, 5, 7});
+    ASSERT_EQ(0u, cache->nr_hit);
+    ASSERT_EQ(cache->nr_get, cache->nr_put);
+    ASSERT_GT(cache->nr_put, 0u);
+
+    // same graph and shape in a new graph: plan should be reused
+    auto nr_put = cache->nr_put;
+    auto size1 = run({3, 5, 7});
+    ASSERT_TRUE(size0 == size1);
+    ASSERT_EQ(nr_put, cache->nr_hit);
+    ASSERT_EQ(nr_put, cache->nr_put);
+
+    // a new shape must not hit the cache
+    auto nr_hit = cache->nr_hit;
+    run({4, 6, 8});
+    ASSERT_EQ(nr_hit, cache->nr_hit);
+
+    PersistentCache::set_impl(orig_cache);
+}
+
+TEST(TestGraph, MemAllocAlgoSearch) {
+    HostTensorGenerator<> gen;
+    auto host_x = gen({2, 3, 5}), host_y = gen({7, 2});
+    auto run = [&](bool algo_search) {
+        auto graph = ComputingGraph::make();
+        graph->options().graph_opt_level = 0;
+        graph->options().seq_opt.enable_mem_alloc_algo_search = algo_search;
+        auto sum = [](SymbolVar x) { return opr::reduce_sum(x, x.make_scalar(1)); };
+        // vars of different sizes and lifetimes
+        auto x = opr::Host2DeviceCopy::make(*graph, host_x),
+             y = opr::Host2DeviceCopy::make(*graph, host_y), a = opr::exp(x) + 1,
+             b = opr::Broadcast::make(sum(a), {7, 7}),
+             c = opr::exp(y * 2) + sum(b), z = sum(c) + sum(a * 3);
+        HostTensorND host_z;
+        auto func = graph->compile({make_callback_copy(z, host_z)});
+        auto size = func->update_static_alloc_plan_and_get_size();
+        func->execute();
+        return std::make_pair(size.at(x.node()->comp_node()), host_z);
+    };
+    auto rst0 = run(false), rst1 = run(true);
+    ASSERT_LE(rst1.first, rst0.first);
+    MGB_ASSERT_TENSOR_EQ(rst0.second, rst1.second);
+}
+
 TEST(TestGraph, CPUGPUHybrid) {
     REQUIRE_GPU(1);
     auto cn_gpu = CompNode::load("gpu0");
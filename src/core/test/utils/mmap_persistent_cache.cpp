@@ -0,0 +1,124 @@
+/**
+ * \file src/core/test/utils/mmap_persistent_cache.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "megbrain/utils/mmap_persistent_cache.h"
+#include "megbrain/test/helper.h"
+
+#include <thread>
+
+#if !defined(_WIN32)
+using namespace mgb;
+
+namespace {
+#define GET_OUTPUT_FILE() output_file(ssprintf("TestMmapPersistentCache.%d", __LINE__))
+
+PersistentCache::Blob to_blob(const std::string& s) {
+    return {s.data(), s.size()};
+}
+
+std::string get_str(
+        PersistentCache& cache, const std::string& category, const std::string& key) {
+    auto ret = cache.get(category, to_blob(key));
+    if (!ret.valid()) {
+        return "<none>";
+    }
+    return {static_cast<const char*>(ret->ptr), ret->size};
+}
+}  // anonymous namespace
+
+TEST(TestMmapPersistentCache, Basic) {
+    auto fname = GET_OUTPUT_FILE();
+    {
+        // use few buckets to test hash chains
+        MmapPersistentCache cache{fname.c_str(), 4};
+        ASSERT_EQ("<none>", get_str(cache, "c0", "k0"));
+        for (int i = 0; i < 20; ++i) {
+            cache.put("c0", to_blob(ssprintf("k%d", i)), to_blob(ssprintf("v%d", i)));
+        }
+        cache.put("c1", to_blob("k0"), to_blob("c1v0"));
+        cache.put("c0", to_blob("k3"), to_blob("new_v3"));
+        cache.put("c0", to_blob(""), to_blob(""));
+        ASSERT_EQ("v0", get_str(cache, "c0", "k0"));
+        ASSERT_EQ("c1v0", get_str(cache, "c1", "k0"));
+        ASSERT_EQ("new_v3", get_str(cache, "c0", "k3"));
+        ASSERT_EQ("", get_str(cache, "c0", ""));
+        ASSERT_EQ("<none>", get_str(cache, "c1", "k1"));
+    }
+
+    // reopen the file
+    MmapPersistentCache cache{fname.c_str()};
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_EQ(i == 3 ? "new_v3" : ssprintf("v%d", i),
+                  get_str(cache, "c0", ssprintf("k%d", i)));
+    }
+    ASSERT_EQ("c1v0", get_str(cache, "c1", "k0"));
+}
+
+TEST(TestMmapPersistentCache, Shared) {
+    auto fname = GET_OUTPUT_FILE();
+    MmapPersistentCache cache0{fname.c_str()}, cache1{fname.c_str()};
+    cache0.put("c", to_blob("k0"), to_blob("v0"));
+    ASSERT_EQ("v0", get_str(cache1, "c", "k0"));
+
+    // blobs returned before remapping should remain valid
+    auto blob = cache1.get("c", to_blob("k0"));
+    ASSERT_TRUE(blob.valid());
+    std::string large(1 << 20, 'x');
+    cache0.put("c", to_blob("k1"), to_blob(large));
+    ASSERT_EQ(large, get_str(cache1, "c", "k1"));
+    ASSERT_EQ("v0", std::string(static_cast<const char*>(blob->ptr), blob->size));
+
+    cache1.put("c", to_blob("k0"), to_blob("v0_new"));
+    ASSERT_EQ("v0_new", get_str(cache0, "c", "k0"));
+}
+
+TEST(TestMmapPersistentCache, ConcurrentPut) {
+    auto fname = GET_OUTPUT_FILE();
+    constexpr int NR_WORKER = 4, NR_ENTRY = 200;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < NR_WORKER; ++i) {
+        workers.emplace_back([&fname, i]() {
+            // each worker opens the file on its own, as separate processes do
+            MmapPersistentCache cache{fname.c_str(), 64};
+            for (int j = 0; j < NR_ENTRY; ++j) {
+                auto key = ssprintf("%d:%d", i, j);
+                cache.put("c", to_blob(key), to_blob(key + "v"));
+                ASSERT_EQ(key + "v", get_str(cache, "c", key));
+            }
+        });
+    }
+    for (auto&& i : workers) {
+        i.join();
+    }
+
+    // no entry should be lost
+    MmapPersistentCache cache{fname.c_str()};
+    for (int i = 0; i < NR_WORKER; ++i) {
+        for (int j = 0; j < NR_ENTRY; ++j) {
+            auto key = ssprintf("%d:%d", i, j);
+            ASSERT_EQ(key + "v", get_str(cache, "c", key));
+        }
+    }
+}
+
+TEST(TestMmapPersistentCache, InvalidFile) {
+    auto fname = GET_OUTPUT_FILE();
+    {
+        FILE* fout = fopen(fname.c_str(), "wb");
+        fputs("not a cache file", fout);
+        fclose(fout);
+    }
+    ASSERT_THROW(MmapPersistentCache{fname.c_str()}, MegBrainError);
+}
+
+#endif  // _WIN32
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -10,8 +10,11 @@
  */
 #include "megbrain/utils/thread_pool.h"
 #include <atomic>
+#include <chrono>
 #include <random>
+#include <set>
 #include "megbrain/comp_node.h"
+#include "megbrain/comp_node_env.h"
 #include "megbrain/opr/io.h"
 #include "megbrain/opr/utility.h"
 #include "megbrain/system.h"
@@ -62,6 +65,162 @@ TEST(TestThreadPool, BASIC) {
     }
 }
 
+TEST(TestThreadPool, ReplayTaskElems) {
+    // task elems are kept alive by the caller and replayed many times, as done
+    // by the cpu comp node seq recorder
+    auto thread_pool = std::make_shared<ThreadPool>(4u);
+    constexpr size_t NR_ELEM = 64, NR_RUN = 20;
+    std::vector<size_t> dst(NR_ELEM, 0);
+    std::atomic_size_t nr_serial{0};
+    std::vector<TaskElem> tasks;
+    tasks.push_back({[&](size_t, size_t) { nr_serial++; }, 1});
+    tasks.push_back({[&](size_t index, size_t) { dst[index] += index; }, NR_ELEM});
+    tasks.push_back({[&](size_t, size_t) { nr_serial++; }, 1});
+    tasks.push_back({[&](size_t index, size_t) { dst[index] += 1; }, NR_ELEM});
+
+    for (size_t run = 0; run < NR_RUN; ++run) {
+        thread_pool->active();
+        for (auto&& i : tasks) {
+            thread_pool->add_task(i);
+        }
+        thread_pool->deactive();
+    }
+    ASSERT_EQ(nr_serial, NR_RUN * 2);
+    for (size_t i = 0; i < NR_ELEM; ++i) {
+        ASSERT_EQ(dst[i], NR_RUN * (i + 1));
+    }
+}
+
+TEST(TestThreadPool, Shared) {
+    // thread pools of several comp nodes run tasks concurrently in 3 shared
+    // workers
+    auto shared_pool = std::make_shared<SharedThreadPool>(3u);
+    constexpr size_t NR_CLIENT = 4, NR_ELEM = 64, NR_RUN = 50;
+    std::vector<std::thread> clients;
+    std::mutex mtx;
+    std::set<std::thread::id> thread_ids;
+    std::atomic_size_t nr_bad_id{0};
+    for (size_t i = 0; i < NR_CLIENT; ++i) {
+        clients.emplace_back([&, i]() {
+            ThreadPool thread_pool{8u, shared_pool};
+            ASSERT_EQ(4u, thread_pool.nr_threads());
+            thread_pool.set_weight(i + 1);
+            std::vector<size_t> dst(NR_ELEM, 0);
+            for (size_t run = 0; run < NR_RUN; ++run) {
+                thread_pool.active();
+                thread_pool.add_task(
+                        {[&](size_t index, size_t thread_id) {
+                             if (thread_id >= thread_pool.nr_threads()) {
+                                 ++nr_bad_id;
+                             }
+                             {
+                                 MGB_LOCK_GUARD(mtx);
+                                 thread_ids.insert(std::this_thread::get_id());
+                             }
+                             dst[index] += index;
+                         },
+                         NR_ELEM});
+                thread_pool.deactive();
+            }
+            for (size_t j = 0; j < NR_ELEM; ++j) {
+                ASSERT_EQ(NR_RUN * j, dst[j]);
+            }
+        });
+    }
+    for (auto&& i : clients) {
+        i.join();
+    }
+    ASSERT_EQ(0u, nr_bad_id);
+    ASSERT_LE(thread_ids.size(), NR_CLIENT + 3);
+}
+
+TEST(TestThreadPool, SharedMaxConcurrency) {
+    auto shared_pool = std::make_shared<SharedThreadPool>(4u, 1u);
+    constexpr size_t NR_CLIENT = 4, NR_RUN = 20;
+    std::atomic_size_t nr_running{0}, max_running{0}, nr_task{0};
+    std::vector<std::thread> clients;
+    for (size_t i = 0; i < NR_CLIENT; ++i) {
+        clients.emplace_back([&]() {
+            ThreadPool thread_pool{2u, shared_pool};
+            for (size_t run = 0; run < NR_RUN; ++run) {
+                std::atomic_size_t nr_begin{0}, nr_end{0};
+                thread_pool.add_task(
+                        {[&](size_t, size_t) {
+                             // the first sub task of a task enters and the
+                             // last one leaves
+                             if (!nr_begin++) {
+                                 auto cur = ++nr_running;
+                                 auto prev = max_running.load();
+                                 while (prev < cur &&
+                                        !max_running.compare_exchange_weak(prev, cur))
+                                     ;
+                             }
+                             ++nr_task;
+                             if (++nr_end == 8) {
+                                 --nr_running;
+                             }
+                         },
+                         8});
+            }
+            thread_pool.deactive();
+        });
+    }
+    for (auto&& i : clients) {
+        i.join();
+    }
+    ASSERT_EQ(NR_CLIENT * NR_RUN * 8, nr_task);
+    ASSERT_EQ(1u, max_running);
+}
+
+TEST(TestThreadPool, SharedAffinity) {
+    auto shared_pool = std::make_shared<SharedThreadPool>(2u);
+    ThreadPool thread_pool{3u, shared_pool};
+    std::mutex mtx;
+    std::set<size_t> bound_ids;
+    thread_pool.set_affinity([&](size_t id) {
+        MGB_LOCK_GUARD(mtx);
+        bound_ids.insert(id);
+    });
+    thread_pool.active();
+    thread_pool.add_task({[](size_t, size_t) {}, 4});
+    thread_pool.deactive();
+    // the workers are bound asynchronously
+    for (int i = 0; i < 1000; ++i) {
+        {
+            MGB_LOCK_GUARD(mtx);
+            if (bound_ids.size() == 3)
+                break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    MGB_LOCK_GUARD(mtx);
+    ASSERT_EQ((std::set<size_t>{0, 1, 2}), bound_ids);
+}
+
+TEST(TestThreadPool, SharedCompNode) {
+    auto shared_pool = std::make_shared<SharedThreadPool>(2u);
+    SharedThreadPool::set_global(shared_pool);
+    // use a locator not loaded by other tests, as comp nodes are cached
+    auto cn = CompNode::load("multithread4:13");
+    SharedThreadPool::set_global(nullptr);
+    auto&& env = CompNodeEnv::from_comp_node(cn);
+    ASSERT_EQ(3u, env.cpu_env().dispatcher->nr_threads());
+    env.cpu_env().set_thread_pool_weight(2);
+
+    HostTensorGenerator<> gen;
+    auto host_x = gen({1024}, cn);
+    HostTensorND host_y;
+    auto graph = ComputingGraph::make();
+    auto x = opr::Host2DeviceCopy::make(*graph, host_x);
+    auto y = x * 2 + 3;
+    auto func = graph->compile({make_callback_copy(y, host_y)});
+    func->execute().wait();
+    auto px = host_x->ptr<float>(), py = host_y.ptr<float>();
+    for (size_t i = 0; i < 1024; ++i) {
+        ASSERT_FLOAT_EQ(px[i] * 2 + 3, py[i]);
+    }
+}
+
 TEST(TestGraph, ParallelRunMultithreadMode) {
     // check race conditions when graphs are executed on multple threads
     std::atomic_size_t sync_counter{0};
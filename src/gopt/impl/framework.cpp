@@ -620,6 +620,12 @@ GraphOptimizer& GraphOptimizer::add_preset_passes(
             inference_opt ? ConstVarType::IMMUTABLE_AND_PARAM : ConstVarType::IMMUTABLE;
     if (inference_opt) {
         add_pass<ConvertBatchNormToElemwisePass>();
+        // the arith passes below would reorder and fuse the elemwise chains of
+        // layer norm and gelu beyond recognition, so fuse them in advance; the
+        // same pass added by the optimize options later is then a no-op
+        if (inference_opt->fuse_layer_norm_gelu) {
+            add_pass<FuseLayerNormGELUPass>();
+        }
     }
     if (!after_grad || inference_opt) {
         add_pass<CondExecConstPredicateFolding>();
@@ -808,6 +814,8 @@ const GraphOptimizer& GraphOptimizer::add_passes_for_optimize_options(
         add_pass<FuseConvBiasNonlinPass>();
         add_pass<FuseConvBiasZPass>();
     });
+    cb(fuse_attention, { add_pass<FuseAttentionPass>(); });
+    cb(fuse_layer_norm_gelu, { add_pass<FuseLayerNormGELUPass>(); });
 
 #undef cb
 
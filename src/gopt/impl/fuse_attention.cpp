@@ -0,0 +1,238 @@
+/**
+ * \file src/gopt/impl/fuse_attention.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+
+#include "megbrain/gopt/inference.h"
+#include "megbrain/opr/basic_arith.h"
+#include "megbrain/opr/blas.h"
+#include "megbrain/opr/dnn/fused_attention.h"
+#include "megbrain/opr/dnn/softmax.h"
+#include "megbrain/opr/tensor_manip.h"
+#include "megbrain/utils/hash_ct.h"
+
+#include "midout.h"
+
+MIDOUT_DECL(megbrain_fuse_attention)
+#define MIDOUT_B(tag) \
+    MIDOUT_BEGIN(megbrain_fuse_attention, midout_iv(MGB_HASH_STR(tag))) {
+#define MIDOUT_E \
+    }            \
+    MIDOUT_END();
+
+using namespace mgb;
+using namespace gopt;
+
+namespace {
+
+using Mode = opr::Elemwise::Mode;
+
+//! the matched attention, in vars of the original graph
+struct AttentionPattern {
+    VarNode *q = nullptr, *k = nullptr, *v = nullptr, *mask = nullptr;
+    //! output of q * k^T
+    VarNode* qk = nullptr;
+    //! whether k is (N, Sk, D) rather than (N, D, Sk)
+    bool k_transposed = false;
+    float scale = 1.f;
+};
+
+bool is_plain_batched_matmul(opr::BatchedMatrixMul* mm) {
+    if (!mm)
+        return false;
+    auto&& param = mm->param();
+    return !param.transposeA &&
+           param.format == opr::BatchedMatrixMul::Param::Format::DEFAULT &&
+           param.compute_mode == opr::BatchedMatrixMul::Param::ComputeMode::DEFAULT;
+}
+
+Maybe<float> get_scalar(VarNode* var) {
+    auto val = SymbolVar{var}.as_immutable_scalar_require_shape();
+    if (!val.valid())
+        return None;
+    return val->get_cast<float>();
+}
+
+//! whether mask of given shape can be broadcast to (N, Sq, Sk) of score
+bool check_mask_shape(const TensorShape& mask, const TensorShape& score) {
+    if (!mask.ndim || mask.ndim > 3 || mask[mask.ndim - 1] != score[2])
+        return false;
+    if (mask.ndim >= 2 && mask[mask.ndim - 2] != 1 && mask[mask.ndim - 2] != score[1])
+        return false;
+    if (mask.ndim == 3 && mask[0] != 1 && mask[0] != score[0])
+        return false;
+    return true;
+}
+
+class Matcher {
+public:
+    Matcher(OptState& opt)
+            : m_graph{opt.graph()}, m_uniq_reader_check{opt.graph()} {}
+
+    //! match the attention ending with the second matmul
+    Maybe<AttentionPattern> match(OperatorNodeBase* opr) const {
+        auto mm2 = try_cast_as_op<opr::BatchedMatrixMul>(opr);
+        if (!mm2 || !is_plain_batched_matmul(mm2) || mm2->param().transposeB ||
+            !is_float32(mm2->output(0)) ||
+            mm2->output(0)->comp_node().device_type() != CompNode::DeviceType::CPU)
+            return None;
+        auto softmax = try_cast_as_op<opr::Softmax>(internal(mm2->input(0)));
+        if (!softmax || (softmax->param().axis != 2 && softmax->param().axis != -1))
+            return None;
+
+        AttentionPattern ret;
+        ret.v = mm2->input(1);
+        VarNode* score = softmax->input(0);
+        if (!match_score(score, ret))
+            return None;
+        auto score_shp = score->shape();
+        // mask must not broadcast the scores to a larger shape
+        if (score_shp.ndim != 3 || !ret.v->shape().ndim ||
+            !ret.qk->shape().eq_shape(score_shp))
+            return None;
+        if (ret.mask && !check_mask_shape(ret.mask->shape(), score_shp))
+            return None;
+        return ret;
+    }
+
+private:
+    const SubGraph& m_graph;
+    UniqReaderCheck m_uniq_reader_check;
+
+    static bool is_float32(VarNode* var) {
+        return var->dtype() == dtype::Float32();
+    }
+
+    //! owner opr of an intermediate var that is only read by the pattern
+    OperatorNodeBase* internal(VarNode* var) const {
+        if (!m_uniq_reader_check(var) || m_graph.endpoint_contain(var))
+            return nullptr;
+        return var->owner_opr();
+    }
+
+    //! match (q * k^T) [* or / scale] [+ mask], with the scale and mask
+    //! optionally fused into FUSE_MUL_ADD3
+    bool match_score(VarNode* var, AttentionPattern& pattern) const {
+        auto elem = try_cast_as_op<opr::Elemwise>(internal(var));
+        if (!elem)
+            return match_qk(var, pattern);
+        auto mode = elem->param().mode;
+        auto&& inp = elem->input();
+        if (mode == Mode::FUSE_MUL_ADD3) {
+            if (!is_float32(inp[2]))
+                return false;
+            pattern.mask = inp[2];
+            return match_scale(inp[0], inp[1], pattern) ||
+                   match_scale(inp[1], inp[0], pattern);
+        }
+        if (mode == Mode::ADD) {
+            for (size_t i = 0; i < 2; ++i) {
+                if (!is_float32(inp[1 - i]))
+                    continue;
+                pattern.mask = inp[1 - i];
+                if (match_scaled(inp[i], pattern))
+                    return true;
+            }
+            pattern.mask = nullptr;
+            return false;
+        }
+        return match_scaled(var, pattern);
+    }
+
+    //! match (q * k^T) [* or / scale]
+    bool match_scaled(VarNode* var, AttentionPattern& pattern) const {
+        auto elem = try_cast_as_op<opr::Elemwise>(internal(var));
+        if (!elem)
+            return match_qk(var, pattern);
+        auto mode = elem->param().mode;
+        auto&& inp = elem->input();
+        if (mode == Mode::MUL) {
+            return match_scale(inp[0], inp[1], pattern) ||
+                   match_scale(inp[1], inp[0], pattern);
+        }
+        if (mode == Mode::TRUE_DIV) {
+            auto div = get_scalar(inp[1]);
+            if (!div.valid() || div.val() == 0 || !match_qk(inp[0], pattern))
+                return false;
+            pattern.scale = 1.f / div.val();
+            return true;
+        }
+        return false;
+    }
+
+    bool match_scale(VarNode* qk, VarNode* scale, AttentionPattern& pattern) const {
+        auto val = get_scalar(scale);
+        if (!val.valid() || !match_qk(qk, pattern))
+            return false;
+        pattern.scale = val.val();
+        return true;
+    }
+
+    bool match_qk(VarNode* var, AttentionPattern& pattern) const {
+        auto mm1 = try_cast_as_op<opr::BatchedMatrixMul>(internal(var));
+        if (!mm1 || !is_plain_batched_matmul(mm1) || !is_float32(mm1->input(0)) ||
+            !is_float32(mm1->input(1)))
+            return false;
+        pattern.q = mm1->input(0);
+        pattern.k = mm1->input(1);
+        pattern.k_transposed = mm1->param().transposeB;
+        pattern.qk = var;
+        return true;
+    }
+};
+
+}  // anonymous namespace
+
+/* ==================== FuseAttentionPass ================= */
+const char* FuseAttentionPass::name() const {
+    return mgb_cstr_log("fuse attention pass");
+}
+
+void FuseAttentionPass::apply(OptState& opt) const {
+    MIDOUT_B("FuseAttentionPass::apply")
+    opt.set_var_replace_check_flag(
+            VarReplaceCheckFlag::CHECK_DTYPE | VarReplaceCheckFlag::CHECK_SHAPE);
+    auto rewriter = opt.graph().make_rewriter();
+    Matcher matcher{opt};
+
+    auto on_opr = [&](OperatorNodeBase* opr) {
+        auto pattern = matcher.match(opr);
+        if (!pattern.valid()) {
+            rewriter.auto_replace_outputs(opr);
+            return;
+        }
+        SymbolVar q = rewriter.get_var(pattern->q), k = rewriter.get_var(pattern->k),
+                  v = rewriter.get_var(pattern->v);
+        if (!pattern->k_transposed) {
+            k = opr::Dimshuffle::make(k, {0, 2, 1});
+        }
+        opr::FusedAttention::Param param;
+        param.scale = pattern->scale;
+        SymbolVar out;
+        if (pattern->mask) {
+            SymbolVar mask = rewriter.get_var(pattern->mask);
+            for (size_t i = pattern->mask->shape().ndim; i < 3; ++i) {
+                mask = mask.add_axis(0);
+            }
+            param.has_mask = true;
+            out = opr::FusedAttention::make(q, k, v, mask, param);
+        } else {
+            out = opr::FusedAttention::make(q, k, v, param);
+        }
+        rewriter.replace_var(
+                opr->output(0), out.node(),
+                mgb_cstr_log("replace matmul + softmax + matmul to FusedAttention"));
+    };
+    opt.graph().iter(on_opr);
+    rewriter.apply_inplace();
+    MIDOUT_E
+}
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
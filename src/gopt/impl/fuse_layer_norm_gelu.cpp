@@ -0,0 +1,434 @@
+/**
+ * \file src/gopt/impl/fuse_layer_norm_gelu.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+
+#include "megbrain/gopt/inference.h"
+#include "megbrain/opr/basic_arith.h"
+#include "megbrain/opr/dnn/layer_norm.h"
+#include "megbrain/opr/tensor_manip.h"
+#include "megbrain/utils/hash_ct.h"
+
+#include <cmath>
+
+#include "midout.h"
+
+MIDOUT_DECL(megbrain_fuse_layer_norm_gelu)
+#define MIDOUT_B(tag) \
+    MIDOUT_BEGIN(megbrain_fuse_layer_norm_gelu, midout_iv(MGB_HASH_STR(tag))) {
+#define MIDOUT_E \
+    }            \
+    MIDOUT_END();
+
+using namespace mgb;
+using namespace gopt;
+
+namespace {
+
+using Mode = opr::Elemwise::Mode;
+
+bool approx_eq(float a, float b) {
+    return std::abs(a - b) <= 1e-4f * std::abs(b);
+}
+
+Maybe<float> get_scalar(VarNode* var) {
+    auto val = SymbolVar{var}.as_immutable_scalar_require_shape();
+    if (!val.valid())
+        return None;
+    return val->get_cast<float>();
+}
+
+opr::Elemwise* as_elemwise(VarNode* var, Mode mode) {
+    auto elem = try_cast_as_op<opr::Elemwise>(var->owner_opr());
+    if (!elem || elem->param().mode != mode)
+        return nullptr;
+    return elem;
+}
+
+//! call \p func with the inputs of a binary commutative opr in both orders
+template <typename Func>
+bool match_commutative(opr::Elemwise* elem, Func&& func) {
+    return func(elem->input(0), elem->input(1)) || func(elem->input(1), elem->input(0));
+}
+
+class PatternMatcher {
+public:
+    struct Match {
+        enum Kind { LAYER_NORM, GELU } kind;
+        VarNode *x = nullptr, *weight = nullptr, *bias = nullptr;
+        float eps = 0;
+        //! oprs to be replaced, including the root
+        ThinHashSet<OperatorNodeBase*> oprs;
+    };
+
+    explicit PatternMatcher(const SubGraph& graph) : m_graph{graph} {
+        graph.iter([this](OperatorNodeBase* opr) {
+            for (auto&& i : opr->node_prop().dep_map()) {
+                m_readers[i.first].push_back(opr);
+            }
+        });
+    }
+
+    //! match the pattern whose output is the output of given opr
+    Maybe<Match> match(OperatorNodeBase* opr) const {
+        if (!try_cast_as_op<opr::Elemwise>(opr))
+            return None;
+        Match ret;
+        ret.oprs.insert(opr);
+        if (!match_layer_norm(opr->output(0), ret)) {
+            ret = {};
+            ret.oprs.insert(opr);
+            if (!match_gelu(opr->output(0), ret))
+                return None;
+        }
+        if (!ret.x->shape().eq_shape(opr->output(0)->shape()) ||
+            !check_readers(ret, opr))
+            return None;
+        return ret;
+    }
+
+private:
+    const SubGraph& m_graph;
+    ThinHashMap<VarNode*, SmallVector<OperatorNodeBase*>> m_readers;
+
+    //! whether the intermediate results are only read inside the match
+    bool check_readers(const Match& match, OperatorNodeBase* root) const {
+        for (auto opr : match.oprs) {
+            if (opr == root)
+                continue;
+            auto var = opr->output(0);
+            if (m_graph.endpoint_contain(var))
+                return false;
+            auto iter = m_readers.find(var);
+            if (iter == m_readers.end())
+                return false;
+            for (auto reader : iter->second) {
+                if (!match.oprs.count(reader))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    //! whether a var is only read by one opr, so it could be fused
+    bool single_reader(VarNode* var) const {
+        auto iter = m_readers.find(var);
+        return iter != m_readers.end() && iter->second.size() == 1 &&
+               !m_graph.endpoint_contain(var);
+    }
+
+    bool is_last_axis_mean(VarNode* var, VarNode* src) const {
+        auto reduce = try_cast_as_op<opr::Reduce>(var->owner_opr());
+        if (!reduce || reduce->input().size() != 1 || reduce->input(0) != src)
+            return false;
+        auto&& param = reduce->param();
+        auto ndim = src->shape().ndim;
+        return ndim && param.mode == opr::Reduce::Mode::MEAN &&
+               param.axis == static_cast<int>(ndim) - 1;
+    }
+
+    /* ================== layer norm ================== */
+
+    /*!
+     * \brief match LayerNorm in the form of
+     *      d = x - mean(x); v = mean(d * d) + eps; y = d / sqrt(v)
+     *
+     * d * d may also be written as d ** 2, and the division by sqrt(v) as
+     * multiplication by v ** -0.5 or 1 / sqrt(v), where sqrt(v) is v ** 0.5.
+     * The result may be multiplied by weight and then added by bias.
+     */
+    bool match_layer_norm(VarNode* out, Match& match) const {
+        match.kind = Match::LAYER_NORM;
+        if (auto add = as_elemwise(out, Mode::ADD)) {
+            bool matched = match_commutative(add, [&](VarNode* scaled, VarNode* bias) {
+                auto mul = as_elemwise(scaled, Mode::MUL);
+                if (!mul)
+                    return false;
+                return match_commutative(mul, [&](VarNode* y, VarNode* weight) {
+                    Match m = match;
+                    if (!match_normalize(y, m) || !is_affine_param(weight, m.x) ||
+                        !is_affine_param(bias, m.x))
+                        return false;
+                    m.oprs.insert(mul);
+                    m.weight = weight;
+                    m.bias = bias;
+                    match = std::move(m);
+                    return true;
+                });
+            });
+            if (matched)
+                return true;
+        }
+        return match_normalize(out, match);
+    }
+
+    bool is_affine_param(VarNode* var, VarNode* x) const {
+        auto&& shp = var->shape();
+        size_t c = x->shape()[x->shape().ndim - 1];
+        return var->dtype() == x->dtype() && shp.ndim && shp[shp.ndim - 1] == c &&
+               shp.total_nr_elems() == c;
+    }
+
+    bool match_normalize(VarNode* y, Match& match) const {
+        VarNode *d = nullptr, *v = nullptr;
+        if (auto div = as_elemwise(y, Mode::TRUE_DIV)) {
+            d = div->input(0);
+            if (!match_pow(div->input(1), 0.5f, v, match))
+                return false;
+            match.oprs.insert(div);
+        } else if (auto mul = as_elemwise(y, Mode::MUL)) {
+            bool matched = match_commutative(mul, [&](VarNode* i0, VarNode* i1) {
+                d = i0;
+                if (match_pow(i1, -0.5f, v, match))
+                    return true;
+                auto rdiv = as_elemwise(i1, Mode::TRUE_DIV);
+                if (!rdiv || !get_scalar(rdiv->input(0)).valid() ||
+                    get_scalar(rdiv->input(0)).val() != 1.f ||
+                    !match_pow(rdiv->input(1), 0.5f, v, match))
+                    return false;
+                match.oprs.insert(rdiv);
+                return true;
+            });
+            if (!matched)
+                return false;
+            match.oprs.insert(mul);
+        } else {
+            return false;
+        }
+
+        // d = x - mean(x)
+        auto sub = as_elemwise(d, Mode::SUB);
+        if (!sub)
+            return false;
+        VarNode *x = sub->input(0), *mean = sub->input(1);
+        if (x->dtype() != dtype::Float32() || !is_last_axis_mean(mean, x))
+            return false;
+
+        // v = mean(d * d) + eps
+        auto add_eps = as_elemwise(v, Mode::ADD);
+        if (!add_eps)
+            return false;
+        VarNode* var = nullptr;
+        bool matched = match_commutative(add_eps, [&](VarNode* i0, VarNode* i1) {
+            auto eps = get_scalar(i1);
+            if (!eps.valid() || eps.val() < 0)
+                return false;
+            var = i0;
+            match.eps = eps.val();
+            return true;
+        });
+        if (!matched)
+            return false;
+        auto reduce = try_cast_as_op<opr::Reduce>(var->owner_opr());
+        if (!reduce || !is_last_axis_mean(var, reduce->input(0)))
+            return false;
+        auto sqr = reduce->input(0);
+        if (auto mul = as_elemwise(sqr, Mode::MUL)) {
+            if (mul->input(0) != d || mul->input(1) != d)
+                return false;
+            match.oprs.insert(mul);
+        } else if (auto pow = as_elemwise(sqr, Mode::POW)) {
+            auto exp = get_scalar(pow->input(1));
+            if (pow->input(0) != d || !exp.valid() || exp.val() != 2.f)
+                return false;
+            match.oprs.insert(pow);
+        } else {
+            return false;
+        }
+        match.oprs.insert(sub);
+        match.oprs.insert(mean->owner_opr());
+        match.oprs.insert(add_eps);
+        match.oprs.insert(reduce);
+        match.x = x;
+        return true;
+    }
+
+    //! match var = base ** exp
+    bool match_pow(VarNode* var, float exp, VarNode*& base, Match& match) const {
+        auto pow = as_elemwise(var, Mode::POW);
+        if (!pow)
+            return false;
+        auto val = get_scalar(pow->input(1));
+        if (!val.valid() || val.val() != exp)
+            return false;
+        base = pow->input(0);
+        match.oprs.insert(pow);
+        return true;
+    }
+
+    /* ================== gelu ================== */
+
+    /*!
+     * \brief flatten a product into a constant coefficient and other factors
+     *
+     * Only the products read by a single opr are expanded, except the root.
+     */
+    void flatten_product(
+            VarNode* var, bool is_root, float& coeff, VarNodeArray& factors,
+            Match& match) const {
+        auto val = get_scalar(var);
+        if (val.valid()) {
+            coeff *= val.val();
+            return;
+        }
+        auto elem = try_cast_as_op<opr::Elemwise>(var->owner_opr());
+        if (elem && (is_root || single_reader(var))) {
+            auto mode = elem->param().mode;
+            if (mode == Mode::MUL) {
+                match.oprs.insert(elem);
+                flatten_product(elem->input(0), false, coeff, factors, match);
+                flatten_product(elem->input(1), false, coeff, factors, match);
+                return;
+            }
+            auto div = get_scalar(elem->input(1));
+            if (mode == Mode::TRUE_DIV && div.valid() && div.val() != 0) {
+                match.oprs.insert(elem);
+                flatten_product(elem->input(0), false, coeff, factors, match);
+                coeff /= div.val();
+                return;
+            }
+        }
+        factors.push_back(var);
+    }
+
+    /*!
+     * \brief match GELU in the form of 0.5 * x * (1 + erf(x / sqrt(2)))
+     *
+     * The factors may be multiplied in any order. The tanh approximation is
+     * not matched, since Mode::GELU computes the exact one.
+     */
+    bool match_gelu(VarNode* out, Match& match) const {
+        match.kind = Match::GELU;
+        float coeff = 1;
+        VarNodeArray factors;
+        flatten_product(out, true, coeff, factors, match);
+        if (factors.size() != 2 || !approx_eq(coeff, 0.5f))
+            return false;
+        for (size_t i = 0; i < 2; ++i) {
+            Match m = match;
+            VarNode *x = factors[i], *t = factors[1 - i];
+            if (x->dtype().category() == DTypeCategory::FLOAT &&
+                match_gelu_cdf(t, x, m)) {
+                m.x = x;
+                match = std::move(m);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //! match 1 + erf(x / sqrt(2))
+    bool match_gelu_cdf(VarNode* var, VarNode* x, Match& match) const {
+        auto add = as_elemwise(var, Mode::ADD);
+        if (!add || !single_reader(var))
+            return false;
+        return match_commutative(add, [&](VarNode* one, VarNode* func) {
+            auto val = get_scalar(one);
+            if (!val.valid() || val.val() != 1.f || !single_reader(func))
+                return false;
+            auto erf = as_elemwise(func, Mode::ERF);
+            if (!erf)
+                return false;
+            Match m = match;
+            float coeff = 1;
+            VarNodeArray factors;
+            flatten_product(erf->input(0), false, coeff, factors, m);
+            if (!approx_eq(coeff, static_cast<float>(M_SQRT1_2)) ||
+                factors.size() != 1 || factors[0] != x)
+                return false;
+            m.oprs.insert(erf);
+            m.oprs.insert(add);
+            match = std::move(m);
+            return true;
+        });
+    }
+};
+
+}  // anonymous namespace
+
+/* ==================== FuseLayerNormGELUPass ================= */
+const char* FuseLayerNormGELUPass::name() const {
+    return mgb_cstr_log("fuse layer norm gelu pass");
+}
+
+void FuseLayerNormGELUPass::apply(OptState& opt) const {
+    MIDOUT_B("FuseLayerNormGELUPass::apply")
+    using Match = PatternMatcher::Match;
+    opt.set_var_replace_check_flag(
+            VarReplaceCheckFlag::CHECK_DTYPE | VarReplaceCheckFlag::CHECK_SHAPE);
+
+    PatternMatcher matcher{opt.graph()};
+    std::vector<std::pair<OperatorNodeBase*, Match>> candidates;
+    opt.graph().iter([&](OperatorNodeBase* opr) {
+        auto match = matcher.match(opr);
+        if (match.valid()) {
+            candidates.emplace_back(opr, std::move(match.val()));
+        }
+    });
+
+    // prefer the outermost match, e.g. the affine layer norm rather than the
+    // normalization inside it
+    ThinHashMap<OperatorNodeBase*, Match> matches;
+    ThinHashSet<OperatorNodeBase*> covered;
+    for (auto iter = candidates.rbegin(); iter != candidates.rend(); ++iter) {
+        if (covered.count(iter->first))
+            continue;
+        for (auto opr : iter->second.oprs) {
+            covered.insert(opr);
+        }
+        matches.emplace(iter->first, std::move(iter->second));
+    }
+
+    auto rewriter = opt.graph().make_rewriter();
+    auto on_opr = [&](OperatorNodeBase* opr) {
+        auto iter = matches.find(opr);
+        if (iter == matches.end()) {
+            rewriter.auto_replace_outputs(opr);
+            return;
+        }
+        auto&& match = iter->second;
+        SymbolVar x = rewriter.get_var(match.x), out;
+        if (match.kind == Match::GELU) {
+            out = opr::Elemwise::make({x}, Mode::GELU);
+            rewriter.replace_var(
+                    opr->output(0), out.node(),
+                    mgb_cstr_log("replace elemwise chain to GELU"));
+            return;
+        }
+        opr::LayerNorm::Param param;
+        param.eps = match.eps;
+        param.normalized_dim = 1;
+        param.normalized_size = match.x->shape()[match.x->shape().ndim - 1];
+        if (match.weight) {
+            TensorShape shp{param.normalized_size};
+            auto weight = rewriter.get_var(match.weight),
+                 bias = rewriter.get_var(match.bias);
+            if (weight->shape().ndim != 1) {
+                weight = SymbolVar{weight}.reshape(shp).node();
+            }
+            if (bias->shape().ndim != 1) {
+                bias = SymbolVar{bias}.reshape(shp).node();
+            }
+            param.affine = true;
+            out = opr::LayerNorm::make(x, weight, bias, param)[0];
+        } else {
+            param.affine = false;
+            out = opr::LayerNorm::make(x, param)[0];
+        }
+        rewriter.replace_var(
+                opr->output(0), out.node(),
+                mgb_cstr_log("replace reduce and elemwise chain to LayerNorm"));
+    };
+    opt.graph().iter(on_opr);
+    rewriter.apply_inplace();
+    MIDOUT_E
+}
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
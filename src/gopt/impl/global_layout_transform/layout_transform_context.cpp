@@ -128,6 +128,48 @@ std::unique_ptr<LayoutTransformContext> make_cpu_ctx(
                      OprFormatConfigID::NCHW88});
     return ctx;
 }
+
+/*!
+ * x86 kernels of megdnn are implemented in NCHW for all dtypes, including the
+ * int8 ones of AVX2 and VNNI, and in NCHW88 for float32 with AVX/AVX2. Other
+ * formats of the arm context only have naive kernels on x86, so they are not
+ * worth profiling.
+ */
+std::unique_ptr<LayoutTransformContext> make_x86_ctx(
+        OprFormatConfigID base_config_id, TensorFormats base_tensor_format) {
+    OprList opr_list = {
+            opr::ConvBiasForward::typeinfo(),
+            opr::ConvolutionForward::typeinfo(),
+            opr::ElemwiseMultiType::typeinfo(),
+            opr::Elemwise::typeinfo(),
+            opr::TypeCvt::typeinfo(),
+            opr::PoolingForward::typeinfo(),
+            opr::Resize::typeinfo(),
+            opr::PowC::typeinfo(),
+            opr::Concat::typeinfo(),
+    };
+
+    SmallVector<TensorFormats> available_tensor_formats = {
+            TensorFormats::NCHW, TensorFormats::NCHWc8};
+    Attribute attribute = {base_config_id, base_tensor_format, Target::CPU};
+    auto ctx = std::make_unique<LayoutTransformContext>(
+            std::move(opr_list), std::move(available_tensor_formats), attribute);
+    ctx->add_opr_config(
+               opr::ConvBiasForward::typeinfo(),
+               {OprFormatConfigID::NCHW, OprFormatConfigID::NCHW88,
+                OprFormatConfigID::NCHW88_HYBRID})
+            .add_opr_config(
+                    opr::ConvolutionForward::typeinfo(),
+                    {OprFormatConfigID::NCHW, OprFormatConfigID::NCHW88,
+                     OprFormatConfigID::NCHW88_HYBRID})
+            .add_opr_config(
+                    opr::PoolingForward::typeinfo(),
+                    {OprFormatConfigID::NCHW, OprFormatConfigID::NCHW88})
+            .add_opr_config(
+                    opr::ResizeForward::typeinfo(),
+                    {OprFormatConfigID::NCHW, OprFormatConfigID::NCHW88});
+    return ctx;
+}
 }  // namespace
 
 /* ================= LayoutTransformContext ==================*/
@@ -157,7 +199,11 @@ std::unique_ptr<LayoutTransformContext> LayoutTransformContext::make(
         case Target::CUDA:
             return make_cuda_ctx(base_config_id, base_tensor_format);
         case Target::CPU:
+#if MEGDNN_X86
+            return make_x86_ctx(base_config_id, base_tensor_format);
+#else
             return make_cpu_ctx(base_config_id, base_tensor_format);
+#endif
         default:
             mgb_assert(false, "unsupported target %s\n", target_to_string(target));
     }
@@ -209,6 +209,34 @@ public:
     void apply(OptState& opt) const override;
 };
 
+/*!
+ * \brief fuse the decomposed attention
+ *      BatchedMatrixMul -> scale / mask -> Softmax -> BatchedMatrixMul
+ *      into a FusedAttention opr on CPU
+ *
+ * The scale must be a constant scalar, and the intermediate results must not
+ * be used elsewhere.
+ */
+class FuseAttentionPass final : public Pass {
+public:
+    const char* name() const override;
+    void apply(OptState& opt) const override;
+};
+
+/*!
+ * \brief fuse the layer norm over the last axis written in Reduce and
+ *      Elemwise oprs into a LayerNorm opr, and the gelu written in erf into
+ *      Elemwise GELU
+ *
+ * The tanh approximation of gelu is left unchanged, since Elemwise GELU
+ * computes the exact one.
+ */
+class FuseLayerNormGELUPass final : public Pass {
+public:
+    const char* name() const override;
+    void apply(OptState& opt) const override;
+};
+
 /*!
  * \brief tensor format converter to accelerate inference speed on Nvidia
  * platform
@@ -338,6 +366,10 @@ struct OptimizeForInferenceOptions : cg::GraphCommonOptimizeOptions {
             ret |= 1u << 4;
         if (fuse_preprocess)
             ret |= 1u << 5;
+        if (fuse_attention)
+            ret |= 1u << 6;
+        if (fuse_layer_norm_gelu)
+            ret |= 1u << 7;
         return ret;
     }
 
@@ -349,6 +381,8 @@ struct OptimizeForInferenceOptions : cg::GraphCommonOptimizeOptions {
         ret.fuse_conv_bias_with_z = buf & 1u << 3;
         ret.weight_preprocess = buf & 1u << 4;
         ret.fuse_preprocess = buf & 1u << 5;
+        ret.fuse_attention = buf & 1u << 6;
+        ret.fuse_layer_norm_gelu = buf & 1u << 7;
         ret.layout_transform = (LayoutTransform)(buf >> 32);
         return ret;
     }
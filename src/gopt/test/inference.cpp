@@ -21,7 +21,10 @@
 #include "megbrain/opr/blas.h"
 #include "megbrain/opr/dnn/batch_norm.h"
 #include "megbrain/opr/dnn/convolution.h"
+#include "megbrain/opr/dnn/fused_attention.h"
+#include "megbrain/opr/dnn/layer_norm.h"
 #include "megbrain/opr/dnn/pooling.h"
+#include "megbrain/opr/dnn/softmax.h"
 #include "megbrain/opr/imgproc.h"
 #include "megbrain/opr/io.h"
 #include "megbrain/opr/nn_int.h"
@@ -4072,6 +4075,154 @@ TEST(TestGoptInference, ConvertFormatCD4GroupOneConv) {
     MGB_ASSERT_TENSOR_NEAR(host_y, host_y_opt, 1e-3);
 }
 
+TEST(TestGoptInference, FuseAttention) {
+    HostTensorGenerator<> gen;
+    auto cn = CompNode::load("cpu0");
+    auto graph = ComputingGraph::make();
+    graph->options().graph_opt_level = 0;
+    auto mkvar = [&](const char* name, const TensorShape& shp) {
+        return opr::Host2DeviceCopy::make(*graph, gen(shp, cn)).rename(name);
+    };
+    auto mkcvar = [&](const char* name, float val) {
+        return opr::ImmutableTensor::make(
+                       *graph, DTypeScalar(static_cast<dt_float32>(val)), cn)
+                .rename(name);
+    };
+    size_t N = 4, SQ = 20, SK = 33, D = 16, DV = 8;
+    auto q = mkvar("q", {N, SQ, D}), k = mkvar("k", {N, SK, D}),
+         v = mkvar("v", {N, SK, DV}), mask = mkvar("mask", {SQ, SK});
+
+    // k transposed by matmul, scaled by mul and masked
+    opr::BatchedMatrixMul::Param param;
+    param.transposeB = true;
+    auto score0 = opr::BatchedMatrixMul::make(q, k, param) * mkcvar("scale", 0.25f) +
+                  mask;
+    auto y0 = opr::BatchedMatrixMul::make(opr::Softmax::make(score0), v);
+
+    // k transposed by dimshuffle, scaled by div
+    auto kt = opr::Dimshuffle::make(k, {0, 2, 1});
+    auto score1 = opr::BatchedMatrixMul::make(q, kt) / mkcvar("div", 4.f);
+    auto y1 = opr::BatchedMatrixMul::make(opr::Softmax::make(score1), v);
+
+    // the scores are also an output, so they can not be fused
+    auto score2 = opr::BatchedMatrixMul::make(mkvar("q2", {N, SQ, D}), k, param);
+    auto y2 = opr::BatchedMatrixMul::make(opr::Softmax::make(score2), v);
+
+    SymbolVar y0_opt, y1_opt, y2_opt, score2_opt;
+    auto options = gopt::OptimizeForInferenceOptions{};
+    options.enable_fuse_attention();
+    unpack_vector(
+            gopt::optimize_for_inference({y0, y1, y2, score2}, options), y0_opt,
+            y1_opt, y2_opt, score2_opt);
+    using gopt::try_cast_as_op;
+    auto fused0 = try_cast_as_op<opr::FusedAttention>(y0_opt.node()->owner_opr()),
+         fused1 = try_cast_as_op<opr::FusedAttention>(y1_opt.node()->owner_opr());
+    ASSERT_TRUE(fused0 && fused1);
+    ASSERT_TRUE(fused0->param().has_mask);
+    ASSERT_FALSE(fused1->param().has_mask);
+    ASSERT_EQ(
+            opr::BatchedMatrixMul::typeinfo(),
+            y2_opt.node()->owner_opr()->dyn_typeinfo());
+    ASSERT_EQ(
+            opr::BatchedMatrixMul::typeinfo(),
+            score2_opt.node()->owner_opr()->dyn_typeinfo());
+
+    HostTensorND host_y0, host_y0_opt, host_y1, host_y1_opt;
+    auto func = graph->compile(
+            {make_callback_copy(y0, host_y0), make_callback_copy(y0_opt, host_y0_opt),
+             make_callback_copy(y1, host_y1),
+             make_callback_copy(y1_opt, host_y1_opt)});
+    func->execute();
+    MGB_ASSERT_TENSOR_NEAR(host_y0, host_y0_opt, 1e-5);
+    MGB_ASSERT_TENSOR_NEAR(host_y1, host_y1_opt, 1e-5);
+}
+
+TEST(TestGoptInference, FuseLayerNormGELU) {
+    using Mode = opr::Elemwise::Mode;
+    HostTensorGenerator<> gen;
+    auto cn = CompNode::load("cpu0");
+    auto graph = ComputingGraph::make();
+    graph->options().graph_opt_level = 0;
+    auto mkvar = [&](const char* name, const TensorShape& shp) {
+        return opr::Host2DeviceCopy::make(*graph, gen(shp, cn)).rename(name);
+    };
+    auto mkcvar = [&](const char* name, float val) {
+        return opr::ImmutableTensor::make(
+                       *graph, DTypeScalar(static_cast<dt_float32>(val)), cn)
+                .rename(name);
+    };
+    auto mean = [](SymbolVar x) {
+        return opr::Reduce::make(x, {opr::Reduce::Mode::MEAN, 2});
+    };
+    auto pow = [&](SymbolVar x, float exp) {
+        return opr::Elemwise::make({x, mkcvar("exp", exp)}, Mode::POW);
+    };
+    size_t N = 4, T = 10, C = 32;
+
+    // affine layer norm divided by sqrt
+    auto x0 = mkvar("x0", {N, T, C});
+    auto d0 = x0 - mean(x0);
+    auto y0 = d0 / pow(mean(d0 * d0) + mkcvar("eps", 1e-5f), 0.5f) *
+                      mkvar("gamma", {C}) +
+              mkvar("beta", {1, 1, C});
+
+    // layer norm multiplied by rsqrt
+    auto x1 = mkvar("x1", {N, T, C});
+    auto d1 = x1 - mean(x1);
+    auto y1 = d1 * pow(mean(pow(d1, 2.f)) + mkcvar("eps", 1e-5f), -0.5f);
+
+    // gelu in erf
+    auto x2 = mkvar("x2", {N, T, C});
+    auto y2 = mkcvar("half", 0.5f) * x2 *
+              (mkcvar("one", 1.f) +
+               opr::Elemwise::make({x2 / mkcvar("sqrt2", M_SQRT2)}, Mode::ERF));
+
+    // gelu in tanh, which should not be replaced by the exact one
+    auto x3 = mkvar("x3", {N, T, C});
+    auto inner = x3 + mkcvar("k", 0.044715f) * x3 * x3 * x3;
+    auto y3 = x3 * mkcvar("half", 0.5f) *
+              (mkcvar("one", 1.f) +
+               opr::Elemwise::make(
+                       {mkcvar("sqrt_2_pi", 0.7978845608f) * inner}, Mode::TANH));
+
+    // the centered input is also an output, so it can not be fused
+    auto x4 = mkvar("x4", {N, T, C});
+    auto d4 = x4 - mean(x4);
+    auto y4 = d4 / pow(mean(d4 * d4) + mkcvar("eps", 1e-5f), 0.5f);
+
+    SymbolVar y0_opt, y1_opt, y2_opt, y3_opt, y4_opt;
+    auto options = gopt::OptimizeForInferenceOptions{};
+    options.enable_fuse_layer_norm_gelu();
+    unpack_vector(
+            gopt::optimize_for_inference({y0, y1, y2, y3, y4, d4}, options), y0_opt,
+            y1_opt, y2_opt, y3_opt, y4_opt);
+    using gopt::try_cast_as_op;
+    auto ln0 = try_cast_as_op<opr::LayerNorm>(y0_opt.node()->owner_opr()),
+         ln1 = try_cast_as_op<opr::LayerNorm>(y1_opt.node()->owner_opr());
+    ASSERT_TRUE(ln0 && ln1);
+    ASSERT_TRUE(ln0->param().affine);
+    ASSERT_FALSE(ln1->param().affine);
+    ASSERT_EQ(C, ln0->param().normalized_size);
+    auto gelu = try_cast_as_op<opr::Elemwise>(y2_opt.node()->owner_opr());
+    ASSERT_TRUE(gelu && gelu->param().mode == Mode::GELU);
+    gelu = try_cast_as_op<opr::Elemwise>(y3_opt.node()->owner_opr());
+    ASSERT_FALSE(gelu && gelu->param().mode == Mode::GELU);
+    ASSERT_FALSE(try_cast_as_op<opr::LayerNorm>(y4_opt.node()->owner_opr()));
+
+    HostTensorND host_y[5], host_y_opt[5];
+    SymbolVar ys[] = {y0, y1, y2, y3, y4},
+              ys_opt[] = {y0_opt, y1_opt, y2_opt, y3_opt, y4_opt};
+    ComputingGraph::OutputSpec out_spec;
+    for (size_t i = 0; i < 5; ++i) {
+        out_spec.push_back(make_callback_copy(ys[i], host_y[i]));
+        out_spec.push_back(make_callback_copy(ys_opt[i], host_y_opt[i]));
+    }
+    graph->compile(out_spec)->execute();
+    for (size_t i = 0; i < 5; ++i) {
+        MGB_ASSERT_TENSOR_NEAR(host_y[i], host_y_opt[i], 1e-4);
+    }
+}
+
 #if MGB_CUDA
 TEST(TestGoptInference, PreProcessCase0) {
     REQUIRE_GPU(1);
@@ -1111,6 +1111,37 @@ TEST(TestLayoutTransform, MobileNetV2_NCHW88) {
     MGB_ASSERT_TENSOR_EQ(t1, t2);
 }
 
+#if MEGDNN_X86
+TEST(TestLayoutTransform, MobileNetV2_X86) {
+    auto cn = CompNode::load("cpu0");
+
+    Network network(cn);
+    auto output = make_mobilenet_v2(network, 1);
+
+    HostTensorND t1;
+    auto func1 = network.graph->compile({make_callback_copy(output, t1)});
+    func1->execute();
+
+    auto new_out_var = gopt::layout_transform(
+            {output}, GraphTuningOptions::Target::CPU)[0];
+    /// only the formats with x86 kernels are chosen
+    cg::DepOprIter{[](cg::OperatorNodeBase* opr) {
+        if (!opr->same_type<opr::ConvBiasForward>())
+            return;
+        auto format = opr->cast_final_safe<opr::ConvBiasForward>().param().format;
+        ASSERT_TRUE(
+                format == opr::ConvBias::Param::Format::NCHW ||
+                format == opr::ConvBias::Param::Format::NCHW88);
+    }}.add(new_out_var.node()->owner_opr());
+
+    HostTensorND t2;
+    auto func2 = network.graph->compile({make_callback_copy(new_out_var, t2)});
+    func2->execute();
+    /// check correct
+    MGB_ASSERT_TENSOR_NEAR(t1, t2, 1e-4);
+}
+#endif
+
 TEST(TestLayoutTransform, MobileNetV2_NCHW44_DOT) {
     auto cn = CompNode::load("cpu0");
 
@@ -0,0 +1,226 @@
+/**
+ * \file src/jit/impl/c/codegen_c.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "./codegen_c.h"
+
+#include "megbrain/common.h"
+#include "megbrain/jit/ast_c.h"
+#include "megbrain/jit/placeholder_opr.h"
+#include "megbrain/jit/utils.h"
+#include "megbrain/opr/tensor_manip.h"
+
+#include <cinttypes>
+
+#if MGB_JIT
+
+using namespace mgb;
+using namespace jit;
+using namespace ast_c;
+
+namespace {
+
+using VarNode2AST = ThinHashMap<VarNode*, ASTPtr>;
+
+//! generate code to compute the offsets of a row and load input values
+//!
+//! inputs broadcast along the last axis in the layouts given at compile time are
+//! loaded once per row in the fast path; the kernel is only bound to ndim, so the
+//! stride pattern is checked again at runtime
+void gen_input_code(
+        str_util::StrReplaceMap& replace_map, VarNode2AST& var2ast,
+        const JITExecutor::Args& args, const PlaceholderArray& placeholders) {
+    std::string decl_strides_str, contig_cond_str, decl_offsets_str,
+            update_offsets_str, decl_ptrs_str, contig_hoists_str, contig_loads_str,
+            strided_loads_str;
+    auto&& out_layout = args.outputs[0].layout;
+    for (size_t i = 0; i < args.inputs.size(); i++) {
+        mgb_throw_if(
+                args.inputs[i].layout.dtype != dtype::Float32(), GraphError,
+                "unsupported input dtype %s in C JIT fusion",
+                args.inputs[i].layout.dtype.name());
+        auto id = std::to_string(i);
+        ASTPtr elem_var = ASTPtr::make<VariableAST>("x" + id);
+        var2ast[placeholders[args.inputs[i].idx]->output(0)] = elem_var;
+
+        auto layout = args.inputs[i].layout;
+        if (!layout.eq_shape(out_layout)) {
+            layout = layout.broadcast(out_layout);
+        }
+        bool bcast = !layout.stride[layout.ndim - 1];
+
+        decl_strides_str += ssprintf(
+                "const ptrdiff_t s%zu = strides[%zu * ndim + ndim - 1];\n", i, i);
+        contig_cond_str += ssprintf("s%zu == %d && ", i, bcast ? 0 : 1);
+        decl_offsets_str += ssprintf("ptrdiff_t offset_%zu = 0;\n", i);
+        update_offsets_str += ssprintf(
+                "offset_%zu += static_cast<ptrdiff_t>(cur) * strides[%zu * ndim + "
+                "d];\n",
+                i, i);
+        decl_ptrs_str += ssprintf(
+                "const float* __restrict p%zu = inputs[%zu] + offset_%zu;\n", i, i, i);
+        ASTPtr contig_val;
+        if (bcast) {
+            contig_hoists_str += ssprintf("const float b%zu = p%zu[0];\n", i, i);
+            contig_val = ASTPtr::make<VariableAST>("b" + id);
+        } else {
+            contig_val = ASTPtr::make<VariableAST>("p" + id + "[i]");
+        }
+        auto strided_val = ASTPtr::make<VariableAST>("p" + id + "[i * s" + id + "]");
+        auto elem_decl = ASTPtr::make<DeclFloatAST>(elem_var)->code_gen();
+        contig_loads_str += elem_decl;
+        contig_loads_str += ASTPtr::make<AssignAST>(elem_var, contig_val)->code_gen();
+        strided_loads_str += elem_decl;
+        strided_loads_str += ASTPtr::make<AssignAST>(elem_var, strided_val)->code_gen();
+    }
+    contig_cond_str += "true";
+    str_util::append_replace_map(
+            replace_map, {{"{{DECL_STRIDES}}", decl_strides_str},
+                          {"{{CONTIG_COND}}", contig_cond_str},
+                          {"{{DECL_OFFSETS}}", decl_offsets_str},
+                          {"{{UPDATE_OFFSETS}}", update_offsets_str},
+                          {"{{DECL_PTRS}}", decl_ptrs_str},
+                          {"{{CONTIG_HOISTS}}", contig_hoists_str},
+                          {"{{CONTIG_LOADS}}", contig_loads_str},
+                          {"{{STRIDED_LOADS}}", strided_loads_str}});
+}
+
+ASTPtr gen_opr_ast(cg::OperatorNodeBase* opr, const VarNode2AST& var2ast) {
+    ASTPtrArray cur_inputs;
+    for (auto inp_node : opr->input()) {
+        cur_inputs.push_back(var2ast.at(inp_node));
+    }
+    if (opr->same_type<opr::Dimshuffle>()) {
+        // dimshuffle has been applied to the input layouts by JITExecutor
+        return {cur_inputs[0]};
+    }
+
+    return opr2AST(opr, cur_inputs).at(0);
+}
+}  // anonymous namespace
+
+std::pair<std::string, std::string> mgb::jit::codegen_c(
+        const InternalGraph& internal_graph, const JITExecutor::Args& args) {
+    mgb_throw_if(
+            args.outputs[0].layout.dtype != dtype::Float32(), GraphError,
+            "unsupported output dtype %s in C JIT fusion",
+            args.outputs[0].layout.dtype.name());
+
+    // the inner loop over contiguous inputs, and inputs broadcast along the last
+    // axis as loop-invariant scalars, can be vectorized by the host compiler, while
+    // other strided inputs use the general loop
+    std::string source = R"(
+#include <math.h>
+#include <stddef.h>
+
+// same as std::max and std::min used by megdnn, and unlike fmaxf and fminf they
+// can be vectorized
+static inline float mgb_fmaxf(float x, float y) {
+    return x < y ? y : x;
+}
+#define fmaxf mgb_fmaxf
+
+static inline float mgb_fminf(float x, float y) {
+    return y < x ? y : x;
+}
+#define fminf mgb_fminf
+
+static inline float rsqrtf(float x) {
+    return 1.f / sqrtf(x);
+}
+
+static inline float rcbrtf(float x) {
+    return 1.f / cbrtf(x);
+}
+
+static inline float mgb_log_sum_exp(float x, float y) {
+    float a = x < y ? x : y, b = x < y ? y : x;
+    return b + log1pf(expf(a - b));
+}
+
+extern "C" void {{KERNEL_NAME}}(
+        const float* const* inputs, float* output, const size_t* shape,
+        const ptrdiff_t* strides, size_t begin, size_t end) {
+    const size_t ndim = {{NDIM}}, len = shape[ndim - 1];
+    {{DECL_STRIDES}}
+    const bool contig = {{CONTIG_COND}};
+    for (size_t row = begin; row < end; ++row) {
+        {{DECL_OFFSETS}}
+        size_t idx = row;
+        for (size_t d = ndim - 1; d-- > 0;) {
+            size_t cur = idx % shape[d];
+            idx /= shape[d];
+            {{UPDATE_OFFSETS}}
+        }
+        {{DECL_PTRS}}
+        float* __restrict dst = output + row * len;
+        if (contig) {
+            {{CONTIG_HOISTS}}
+            for (size_t i = 0; i < len; ++i) {
+                {{CONTIG_LOADS}}
+                {{INTERNAL_EXPRS}}
+                dst[i] = {{EXP}};
+            }
+        } else {
+            for (size_t i = 0; i < len; ++i) {
+                {{STRIDED_LOADS}}
+                {{INTERNAL_EXPRS}}
+                dst[i] = {{EXP}};
+            }
+        }
+    }
+}
+)";
+
+    VarNode2AST var2ast;
+    str_util::StrReplaceMap source_replace_map;
+
+    // add inputs to the replace map
+    gen_input_code(source_replace_map, var2ast, args, internal_graph.placeholders());
+
+    // add other oprs
+    std::string internal_exps_str;
+    size_t cur_opr_cnt = 0;
+    cg::DepOprIter{[&](cg::OperatorNodeBase* opr) {
+        ++cur_opr_cnt;
+        if (opr->same_type<JITPlaceholder>()) {
+            return;
+        }
+        ASTPtr elem_var = ASTPtr::make<VariableAST>("y" + std::to_string(cur_opr_cnt));
+        ASTPtr elem_val = gen_opr_ast(opr, var2ast);
+        var2ast[opr->output(0)] = elem_var;
+        internal_exps_str += ASTPtr::make<DeclFloatAST>(elem_var)->code_gen();
+        internal_exps_str += ASTPtr::make<AssignAST>(elem_var, elem_val)->code_gen();
+    }}.add(internal_graph.output());
+
+    str_util::append_replace_map(
+            source_replace_map,
+            {{"{{NDIM}}", std::to_string(args.outputs[0].layout.ndim)},
+             {"{{INTERNAL_EXPRS}}", internal_exps_str},
+             {"{{EXP}}", var2ast.at(internal_graph.output())->code_gen()}});
+
+    str_util::replace_all_pairs_inplace(source, source_replace_map);
+
+    auto kernel_name = ssprintf(
+            "jit_c_%" PRIx64, XXHash{}.update(source.data(), source.size()).digest());
+    str_util::replace_all_pairs_inplace(source, {{"{{KERNEL_NAME}}", kernel_name}});
+
+    if (ExecutableHelper::keep_interm()) {
+        ExecutableHelper::get().write_file(
+                kernel_name + ".cpp",
+                "// " + internal_graph.output()->owner_opr()->name() + "\n" + source);
+    }
+
+    return {kernel_name, source};
+}
+
+#endif  // MGB_JIT
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -0,0 +1,46 @@
+/**
+ * \file src/jit/impl/c/codegen_c.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include "megbrain_build_config.h"
+
+#if MGB_JIT
+
+#include "megbrain/jit/executor_opr.h"
+
+namespace mgb {
+namespace jit {
+
+/*!
+ * \brief signature of the generated cpu kernel
+ *
+ * It computes rows [begin, end) of the output, where a row is the last axis of
+ * the output layout. \p shape is the output shape and \p strides contains the
+ * strides of all the inputs broadcast to the output, in number of elements.
+ */
+using CpuKernel = void (*)(
+        const float* const* inputs, float* output, const size_t* shape,
+        const ptrdiff_t* strides, size_t begin, size_t end);
+
+/*!
+ * \brief generate C source code of a cpu kernel
+ * \return (kernel name, kernel source)
+ */
+std::pair<std::string, std::string> codegen_c(
+        const InternalGraph& internal_graph, const JITExecutor::Args& args);
+
+}  // namespace jit
+}  // namespace mgb
+
+#endif  // MGB_JIT
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
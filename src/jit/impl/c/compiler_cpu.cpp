@@ -0,0 +1,153 @@
+/**
+ * \file src/jit/impl/c/compiler_cpu.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "./compiler_cpu.h"
+
+#include "megbrain/comp_node_env.h"
+#include "megbrain/jit/utils.h"
+#include "megbrain/utils/persistent_cache.h"
+#include "megbrain/utils/timer.h"
+
+#if MGB_JIT
+
+using namespace mgb;
+using namespace jit;
+
+/* =================== CpuExecutable ==================== */
+
+CpuExecutable::CpuExecutable(std::string source, std::string name)
+        : m_source{std::move(source)}, m_name{std::move(name)} {}
+
+CpuExecutable::~CpuExecutable() {
+    if (m_dl_handle) {
+        ExecutableHelper::get().unload_lib(m_dl_handle);
+    }
+}
+
+void CpuExecutable::load(CompNode cn) {
+    RealTimer timer;
+    auto&& helper = ExecutableHelper::get();
+    auto&& cache = PersistentCache::inst();
+    auto category = "jit:c:" + PersistentCache::make_category_from_comp_node(cn);
+    PersistentCache::Blob key{m_source.data(), m_source.size()};
+    auto load_lib = [&](const std::string& lib_name) {
+        m_dl_handle = helper.load_lib(lib_name);
+        helper.resolve_func(m_kern, m_dl_handle, m_name);
+    };
+    // use a new file name in each load, since the library of the same kernel
+    // may have been loaded by another executable
+    auto compile_and_load = [&]() {
+        auto lib_name = next_kernel_name() + ".so";
+        // errno and floating point exceptions are not used by the kernel, and
+        // ignoring them enables vectorization of math functions and comparisons
+        auto obj_name = helper.compile_cpp_source_secondary(
+                m_source.c_str(), m_name.c_str(),
+                "-O3 -fno-math-errno -fno-trapping-math");
+        helper.link({obj_name}, lib_name);
+        load_lib(lib_name);
+        // put only after loading, so that a library that can not be loaded
+        // never reaches the cache
+        auto lib = helper.read_file(lib_name);
+        cache.put(category, key, {lib.data(), lib.size()});
+    };
+
+    auto lib_cache = cache.get(category, key);
+    bool cache_hit = lib_cache.valid();
+    if (cache_hit) {
+        auto lib_name = next_kernel_name() + ".so";
+        helper.write_file(
+                lib_name, {static_cast<const char*>(lib_cache->ptr), lib_cache->size});
+        MGB_TRY { load_lib(lib_name); }
+        MGB_CATCH(SystemError & exc, {
+            // the cached library may be corrupted or built for another host
+            mgb_log_warn(
+                    "C JIT: failed to load cached %s, compile it again: %s",
+                    m_name.c_str(), exc.what());
+            if (m_dl_handle) {
+                helper.unload_lib(m_dl_handle);
+                m_dl_handle = nullptr;
+            }
+            m_kern = nullptr;
+            cache_hit = false;
+        });
+    }
+    if (!cache_hit) {
+        compile_and_load();
+    }
+    mgb_log("C JIT: load %s: source_len=%zu cache_hit=%d time=%.3fms",
+            m_name.c_str(), m_source.size(), cache_hit, timer.get_msecs());
+}
+
+void CpuExecutable::execute(JITExecutor* fusion_opr) {
+    auto cn = fusion_opr->comp_node();
+    {
+        MGB_LOCK_GUARD(m_mtx);
+        if (!m_kern) {
+            load(cn);
+        }
+    }
+
+    auto&& args = fusion_opr->args();
+    auto&& out_layout = args.outputs[0].layout;
+    mgb_assert(
+            out_layout.is_contiguous(), "output of C JIT must be contiguous: %s",
+            out_layout.to_string().c_str());
+    size_t ndim = out_layout.ndim, nr_inps = args.inputs.size(),
+           nr_elems = out_layout.total_nr_elems();
+    if (!nr_elems) {
+        return;
+    }
+
+    // NOTE: we must copy all the params into the kernel closure since it would
+    // be dispatched on a different thread
+    std::vector<size_t> shape(out_layout.shape, out_layout.shape + ndim);
+    std::vector<const float*> inputs(nr_inps);
+    std::vector<ptrdiff_t> strides(nr_inps * ndim);
+    for (size_t i = 0; i < nr_inps; ++i) {
+        auto layout = args.inputs[i].layout;
+        if (!layout.eq_shape(out_layout)) {
+            layout = layout.broadcast(out_layout);
+        }
+        inputs[i] =
+                reinterpret_cast<const float*>(args.inputs[i].from->dev_tensor().raw_ptr());
+        std::copy(layout.stride, layout.stride + ndim, strides.begin() + i * ndim);
+    }
+    auto output = args.outputs[0].from->dev_tensor().as_megdnn().ptr<float>();
+
+    auto&& env = CompNodeEnv::from_comp_node(cn).cpu_env();
+    size_t nr_rows = nr_elems / shape[ndim - 1],
+           nr_tasks = std::min(
+                   env.dispatcher->nr_threads(),
+                   std::max<size_t>(nr_elems / MIN_NR_ELEMS_PER_TASK, 1));
+    nr_tasks = std::min(nr_tasks, nr_rows);
+    auto kern = m_kern;
+    auto task = [kern, inputs = std::move(inputs), output, shape = std::move(shape),
+                 strides = std::move(strides), nr_rows,
+                 nr_tasks](size_t index, size_t) {
+        size_t begin = nr_rows * index / nr_tasks,
+               end = nr_rows * (index + 1) / nr_tasks;
+        kern(inputs.data(), output, shape.data(), strides.data(), begin, end);
+    };
+    env.dispatch(task, nr_tasks);
+}
+
+/* ==================== CpuCompiler ===================== */
+
+std::unique_ptr<Executable> CpuCompiler::do_compile(
+        const InternalGraph& graph, const JITExecutor::Args& args) {
+    std::string source, kernel_name;
+    std::tie(kernel_name, source) = codegen_c(graph, args);
+    return std::make_unique<CpuExecutable>(std::move(source), std::move(kernel_name));
+}
+
+#endif  // MGB_JIT
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -0,0 +1,82 @@
+/**
+ * \file src/jit/impl/c/compiler_cpu.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include "megbrain_build_config.h"
+
+#if MGB_JIT
+
+#include "./codegen_c.h"
+#include "megbrain/jit/compiler.h"
+
+namespace mgb {
+namespace jit {
+
+/*!
+ * \brief Executable class for CPU, which runs a kernel compiled from the
+ *      generated C source by the host compiler
+ */
+class CpuExecutable final : public Executable {
+public:
+    CpuExecutable(std::string source, std::string name);
+    ~CpuExecutable();
+
+    /*!
+     * \brief execute
+     * A Executable instance can be executed by one or more fusion_opr
+     */
+    void execute(JITExecutor* fusion_opr) override final;
+
+private:
+    //! minimal number of elements to be computed by a thread
+    static constexpr size_t MIN_NR_ELEMS_PER_TASK = 16384;
+
+    const std::string m_source;
+    const std::string m_name;
+    std::mutex m_mtx;
+    void* m_dl_handle = nullptr;
+    CpuKernel m_kern = nullptr;
+
+    //! load the shared library from persistent cache, or compile it
+    void load(CompNode cn);
+};
+
+/*!
+ * \brief CPU compiler using the host C compiler
+ *
+ * Only float32 elemwise oprs are supported. The compiled libraries are stored
+ * in PersistentCache keyed by the source, so they could be shipped with the
+ * cache file rather than compiled at the first run.
+ */
+class CpuCompiler final : public Compiler {
+    std::unique_ptr<Executable> do_compile(
+            const InternalGraph& graph, const JITExecutor::Args& args) override;
+
+public:
+    Property property() const override {
+        using F = Property::Flag;
+        return Property{
+                F::NEED_INPUT_COLLAPSE | F::BIND_NDIM | F::FLOAT32_ELEMWISE_ONLY,
+                JITFeatureBits::DIMSHUFFLE, 64};
+    }
+
+    size_t get_nr_workspace_outputs(JITExecutor*) const override { return 0; }
+
+    void init_workspace_size_infer(JITExecutor*) override {}
+};
+
+}  // namespace jit
+}  // namespace mgb
+
+#endif  // MGB_JIT
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -9,6 +9,7 @@
  * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
  */
 
+#include "./c/compiler_cpu.h"
 #include "./mlir/compiler.h"
 #include "./halide/compiler_cuda.h"
 #include "./nvrtc/compiler_cuda.h"
@@ -111,6 +112,10 @@ Compiler* Compiler::get(ComputingGraph& graph, CompNode comp_node) {
                     break;
                 }
 #endif
+                if (!backend || !strcmp(backend, "C")) {
+                    compiler = std::make_unique<CpuCompiler>();
+                    break;
+                }
                 mgb_throw(InternalError, "No compiler support for cpu");
                 break;
             default:
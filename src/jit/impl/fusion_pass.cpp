@@ -328,6 +328,20 @@ bool JITFusionPass::Impl::can_be_fused(cg::OperatorNodeBase* opr) const {
         return false;
     }
 
+    auto compiler =
+            Compiler::get(*m_opt_state.graph().comp_graph(), opr->output(0)->comp_node());
+    if (compiler->property().contain_flag(
+                Compiler::Property::Flag::FLOAT32_ELEMWISE_ONLY)) {
+        if (opr->same_type<opr::Reduce>())
+            return false;
+        for (auto i : opr->input()) {
+            if (i->dtype() != dtype::Float32())
+                return false;
+        }
+        if (opr->output(0)->dtype() != dtype::Float32())
+            return false;
+    }
+
     //! As MLIR backend has some contraints
     const char* backend = MGB_GETENV("MGB_JIT_BACKEND");
     if (!backend) {
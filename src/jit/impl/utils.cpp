@@ -20,6 +20,7 @@
 #include "megbrain/utils/cuda_helper.h"
 #endif
 
+#include <array>
 #include <atomic>
 
 #ifdef __linux__
@@ -190,16 +191,20 @@ public:
     }
 
     std::string compile_cpp_source_secondary(
-            const char* source, const char* out_name) override {
+            const char* source, const char* out_name,
+            const char* extra_opts) override {
         std::string uniq_name{out_name};
         uniq_name.append("-");
-        uniq_name.append(
-                std::to_string(XXHash{}.update(source, strlen(source)).digest()));
+        auto hash = XXHash{}
+                            .update(source, strlen(source))
+                            .update(extra_opts, strlen(extra_opts))
+                            .digest();
+        uniq_name.append(std::to_string(hash));
         auto src_name = uniq_name + ".cpp", obj_name = uniq_name + ".o";
         write_file(src_name, source);
         check_exec(ssprintf(
-                "g++ -O2 -fPIC -std=c++11 '%s' -o '%s' -c", realpath(src_name).c_str(),
-                realpath(obj_name).c_str()));
+                "g++ -O2 -fPIC -std=c++11 %s '%s' -o '%s' -c", extra_opts,
+                realpath(src_name).c_str(), realpath(obj_name).c_str()));
         return obj_name;
     }
 
@@ -250,6 +255,25 @@ void ExecutableHelper::write_file(const std::string& name, const std::string& da
     mgb_throw_if(err, SystemError, "failed to close file: %s", strerror(errno));
 }
 
+std::string ExecutableHelper::read_file(const std::string& name) {
+    auto full_name = realpath(name);
+    FILE* fptr = fopen(full_name.c_str(), "rb");
+    mgb_throw_if(
+            !fptr, SystemError, "failed to open %s: %s", full_name.c_str(),
+            strerror(errno));
+    std::unique_ptr<FILE, int (*)(FILE*)> fptr_close{fptr, ::fclose};
+    std::string data;
+    std::array<char, 4096> buffer;
+    size_t done;
+    while ((done = fread(buffer.data(), 1, buffer.size(), fptr)) > 0) {
+        data.append(buffer.data(), done);
+    }
+    mgb_throw_if(
+            ferror(fptr), SystemError, "failed to read file %s: %s", full_name.c_str(),
+            strerror(errno));
+    return data;
+}
+
 ExecutableHelper& ::ExecutableHelper::get() {
     static ExecutableHelperImpl inst;
     return inst;
@@ -61,7 +61,10 @@ public:
 
             //! if true, input would be contiguous; otherwise it is only
             //! monotone contiguous
-            NEED_INPUT_CONTIG = 1u << 3
+            NEED_INPUT_CONTIG = 1u << 3,
+
+            //! whether only oprs on float32 other than Reduce can be fused
+            FLOAT32_ELEMWISE_ONLY = 1u << 4
         };
 
         //! flags that indicate requirements of this Compiler for the
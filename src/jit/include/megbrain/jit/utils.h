@@ -86,11 +86,12 @@ public:
      *
      * \param out_name output filename template; it should not include the .cpp
      *      suffix
+     * \param extra_opts extra options passed to the compiler
      *
      * \return object file name (without dir path)
      */
     virtual std::string compile_cpp_source_secondary(
-            const char* source, const char* out_name) = 0;
+            const char* source, const char* out_name, const char* extra_opts = "") = 0;
 
     //! link object files to shared library
     virtual void link(
@@ -125,6 +126,9 @@ public:
     //! write content to file
     void write_file(const std::string& name, const std::string& data);
 
+    //! read content of file
+    std::string read_file(const std::string& name);
+
     //! whether MGB_JIT_KEEP_INTERM is set
     static bool keep_interm();
 
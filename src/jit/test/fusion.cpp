@@ -1685,6 +1685,126 @@ TEST(TestJITExecutor, TestJITMlirFusionGpu) {
 
 #endif  // MGB_JIT_MLIR
 
+void run_c(CompNode cn) {
+    set_backend(Backend::C);
+
+    HostTensorGenerator<> gen;
+    auto host_x0 = gen({23, 420}, cn), host_x1 = gen({23, 1}, cn),
+         host_x2 = gen({1, 420}, cn), host_x3 = gen({23, 420}, cn);
+
+    auto make_dst = [&](ComputingGraph& graph) {
+        auto a = opr::Host2DeviceCopy::make(graph, host_x0),
+             b = opr::Host2DeviceCopy::make(graph, host_x1),
+             c = opr::Host2DeviceCopy::make(graph, host_x2),
+             d = opr::Host2DeviceCopy::make(graph, host_x3);
+        return opr::relu(a * b + opr::max(c, d)) + opr::tanh(d) -
+               opr::pow(a, a.make_scalar_dt(2.f));
+    };
+    HostTensorND host_y1, host_y2;
+    auto funcs = make_func_pair(host_y1, host_y2, make_dst, 1);
+
+    funcs.first->execute();
+    funcs.second->execute();
+    MGB_ASSERT_TENSOR_NEAR(host_y1, host_y2, 1e-5);
+
+    JITExecutor* jit;
+    unpack_vector(find_oprs<JITExecutor>(*funcs.second), jit);
+    ASSERT_EQ(0u, find_oprs<opr::Elemwise>(*funcs.second).size());
+    ASSERT_EQ(4u, jit->input().size());
+
+    // the kernel was generated with x1 broadcast along the last axis; it is
+    // reused with the new stride pattern and must take the strided loop
+    *host_x1 = *gen({23, 420}, cn);
+    funcs.first->execute();
+    funcs.second->execute();
+    MGB_ASSERT_TENSOR_NEAR(host_y1, host_y2, 1e-5);
+}
+
+TEST(TestJITExecutor, TestJITCFusion) {
+    run_c(CompNode::load("cpu0"));
+    run_c(CompNode::load("multithread4:0"));
+}
+
+TEST(TestJITExecutor, TestJITCFusionCache) {
+    set_backend(Backend::C);
+    size_t nr_get = 0, nr_put = 0;
+    auto on_get = [&](const std::string& category, const void*, size_t, const void*,
+                      size_t) { nr_get += !category.compare(0, 6, "jit:c:"); };
+    auto on_put = [&](const std::string& category, const void*, size_t, const void*,
+                      size_t) { nr_put += !category.compare(0, 6, "jit:c:"); };
+    auto orig_cache = PersistentCache::set_impl(
+            std::make_shared<InMemoryPersistentCache>());
+    {
+        PersistentCacheHook hook{on_get, on_put};
+        auto cn = CompNode::load("cpu0");
+        HostTensorGenerator<> gen;
+        auto host_x = gen({2, 3}, cn);
+        auto make_dst = [&](ComputingGraph& graph) {
+            auto x = opr::Host2DeviceCopy::make(graph, host_x);
+            return opr::sin(x) * x + x;
+        };
+        for (size_t i = 0; i < 2; ++i) {
+            HostTensorND host_y1, host_y2;
+            auto funcs = make_func_pair(host_y1, host_y2, make_dst, 1);
+            funcs.first->execute();
+            funcs.second->execute();
+            MGB_ASSERT_TENSOR_NEAR(host_y1, host_y2, 1e-6);
+        }
+    }
+    PersistentCache::set_impl(orig_cache);
+    // the library is only compiled and put into the cache at the first time
+    ASSERT_EQ(2u, nr_get);
+    ASSERT_EQ(1u, nr_put);
+}
+
+#if MGB_ENABLE_EXCEPTION
+TEST(TestJITExecutor, TestJITCFusionCorruptedCache) {
+    set_backend(Backend::C);
+    size_t nr_put = 0;
+    std::string category, key;
+    auto on_put = [&](const std::string& cat, const void* key_ptr, size_t key_size,
+                      const void*, size_t) {
+        if (!cat.compare(0, 6, "jit:c:")) {
+            ++nr_put;
+            category = cat;
+            key.assign(static_cast<const char*>(key_ptr), key_size);
+        }
+    };
+    auto mem_cache = std::make_shared<InMemoryPersistentCache>();
+    auto orig_cache = PersistentCache::set_impl(mem_cache);
+    {
+        PersistentCacheHook hook{
+                [](const std::string&, const void*, size_t, const void*, size_t) {},
+                on_put};
+        auto cn = CompNode::load("cpu0");
+        HostTensorGenerator<> gen;
+        auto host_x = gen({2, 3}, cn);
+        auto make_dst = [&](ComputingGraph& graph) {
+            auto x = opr::Host2DeviceCopy::make(graph, host_x);
+            return opr::cos(x) * x - x;
+        };
+        for (size_t i = 0; i < 3; ++i) {
+            HostTensorND host_y1, host_y2;
+            auto funcs = make_func_pair(host_y1, host_y2, make_dst, 1);
+            funcs.first->execute();
+            funcs.second->execute();
+            MGB_ASSERT_TENSOR_NEAR(host_y1, host_y2, 1e-6);
+            if (!i) {
+                ASSERT_EQ(1u, nr_put);
+                std::string garbage = "not a shared library";
+                mem_cache->put(
+                        category, {key.data(), key.size()},
+                        {garbage.data(), garbage.size()});
+            }
+        }
+    }
+    PersistentCache::set_impl(orig_cache);
+    // the corrupted library is compiled again and overwritten, and the new one
+    // is loaded from the cache in the last run
+    ASSERT_EQ(2u, nr_put);
+}
+#endif  // MGB_ENABLE_EXCEPTION
+
 #endif  // MGB_JIT
 
 // vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -138,15 +138,58 @@ void mixin::WeightPreprocessExecutor::mixin_update_preprocessed_filter(
     }
     m_preprocessed_filter.reset(new PreprocessedFilter{});
     m_preprocessed_filter->tensors.resize(new_size);
-    m_filter_storage.resize(new_size);
     m_preprocessed_filter->algorithm_id = nullptr;
-    for (size_t i = 0; i < new_size; i++) {
-        m_filter_storage[i] = {
-                opr.output(0)->comp_node(), new_layout[i], new_layout[i].dtype,
-                new_layout[i].format};
-        m_preprocessed_filter->tensors[i] = m_filter_storage[i].as_megdnn();
+    m_preprocess_algo = preprocess_algo_desc();
+    if (use_packed_weight(new_layout)) {
+        for (size_t i = 0; i < new_size; i++) {
+            m_preprocessed_filter->tensors[i] = m_filter_storage[i].as_megdnn();
+        }
+    } else {
+        m_filter_storage.resize(new_size);
+        for (size_t i = 0; i < new_size; i++) {
+            m_filter_storage[i] = {
+                    opr.output(0)->comp_node(), new_layout[i], new_layout[i].dtype,
+                    new_layout[i].format};
+            m_preprocessed_filter->tensors[i] = m_filter_storage[i].as_megdnn();
+        }
+        scn_do_execute_preprocess();
+    }
+    on_weight_preprocessed();
+}
+
+bool mixin::WeightPreprocessExecutor::use_packed_weight(
+        const SmallVector<TensorLayout>& layouts) {
+    if (!m_packed_weight_to_use.valid()) {
+        return false;
+    }
+    auto packed = std::move(m_packed_weight_to_use.val());
+    m_packed_weight_to_use.invalidate();
+    bool match = packed.algo == m_preprocess_algo &&
+                 packed.tensors.size() == layouts.size();
+    for (size_t i = 0; match && i < layouts.size(); ++i) {
+        match = packed.tensors[i].layout().eq_layout(layouts[i]);
+    }
+    if (!match) {
+        mgb_log_warn(
+                "packed weight for algo %s does not match the chosen algo %s; "
+                "preprocess the original weight instead",
+                packed.algo.name.c_str(), m_preprocess_algo.name.c_str());
+        return false;
+    }
+    m_filter_storage = std::move(packed.tensors);
+    return true;
+}
+
+Maybe<mixin::WeightPreprocessExecutor::PackedWeight> mixin::WeightPreprocessExecutor::
+        packed_weight() const {
+    if (!m_preprocessed_filter) {
+        return None;
     }
-    scn_do_execute_preprocess();
+    return PackedWeight{m_preprocess_algo, m_filter_storage};
+}
+
+void mixin::WeightPreprocessExecutor::set_packed_weight(PackedWeight weight) {
+    m_packed_weight_to_use = std::move(weight);
 }
 
 void mixin::WeightPreprocessExecutor::record_preprocessed_weight(
@@ -286,6 +329,9 @@ void ConvolutionForward::scn_do_execute_preprocess() {
             input(0)->layout(), input(1)->dev_tensor().as_megdnn(), output(0)->layout(),
             preprocessed_filter(),
             intl::get_megdnn_workspace_from_var(output().back()));
+}
+
+void ConvolutionForward::on_weight_preprocessed() {
     //! Flag the input(1) no use later, which can be freed when no other
     //! var depend on its dev_value, host_value and shape.
     auto receiver_info =
@@ -900,6 +946,16 @@ void ConvBiasForward::scn_do_execute_preprocess() {
                 z_layout, output(0)->layout(), preprocessed_filter(),
                 intl::get_megdnn_workspace_from_var(output().back()));
     }
+}
+
+void ConvBiasForward::on_weight_preprocessed() {
+    TensorLayout bias_layout(output(0)->dtype()), z_layout(output(0)->dtype());
+    if (input().size() > 2) {
+        bias_layout = input(2)->layout();
+    }
+    if (input().size() > 3) {
+        z_layout = input(3)->layout();
+    }
     //! Flag the weight and bias no use later, which can be freed when no other
     //! var depend on its dev_value, host_value and shape.
     auto receiver_info_weight =
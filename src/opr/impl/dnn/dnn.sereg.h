@@ -15,6 +15,7 @@
 #include "megbrain/opr/dnn/convolution.h"
 #include "megbrain/opr/dnn/correlation.h"
 #include "megbrain/opr/dnn/fake_quant.h"
+#include "megbrain/opr/dnn/fused_attention.h"
 #include "megbrain/opr/dnn/images2neibs.h"
 #include "megbrain/opr/dnn/layer_norm.h"
 #include "megbrain/opr/dnn/local.h"
@@ -484,6 +485,26 @@ struct OprMaker<opr::LayerNorm, 0> {
     }
 };
 
+template <>
+struct OprMaker<opr::FusedAttention, 0> {
+    using Param = opr::FusedAttention::Param;
+    static cg::OperatorNodeBase* make(
+            const Param& param, const cg::VarNodeArray& i, ComputingGraph& graph,
+            const OperatorNodeConfig& config) {
+        MGB_MARK_USED_VAR(graph);
+        if (i.size() == 4) {
+            return opr::FusedAttention::make(i[0], i[1], i[2], i[3], param, config)
+                    .node()
+                    ->owner_opr();
+        } else {
+            mgb_assert(i.size() == 3);
+            return opr::FusedAttention::make(i[0], i[1], i[2], param, config)
+                    .node()
+                    ->owner_opr();
+        }
+    }
+};
+
 // OprMaker in MGB_SEREG_OPR only support unique output opr
 template <>
 struct OprMaker<opr::LayerNormBackward, 0> {
@@ -736,6 +757,7 @@ MGB_SEREG_OPR(LSTMForward, 4);
 MGB_SEREG_OPR(LSTMBackward, 9);
 MGB_SEREG_OPR(Softmax, 1);
 MGB_SEREG_OPR(SoftmaxBackward, 2);
+MGB_SEREG_OPR(FusedAttention, 0);
 }  // namespace opr
 
 }  // namespace mgb
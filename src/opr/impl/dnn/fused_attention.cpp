@@ -0,0 +1,99 @@
+/**
+ * \file src/opr/impl/dnn/fused_attention.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+
+#include "megbrain/opr/dnn/fused_attention.h"
+
+#include "../internal/megdnn_opr_wrapper.inl"
+
+using namespace mgb;
+using namespace opr;
+
+/* ==================== FusedAttentionForward  ==================== */
+MGB_DYN_TYPE_OBJ_FINAL_IMPL(FusedAttentionForward);
+
+FusedAttentionForward::FusedAttentionForward(
+        VarNode* q, VarNode* k, VarNode* v, VarNode* mask, const Param& param,
+        const OperatorNodeConfig& config)
+        : Super{q->owner_graph(), config, "fused_attention", {q, k, v, mask}} {
+    mgb_assert(param.has_mask, "mask given to FusedAttention without has_mask");
+    init_megdnn_opr(*this, param);
+
+    add_input({q, k, v, mask});
+    output(0)->dtype(q->dtype());
+}
+
+FusedAttentionForward::FusedAttentionForward(
+        VarNode* q, VarNode* k, VarNode* v, const Param& param,
+        const OperatorNodeConfig& config)
+        : Super{q->owner_graph(), config, "fused_attention", {q, k, v}} {
+    mgb_assert(!param.has_mask, "has_mask is set but no mask given to FusedAttention");
+    init_megdnn_opr(*this, param);
+
+    add_input({q, k, v});
+    output(0)->dtype(q->dtype());
+}
+
+SymbolVar FusedAttentionForward::make(
+        SymbolVar q, SymbolVar k, SymbolVar v, SymbolVar mask, const Param& param,
+        const OperatorNodeConfig& config) {
+    return q.insert_single_output_opr<FusedAttentionForward>(
+            q.node(), k.node(), v.node(), mask.node(), param, config);
+}
+
+SymbolVar FusedAttentionForward::make(
+        SymbolVar q, SymbolVar k, SymbolVar v, const Param& param,
+        const OperatorNodeConfig& config) {
+    return q.insert_single_output_opr<FusedAttentionForward>(
+            q.node(), k.node(), v.node(), param, config);
+}
+
+TensorLayout FusedAttentionForward::mask_layout(
+        const TensorShapeArray& input_shapes) const {
+    if (input_shapes.size() < 4) {
+        return {};
+    }
+    return {input_shapes[3], input(3)->dtype(), input(3)->format()};
+}
+
+void FusedAttentionForward::get_output_var_shape(
+        const TensorShapeArray& inp_shape, TensorShapeArray& out_shape) const {
+    mgb_assert(
+            inp_shape[0].ndim == 3 && inp_shape[2].ndim == 3,
+            "q and v of FusedAttention must be 3D: %s %s",
+            inp_shape[0].to_string().c_str(), inp_shape[2].to_string().c_str());
+    out_shape[0] = {inp_shape[0][0], inp_shape[0][1], inp_shape[2][2]};
+}
+
+size_t FusedAttentionForward::get_workspace_size_bytes(
+        const TensorShapeArray& input_shapes,
+        const TensorShapeArray& output_shapes) const {
+    return megdnn_opr()->get_workspace_in_bytes(
+            {input_shapes[0], input(0)->dtype(), input(0)->format()},
+            {input_shapes[1], input(1)->dtype(), input(1)->format()},
+            {input_shapes[2], input(2)->dtype(), input(2)->format()},
+            mask_layout(input_shapes),
+            {output_shapes[0], output(0)->dtype(), output(0)->format()});
+}
+
+void FusedAttentionForward::scn_do_execute() {
+    megdnn::TensorND mask;
+    if (input().size() == 4) {
+        mask = input(3)->dev_tensor().as_megdnn();
+    }
+    megdnn_opr()->exec(
+            input(0)->dev_tensor().as_megdnn(), input(1)->dev_tensor().as_megdnn(),
+            input(2)->dev_tensor().as_megdnn(), mask,
+            output(0)->dev_tensor().as_megdnn(),
+            intl::get_megdnn_workspace_from_var(output().back()));
+}
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -84,6 +84,8 @@ struct SharedDeviceTensorLoadDump {
             const OperatorNodeConfig& config) {
         mgb_assert(inputs.empty());
         auto val = ctx.load_tensor_shared();
+        // the value is exposed to the oprs loaded after it
+        ctx.wait_tensor_value(*val);
         return Opr::make(ctx.graph(), val, config).node()->owner_opr();
     }
 };
@@ -229,6 +231,7 @@ struct OprLoadDumpImpl<opr::MultipleDeviceTensorWithFormatHolder, 0> {
                         i->storage().ptr(),
                         "storage should not be nullptr if mem_node is "
                         "default_cpu");
+                ctx.wait_tensor_value(*i);
                 HostTensorND src{i->storage().comp_node(), layout_with_format};
                 src.copy_from_fixlayout(*i).sync();
                 *i = DeviceTensorND::make_proxy(src);
@@ -16,6 +16,7 @@
 #include "megbrain/opr/dnn/convolution.h"
 #include "megbrain/opr/internal/megdnn_opr_wrapper.h"
 #include "megbrain/opr/search_policy/algo_chooser_helper.h"
+#include "megbrain/opr/search_policy/algo_cost_model.h"
 #include "megbrain/opr/search_policy/profiler.h"
 
 #include "../internal/invoke.h"
@@ -676,9 +677,14 @@ void AlgoChooser<Opr>::AlgoChooserHelper::construct_execution_policy(
         typename AlgoChooser<Opr>::ImplExecutionPolicy& policy, bool retrive_from_cache,
         bool allow_log) const {
     MIDOUT_B(Opr, midout_iv(MGB_HASH_STR("construct_execution_policy")))
+    bool from_cost_model = false;
     if (!policy.algo.valid()) {
         if (retrive_from_cache) {
             policy.algo = get_profile_result_from_cache(selected_strategy).first;
+            if (!policy.algo.valid()) {
+                policy.algo = get_algo_from_cost_model(selected_strategy);
+                from_cost_model = policy.algo.valid();
+            }
             if (!policy.algo.valid()) {
                 if (allow_log) {
                     auto target_attr = extract_algo_attribute(selected_strategy);
@@ -741,6 +747,71 @@ void AlgoChooser<Opr>::AlgoChooserHelper::construct_execution_policy(
             return;
         }
     });
+
+    if (from_cost_model) {
+        //! workspace of the profiled shapes does not apply here
+        auto workspace_limit = WorkspaceLimitGetter::get_workspace_limit(
+                owner_graph(), m_cn, m_execution_policy.workspace_limit);
+        if (get_workspace_size_bytes(policy) > workspace_limit) {
+            policy = {};
+        }
+    }
+    MIDOUT_E
+}
+
+template <typename Opr>
+typename AlgoChooser<Opr>::ImplAlgoDesc AlgoChooser<Opr>::AlgoChooserHelper::
+        get_algo_from_cost_model(const ExecutionStrategy& selected_strategy) const {
+    MIDOUT_B(Opr, midout_iv(MGB_HASH_STR("get_algo_from_cost_model")))
+    auto model = AlgoCostModel::inst();
+    if (!model)
+        return {};
+
+    AlgoChooserProfileCache cache(m_cn, profile_name(m_dnn_opr).c_str());
+    typename Opr::Param origin_param = m_dnn_opr->param();
+    AlgoChooserProfileCache::Key cache_key{
+            m_incache_layouts.data(), m_incache_layouts.size(), &origin_param,
+            sizeof(origin_param)};
+    auto target_attr = extract_algo_attribute(selected_strategy);
+    auto pred = model->predict(
+            cache.category(), cache_key.build_blob(), arity, target_attr.first,
+            target_attr.second);
+    if (!pred.valid())
+        return {};
+
+    std::string layouts_str =
+            format_fixlayouts<Opr>(m_fastrun_layouts, arity_in, arity_out);
+    Algorithm::Info::Desc algo_desc = deserialize_read_pod(pred->algo);
+    if (pred->confidence < model->min_confidence()) {
+        mgb_log_debug(
+                "opr: %s, layouts: %s, algo %s predicted by cost model with low "
+                "confidence %.2f, fall back to profiling",
+                m_base_mgb_opr->dyn_typeinfo()->name, layouts_str.c_str(),
+                algo_desc.name.c_str(), pred->confidence);
+        return {};
+    }
+
+    //! the algo may be unavailable on this shape or missing in this build
+    auto&& candidates =
+            APPLY(m_dnn_opr->get_all_algorithms_info_safe(args...), m_fastrun_layouts);
+    bool found = false;
+    for (auto&& i : candidates) {
+        found |= i.desc == algo_desc;
+    }
+    if (!found) {
+        mgb_log_debug(
+                "opr: %s, layouts: %s, algo %s predicted by cost model is not "
+                "available",
+                m_base_mgb_opr->dyn_typeinfo()->name, layouts_str.c_str(),
+                algo_desc.name.c_str());
+        return {};
+    }
+    mgb_log_debug(
+            "opr: %s, layouts: %s, choose algo %s by cost model: confidence=%.2f "
+            "relative_time=%.2f",
+            m_base_mgb_opr->dyn_typeinfo()->name, layouts_str.c_str(),
+            algo_desc.name.c_str(), pred->confidence, pred->relative_time);
+    return algo_desc;
     MIDOUT_E
 }
 
@@ -1051,6 +1122,9 @@ std::pair<AlgoAttribute, AlgoAttribute> AlgoChooser<Opr>::AlgoChooserHelper::
             Maybe<AlgoChooserProfileCache::Result>>                               \
     AlgoChooser<megdnn::Opr>::AlgoChooserHelper::get_profile_result_from_cache(   \
             const ExecutionStrategy& select_strategy) const;                      \
+    template typename AlgoChooser<megdnn::Opr>::ImplAlgoDesc                      \
+    AlgoChooser<megdnn::Opr>::AlgoChooserHelper::get_algo_from_cost_model(        \
+            const ExecutionStrategy& select_strategy) const;                      \
     template void                                                                 \
     AlgoChooser<megdnn::Opr>::AlgoChooserHelper::construct_execution_policy(      \
             const ExecutionStrategy& select_strategy,                             \
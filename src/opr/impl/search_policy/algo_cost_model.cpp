@@ -0,0 +1,364 @@
+/**
+ * \file src/opr/impl/search_policy/algo_cost_model.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+
+#include "megbrain/opr/search_policy/algo_cost_model.h"
+#include "megbrain/opr/search_policy/algo_chooser.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace mgb;
+using namespace opr;
+
+namespace {
+
+//! number of neighbours voting for a prediction
+constexpr size_t NR_NEIGHBOUR = 3;
+//! relative time of an algorithm missing in the result of a neighbour, the
+//! same as the timeout tolerance of profiling
+constexpr double MISSING_RELATIVE_TIME = 2;
+//! an algorithm is regarded as the fastest one on a sample if it is within
+//! this ratio of the fastest time
+constexpr double AGREE_TOLERANCE = 0.05;
+
+constexpr char MAGIC[8] = {'m', 'g', 'b', 'a', 'c', 'm', '0', '1'};
+
+std::shared_ptr<AlgoCostModel> g_inst;
+
+/*!
+ * \brief get number of layouts in the cache key of a profile category
+ *
+ * The category ends with the opr type name followed by the cache key version
+ * and the algorithm set name, see profile_name() in algo_chooser.cpp.
+ */
+size_t nr_layout_of_category(const std::string& category) {
+    struct Entry {
+        const char* name;
+        size_t arity;
+    };
+#define cb(_Opr)                                                \
+    {MegDNNOpr2MGBOpr<megdnn::_Opr>::MGBOpr::typeinfo()->name, \
+     OprArityTrait<megdnn::_Opr>::arity},
+    static const Entry entries[] = {MGB_FOREACH_FASTRUN_OPR(cb)};
+#undef cb
+    for (auto&& i : entries) {
+        auto pos = category.find(std::string{":"} + i.name + "v");
+        if (pos == std::string::npos)
+            continue;
+        auto ver = pos + strlen(i.name) + 2;
+        if (ver < category.size() && isdigit(category[ver]))
+            return i.arity;
+    }
+    return 0;
+}
+
+class BinaryWriter {
+    FILE* m_fp;
+
+public:
+    explicit BinaryWriter(const char* path) : m_fp{fopen(path, "wb")} {
+        mgb_assert(m_fp, "failed to open %s: %s", path, strerror(errno));
+    }
+    ~BinaryWriter() { fclose(m_fp); }
+
+    void write(const void* buf, size_t size) {
+        auto ret = fwrite(buf, size, 1, m_fp);
+        mgb_assert(ret == 1, "failed to write algo cost model");
+    }
+
+    template <typename T>
+    void write(T val) {
+        write(&val, sizeof(T));
+    }
+
+    void write(const std::string& str) {
+        write<uint32_t>(str.size());
+        write(str.data(), str.size());
+    }
+};
+
+class BinaryReader {
+    FILE* m_fp;
+
+public:
+    explicit BinaryReader(const char* path) : m_fp{fopen(path, "rb")} {
+        mgb_assert(m_fp, "failed to open %s: %s", path, strerror(errno));
+    }
+    ~BinaryReader() { fclose(m_fp); }
+
+    void read(void* buf, size_t size) {
+        if (!size)
+            return;
+        auto ret = fread(buf, size, 1, m_fp);
+        mgb_assert(ret == 1, "truncated algo cost model file");
+    }
+
+    template <typename T>
+    T read() {
+        T val;
+        read(&val, sizeof(T));
+        return val;
+    }
+
+    std::string read_str() {
+        std::string ret(read<uint32_t>(), '\0');
+        read(&ret[0], ret.size());
+        return ret;
+    }
+};
+
+//! collect profiling results put by InFilePersistentCache::put_to()
+class ProfileCollector final : public PersistentCache {
+    AlgoCostModel& m_model;
+    size_t m_nr_added = 0;
+
+public:
+    explicit ProfileCollector(AlgoCostModel& model) : m_model{model} {}
+
+    size_t nr_added() const { return m_nr_added; }
+
+    Maybe<Blob> get(const std::string&, const Blob&) override { return None; }
+
+    void put(const std::string& category, const Blob& key, const Blob& value) override {
+        if (category.compare(0, 8, "profile:"))
+            return;
+        auto nr_layout = nr_layout_of_category(category);
+        if (!nr_layout) {
+            mgb_log_warn(
+                    "algo cost model: unknown opr type of category %s",
+                    category.c_str());
+            return;
+        }
+        auto result = AlgoChooserProfileCache::deserialize_result(value);
+        if (!result.empty() && m_model.add(category, key, nr_layout, result))
+            ++m_nr_added;
+    }
+};
+
+}  // anonymous namespace
+
+AlgoCostModel* AlgoCostModel::inst() {
+    return g_inst.get();
+}
+
+std::shared_ptr<AlgoCostModel> AlgoCostModel::set_inst(
+        std::shared_ptr<AlgoCostModel> model) {
+    std::swap(g_inst, model);
+    return model;
+}
+
+bool AlgoCostModel::parse_key(
+        const PersistentCache::Blob& key, size_t nr_layout, std::string& group,
+        std::vector<float>& feature) {
+    auto ptr = static_cast<const char*>(key.ptr), end = ptr + key.size;
+    feature.clear();
+    for (size_t i = 0; i < nr_layout; ++i) {
+        auto bar = std::find(ptr, end, '|');
+        auto semi = std::find(ptr, bar, ';');
+        if (bar == end || semi == bar)
+            return false;
+        //! the shape goes to the feature and its ndim to the group; strides of
+        //! non-contiguous layouts and the dtype are kept in the group as is
+        size_t ndim = 0;
+        for (auto p = ptr; p < semi;) {
+            char* next;
+            auto dim = strtoull(p, &next, 10);
+            if (next == p || next > semi)
+                return false;
+            feature.push_back(std::log2(static_cast<float>(std::max<size_t>(dim, 1))));
+            ++ndim;
+            p = *next == ',' ? next + 1 : next;
+        }
+        group.append(std::to_string(ndim));
+        group.append(semi, bar + 1);
+        ptr = bar + 1;
+    }
+    group.append(ptr, end);
+    return true;
+}
+
+bool AlgoCostModel::add(
+        const std::string& category, const PersistentCache::Blob& key,
+        size_t nr_layout, const AlgoChooserProfileCache::Result& result) {
+    std::string group = category;
+    group.push_back('\0');
+    Sample sample;
+    if (!parse_key(key, nr_layout, group, sample.feature))
+        return false;
+    sample.result = result;
+
+    MGB_LOCK_GUARD(m_mtx);
+    auto&& samples = m_groups[group];
+    for (auto&& i : samples) {
+        if (i.feature == sample.feature) {
+            i = std::move(sample);
+            return true;
+        }
+    }
+    samples.emplace_back(std::move(sample));
+    return true;
+}
+
+void AlgoCostModel::add_from_cache(InFilePersistentCache& cache) {
+    ProfileCollector collector{*this};
+    cache.put_to(collector);
+    mgb_log_debug("algo cost model: %zu samples added", collector.nr_added());
+}
+
+size_t AlgoCostModel::nr_sample() const {
+    MGB_LOCK_GUARD(m_mtx);
+    size_t ret = 0;
+    for (auto&& i : m_groups) {
+        ret += i.second.size();
+    }
+    return ret;
+}
+
+Maybe<AlgoCostModel::Prediction> AlgoCostModel::predict(
+        const std::string& category, const PersistentCache::Blob& key,
+        size_t nr_layout, AlgoAttribute positive, AlgoAttribute negative) const {
+    std::string group = category;
+    group.push_back('\0');
+    std::vector<float> feature;
+    if (!parse_key(key, nr_layout, group, feature))
+        return None;
+
+    MGB_LOCK_GUARD(m_mtx);
+    auto iter = m_groups.find(group);
+    if (iter == m_groups.end())
+        return None;
+
+    auto usable = [&](const AlgoChooserProfileCache::ResultEntry& entry) {
+        auto attr = static_cast<AlgoAttribute>(entry.attribute);
+        return (attr & positive) == positive && !static_cast<bool>(attr & negative);
+    };
+
+    //! (distance, sample) of the nearest samples having usable algorithms
+    std::vector<std::pair<double, const Sample*>> neighbours;
+    for (auto&& sample : iter->second) {
+        if (sample.feature.size() != feature.size() ||
+            std::none_of(sample.result.begin(), sample.result.end(), usable))
+            continue;
+        double dist = 0;
+        for (size_t i = 0; i < feature.size(); ++i) {
+            double d = sample.feature[i] - feature[i];
+            dist += d * d;
+        }
+        neighbours.emplace_back(std::sqrt(dist), &sample);
+    }
+    if (neighbours.empty())
+        return None;
+    auto nr_neighbour = std::min(NR_NEIGHBOUR, neighbours.size());
+    std::partial_sort(
+            neighbours.begin(), neighbours.begin() + nr_neighbour, neighbours.end(),
+            [](const std::pair<double, const Sample*>& a,
+               const std::pair<double, const Sample*>& b) { return a.first < b.first; });
+    neighbours.resize(nr_neighbour);
+
+    //! relative time of each algorithm on each neighbour
+    std::unordered_map<std::string, std::vector<double>> relative_time;
+    std::vector<double> weight;
+    double sum_weight = 0;
+    for (size_t i = 0; i < nr_neighbour; ++i) {
+        weight.push_back(1 / (1 + neighbours[i].first));
+        sum_weight += weight.back();
+        double best = -1;
+        for (auto&& entry : neighbours[i].second->result) {
+            if (!usable(entry))
+                continue;
+            if (best < 0)
+                best = std::max(entry.time, 1e-9);
+            auto&& rel = relative_time[entry.algo];
+            if (rel.empty())
+                rel.resize(nr_neighbour, MISSING_RELATIVE_TIME);
+            rel[i] = std::min(entry.time / best, MISSING_RELATIVE_TIME);
+        }
+    }
+
+    Prediction ret;
+    ret.relative_time = std::numeric_limits<double>::infinity();
+    const std::vector<double>* best_rel = nullptr;
+    for (auto&& i : relative_time) {
+        double score = 0;
+        for (size_t j = 0; j < nr_neighbour; ++j) {
+            score += weight[j] * i.second[j];
+        }
+        score /= sum_weight;
+        if (score < ret.relative_time) {
+            ret.relative_time = score;
+            ret.algo = i.first;
+            best_rel = &i.second;
+        }
+    }
+
+    double agree = 0;
+    for (size_t i = 0; i < nr_neighbour; ++i) {
+        if ((*best_rel)[i] <= 1 + AGREE_TOLERANCE)
+            agree += weight[i];
+    }
+    ret.confidence = agree / sum_weight * weight[0];
+    return ret;
+}
+
+void AlgoCostModel::dump(const char* path) const {
+    MGB_LOCK_GUARD(m_mtx);
+    BinaryWriter out{path};
+    out.write(MAGIC, sizeof(MAGIC));
+    out.write<uint32_t>(m_groups.size());
+    for (auto&& group : m_groups) {
+        out.write(group.first);
+        out.write<uint32_t>(group.second.size());
+        for (auto&& sample : group.second) {
+            out.write<uint32_t>(sample.feature.size());
+            out.write(sample.feature.data(), sample.feature.size() * sizeof(float));
+            out.write<uint32_t>(sample.result.size());
+            for (auto&& entry : sample.result) {
+                out.write(entry.algo);
+                out.write<uint32_t>(entry.attribute);
+                out.write<double>(entry.time);
+                out.write<uint64_t>(entry.workspace);
+            }
+        }
+    }
+}
+
+std::shared_ptr<AlgoCostModel> AlgoCostModel::load(const char* path) {
+    auto ret = std::make_shared<AlgoCostModel>();
+    BinaryReader inp{path};
+    char magic[sizeof(MAGIC)];
+    inp.read(magic, sizeof(magic));
+    mgb_assert(
+            !memcmp(magic, MAGIC, sizeof(MAGIC)), "%s is not an algo cost model file",
+            path);
+    auto nr_group = inp.read<uint32_t>();
+    for (uint32_t i = 0; i < nr_group; ++i) {
+        auto&& samples = ret->m_groups[inp.read_str()];
+        samples.resize(inp.read<uint32_t>());
+        for (auto&& sample : samples) {
+            sample.feature.resize(inp.read<uint32_t>());
+            inp.read(sample.feature.data(), sample.feature.size() * sizeof(float));
+            sample.result.resize(inp.read<uint32_t>());
+            for (auto&& entry : sample.result) {
+                entry.algo = inp.read_str();
+                entry.attribute = inp.read<uint32_t>();
+                entry.time = inp.read<double>();
+                entry.workspace = inp.read<uint64_t>();
+            }
+        }
+    }
+    return ret;
+}
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
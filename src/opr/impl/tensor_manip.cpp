@@ -1307,8 +1307,13 @@ void Concat::scn_do_execute() {
             real_axis += in.shape().ndim;
         end = begin + in.shape().shape[real_axis];
         if (!in.layout().is_empty()) {
-            out.sub(Slice(begin, end).apply(out.layout(), real_axis))
-                    .copy_from_fixlayout(in);
+            auto dst = out.sub(Slice(begin, end).apply(out.layout(), real_axis));
+            if (dst.raw_ptr() == in.raw_ptr()) {
+                // input has been computed in place by out2in forwarding
+                mgb_assert(dst.layout().eq_layout(in.layout()));
+                continue;
+            }
+            dst.copy_from_fixlayout(in);
         }
     }
 }
@@ -1363,6 +1368,24 @@ void Concat::add_input_layout_constraint() {
     }
 }
 
+void Concat::mem_plan_fwd_out2in_writable() {
+    auto out = output(0);
+    auto&& out_layout = out->mem_plan().layout();
+    auto real_axis = m_axis;
+    if (real_axis < 0)
+        real_axis += out_layout.ndim;
+    size_t end = 0;
+    for (auto i : input()) {
+        auto begin = end;
+        end = begin + i->shape().shape[real_axis];
+        if (i->comp_node() != out->comp_node() || i->shape().is_empty())
+            continue;
+        // failure is not an error: the input would be copied in
+        // scn_do_execute() as usual
+        i->set_fwd_out2in_writable(out, Slice(begin, end).apply(out_layout, real_axis));
+    }
+}
+
 void Concat::init_output_comp_node() {
     Super::init_output_comp_node();
 
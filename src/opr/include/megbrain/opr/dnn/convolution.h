@@ -31,9 +31,40 @@ protected:
 class WeightPreprocessExecutor : public cg::OperatorNodeMixinBase {
     class PreprocessedFilterExecDep;
 
+public:
+    using AlgorithmDesc = megdnn::detail::Algorithm::Info::Desc;
+
+    //! preprocessed weight together with the algorithm that produced it
+    struct PackedWeight {
+        AlgorithmDesc algo;
+        SmallVector<DeviceTensorND> tensors;
+    };
+
+    /*!
+     * \brief get the preprocessed weight of previous execution, or None if
+     *      weight preprocess has not been run
+     */
+    MGE_WIN_DECLSPEC_FUC Maybe<PackedWeight> packed_weight() const;
+
+    /*!
+     * \brief provide a preprocessed weight, which would be used instead of
+     *      running the preprocess at first execution
+     *
+     * The weight is only used if the algorithm chosen at runtime and the
+     * preprocessed layouts are the same as those recorded in \p weight;
+     * otherwise the original weight is preprocessed as usual.
+     */
+    MGE_WIN_DECLSPEC_FUC void set_packed_weight(PackedWeight weight);
+
+private:
     using PreprocessedFilter = megdnn::detail::PreprocessedFilter;
     std::unique_ptr<PreprocessedFilter> m_preprocessed_filter;
     SmallVector<DeviceTensorND> m_filter_storage;
+    AlgorithmDesc m_preprocess_algo;
+    Maybe<PackedWeight> m_packed_weight_to_use;
+
+    //! try to fill m_filter_storage from m_packed_weight_to_use
+    bool use_packed_weight(const SmallVector<TensorLayout>& layouts);
 
 protected:
     //! this should only be called in scn_do_execute or similar functions (i.e.
@@ -47,6 +78,11 @@ protected:
     bool mixin_allow_weight_preprocess(const OperatorNodeBase& opr) const;
     virtual SmallVector<TensorLayout> deduce_preprocessed_filter_layout() = 0;
     virtual void scn_do_execute_preprocess() = 0;
+    //! called after preprocessed_filter() is filled, either by
+    //! scn_do_execute_preprocess() or from a packed weight
+    virtual void on_weight_preprocessed() {}
+    //! the algorithm that would be used to execute the preprocessed filter
+    virtual AlgorithmDesc preprocess_algo_desc() = 0;
     virtual ~WeightPreprocessExecutor() = default;
 };
 
@@ -110,6 +146,10 @@ MGB_DEFINE_OPR_CLASS_WITH_EXPORT(
     void record_execute_deps(cg::GraphExecutable::ExecDependencyArray& deps) override;
     SmallVector<TensorLayout> deduce_preprocessed_filter_layout() override;
     void scn_do_execute_preprocess() override;
+    void on_weight_preprocessed() override;
+    AlgorithmDesc preprocess_algo_desc() override {
+        return megdnn_opr()->execution_policy().algo;
+    }
 
     friend testing::ConvolutionTestingPeer;
 
@@ -144,6 +184,10 @@ MGB_DEFINE_OPR_CLASS_WITH_EXPORT(
     }
     SmallVector<TensorLayout> deduce_preprocessed_filter_layout() override;
     void scn_do_execute_preprocess() override;
+    void on_weight_preprocessed() override;
+    AlgorithmDesc preprocess_algo_desc() override {
+        return megdnn_opr()->execution_policy().algo;
+    }
 
 public:
     //! src * filter
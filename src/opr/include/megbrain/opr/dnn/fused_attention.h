@@ -0,0 +1,61 @@
+/**
+ * \file src/opr/include/megbrain/opr/dnn/fused_attention.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include "megbrain/opr/internal/megdnn_opr_wrapper.h"
+#include "megdnn/oprs/nn.h"
+
+namespace mgb {
+namespace opr {
+
+/*!
+ * \brief softmax(q * k^T * scale + mask) * v, see megdnn::FusedAttentionForward
+ *
+ * It is usually not built by users directly, but by gopt::FuseAttentionPass
+ * from the decomposed attention of transformers. param().has_mask must be
+ * consistent with whether mask is given.
+ */
+MGB_DEFINE_OPR_CLASS_WITH_EXPORT(
+        FusedAttentionForward,
+        intl::MegDNNOprWrapperFwd<megdnn::FusedAttentionForward>) // {
+public:
+    MGE_WIN_DECLSPEC_FUC FusedAttentionForward(
+            VarNode* q, VarNode* k, VarNode* v, VarNode* mask, const Param& param,
+            const OperatorNodeConfig& config);
+    MGE_WIN_DECLSPEC_FUC FusedAttentionForward(
+            VarNode* q, VarNode* k, VarNode* v, const Param& param,
+            const OperatorNodeConfig& config);
+
+    MGE_WIN_DECLSPEC_FUC static SymbolVar make(
+            SymbolVar q, SymbolVar k, SymbolVar v, SymbolVar mask,
+            const Param& param = {}, const OperatorNodeConfig& config = {});
+    MGE_WIN_DECLSPEC_FUC static SymbolVar make(
+            SymbolVar q, SymbolVar k, SymbolVar v, const Param& param = {},
+            const OperatorNodeConfig& config = {});
+
+private:
+    TensorLayout mask_layout(const TensorShapeArray& input_shapes) const;
+
+    void get_output_var_shape(
+            const TensorShapeArray& inp_shape,
+            TensorShapeArray& out_shape) const override;
+    size_t get_workspace_size_bytes(
+            const TensorShapeArray& input_shapes,
+            const TensorShapeArray& output_shapes) const override;
+    void scn_do_execute() override;
+};
+using FusedAttention = FusedAttentionForward;
+
+}  // namespace opr
+}  // namespace mgb
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
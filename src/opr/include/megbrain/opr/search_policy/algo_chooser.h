@@ -127,13 +127,22 @@ public:
         std::pair<ImplAlgoDesc, Maybe<AlgoChooserProfileCache::Result>>
         get_profile_result_from_cache(const ExecutionStrategy& selected_strategy) const;
 
+        /*!
+         * \brief predict the algo by AlgoCostModel::inst()
+         *
+         * \return invalid desc if there is no model, or the prediction is not
+         *      confident or not available
+         */
+        ImplAlgoDesc get_algo_from_cost_model(
+                const ExecutionStrategy& selected_strategy) const;
+
         /**
          * \brief construct execution policy from cache or heuristic.
          *
          * \param selected_strategy select algo which matched this strategy
          * \param[in,out] policy execution policy
-         * \param retrive_from_cache retrive algo from cache if set True, get
-         *     from heuristic otherwise.
+         * \param retrive_from_cache retrive algo from cache, or from the cost
+         *     model on cache miss, if set True, get from heuristic otherwise.
          * \param allow_log no warning log print if set True, print warning info
          * otherwise.
          */
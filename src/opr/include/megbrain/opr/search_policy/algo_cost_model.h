@@ -0,0 +1,120 @@
+/**
+ * \file src/opr/include/megbrain/opr/search_policy/algo_cost_model.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+
+#pragma once
+
+#include <unordered_map>
+#include "megbrain/utils/infile_persistent_cache.h"
+#include "megbrain/utils/persistent_cache.h"
+#include "megdnn/oprs/base.h"
+
+namespace mgb {
+namespace opr {
+
+/*!
+ * \brief predict the fastest algorithm of an operator from the profiling
+ *      results of similar shapes, so that algorithms can be chosen without
+ *      profiling
+ *
+ * The model is built offline from fastrun caches and shipped as a data file.
+ * Profiling results are grouped by the cache category and everything in the
+ * cache key except the shapes, i.e. the dtypes, ndims, strides and opr
+ * param, which must match exactly. Within a group the k nearest samples in
+ * the space of log2 of the shapes vote for the algorithm with the least
+ * weighted relative time.
+ *
+ * The confidence of a prediction is the product of the proximity of the
+ * nearest sample (1 for the same shape, 0.5 if it is off by a factor of 2 in
+ * one dim) and the weighted fraction of neighbours on which the predicted
+ * algorithm is within 5% of the fastest one. AlgoChooser only uses
+ * predictions whose confidence is not less than min_confidence(), and
+ * profiles as usual otherwise.
+ */
+class AlgoCostModel final : public NonCopyableObj {
+public:
+    using AlgoAttribute = megdnn::AlgoAttribute;
+
+    struct Prediction {
+        std::string algo;   //!< serialized algo desc
+        double confidence;  //!< in [0, 1]
+        //! estimated time relative to the fastest algorithm of the neighbours
+        double relative_time;
+    };
+
+    //! the model used by AlgoChooser, or nullptr if not set
+    static AlgoCostModel* inst();
+
+    /*!
+     * \brief set the model used by AlgoChooser
+     * \return the previous model
+     */
+    static std::shared_ptr<AlgoCostModel> set_inst(std::shared_ptr<AlgoCostModel> model);
+
+    //! load a model written by dump()
+    static std::shared_ptr<AlgoCostModel> load(const char* path);
+
+    void dump(const char* path) const;
+
+    //! add all the profiling results in a fastrun cache as samples
+    void add_from_cache(InFilePersistentCache& cache);
+
+    /*!
+     * \brief add a profiling result
+     *
+     * A previous sample of the same key is replaced.
+     *
+     * \param category category of AlgoChooserProfileCache
+     * \param key blob of AlgoChooserProfileCache::Key
+     * \param nr_layout number of layouts in the key
+     * \param result profiling result sorted by ascending time
+     * \return whether the key could be parsed
+     */
+    bool add(
+            const std::string& category, const PersistentCache::Blob& key,
+            size_t nr_layout, const AlgoChooserProfileCache::Result& result);
+
+    /*!
+     * \brief predict the fastest algorithm of given key
+     *
+     * \param positive attributes that the algorithm must have
+     * \param negative attributes that the algorithm must not have
+     * \return None if there is no sample in the group of the key
+     */
+    Maybe<Prediction> predict(
+            const std::string& category, const PersistentCache::Blob& key,
+            size_t nr_layout, AlgoAttribute positive, AlgoAttribute negative) const;
+
+    double min_confidence() const { return m_min_confidence; }
+    void min_confidence(double confidence) { m_min_confidence = confidence; }
+
+    size_t nr_sample() const;
+
+private:
+    struct Sample {
+        std::vector<float> feature;
+        AlgoChooserProfileCache::Result result;
+    };
+
+    //! split a cache key into the group part and the shape feature
+    static bool parse_key(
+            const PersistentCache::Blob& key, size_t nr_layout, std::string& group,
+            std::vector<float>& feature);
+
+    std::unordered_map<std::string, std::vector<Sample>> m_groups;
+    double m_min_confidence = 0.5;
+    mutable MGB_MUTEX m_mtx;
+};
+
+}  // namespace opr
+}  // namespace mgb
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -0,0 +1,153 @@
+/**
+ * \file src/opr/test/algo_cost_model.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "megbrain/opr/search_policy/algo_cost_model.h"
+#include "megbrain/opr/blas.h"
+#include "megbrain/opr/io.h"
+#include "megbrain/test/helper.h"
+
+using namespace mgb;
+
+namespace {
+
+using Result = AlgoChooserProfileCache::Result;
+using AlgoAttribute = megdnn::AlgoAttribute;
+
+//! add a sample of matmul with shape (m, k) x (k, n)
+void add_sample(
+        opr::AlgoCostModel& model, size_t m, size_t k, size_t n, Result result) {
+    TensorLayout layouts[3] = {
+            {{m, k}, dtype::Float32()},
+            {{k, n}, dtype::Float32()},
+            {{m, n}, dtype::Float32()}};
+    megdnn::param::MatrixMul param;
+    AlgoChooserProfileCache::Key key{layouts, 3, &param, sizeof(param)};
+    ASSERT_TRUE(model.add("profile:test", key.build_blob(), 3, result));
+}
+
+Maybe<opr::AlgoCostModel::Prediction> predict(
+        opr::AlgoCostModel& model, size_t m, size_t k, size_t n,
+        AlgoAttribute positive = AlgoAttribute::DEFAULT) {
+    TensorLayout layouts[3] = {
+            {{m, k}, dtype::Float32()},
+            {{k, n}, dtype::Float32()},
+            {{m, n}, dtype::Float32()}};
+    megdnn::param::MatrixMul param;
+    AlgoChooserProfileCache::Key key{layouts, 3, &param, sizeof(param)};
+    return model.predict(
+            "profile:test", key.build_blob(), 3, positive, AlgoAttribute::DEFAULT);
+}
+
+}  // anonymous namespace
+
+TEST(TestOprAlgoCostModel, Predict) {
+    auto reproducible = static_cast<uint32_t>(AlgoAttribute::REPRODUCIBLE);
+    opr::AlgoCostModel model;
+    add_sample(model, 32, 64, 64, {{"a", 0, 1e-3, 0}, {"b", reproducible, 2e-3, 0}});
+    add_sample(model, 64, 64, 64, {{"a", 0, 2e-3, 0}, {"b", reproducible, 3e-3, 0}});
+    add_sample(model, 1024, 1024, 1024, {{"b", reproducible, 1, 0}, {"a", 0, 2, 0}});
+    ASSERT_EQ(3u, model.nr_sample());
+
+    auto pred = predict(model, 32, 64, 64);
+    ASSERT_TRUE(pred.valid());
+    ASSERT_EQ("a", pred->algo);
+    ASSERT_GT(pred->confidence, 0.5);
+
+    // nearest to the large shape, but far from any sample
+    pred = predict(model, 512, 512, 512);
+    ASSERT_TRUE(pred.valid());
+    ASSERT_EQ("b", pred->algo);
+    ASSERT_LT(pred->confidence, model.min_confidence());
+
+    // only b is reproducible
+    pred = predict(model, 32, 64, 64, AlgoAttribute::REPRODUCIBLE);
+    ASSERT_TRUE(pred.valid());
+    ASSERT_EQ("b", pred->algo);
+
+    // no sample of the same ndim
+    TensorLayout layouts[3] = {
+            {{2, 32, 64}, dtype::Float32()},
+            {{2, 64, 64}, dtype::Float32()},
+            {{2, 32, 64}, dtype::Float32()}};
+    megdnn::param::MatrixMul param;
+    AlgoChooserProfileCache::Key key{layouts, 3, &param, sizeof(param)};
+    ASSERT_FALSE(model.predict(
+                              "profile:test", key.build_blob(), 3,
+                              AlgoAttribute::DEFAULT, AlgoAttribute::DEFAULT)
+                         .valid());
+
+    // replace the sample of the same shape
+    add_sample(model, 32, 64, 64, {{"b", 0, 1e-3, 0}, {"a", reproducible, 2e-3, 0}});
+    ASSERT_EQ(3u, model.nr_sample());
+    ASSERT_EQ("b", predict(model, 32, 64, 64)->algo);
+}
+
+TEST(TestOprAlgoCostModel, DumpLoad) {
+    opr::AlgoCostModel model;
+    add_sample(model, 32, 64, 64, {{"a", 0, 1e-3, 16}, {"b", 0, 2e-3, 0}});
+    add_sample(model, 8, 8, 8, {{"b", 0, 1e-5, 0}});
+    auto fname = output_file("AlgoCostModelDumpLoad");
+    model.dump(fname.c_str());
+    auto loaded = opr::AlgoCostModel::load(fname.c_str());
+    ASSERT_EQ(2u, loaded->nr_sample());
+    auto pred0 = predict(model, 16, 32, 64), pred1 = predict(*loaded, 16, 32, 64);
+    ASSERT_TRUE(pred0.valid() && pred1.valid());
+    ASSERT_EQ(pred0->algo, pred1->algo);
+    ASSERT_EQ(pred0->confidence, pred1->confidence);
+}
+
+#if MGB_ENABLE_FASTRUN
+TEST(TestOprAlgoCostModel, ChooseWithoutProfiling) {
+    using Policy = opr::MatrixMul::ExecutionPolicy;
+    Policy policy;
+    policy.strategy = Policy::Strategy::PROFILE;
+    auto cn = CompNode::load("cpux");
+    HostTensorGenerator<> gen;
+    auto run = [&](size_t m) {
+        auto graph = ComputingGraph::make();
+        auto a = opr::Host2DeviceCopy::make(*graph, gen({m, 64}), cn),
+             b = opr::Host2DeviceCopy::make(*graph, gen({64, 32}), cn);
+        auto c = opr::MatrixMul::make(a, b, {}, policy);
+        HostTensorND host_c;
+        graph->compile({make_callback_copy(c, host_c)})->execute();
+    };
+
+    auto cache = std::make_shared<InFilePersistentCache>();
+    auto orig_cache = PersistentCache::set_impl(cache);
+    run(32);
+    auto model = std::make_shared<opr::AlgoCostModel>();
+    model->add_from_cache(*cache);
+    ASSERT_GT(model->nr_sample(), 0u);
+    auto orig_model = opr::AlgoCostModel::set_inst(model);
+
+    PersistentCache::set_impl(std::make_shared<InFilePersistentCache>());
+    size_t nr_profile = 0;
+    {
+        PersistentCacheHook hook{
+                PersistentCacheHook::Hook{
+                        [](const std::string&, const void*, size_t, const void*,
+                           size_t) {}},
+                [&](const std::string& category, const void*, size_t, const void*,
+                    size_t) { nr_profile += !category.compare(0, 8, "profile:"); }};
+        // the profiled shape is chosen by the model
+        run(32);
+        ASSERT_EQ(0u, nr_profile);
+        // far from the profiled shape, so it falls back to profiling
+        run(4096);
+        ASSERT_GT(nr_profile, 0u);
+    }
+
+    opr::AlgoCostModel::set_inst(orig_model);
+    PersistentCache::set_impl(orig_cache);
+}
+#endif
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -2596,6 +2596,84 @@ TEST_F(TestWeightPreprocess, PreprocessCalledOnlyOnce) {
     }
 }
 
+TEST_F(TestWeightPreprocess, UsePackedWeight) {
+    megdnn::HeuristicCache::instance().clear();
+    using ::testing::_;
+    using ::testing::Invoke;
+    using ::testing::Return;
+    using PF = MockConvolutionForward::PreprocessedFilter;
+
+    auto& mock = mock_conv();
+    MockAlgorithm algo;
+    SmallVector<TensorLayout> filter_layout{{{1, 2, 3, 4}, dtype::Float32()}};
+    EXPECT_CALL(mock, deduce_preprocessed_filter_layout(_, _, _))
+            .WillRepeatedly(Return(filter_layout));
+    EXPECT_CALL(mock, get_algorithm_from_desc(_)).WillRepeatedly(Return(&algo));
+    EXPECT_CALL(mock, get_algorithm_heuristic(_, _, _, _, _, _))
+            .WillRepeatedly(Return(&algo));
+    EXPECT_CALL(mock, get_workspace_in_bytes(_, _, _, _)).WillRepeatedly(Return(0));
+    EXPECT_CALL(mock, get_preprocess_workspace_in_bytes(_, _, _))
+            .WillRepeatedly(Return(0));
+
+    opr::mixin::WeightPreprocessExecutor::PackedWeight packed;
+    packed.algo = algo.desc();
+    packed.tensors.emplace_back(comp_node, filter_layout[0]);
+    packed.tensors[0].ptr<float>()[0] = 114.514f;
+    auto packed_ptr = packed.tensors[0].raw_ptr();
+    auto&& opr = y.node()->owner_opr()->cast_final<opr::ConvolutionForward>();
+    opr.set_packed_weight(packed);
+
+    // the packed weight is used directly without running preprocess
+    EXPECT_CALL(mock, exec_preprocess(_, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock, exec(_, _, _, _, _))
+            .Times(2)
+            .WillRepeatedly(Invoke([&](_megdnn_tensor_in, _megdnn_tensor_in,
+                                       _megdnn_tensor_out, const PF* pf,
+                                       _megdnn_workspace) {
+                ASSERT_NE(pf, nullptr);
+                ASSERT_EQ(packed_ptr, pf->tensors[0].raw_ptr());
+                ASSERT_EQ(pf->tensors[0].ptr<float>()[0], 114.514f);
+            }));
+    run();
+    run();
+
+    auto got = opr.packed_weight();
+    ASSERT_TRUE(got.valid());
+    ASSERT_TRUE(got->algo == algo.desc());
+    ASSERT_EQ(1u, got->tensors.size());
+    ASSERT_EQ(packed_ptr, got->tensors[0].raw_ptr());
+}
+
+TEST_F(TestWeightPreprocess, PackedWeightAlgoMismatch) {
+    megdnn::HeuristicCache::instance().clear();
+    using ::testing::_;
+    using ::testing::Return;
+
+    auto& mock = mock_conv();
+    MockAlgorithm algo;
+    SmallVector<TensorLayout> filter_layout{{{1, 2, 3, 4}, dtype::Float32()}};
+    EXPECT_CALL(mock, deduce_preprocessed_filter_layout(_, _, _))
+            .WillRepeatedly(Return(filter_layout));
+    EXPECT_CALL(mock, get_algorithm_from_desc(_)).WillRepeatedly(Return(&algo));
+    EXPECT_CALL(mock, get_algorithm_heuristic(_, _, _, _, _, _))
+            .WillRepeatedly(Return(&algo));
+    EXPECT_CALL(mock, get_workspace_in_bytes(_, _, _, _)).WillRepeatedly(Return(0));
+    EXPECT_CALL(mock, get_preprocess_workspace_in_bytes(_, _, _))
+            .WillRepeatedly(Return(0));
+
+    // packed by another algo, so the original weight should be preprocessed
+    opr::mixin::WeightPreprocessExecutor::PackedWeight packed;
+    packed.algo = algo.desc();
+    packed.algo.name = "AnotherAlgo";
+    packed.tensors.emplace_back(comp_node, filter_layout[0]);
+    y.node()->owner_opr()->cast_final<opr::ConvolutionForward>().set_packed_weight(
+            packed);
+
+    EXPECT_CALL(mock, exec_preprocess(_, _, _, _, _)).Times(1);
+    EXPECT_CALL(mock, exec(_, _, _, _, _)).Times(1);
+    run();
+}
+
 class TestNoWeightPreprocess : public TestWeightPreprocess {
     bool is_weight_preprocess() override { return false; }
 };
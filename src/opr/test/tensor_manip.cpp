@@ -1446,6 +1446,51 @@ TEST(TestTensorManip, ConcatEmpty2) {
     ASSERT_EQ(TensorShape({2, 0, 11}), host_z.shape());
 }
 
+TEST(TestTensorManip, ConcatMemFwdOut2In) {
+    HostTensorGenerator<> gen;
+    auto host_x0 = gen({4, 16}), host_x1 = gen({2, 16}), host_x2 = gen({3, 16});
+    auto graph = ComputingGraph::make();
+    auto x0 = opr::Host2DeviceCopy::make(*graph, host_x0),
+         x1 = opr::Host2DeviceCopy::make(*graph, host_x1),
+         x2 = opr::Host2DeviceCopy::make(*graph, host_x2), a = x0 + 1, b = x1 * 2,
+         c = x2 - 3, ab = opr::Concat::make({a, b}, 0),
+         z = opr::Concat::make({ab, c}, 0);
+    HostTensorND host_z;
+    auto func = graph->compile({make_callback_copy(z, host_z)});
+    func->execute();
+
+    // inputs are computed directly into the buffer of the final output
+    auto ptr_z = static_cast<const float*>(prev_dev_ptr(z));
+    ASSERT_EQ(ptr_z, prev_dev_ptr(ab));
+    ASSERT_EQ(ptr_z, prev_dev_ptr(a));
+    ASSERT_EQ(ptr_z + 4 * 16, prev_dev_ptr(b));
+    ASSERT_EQ(ptr_z + 6 * 16, prev_dev_ptr(c));
+
+    HostTensorND expect{host_z.comp_node(), {9, 16}};
+    auto px0 = host_x0->ptr<float>(), px1 = host_x1->ptr<float>(),
+         px2 = host_x2->ptr<float>(), pe = expect.ptr<float>();
+    for (size_t i = 0; i < 4 * 16; ++i)
+        pe[i] = px0[i] + 1;
+    for (size_t i = 0; i < 2 * 16; ++i)
+        pe[4 * 16 + i] = px1[i] * 2;
+    for (size_t i = 0; i < 3 * 16; ++i)
+        pe[6 * 16 + i] = px2[i] - 3;
+    MGB_ASSERT_TENSOR_EQ(expect, host_z);
+
+    // non-contiguous slices fall back to copy
+    auto y = opr::Concat::make({a, b.reshape({4, 8})}, 1);
+    HostTensorND host_y;
+    func = graph->compile({make_callback_copy(y, host_y)});
+    func->execute();
+    ASSERT_NE(prev_dev_ptr(y), prev_dev_ptr(a));
+    ASSERT_EQ(TensorShape({4, 24}), host_y.shape());
+    for (size_t i = 0; i < 4; ++i) {
+        for (size_t j = 0; j < 16; ++j) {
+            ASSERT_EQ(px0[i * 16 + j] + 1, host_y.ptr<float>()[i * 24 + j]);
+        }
+    }
+}
+
 TEST(TestTensorManip, AxisAddRemove) {
     HostTensorGenerator<> gen;
     for (bool dyn_shape : {false, true}) {
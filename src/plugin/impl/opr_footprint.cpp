@@ -15,12 +15,16 @@
 #include "megbrain/opr/dnn/adaptive_pooling.h"
 #include "megbrain/opr/dnn/batch_norm.h"
 #include "megbrain/opr/dnn/convolution.h"
+#include "megbrain/opr/dnn/correlation.h"
 #include "megbrain/opr/dnn/images2neibs.h"
+#include "megbrain/opr/dnn/layer_norm.h"
 #include "megbrain/opr/dnn/local.h"
 #include "megbrain/opr/dnn/lrn.h"
 #include "megbrain/opr/dnn/pooling.h"
 #include "megbrain/opr/dnn/roi_align.h"
+#include "megbrain/opr/dnn/rnn.h"
 #include "megbrain/opr/dnn/roi_pooling.h"
+#include "megbrain/opr/dnn/softmax.h"
 #include "megbrain/opr/imgproc.h"
 #include "megbrain/opr/indexing.h"
 #include "megbrain/opr/internal/indexing_helper.h"
@@ -38,6 +42,8 @@
 #include "megbrain/utils/hash_ct.h"
 #include "midout.h"
 
+#include <cmath>
+
 MIDOUT_DECL(megbrain_opr_footprint)
 #define MIDOUT_B(...) MIDOUT_BEGIN(megbrain_opr_footprint, __VA_ARGS__) {
 #define MIDOUT_E \
@@ -494,6 +500,338 @@ uint64_t opr_footprint_func<opr::Host2DeviceCopy>(cg::OperatorNodeBase* opr) {
     return out_shape.total_nr_elems();
 }
 
+// Convolution3D
+/*!
+ * each output value needs the mul-adds of one filter of a output channel,
+ * which does not depend on the format or the sparsity
+ */
+uint64_t eval_conv3d_computation(
+        const TensorShape& filter_shape, const TensorShape& dst_shape,
+        cg::OperatorNodeBase* opr) {
+    using Param = opr::Convolution3DForward::Param;
+    Param::Format format;
+    if (auto conv = opr->try_cast_final<opr::Convolution3DForward>()) {
+        format = conv->param().format;
+    } else if (auto conv = opr->try_cast_final<opr::Convolution3DBackwardData>()) {
+        format = conv->param().format;
+    } else {
+        format = opr->cast_final_safe<opr::Convolution3DBackwardFilter>()
+                         .param()
+                         .format;
+    }
+    size_t oc = format == Param::Format::NCDHW ? dst_shape[1] : dst_shape[4];
+    return dst_shape.total_nr_elems() * filter_shape.total_nr_elems() / oc * 2;
+}
+
+template <>
+uint64_t opr_footprint_func<opr::Convolution3DForward>(cg::OperatorNodeBase* opr) {
+    return eval_conv3d_computation(
+            opr->input(1)->shape(), opr->output(0)->shape(), opr);
+}
+
+template <>
+uint64_t opr_footprint_func<opr::Convolution3DBackwardData>(
+        cg::OperatorNodeBase* opr) {
+    // input: filter, diff
+    return eval_conv3d_computation(
+            opr->input(0)->shape(), opr->input(1)->shape(), opr);
+}
+
+template <>
+uint64_t opr_footprint_func<opr::Convolution3DBackwardFilter>(
+        cg::OperatorNodeBase* opr) {
+    // input: src, diff, output: grad of filter
+    return eval_conv3d_computation(
+            opr->output(0)->shape(), opr->input(1)->shape(), opr);
+}
+
+// MaskConvolution
+template <>
+uint64_t opr_footprint_func<opr::MaskConvolution>(cg::OperatorNodeBase* opr) {
+    auto&& out_shape = opr->output(0)->shape();
+    return out_shape.total_nr_elems() * opr->input(1)->shape().total_nr_elems() /
+           out_shape[1] * 2;
+}
+
+// Local and GroupLocal
+/*!
+ * filter is {OH, OW, IC, FH, FW, OC} for local and {G, OH, OW, IC/G, FH, FW,
+ * OC/G} for group local, so each output value needs IC/G * FH * FW mul-adds
+ */
+uint64_t eval_local_computation(cg::OperatorNodeBase* opr) {
+    auto&& out_shape = opr->output(0)->shape();
+    mgb_assert(out_shape.ndim == 4, "Local opr should be in NCHW format");
+    return out_shape.total_nr_elems() * opr->input(1)->shape().total_nr_elems() /
+           (out_shape[1] * out_shape[2] * out_shape[3]) * 2;
+}
+
+template <>
+uint64_t opr_footprint_func<opr::LocalForward>(cg::OperatorNodeBase* opr) {
+    return eval_local_computation(opr);
+}
+
+template <>
+uint64_t opr_footprint_func<opr::GroupLocalForward>(cg::OperatorNodeBase* opr) {
+    return eval_local_computation(opr);
+}
+
+// BatchedMatrixMul
+template <>
+uint64_t opr_footprint_func<opr::BatchedMatrixMul>(cg::OperatorNodeBase* opr) {
+    auto&& mopr = opr->cast_final_safe<opr::BatchedMatrixMul>();
+    auto&& i0 = opr->input(0)->shape();
+    mgb_assert(i0.ndim == 3);
+    auto k = mopr.param().transposeA ? i0[1] : i0[2];
+    return opr->output(0)->shape().total_nr_elems() * k * 2;
+}
+
+// Dot
+template <>
+uint64_t opr_footprint_func<opr::Dot>(cg::OperatorNodeBase* opr) {
+    return opr->input(0)->shape().total_nr_elems() * 2;
+}
+
+// MatrixInverse
+template <>
+uint64_t opr_footprint_func<opr::MatrixInverse>(cg::OperatorNodeBase* opr) {
+    // Gauss-Jordan elimination of n * n matrices
+    auto&& shape = opr->input(0)->shape();
+    return shape.total_nr_elems() * shape[shape.ndim - 1] * 2;
+}
+
+// LRN
+template <>
+uint64_t opr_footprint_func<opr::LRNForward>(cg::OperatorNodeBase* opr) {
+    auto&& param = opr->cast_final_safe<opr::LRNForward>().param();
+    return opr->output(0)->shape().total_nr_elems() * param.n * 2;
+}
+
+// BatchNorm
+template <>
+uint64_t opr_footprint_func<opr::BatchNormForward>(cg::OperatorNodeBase* opr) {
+    using Param = opr::BatchNormForward::Param;
+    auto&& param = opr->cast_final_safe<opr::BatchNormForward>().param();
+    // mean and variance are computed in training
+    size_t ops = param.fwd_mode == Param::FwdMode::INFERENCE ? 2 : 5;
+    return opr->input(0)->shape().total_nr_elems() * ops;
+}
+
+// LayerNorm
+template <>
+uint64_t opr_footprint_func<opr::LayerNormForward>(cg::OperatorNodeBase* opr) {
+    auto&& param = opr->cast_final_safe<opr::LayerNormForward>().param();
+    // mean, variance and normalization, then scale and shift if affine
+    size_t ops = param.affine ? 7 : 5;
+    return opr->input(0)->shape().total_nr_elems() * ops;
+}
+
+// Softmax
+template <>
+uint64_t opr_footprint_func<opr::SoftmaxForward>(cg::OperatorNodeBase* opr) {
+    // max, sub, exp, sum and div, where exp is counted as 1 operation
+    return opr->input(0)->shape().total_nr_elems() * 5;
+}
+
+// ElemwiseMultiType
+template <>
+uint64_t opr_footprint_func<opr::ElemwiseMultiType>(cg::OperatorNodeBase* opr) {
+    return opr->output()[0]->shape().total_nr_elems() *
+           (std::max<size_t>(opr->input().size(), 2) - 1);
+}
+
+// element-wise oprs with one operation for each output
+template <>
+uint64_t opr_footprint_func<opr::PowC>(cg::OperatorNodeBase* opr) {
+    return opr->output(0)->shape().total_nr_elems();
+}
+
+template <>
+uint64_t opr_footprint_func<opr::TypeCvt>(cg::OperatorNodeBase* opr) {
+    return opr->output(0)->shape().total_nr_elems();
+}
+
+template <>
+uint64_t opr_footprint_func<opr::RelayoutFormat>(cg::OperatorNodeBase* opr) {
+    return opr->output(0)->shape().total_nr_elems();
+}
+
+template <>
+uint64_t opr_footprint_func<opr::Images2NeibsForward>(cg::OperatorNodeBase* opr) {
+    return opr->output(0)->shape().total_nr_elems();
+}
+
+template <>
+uint64_t opr_footprint_func<opr::IndexingOneHot>(cg::OperatorNodeBase* opr) {
+    return opr->output(0)->shape().total_nr_elems();
+}
+
+// oprs with one operation for each input
+template <>
+uint64_t opr_footprint_func<opr::AdaptivePoolingForward>(cg::OperatorNodeBase* opr) {
+    return opr->input(0)->shape().total_nr_elems();
+}
+
+template <>
+uint64_t opr_footprint_func<opr::Argmax>(cg::OperatorNodeBase* opr) {
+    return opr->input(0)->shape().total_nr_elems();
+}
+
+template <>
+uint64_t opr_footprint_func<opr::Argmin>(cg::OperatorNodeBase* opr) {
+    return opr->input(0)->shape().total_nr_elems();
+}
+
+template <>
+uint64_t opr_footprint_func<opr::TopK>(cg::OperatorNodeBase* opr) {
+    return opr->input(0)->shape().total_nr_elems();
+}
+
+template <>
+uint64_t opr_footprint_func<opr::Cumsum>(cg::OperatorNodeBase* opr) {
+    return opr->input(0)->shape().total_nr_elems();
+}
+
+// Argsort
+template <>
+uint64_t opr_footprint_func<opr::ArgsortForward>(cg::OperatorNodeBase* opr) {
+    // comparisons of sorting each row
+    auto&& shape = opr->input(0)->shape();
+    size_t len = shape[shape.ndim - 1];
+    return shape.total_nr_elems() *
+           std::max<uint64_t>(std::ceil(std::log2(std::max<size_t>(len, 2))), 1);
+}
+
+// oprs with interpolation
+/*!
+ * operations to compute an output value from its taps, in which mul and add
+ * are counted as 2 operations
+ */
+uint64_t eval_interp_computation(
+        const TensorShape& dst_shape,
+        megdnn::param::WarpPerspective::InterpolationMode imode) {
+    using Mode = megdnn::param::WarpPerspective::InterpolationMode;
+    size_t taps;
+    switch (imode) {
+        case Mode::NEAREST:
+            return dst_shape.total_nr_elems();
+        case Mode::CUBIC:
+            taps = 16;
+            break;
+        case Mode::LANCZOS4:
+            taps = 64;
+            break;
+        default:
+            taps = 4;
+    }
+    return dst_shape.total_nr_elems() * taps * 2;
+}
+
+template <>
+uint64_t opr_footprint_func<opr::WarpPerspectiveForward>(cg::OperatorNodeBase* opr) {
+    auto&& param = opr->cast_final_safe<opr::WarpPerspectiveForward>().param();
+    return eval_interp_computation(opr->output(0)->shape(), param.imode);
+}
+
+template <>
+uint64_t opr_footprint_func<opr::WarpAffineForward>(cg::OperatorNodeBase* opr) {
+    auto&& param = opr->cast_final_safe<opr::WarpAffineForward>().param();
+    return eval_interp_computation(opr->output(0)->shape(), param.imode);
+}
+
+template <>
+uint64_t opr_footprint_func<opr::RemapForward>(cg::OperatorNodeBase* opr) {
+    auto&& param = opr->cast_final_safe<opr::RemapForward>().param();
+    return eval_interp_computation(opr->output(0)->shape(), param.imode);
+}
+
+template <>
+uint64_t opr_footprint_func<opr::ResizeForward>(cg::OperatorNodeBase* opr) {
+    auto&& param = opr->cast_final_safe<opr::ResizeForward>().param();
+    return eval_interp_computation(opr->output(0)->shape(), param.imode);
+}
+
+// ROIAlign
+template <>
+uint64_t opr_footprint_func<opr::ROIAlignForward>(cg::OperatorNodeBase* opr) {
+    // bilinear interpolation of each sample
+    auto&& param = opr->cast_final_safe<opr::ROIAlignForward>().param();
+    return opr->output(0)->shape().total_nr_elems() * param.sample_height *
+           param.sample_width * 4 * 2;
+}
+
+// ROIPooling
+template <>
+uint64_t opr_footprint_func<opr::ROIPoolingForward>(cg::OperatorNodeBase* opr) {
+    // the pooling window is estimated by the ratio of the feature map to
+    // the output, as the rois are only known at runtime
+    auto&& src_shape = opr->input(0)->shape();
+    auto&& dst_shape = opr->output(0)->shape();
+    mgb_assert(src_shape.ndim == 4 && dst_shape.ndim == 4);
+    return dst_shape.total_nr_elems() *
+           std::max<size_t>(
+                   src_shape[2] * src_shape[3] / (dst_shape[2] * dst_shape[3]), 1);
+}
+
+// DeformablePSROIPooling
+template <>
+uint64_t opr_footprint_func<opr::DeformablePSROIPoolingForward>(
+        cg::OperatorNodeBase* opr) {
+    auto&& param = opr->cast_final_safe<opr::DeformablePSROIPoolingForward>().param();
+    return opr->output(0)->shape().total_nr_elems() * param.sample_per_part *
+           param.sample_per_part * 4 * 2;
+}
+
+// Correlation
+template <>
+uint64_t opr_footprint_func<opr::CorrelationForward>(cg::OperatorNodeBase* opr) {
+    auto&& param = opr->cast_final_safe<opr::CorrelationForward>().param();
+    auto&& src_shape = opr->input(0)->shape();
+    return opr->output(0)->shape().total_nr_elems() * param.kernel_size *
+           param.kernel_size * src_shape[1] * 2;
+}
+
+// RNN and LSTM
+/*!
+ * each step multiplies the input and the hidden state of every sample with
+ * all the weights, which dominates the computation
+ */
+template <>
+uint64_t opr_footprint_func<opr::RNNCellForward>(cg::OperatorNodeBase* opr) {
+    // input: input, weight_ih, bias_ih, hx, weight_hh, bias_hh
+    size_t batch = opr->input(0)->shape()[0];
+    return batch *
+           (opr->input(1)->shape().total_nr_elems() +
+            opr->input(4)->shape().total_nr_elems()) *
+           2;
+}
+
+template <>
+uint64_t opr_footprint_func<opr::LSTMCellForward>(cg::OperatorNodeBase* opr) {
+    // input: input, weight_ih, bias_ih, hx, weight_hh, bias_hh, cx
+    size_t batch = opr->input(0)->shape()[0];
+    return batch *
+           (opr->input(1)->shape().total_nr_elems() +
+            opr->input(4)->shape().total_nr_elems()) *
+           2;
+}
+
+uint64_t eval_rnn_computation(cg::OperatorNodeBase* opr) {
+    // input: input {seq_len, batch, input_size}, ..., flatten_weights
+    auto&& src_shape = opr->input(0)->shape();
+    auto&& weight_shape = opr->input().back()->shape();
+    return src_shape[0] * src_shape[1] * weight_shape.total_nr_elems() * 2;
+}
+
+template <>
+uint64_t opr_footprint_func<opr::RNNForward>(cg::OperatorNodeBase* opr) {
+    return eval_rnn_computation(opr);
+}
+
+template <>
+uint64_t opr_footprint_func<opr::LSTMForward>(cg::OperatorNodeBase* opr) {
+    return eval_rnn_computation(opr);
+}
+
 /******************* Registe Param Json Functions *************************/
 #if MGB_ENABLE_JSON
 template <class T>
@@ -710,6 +1048,43 @@ void OprFootprint::init_all_footprints() {
     add_single_comp_footprint<opr::DeformableConvBackwardFilter>();
     add_single_comp_footprint<opr::DeformableConvBackwardData>();
     add_single_comp_footprint<opr::BatchConvBiasForward>();
+    add_single_comp_footprint<opr::Convolution3DForward>();
+    add_single_comp_footprint<opr::Convolution3DBackwardData>();
+    add_single_comp_footprint<opr::Convolution3DBackwardFilter>();
+    add_single_comp_footprint<opr::MaskConvolution>();
+    add_single_comp_footprint<opr::LocalForward>();
+    add_single_comp_footprint<opr::GroupLocalForward>();
+    add_single_comp_footprint<opr::BatchedMatrixMul>();
+    add_single_comp_footprint<opr::Dot>();
+    add_single_comp_footprint<opr::MatrixInverse>();
+    add_single_comp_footprint<opr::LRNForward>();
+    add_single_comp_footprint<opr::BatchNormForward>();
+    add_single_comp_footprint<opr::LayerNormForward>();
+    add_single_comp_footprint<opr::SoftmaxForward>();
+    add_single_comp_footprint<opr::ElemwiseMultiType>();
+    add_single_comp_footprint<opr::PowC>();
+    add_single_comp_footprint<opr::TypeCvt>();
+    add_single_comp_footprint<opr::RelayoutFormat>();
+    add_single_comp_footprint<opr::Images2NeibsForward>();
+    add_single_comp_footprint<opr::IndexingOneHot>();
+    add_single_comp_footprint<opr::AdaptivePoolingForward>();
+    add_single_comp_footprint<opr::Argmax>();
+    add_single_comp_footprint<opr::Argmin>();
+    add_single_comp_footprint<opr::TopK>();
+    add_single_comp_footprint<opr::Cumsum>();
+    add_single_comp_footprint<opr::ArgsortForward>();
+    add_single_comp_footprint<opr::WarpPerspectiveForward>();
+    add_single_comp_footprint<opr::WarpAffineForward>();
+    add_single_comp_footprint<opr::RemapForward>();
+    add_single_comp_footprint<opr::ResizeForward>();
+    add_single_comp_footprint<opr::ROIAlignForward>();
+    add_single_comp_footprint<opr::ROIPoolingForward>();
+    add_single_comp_footprint<opr::DeformablePSROIPoolingForward>();
+    add_single_comp_footprint<opr::CorrelationForward>();
+    add_single_comp_footprint<opr::RNNCellForward>();
+    add_single_comp_footprint<opr::LSTMCellForward>();
+    add_single_comp_footprint<opr::RNNForward>();
+    add_single_comp_footprint<opr::LSTMForward>();
 
 #if MGB_ENABLE_JSON
     add_single_param_json<opr::Elemwise>();
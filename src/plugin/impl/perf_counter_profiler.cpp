@@ -0,0 +1,361 @@
+/**
+ * \file src/plugin/impl/perf_counter_profiler.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "megbrain/plugin/perf_counter_profiler.h"
+
+#if MGB_ENABLE_JSON
+#include "megbrain/comp_node_env.h"
+#include "megbrain/graph/event.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+
+#if defined(__linux__)
+#define MGB_HAVE_PERF_EVENT 1
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#define MGB_HAVE_PERF_EVENT 0
+#endif
+
+using namespace mgb;
+using namespace cg;
+
+namespace {
+//! used for estimating DRAM traffic from cache misses
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+//! max time to wait for the other threads when finding the pool threads
+constexpr int REGISTER_TIMEOUT_MS = 100;
+
+const char* counter_name(int idx) {
+    static const char* names[PerfCounterProfiler::NR_COUNTER] = {
+            "cycles", "instructions", "llc_references", "llc_misses"};
+    return names[idx];
+}
+
+//! open a counter for given thread, or the caller thread if tid is 0;
+//! return -1 on failure
+int open_counter(int idx, int tid = 0) {
+#if MGB_HAVE_PERF_EVENT
+    static const uint64_t configs[PerfCounterProfiler::NR_COUNTER] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES};
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = configs[idx];
+    // user space only, so it works with perf_event_paranoid == 2
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, tid, -1, -1, 0));
+#else
+    MGB_MARK_USED_VAR(idx);
+    MGB_MARK_USED_VAR(tid);
+    return -1;
+#endif
+}
+
+int get_tid() {
+#if MGB_HAVE_PERF_EVENT
+    return static_cast<int>(syscall(SYS_gettid));
+#else
+    return 0;
+#endif
+}
+
+void close_counter(int fd) {
+#if MGB_HAVE_PERF_EVENT
+    if (fd >= 0) {
+        close(fd);
+    }
+#else
+    MGB_MARK_USED_VAR(fd);
+#endif
+}
+}  // anonymous namespace
+
+/* ==================== ThreadCounter ==================== */
+//! counters of a thread, which can be read on any thread of the process
+class PerfCounterProfiler::ThreadCounter : public NonCopyableObj {
+    std::array<int, NR_COUNTER> m_fd;
+
+public:
+    explicit ThreadCounter(int tid) {
+        for (int i = 0; i < NR_COUNTER; ++i) {
+            m_fd[i] = open_counter(i, tid);
+        }
+    }
+
+    ~ThreadCounter() {
+        for (auto fd : m_fd) {
+            close_counter(fd);
+        }
+    }
+
+    //! add the current values to \p dest
+    void read_add(CounterValues& dest) const {
+#if MGB_HAVE_PERF_EVENT
+        for (int i = 0; i < NR_COUNTER; ++i) {
+            uint64_t val;
+            if (m_fd[i] >= 0 && ::read(m_fd[i], &val, sizeof(val)) == sizeof(val)) {
+                dest[i] += val;
+            }
+        }
+#else
+        MGB_MARK_USED_VAR(dest);
+#endif
+    }
+};
+
+/* ==================== CompNodeCounter ==================== */
+struct PerfCounterProfiler::CompNodeCounter : public NonCopyableObj {
+    //! set after the threads are found; the fields below are only accessed
+    //! by the dispatch thread afterwards
+    std::atomic_bool registered{false};
+    std::vector<std::unique_ptr<ThreadCounter>> threads;
+    //! counter values at kernel start
+    CounterValues kern_start{};
+
+    //! thread ids found by the registering task
+    std::mutex tids_mtx;
+    std::condition_variable tids_cv;
+    std::vector<int> tids;
+
+    //! sum of counters over the threads
+    CounterValues read() const {
+        CounterValues ret{};
+        for (auto&& i : threads) {
+            i->read_add(ret);
+        }
+        return ret;
+    }
+
+    /*!
+     * \brief dispatch tasks to find the threads running kernels and open
+     *      their counters
+     *
+     * Each part of the multithreading task waits until all threads have
+     * joined, so that a thread can not take two parts. Under seq recording
+     * the tasks are replayed, and return at once after the first run.
+     */
+    void dispatch_register(const CompNodeEnv::CpuEnv& env) {
+        size_t nr_threads = env.dispatcher->nr_threads();
+        auto find_tid = [this, nr_threads](size_t, size_t) {
+            if (registered.load(std::memory_order_acquire))
+                return;
+            std::unique_lock<std::mutex> lock{tids_mtx};
+            auto tid = get_tid();
+            if (std::find(tids.begin(), tids.end(), tid) == tids.end()) {
+                tids.push_back(tid);
+            }
+            tids_cv.notify_all();
+            tids_cv.wait_for(
+                    lock, std::chrono::milliseconds(REGISTER_TIMEOUT_MS),
+                    [&]() { return tids.size() >= nr_threads; });
+        };
+        env.dispatch(find_tid, nr_threads);
+        env.dispatch([this]() {
+            if (registered.load(std::memory_order_acquire))
+                return;
+            MGB_LOCK_GUARD(tids_mtx);
+            for (auto tid : tids) {
+                threads.emplace_back(std::make_unique<ThreadCounter>(tid));
+            }
+            registered.store(true, std::memory_order_release);
+        });
+    }
+};
+
+/* ==================== PerfCounterProfiler ==================== */
+PerfCounterProfiler::PerfCounterProfiler(cg::ComputingGraph* graph)
+        : PluginBase(graph) {
+    using namespace cg::event;
+    auto on_before_kern = [this](BeforeKernel const& event) {
+        if (!is_cpu(event.comp_node))
+            return;
+
+        auto opr = event.opr;
+        bool need_footprint;
+        {
+            MGB_LOCK_GUARD(m_mtx);
+            need_footprint = !m_opr_fp_rst.count(opr);
+        }
+        if (need_footprint) {
+            // computed once for each opr, since the event is emitted on each
+            // execution without seq recording
+            auto footprint = m_opr_footprint_ptr->calc_footprint(opr);
+            MGB_LOCK_GUARD(m_mtx);
+            m_opr_fp_rst.emplace(opr, footprint);
+        }
+
+        auto counter = get_cn_counter(event.comp_node);
+        auto runner = [counter]() { counter->kern_start = counter->read(); };
+        CompNodeEnv::from_comp_node(event.comp_node).cpu_env().dispatch(runner);
+    };
+    auto on_after_kern = [this](AfterKernel const& event) {
+        if (!is_cpu(event.comp_node))
+            return;
+
+        auto counter = get_cn_counter(event.comp_node);
+        OprStat* stat;
+        {
+            MGB_LOCK_GUARD(m_mtx);
+            stat = &m_opr_stat[event.opr];
+        }
+        auto runner = [this, counter, stat]() {
+            // read the counters first, so that the lock is not counted
+            auto cur = counter->read();
+            CounterValues delta;
+            for (int i = 0; i < NR_COUNTER; ++i) {
+                delta[i] = cur[i] - counter->kern_start[i];
+            }
+            MGB_LOCK_GUARD(m_mtx);
+            for (int i = 0; i < NR_COUNTER; ++i) {
+                stat->value[i] += delta[i];
+            }
+            ++stat->nr_exec;
+        };
+        CompNodeEnv::from_comp_node(event.comp_node).cpu_env().dispatch(runner);
+    };
+    auto on_graph_compile = [this](const CompSeqOrderDetermined&) {
+        // clear status after graph recompilation; pending readers refer to
+        // the stats
+        sync_comp_nodes();
+        MGB_LOCK_GUARD(m_mtx);
+        m_opr_stat.clear();
+        m_opr_fp_rst.clear();
+    };
+    auto&& ev = graph->event();
+    add_event_handler(ev.register_receiver<BeforeKernel>(on_before_kern));
+    add_event_handler(ev.register_receiver<AfterKernel>(on_after_kern));
+    add_event_handler(ev.register_receiver<CompSeqOrderDetermined>(on_graph_compile));
+}
+
+PerfCounterProfiler::~PerfCounterProfiler() noexcept {
+    sync_comp_nodes();
+}
+
+void PerfCounterProfiler::sync_comp_nodes() {
+    CompNode::UnorderedSet comp_nodes;
+    {
+        MGB_LOCK_GUARD(m_mtx);
+        for (auto&& i : m_cn_counter) {
+            comp_nodes.insert(i.first);
+        }
+    }
+    for (auto&& i : comp_nodes) {
+        i.sync();
+    }
+}
+
+bool PerfCounterProfiler::is_cpu(CompNode cn) {
+    auto type = cn.device_type();
+    return type == CompNode::DeviceType::CPU ||
+           type == CompNode::DeviceType::MULTITHREAD;
+}
+
+PerfCounterProfiler::CompNodeCounter* PerfCounterProfiler::get_cn_counter(
+        CompNode cn) {
+    CompNodeCounter* ret;
+    {
+        MGB_LOCK_GUARD(m_mtx);
+        auto&& ptr = m_cn_counter[cn];
+        if (ptr) {
+            return ptr.get();
+        }
+        ptr = std::make_unique<CompNodeCounter>();
+        ret = ptr.get();
+    }
+    ret->dispatch_register(CompNodeEnv::from_comp_node(cn).cpu_env());
+    return ret;
+}
+
+bool PerfCounterProfiler::available(Counter counter) {
+    auto fd = open_counter(static_cast<int>(counter));
+    close_counter(fd);
+    return fd >= 0;
+}
+
+const PerfCounterProfiler::OprStat* PerfCounterProfiler::opr_stat(
+        cg::OperatorNodeBase* opr) {
+    sync_comp_nodes();
+    MGB_LOCK_GUARD(m_mtx);
+    auto iter = m_opr_stat.find(opr);
+    return iter == m_opr_stat.end() ? nullptr : &iter->second;
+}
+
+std::shared_ptr<json::Object> PerfCounterProfiler::to_json() {
+    using namespace json;
+    sync_comp_nodes();
+    MGB_LOCK_GUARD(m_mtx);
+
+    auto counters = Object::make();
+    std::array<bool, NR_COUNTER> avail;
+    for (int i = 0; i < NR_COUNTER; ++i) {
+        avail[i] = available(static_cast<Counter>(i));
+        (*counters)[counter_name(i)] = Bool::make(avail[i]);
+    }
+
+    auto oprs = Object::make();
+    for (auto&& i : m_opr_stat) {
+        auto&& stat = i.second;
+        auto obj = Object::make();
+        (*obj)["nr_exec"] = NumberInt::make(stat.nr_exec);
+        for (int j = 0; j < NR_COUNTER; ++j) {
+            if (avail[j]) {
+                (*obj)[counter_name(j)] = NumberInt::make(stat.value[j]);
+            }
+        }
+        auto cycles = static_cast<double>(stat.get(Counter::CYCLES)),
+             insts = static_cast<double>(stat.get(Counter::INSTRUCTIONS)),
+             refs = static_cast<double>(stat.get(Counter::CACHE_REFERENCES)),
+             misses = static_cast<double>(stat.get(Counter::CACHE_MISSES));
+        if (cycles > 0 && insts > 0) {
+            (*obj)["ipc"] = Number::make(insts / cycles);
+        }
+        if (refs > 0 && avail[static_cast<int>(Counter::CACHE_MISSES)]) {
+            (*obj)["llc_miss_rate"] = Number::make(misses / refs);
+        }
+        if (avail[static_cast<int>(Counter::CACHE_MISSES)]) {
+            (*obj)["est_dram_bytes"] = NumberInt::make(
+                    stat.get(Counter::CACHE_MISSES) * CACHE_LINE_SIZE);
+        }
+        auto fp_iter = m_opr_fp_rst.find(i.first);
+        if (fp_iter != m_opr_fp_rst.end()) {
+            auto&& fp = fp_iter->second;
+            (*obj)["computation"] = NumberInt::make(fp.computation);
+            (*obj)["memory"] = NumberInt::make(fp.memory);
+            if (fp.computation && cycles > 0) {
+                (*obj)["computation_per_cycle"] = Number::make(
+                        fp.computation * stat.nr_exec / cycles);
+            }
+        }
+        (*oprs)[i.first->id_str()] = obj;
+    }
+
+    auto threads = Object::make();
+    for (auto&& i : m_cn_counter) {
+        (*threads)[i.first.to_string()] = NumberInt::make(i.second->threads.size());
+    }
+
+    return Object::make(
+            {{"counters", counters}, {"counted_threads", threads}, {"opr", oprs}});
+}
+
+#endif  // MGB_ENABLE_JSON
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
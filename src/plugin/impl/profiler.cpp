@@ -209,6 +209,75 @@ std::shared_ptr<json::Object> GraphProfiler::to_json() const {
              {"opr_internal_pf", opr_internal_pf}});
 }
 
+std::shared_ptr<json::Object> GraphProfiler::roofline_json(
+        const RooflinePeak& peak) const {
+    using namespace json;
+    //! oprs spending less than this ratio of time on the roof are considered
+    //! to be bound by overhead, such as launching or tiny kernels
+    constexpr double OVERHEAD_RATIO = 0.1;
+
+    // time of an opr is the longest kernel time among its comp nodes
+    ThinHashMap<OperatorNodeBase*, double> opr_time;
+    for (auto&& kern_ev : m_kern_event) {
+        auto&& event = kern_ev.second;
+        if (!event.kern || !event.end)
+            continue;
+        event.end->host_wait();
+        auto&& time = opr_time[kern_ev.first.first];
+        time = std::max(time, event.kern->elapsed_time_until(*event.end));
+    }
+
+    auto div = [](double a, double b) { return b > 0 ? a / b : 0.; };
+    auto oprs = Object::make();
+    double compute_time = 0, memory_time = 0, overhead_time = 0;
+    for (auto&& i : opr_time) {
+        auto opr = i.first;
+        double time = i.second, flops = 0, bytes = 0;
+        auto fp = m_opr_fp_rst.find(opr);
+        if (fp != m_opr_fp_rst.end()) {
+            flops = fp->second.computation;
+            bytes = fp->second.memory;
+        }
+        double compute_roof = div(flops, peak.gflops * 1e9),
+               memory_roof = div(bytes, peak.gbps * 1e9),
+               roof = std::max(compute_roof, memory_roof);
+        std::string bound;
+        if (roof < time * OVERHEAD_RATIO) {
+            bound = "overhead";
+            overhead_time += time;
+        } else if (compute_roof >= memory_roof) {
+            bound = "compute";
+            compute_time += time;
+        } else {
+            bound = "memory";
+            memory_time += time;
+        }
+        (*oprs)[opr->id_str()] = Object::make(
+                {{"name", String::make(opr->name())},
+                 {"type", String::make(opr->dyn_typeinfo()->name)},
+                 {"time", Number::make(time)},
+                 {"flops", Number::make(flops)},
+                 {"bytes", Number::make(bytes)},
+                 {"gflops", Number::make(div(flops, time) * 1e-9)},
+                 {"gbps", Number::make(div(bytes, time) * 1e-9)},
+                 {"intensity", Number::make(div(flops, bytes))},
+                 {"efficiency", Number::make(div(roof, time))},
+                 {"bound", String::make(bound)}});
+    }
+
+    return Object::make(
+            {{"peak", peak.to_json()},
+             {"oprs", oprs},
+             {"summary",
+              Object::make(
+                      {{"compute", Number::make(compute_time)},
+                       {"memory", Number::make(memory_time)},
+                       {"overhead", Number::make(overhead_time)},
+                       {"total", Number::make(
+                                         compute_time + memory_time +
+                                         overhead_time)}})}});
+}
+
 #endif  // MGB_ENABLE_JSON
 
 // vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
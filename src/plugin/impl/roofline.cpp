@@ -0,0 +1,83 @@
+/**
+ * \file src/plugin/impl/roofline.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "megbrain/plugin/roofline.h"
+
+#if MGB_ENABLE_JSON
+#include "megbrain/opr/basic_arith.h"
+#include "megbrain/opr/blas.h"
+#include "megbrain/opr/io.h"
+#include "megbrain/utils/timer.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace mgb;
+
+namespace {
+//! a float32 tensor of ones on given comp node
+SymbolVar make_ones(ComputingGraph& graph, CompNode cn, const TensorShape& shape) {
+    HostTensorND host{CompNode::default_cpu(), shape, dtype::Float32()};
+    auto ptr = host.ptr<float>();
+    std::fill(ptr, ptr + shape.total_nr_elems(), 1.f);
+    return opr::SharedDeviceTensor::make(graph, host, {cn});
+}
+
+//! best time in seconds of executing the graph which computes var
+double best_time(ComputingGraph& graph, SymbolVar var, size_t nr_run) {
+    auto func = graph.compile({{var, {}}});
+    // the first run includes algo selection and memory allocation
+    func->execute().wait();
+    double best = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < nr_run; ++i) {
+        RealTimer timer;
+        func->execute().wait();
+        best = std::min(best, timer.get_secs());
+    }
+    return best;
+}
+}  // anonymous namespace
+
+RooflinePeak RooflinePeak::measure(CompNode cn) {
+    constexpr size_t NR_RUN = 5;
+    bool is_cpu = cn.device_type() == CompNode::DeviceType::CPU ||
+                  cn.device_type() == CompNode::DeviceType::MULTITHREAD;
+    RooflinePeak ret;
+    {
+        auto graph = ComputingGraph::make();
+        graph->options().graph_opt_level = 0;
+        size_t n = is_cpu ? 1024 : 4096;
+        auto a = make_ones(*graph, cn, {n, n}), b = make_ones(*graph, cn, {n, n});
+        auto time = best_time(*graph, opr::MatrixMul::make(a, b), NR_RUN);
+        ret.gflops = 2.0 * n * n * n / time * 1e-9;
+    }
+    {
+        auto graph = ComputingGraph::make();
+        graph->options().graph_opt_level = 0;
+        // 64MB, which is much larger than the last level cache
+        size_t nr_elems = 16 * 1024 * 1024;
+        auto x = make_ones(*graph, cn, {nr_elems});
+        auto time = best_time(*graph, x + 1.f, NR_RUN);
+        ret.gbps = 2.0 * sizeof(float) * nr_elems / time * 1e-9;
+    }
+    return ret;
+}
+
+std::shared_ptr<json::Object> RooflinePeak::to_json() const {
+    return json::Object::make(
+            {{"gflops", json::Number::make(gflops)},
+             {"gbps", json::Number::make(gbps)},
+             {"ridge", json::Number::make(ridge())}});
+}
+
+#endif  // MGB_ENABLE_JSON
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -0,0 +1,108 @@
+/**
+ * \file src/plugin/include/megbrain/plugin/perf_counter_profiler.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include "megbrain/graph.h"
+#include "megbrain/plugin/base.h"
+#include "megbrain/plugin/opr_footprint.h"
+
+#if MGB_ENABLE_JSON
+
+#include <array>
+#include <memory>
+#include <mutex>
+
+namespace mgb {
+/*!
+ * \brief profile hardware performance counters of operators on cpu comp nodes
+ *
+ * Counters are opened by linux perf_event for every thread that executes
+ * kernels of a comp node, i.e. the dispatch thread and the workers of its
+ * thread pool, and the values of an operator are summed over these threads.
+ * The threads are found by a task run on the thread pool before the first
+ * kernel; if the pool is shared and some workers do not join that task
+ * soon, their work is not counted. Counters that can not be opened
+ * (perf_event unsupported, or forbidden by perf_event_paranoid) are reported
+ * as unavailable, and operators on other device types are ignored.
+ */
+class PerfCounterProfiler final : public PluginBase {
+public:
+    enum class Counter : int {
+        CYCLES = 0,
+        INSTRUCTIONS = 1,
+        //! last level cache references
+        CACHE_REFERENCES = 2,
+        //! last level cache misses
+        CACHE_MISSES = 3,
+    };
+    static constexpr int NR_COUNTER = 4;
+    using CounterValues = std::array<uint64_t, NR_COUNTER>;
+
+    //! accumulated counter values of an operator
+    struct OprStat {
+        CounterValues value{};
+        size_t nr_exec = 0;
+
+        uint64_t get(Counter c) const { return value[static_cast<int>(c)]; }
+    };
+
+private:
+    class ThreadCounter;
+    struct CompNodeCounter;
+
+    std::mutex m_mtx;
+    //! counters of the threads of each comp node, only read by its dispatch
+    //! thread
+    CompNode::UnorderedMap<std::unique_ptr<CompNodeCounter>> m_cn_counter;
+    ThinHashMap<cg::OperatorNodeBase*, OprStat> m_opr_stat;
+    ThinHashMap<cg::OperatorNodeBase*, OprFootprint::Result> m_opr_fp_rst;
+    std::unique_ptr<OprFootprint> m_opr_footprint_ptr{std::make_unique<OprFootprint>()};
+
+    /*!
+     * \brief get counters of a comp node, and open them on the first call
+     *
+     * m_mtx must not be held, since the inplace dispatcher runs the tasks
+     * opening the counters at once
+     */
+    CompNodeCounter* get_cn_counter(CompNode cn);
+
+    //! wait for the dispatched readers which refer to this object
+    void sync_comp_nodes();
+
+    static bool is_cpu(CompNode cn);
+
+public:
+    MGE_WIN_DECLSPEC_FUC PerfCounterProfiler(cg::ComputingGraph* graph);
+    MGE_WIN_DECLSPEC_FUC ~PerfCounterProfiler() noexcept;
+
+    //! whether given counter can be read on the caller thread
+    MGE_WIN_DECLSPEC_FUC static bool available(Counter counter);
+
+    //! get accumulated stat of an operator, or nullptr if not profiled
+    MGE_WIN_DECLSPEC_FUC const OprStat* opr_stat(cg::OperatorNodeBase* opr);
+
+    /*!
+     * \brief convert profiling result to json
+     *
+     * For each operator the raw counters are given together with IPC, cache
+     * miss rate, an estimation of DRAM traffic (cache misses times cache line
+     * size) and the computation and memory of OprFootprint, so that
+     * compute-bound and memory-bound kernels can be told apart.
+     */
+    MGE_WIN_DECLSPEC_FUC std::shared_ptr<json::Object> to_json();
+};
+
+}  // namespace mgb
+
+#endif  // MGB_ENABLE_JSON
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -14,6 +14,7 @@
 #include "megbrain/graph.h"
 #include "megbrain/plugin/base.h"
 #include "megbrain/plugin/opr_footprint.h"
+#include "megbrain/plugin/roofline.h"
 #include "megbrain/utils/small_vector.h"
 #include "megbrain/utils/timer.h"
 
@@ -91,6 +92,19 @@ public:
      */
     MGE_WIN_DECLSPEC_FUC std::shared_ptr<json::Object> to_json() const;
 
+    /*!
+     * \brief analyze the profiling result by the roofline model
+     *
+     * For each opr, the kernel time is combined with its footprint to get the
+     * achieved GFLOP/s and GB/s, which are compared with the peaks. An opr is
+     * bound by compute or memory according to which roof limits it, or by
+     * overhead if its time is far longer than both roofs allow.
+     *
+     * keys: peak, oprs (opr id => result), summary (bound => total time)
+     */
+    MGE_WIN_DECLSPEC_FUC std::shared_ptr<json::Object> roofline_json(
+            const RooflinePeak& peak) const;
+
     /*!
      * \brief dump to visualizer format
      */
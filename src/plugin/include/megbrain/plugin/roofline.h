@@ -0,0 +1,52 @@
+/**
+ * \file src/plugin/include/megbrain/plugin/roofline.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include "megbrain/graph.h"
+
+#if MGB_ENABLE_JSON
+
+namespace mgb {
+
+/*!
+ * \brief peak performance of a comp node used as the roofs of the roofline
+ *      model
+ *
+ * \see GraphProfiler::roofline_json
+ */
+struct RooflinePeak {
+    //! float32 arithmetic throughput, in GFLOP/s
+    double gflops = 0;
+    //! memory bandwidth, in GB/s
+    double gbps = 0;
+
+    /*!
+     * \brief measure the peaks on given comp node by microbenchmarks
+     *
+     * The compute peak is measured by a large float32 MatrixMul and the
+     * bandwidth by an elemwise opr on a tensor much larger than the cache, so
+     * they are the peaks achievable by megdnn kernels rather than the
+     * theoretical ones of the hardware. It takes about one second.
+     */
+    MGE_WIN_DECLSPEC_FUC static RooflinePeak measure(CompNode cn);
+
+    //! arithmetic intensity (FLOP/byte) where the two roofs meet
+    double ridge() const { return gbps > 0 ? gflops / gbps : 0; }
+
+    MGE_WIN_DECLSPEC_FUC std::shared_ptr<json::Object> to_json() const;
+};
+
+}  // namespace mgb
+
+#endif  // MGB_ENABLE_JSON
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -14,6 +14,7 @@
 #include "megbrain/opr/blas.h"
 #include "megbrain/opr/dnn/convolution.h"
 #include "megbrain/opr/dnn/pooling.h"
+#include "megbrain/opr/dnn/softmax.h"
 #include "megbrain/opr/io.h"
 #include "megbrain/opr/tensor_manip.h"
 #include "megbrain/plugin/profiler.h"
@@ -222,6 +223,30 @@ TEST(TestOprFootprint, MatrixMul) {
             dtype::Float32(), Param{true, true});
 }
 
+TEST(TestOprFootprint, BatchedMatrixMul) {
+    using OprType = opr::BatchedMatrixMul;
+    using Param = OprType::Param;
+    auto func = [](SymbolVar x, SymbolVar y, SymbolVar z, const Param& param) {
+        return OprType::make(x, y, param);
+    };
+    run_test(
+            func, {2, 3, 5}, {2, 5, 7}, {0}, 2 * 3 * 5 * 7 * 2,
+            2 * (3 * 5 + 5 * 7 + 3 * 7), dtype::Float32(), Param{});
+}
+
+TEST(TestOprFootprint, Softmax) {
+    using OprType = opr::Softmax;
+    using Param = OprType::Param;
+    auto func = [](SymbolVar x, SymbolVar y, SymbolVar z, const Param& param) {
+        return OprType::make(x, param);
+    };
+    Param param;
+    param.axis = 1;
+    run_test(
+            func, {4, 10}, {0}, {0}, 4 * 10 * 5, 4 * 10 * 2, dtype::Float32(),
+            param);
+}
+
 TEST(TestOprFootprint, PoolingForward) {
     using OprType = opr::PoolingForward;
     using Param = OprType::Param;
@@ -0,0 +1,80 @@
+/**
+ * \file src/plugin/test/perf_counter_profiler.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "megbrain/plugin/perf_counter_profiler.h"
+#include "megbrain/opr/basic_arith_wrapper.h"
+#include "megbrain/opr/blas.h"
+#include "megbrain/opr/io.h"
+#include "megbrain/test/helper.h"
+
+#if MGB_ENABLE_JSON
+
+using namespace mgb;
+
+namespace {
+void run_test(CompNode cn, int64_t nr_threads, const char* fpath) {
+    HostTensorGenerator<> gen;
+    auto host_x = gen({64, 64}, cn), host_y = gen({64, 64}, cn);
+    auto graph = ComputingGraph::make();
+    auto x = opr::Host2DeviceCopy::make(*graph, host_x).rename("x"),
+         y = opr::Host2DeviceCopy::make(*graph, host_y).rename("y"),
+         z = opr::MatrixMul::make(x, y).rename("z"), w = z + x;
+
+    HostTensorND host_w;
+    auto func = graph->compile({make_callback_copy(w, host_w)});
+    auto profiler = std::make_shared<PerfCounterProfiler>(graph.get());
+    func->execute();
+    func->execute();
+
+    auto stat = profiler->opr_stat(z.node()->owner_opr());
+    ASSERT_NE(nullptr, stat);
+    ASSERT_EQ(2u, stat->nr_exec);
+    using Counter = PerfCounterProfiler::Counter;
+    if (PerfCounterProfiler::available(Counter::INSTRUCTIONS)) {
+        ASSERT_GT(stat->get(Counter::INSTRUCTIONS), 0u);
+    }
+
+    // counters are opened for every thread running the kernels
+    auto rst = profiler->to_json();
+    auto&& threads = *static_cast<json::Object*>((*rst)["counted_threads"].get());
+    ASSERT_EQ(
+            nr_threads,
+            static_cast<json::NumberInt*>(threads[cn.to_string()].get())->get_impl());
+    rst->writeto_fpath(output_file(fpath));
+}
+}  // namespace
+
+TEST(TestPerfCounterProfiler, MatMulCPU) {
+    run_test(CompNode::load("cpu0"), 1, "test_perf_counter_profiler_cpu.json");
+}
+
+TEST(TestPerfCounterProfiler, MatMulMultiThread) {
+    run_test(
+            CompNode::load("multithread2:0"), 2,
+            "test_perf_counter_profiler_multithread.json");
+}
+
+TEST(TestPerfCounterProfiler, IgnoreGPU) {
+    REQUIRE_GPU(1);
+    HostTensorGenerator<> gen;
+    auto host_x = gen({23}, CompNode::load("gpu0"));
+    auto graph = ComputingGraph::make();
+    auto x = opr::Host2DeviceCopy::make(*graph, host_x), y = x + 1;
+    HostTensorND host_y;
+    auto func = graph->compile({make_callback_copy(y, host_y)});
+    auto profiler = std::make_shared<PerfCounterProfiler>(graph.get());
+    func->execute();
+    ASSERT_EQ(nullptr, profiler->opr_stat(y.node()->owner_opr()));
+}
+
+#endif  // MGB_ENABLE_JSON
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -12,6 +12,7 @@
 #include "megbrain/plugin/profiler.h"
 #include <sstream>
 #include "megbrain/opr/basic_arith.h"
+#include "megbrain/opr/blas.h"
 #include "megbrain/opr/io.h"
 #include "megbrain/test/helper.h"
 
@@ -46,4 +47,46 @@ TEST(TestGraphProfiler, APlusBCPU) {
     run_test(CompNode::load("cpu0"), "test_profiler_cpu.json");
 }
 
+TEST(TestGraphProfiler, Roofline) {
+    HostTensorGenerator<> gen;
+    auto cn = CompNode::load("cpu0");
+    auto host_a = gen({64, 64}, cn), host_b = gen({64, 64}, cn);
+    auto graph = ComputingGraph::make();
+    graph->options().graph_opt_level = 0;
+    auto a = opr::Host2DeviceCopy::make(*graph, host_a),
+         b = opr::Host2DeviceCopy::make(*graph, host_b),
+         c = opr::MatrixMul::make(a, b);
+
+    HostTensorND host_c;
+    auto func = graph->compile({make_callback_copy(c, host_c)});
+    auto profiler = std::make_shared<GraphProfiler>(graph.get());
+    func->execute().wait();
+
+    RooflinePeak peak;
+    peak.gflops = 10;
+    peak.gbps = 2;
+    ASSERT_FLOAT_EQ(5, peak.ridge());
+    auto rst = profiler->roofline_json(peak);
+    rst->writeto_fpath(output_file("test_profiler_roofline.json"));
+
+    auto get = [](const std::shared_ptr<json::Value>& obj,
+                  const char* key) -> std::shared_ptr<json::Value>& {
+        return (*static_cast<json::Object*>(obj.get()))[key];
+    };
+    auto&& opr = get(get(rst, "oprs"), c.node()->owner_opr()->id_str().c_str());
+    ASSERT_TRUE(opr);
+    auto number = [&](const char* key) {
+        return static_cast<json::Number*>(get(opr, key).get())->get_impl();
+    };
+    ASSERT_EQ(64.0 * 64 * 64 * 2, number("flops"));
+    ASSERT_EQ(64.0 * 64 * 3 * sizeof(float), number("bytes"));
+    ASSERT_FLOAT_EQ(64.0 * 2 / (3 * sizeof(float)), number("intensity"));
+    ASSERT_GT(number("time"), 0);
+    ASSERT_FLOAT_EQ(number("flops") / number("time") * 1e-9, number("gflops"));
+
+    // the intensity is above the ridge, so it can not be bound by memory
+    auto bound = static_cast<json::String*>(get(opr, "bound").get())->get_impl();
+    ASSERT_NE("memory", bound);
+}
+
 // vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
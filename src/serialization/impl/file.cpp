@@ -11,6 +11,13 @@
 
 #include "megbrain/serialization/file.h"
 
+#if !defined(WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace mgb {
 namespace serialization {
 
@@ -240,6 +247,29 @@ std::unique_ptr<InputFile> InputFile::make_mem_proxy(
     return std::make_unique<SharedMemProxyImpl>(std::move(ptr), size, writable);
 }
 
+std::unique_ptr<InputFile> InputFile::make_mmap(const char* path) {
+#if defined(WIN32)
+    return make_fs(path);
+#else
+    int fd = open(path, O_RDONLY);
+    mgb_assert(fd >= 0, "failed to open %s: %s", path, strerror(errno));
+    struct stat st;
+    bool stat_ok = !fstat(fd, &st) && st.st_size > 0;
+    if (!stat_ok) {
+        close(fd);
+    }
+    mgb_assert(stat_ok, "failed to stat %s or file is empty", path);
+    size_t size = st.st_size;
+    // use a private writable mapping, so tensors sharing the memory can still
+    // be modified inplace by copy-on-write
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    mgb_assert(addr != MAP_FAILED, "failed to mmap %s: %s", path, strerror(errno));
+    std::shared_ptr<void> mapping{addr, [size](void* p) { munmap(p, size); }};
+    return std::make_unique<SharedMemProxyImpl>(std::move(mapping), size, false);
+#endif
+}
+
 class OutputFile::VectorProxyImpl final : public OutputFile {
     std::vector<uint8_t>* const m_buf;
     size_t m_offset;
@@ -23,8 +23,10 @@
 #if MGB_ENABLE_FBS_SERIALIZATION
 
 #include "batched_device_value_loader.h"
+#include "tensor_compression.h"
 
 #include "megbrain/graph/exc_extra_info.h"
+#include "megbrain/opr/dnn/convolution.h"
 #include "megbrain/opr/io.h"
 #include "megbrain/serialization/helper.h"
 #include "megbrain/serialization/internal/flatbuffers_helper.h"
@@ -32,6 +34,7 @@
 #include "megbrain/serialization/metadata.h"
 #include "megbrain/serialization/opr_load_dump.h"
 #include "megbrain/serialization/serializer.h"
+#include "megbrain/utils/async_worker.h"
 #include "megbrain/version.h"
 
 #include <flatbuffers/flatbuffers.h>
@@ -85,15 +88,25 @@ void check_tensor_value_valid(const std::string& name, const HostTensorND& tenso
     }
 }
 
-//! feature bits for backward compatibility; default value should be 0
+/*!
+ * \brief feature bits for backward compatibility; default value should be 0
+ *
+ * A bit is set when the model uses a feature that older runtimes would
+ * misread. Loaders reject unknown bits; the bits are in the low half so that
+ * runtimes which do not check them still fail to identify the model in
+ * is_fbs_file(), which compares the magic together with the following 4 bytes.
+ */
 struct FeatureBits64 {
-    //! reserved for new fields
-    uint64_t : 64;
-    static void write(OutputFile& fout) {
+    //! values of some tensors are compressed by TensorValueEncoder
+    static constexpr uint64_t TENSOR_COMPRESSION = 1;
+    //! all the bits known by this runtime
+    static constexpr uint64_t KNOWN_BITS = TENSOR_COMPRESSION;
+
+    uint64_t bits = 0;
+
+    void write(OutputFile& fout) const {
         static_assert(sizeof(FeatureBits64) == 8, "bad feature bits");
-        FeatureBits64 fb64;
-        memset(&fb64, 0, sizeof(fb64));
-        fout.write(&fb64, 8);
+        fout.write(&bits, 8);
     }
 };
 
@@ -102,6 +115,14 @@ struct FeatureBits64 {
 namespace mgb {
 namespace serialization {
 
+static_assert(
+        static_cast<int>(TensorCompression::FLOAT16) == fbs::TensorCompression_FLOAT16 &&
+                static_cast<int>(TensorCompression::INT8_PER_CHANNEL) ==
+                        fbs::TensorCompression_INT8_PER_CHANNEL &&
+                static_cast<int>(TensorCompression::ENTROPY) ==
+                        fbs::TensorCompression_ENTROPY,
+        "TensorCompression mismatches the schema");
+
 class GraphDumperOSS final : public GraphDumper, OprDumpContextFlatBuffers {
     const std::unique_ptr<OutputFile> m_file;
     flatbuffers::FlatBufferBuilder m_builder;
@@ -110,6 +131,7 @@ class GraphDumperOSS final : public GraphDumper, OprDumpContextFlatBuffers {
     DumpResult m_cur_rst;
 
     size_t m_nr_shared_tensor;
+    FeatureBits64 m_feature_bits;
 
     std::vector<std::pair<cg::OperatorNodeBase*, const OprRegistry*>> m_oprs_to_dump;
     ThinHashMap<VarNode*, size_t> m_var2id;
@@ -121,6 +143,9 @@ class GraphDumperOSS final : public GraphDumper, OprDumpContextFlatBuffers {
 
     //! current opr to be dumped
     cg::OperatorNodeBase* m_cur_opr = nullptr;
+    //! number of VALUE_SHARED tensors dumped by the current opr; param
+    //! holders dump one for each output in order
+    size_t m_cur_opr_shared_tensor_cnt = 0;
 
     // Will be filled in dump_tensor
     std::vector<flatbuffers::Offset<fbs::Tensor>> m_cur_opr_tensor;
@@ -128,13 +153,32 @@ class GraphDumperOSS final : public GraphDumper, OprDumpContextFlatBuffers {
     std::vector<fbs::OperatorParam> m_cur_opr_param_type;
     std::vector<flatbuffers::Offset<void>> m_cur_opr_param;
 
+    //! (index in m_oprs_to_dump, weight) of oprs with packed weights
+    std::vector<std::pair<size_t, opr::mixin::WeightPreprocessExecutor::PackedWeight>>
+            m_packed_weights;
+
+    //! number of leading axes forming the output channels of params, keyed
+    //! by var id; used by INT8_PER_CHANNEL compression
+    ThinHashMap<size_t, size_t> m_param_channel_dims;
+
     void init_oprs_to_dump(const SymbolVarArray& endpoints);
+    void init_param_channel_dims();
     flatbuffers::Offset<fbs::Metadata> build_metadata(const Metadata& metadata);
     flatbuffers::Offset<fbs::Operator> build_single_opr(
             cg::OperatorNodeBase* opr, const OprRegistry* registry);
 
     flatbuffers::Offset<fbs::DType> build_dtype(DType dtype);
 
+    //! write tensor value to the file if \p has_value is true, and build the
+    //! tensor description
+    flatbuffers::Offset<fbs::Tensor> build_tensor(
+            flatbuffers::Offset<flatbuffers::String> fbname, const HostTensorND& tensor,
+            bool has_value, TensorCompression compression, size_t channel_dims = 0);
+
+    //! write packed weights collected from the dumped oprs
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<fbs::PackedWeight>>>
+    build_packed_weights();
+
 public:
     GraphDumperOSS(std::unique_ptr<OutputFile> file) : m_file{std::move(file)} {}
     DumpResult dump(
@@ -201,6 +245,47 @@ void GraphDumperOSS::init_oprs_to_dump(const SymbolVarArray& endpoints) {
     }
 }
 
+void GraphDumperOSS::init_param_channel_dims() {
+    m_param_channel_dims.clear();
+    // output channels are known only for filters of conv oprs whose layout
+    // starts with them; other uses get a single scale
+    auto get_channel_dims = [](cg::OperatorNodeBase* opr, size_t inp_idx) -> size_t {
+        auto conv_dims = [](auto&& param) -> size_t {
+            using Param = std::decay_t<decltype(param)>;
+            if (param.format != Param::Format::NCHW &&
+                param.format != Param::Format::NHWC) {
+                return 0;
+            }
+            return param.sparse == Param::Sparse::DENSE ? 1 : 2;
+        };
+        if (inp_idx != 1) {
+            return 0;
+        }
+        if (opr->same_type<opr::Convolution>()) {
+            return conv_dims(opr->cast_final<opr::Convolution>().param());
+        }
+        if (opr->same_type<opr::ConvBias>()) {
+            return conv_dims(opr->cast_final<opr::ConvBias>().param());
+        }
+        return 0;
+    };
+    for (auto&& i : m_oprs_to_dump) {
+        auto opr = i.first;
+        for (size_t j = 0; j < opr->input().size(); ++j) {
+            auto iter = m_var2id.find(opr->input(j));
+            if (iter == m_var2id.end()) {
+                continue;
+            }
+            auto dims = get_channel_dims(opr, j);
+            auto ins = m_param_channel_dims.emplace(iter->second, dims);
+            if (!ins.second && ins.first->second != dims) {
+                // conflicting uses
+                ins.first->second = 0;
+            }
+        }
+    }
+}
+
 flatbuffers::Offset<fbs::Metadata> GraphDumperOSS::build_metadata(
         const Metadata& metadata) {
     auto user_info = m_builder.CreateSharedString(metadata.user_info);
@@ -215,6 +300,7 @@ flatbuffers::Offset<fbs::Metadata> GraphDumperOSS::build_metadata(
 flatbuffers::Offset<fbs::Operator> GraphDumperOSS::build_single_opr(
         cg::OperatorNodeBase* opr, const OprRegistry* registry) {
     m_cur_opr = opr;
+    m_cur_opr_shared_tensor_cnt = 0;
     ++m_cur_rst.nr_opr;
 
     using namespace flatbuffers;
@@ -264,6 +350,14 @@ flatbuffers::Offset<fbs::Operator> GraphDumperOSS::build_single_opr(
     m_cur_opr_param.clear();
     m_cur_opr_param_type.clear();
     registry->dumper(*this, *opr);
+    if (m_config.dump_packed_weight) {
+        if (auto wp = dynamic_cast<opr::mixin::WeightPreprocessExecutor*>(opr)) {
+            auto packed = wp->packed_weight();
+            if (packed.valid()) {
+                m_packed_weights.emplace_back(m_cur_rst.nr_opr - 1, packed.val());
+            }
+        }
+    }
 
     Offset<Vector<Offset<fbs::Tensor>>> tensors;
     if (m_cur_opr_tensor.size())
@@ -312,6 +406,12 @@ GraphDumper::DumpResult GraphDumperOSS::dump(
         const Metadata& metadata) {
     mgb_throw_if(output_vars.empty(), SerializationError, "Can't dump empty graph");
 
+    mgb_throw_if(
+            config.tensor_value_dumper &&
+                    config.tensor_compression != TensorCompression::NONE,
+            SerializationError,
+            "tensor_compression can not be used with custom tensor_value_dumper");
+
     auto begin_pos = m_file->tell();
     m_config = config;
     m_builder.Reset();
@@ -340,8 +440,10 @@ GraphDumper::DumpResult GraphDumperOSS::dump(
     uint32_t magic = MGB_MAGIC;
     m_file->write(&magic, sizeof(magic));
 
-    // write FeatureBits
-    FeatureBits64::write(*m_file);
+    // write FeatureBits, which are rewritten after all tensors are dumped
+    auto feature_bits_pos = m_file->tell();
+    m_feature_bits = {};
+    m_feature_bits.write(*m_file);
     // Padding
     uint32_t reserved = 0;
     m_file->write(&reserved, sizeof(reserved));
@@ -356,12 +458,18 @@ GraphDumper::DumpResult GraphDumperOSS::dump(
 
     // Dump operators
     init_oprs_to_dump(output_vars);
+    if (m_config.tensor_compression == TensorCompression::INT8_PER_CHANNEL) {
+        init_param_channel_dims();
+    }
     std::vector<flatbuffers::Offset<fbs::Operator>> oprs;
     for (auto&& i : m_oprs_to_dump) {
         oprs.emplace_back(build_single_opr(i.first, i.second));
     }
     auto fb_oprs = m_builder.CreateVector(oprs);
 
+    // Dump packed weights, whose values follow those of all the operators
+    auto fb_packed_weights = build_packed_weights();
+
     // Dump output vars
     std::vector<fbs::OutputVar> output_vars_idx;
     output_vars_idx.reserve(output_vars.size());
@@ -381,6 +489,7 @@ GraphDumper::DumpResult GraphDumperOSS::dump(
     graph.add_output_vars_idx(fb_output_vars);
     graph.add_nr_shared_tensor(m_nr_shared_tensor);
     graph.add_metadata(fbmeta);
+    graph.add_packed_weights(fb_packed_weights);
     m_builder.FinishSizePrefixed(graph.Finish(), fbs::GraphIdentifier());
 
     // Write actual offset_to_fbs
@@ -389,6 +498,10 @@ GraphDumper::DumpResult GraphDumperOSS::dump(
     offset_to_fbs = cur - offset_pos - sizeof(offset_to_fbs);
     m_file->seek(offset_pos);
     m_file->write(&offset_to_fbs, sizeof(offset_to_fbs));
+    if (m_feature_bits.bits) {
+        m_file->seek(feature_bits_pos);
+        m_feature_bits.write(*m_file);
+    }
     m_file->seek(cur);
 
     // Write serialized fbs::Graph
@@ -442,30 +555,114 @@ void GraphDumperOSS::dump_tensor(
             break;
     }
 
-    size_t value_size = 0;
+    auto compression = TensorCompression::NONE;
+    size_t channel_dims = 0;
+    if (method == Meth::VALUE_SHARED) {
+        auto idx = m_cur_opr_shared_tensor_cnt++;
+        if (m_config.tensor_compression == TensorCompression::INT8_PER_CHANNEL &&
+            idx < m_cur_opr->output().size()) {
+            auto id = m_var2id.find(m_cur_opr->output(idx));
+            if (id != m_var2id.end()) {
+                auto iter = m_param_channel_dims.find(id->second);
+                if (iter != m_param_channel_dims.end()) {
+                    channel_dims = iter->second;
+                }
+            }
+        }
+        if (TensorValueEncoder::applicable(
+                    m_config.tensor_compression, tensor, channel_dims)) {
+            compression = m_config.tensor_compression;
+        }
+    }
     if (has_value) {
         check_tensor_value_valid(name, tensor);
+    }
+    auto fbname = should_keep_name ? m_builder.CreateSharedString(name) : 0;
+    m_cur_opr_tensor.emplace_back(
+            build_tensor(fbname, tensor, has_value, compression, channel_dims));
+}
+
+flatbuffers::Offset<fbs::Tensor> GraphDumperOSS::build_tensor(
+        flatbuffers::Offset<flatbuffers::String> fbname, const HostTensorND& tensor,
+        bool has_value, TensorCompression compression, size_t channel_dims) {
+    size_t value_size = 0, value_offset = 0;
+    if (has_value) {
         auto begin = m_file->tell();
+        if (auto align = m_config.tensor_value_alignment) {
+            // pad before the value so that it starts at an aligned file
+            // offset; the padding is skipped by the loader via Tensor::offset
+            constexpr size_t SMALL_TENSOR_ALIGN = 64;
+            mgb_assert(
+                    !(align & (align - 1)),
+                    "tensor_value_alignment must be power of 2, got %zu", align);
+            if (tensor.layout().span().high_byte < align) {
+                align = std::min(align, SMALL_TENSOR_ALIGN);
+            }
+            value_offset = (align - begin % align) % align;
+            if (value_offset) {
+                std::vector<uint8_t> padding(value_offset, 0);
+                m_file->write(padding.data(), value_offset);
+            }
+        }
         auto&& dumper = m_config.tensor_value_dumper;
-        if (dumper) {
+        if (compression != TensorCompression::NONE) {
+            TensorValueEncoder::encode(compression, *m_file, tensor, channel_dims);
+            m_feature_bits.bits |= FeatureBits64::TENSOR_COMPRESSION;
+        } else if (dumper) {
             dumper(*m_file, *m_cur_opr, tensor);
         } else {
             m_file->write(tensor.raw_ptr(), tensor.layout().span().high_byte);
         }
         value_size = m_file->tell() - begin;
-        m_cur_rst.tensor_value_bytes += value_size;
+        m_cur_rst.tensor_value_bytes += value_size - value_offset;
     }
 
-    auto fbname = should_keep_name ? m_builder.CreateSharedString(name) : 0;
     auto shape = m_builder.CreateVectorScalarCast<uint32_t>(
             tensor.shape().shape, tensor.shape().ndim);
     auto comp_node = fbs::CreateCompNode(
             m_builder,
             m_builder.CreateSharedString(tensor.comp_node().to_string_logical()));
     auto dtype = build_dtype(tensor.dtype());
-    auto serialized_tensor =
-            fbs::CreateTensor(m_builder, fbname, shape, comp_node, dtype, value_size);
-    m_cur_opr_tensor.emplace_back(serialized_tensor);
+    return fbs::CreateTensor(
+            m_builder, fbname, shape, comp_node, dtype, value_size, value_offset,
+            static_cast<fbs::TensorCompression>(compression));
+}
+
+flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<fbs::PackedWeight>>>
+GraphDumperOSS::build_packed_weights() {
+    using namespace flatbuffers;
+    std::vector<Offset<fbs::PackedWeight>> ret;
+    for (auto&& i : m_packed_weights) {
+        auto&& weight = i.second;
+        m_cur_opr = m_oprs_to_dump.at(i.first).first;
+        std::vector<Offset<fbs::Tensor>> tensors;
+        for (auto&& dv : weight.tensors) {
+            HostTensorND hv;
+            hv.copy_from(dv).sync();
+            // lossy compression is not applied since the packed layout is
+            // opaque
+            auto compression = TensorCompression::NONE;
+            if (m_config.tensor_compression == TensorCompression::ENTROPY &&
+                TensorValueEncoder::applicable(TensorCompression::ENTROPY, hv)) {
+                compression = TensorCompression::ENTROPY;
+            }
+            tensors.emplace_back(build_tensor(0, hv, true, compression));
+        }
+        auto&& algo = weight.algo;
+        auto algo_param = m_builder.CreateVector(
+                reinterpret_cast<const uint8_t*>(algo.param.data()), algo.param.size());
+        auto algo_name = m_builder.CreateString(algo.name);
+        auto fb_tensors = m_builder.CreateVector(tensors);
+        ret.emplace_back(fbs::CreatePackedWeight(
+                m_builder, i.first, static_cast<uint32_t>(algo.handle_type), algo.type,
+                algo_param, algo_name, fb_tensors));
+    }
+    m_cur_opr = nullptr;
+    m_packed_weights.clear();
+    if (ret.empty()) {
+        return {};
+    }
+    return m_builder.CreateVector(ret);
 }
 
 void GraphDumperOSS::dump_buf_with_len(const void* data, uint32_t size) {
@@ -516,12 +713,21 @@ class GraphLoaderOSS::OprLoadContextImpl final : public OprLoadContextFlatBuffer
     std::shared_ptr<ComputingGraph> m_graph;
     LoadResult::TensorMap m_tensor_map;
     VarNodeArray m_id2varnode;
+    //! loaded oprs, indexed as in fbs::Graph::oprs
+    std::vector<cg::OperatorNodeBase*> m_oprs;
     BatchedDeviceValueLoader m_device_value_loader;
     const fbs::Operator* m_current_opr;
     size_t m_cur_opr_tensor_cnt;
     size_t m_cur_opr_blob_cnt;
     size_t m_cur_opr_param_cnt;
 
+    //! pool to decode tensor values, created on demand; see
+    //! GraphLoadConfig::nr_load_threads
+    std::unique_ptr<FutureThreadPool<void>> m_value_load_pool;
+    //! pending decoding tasks, keyed by the raw storage of the value
+    ThinHashMap<const void*, std::vector<FutureThreadPool<void>::Future>>
+            m_value_load_futures;
+
     ComputingGraph& graph() override { return *m_graph; }
 
     const GraphLoadConfig& config() const override {
@@ -531,12 +737,29 @@ class GraphLoaderOSS::OprLoadContextImpl final : public OprLoadContextFlatBuffer
     void load_tensor_value(
             HostTensorND* dest, const TensorLayout& layout, const fbs::Tensor* tensor);
 
+    /*!
+     * \brief like load_tensor_value(), but decode compressed values or run
+     *      the custom tensor value loader on m_value_load_pool if it is
+     *      enabled
+     *
+     * The value of \p dest would be available after wait_tensor_value() on
+     * it or wait_tensor_value_loading().
+     */
+    void load_tensor_value_async(
+            HostTensorND& dest, const TensorLayout& layout, const fbs::Tensor* tensor);
+
+    void wait_tensor_value_loading();
+
+    void wait_tensor_value(const DeviceTensorND& tensor) override;
+
     std::shared_ptr<HostTensorND> load_tensor() override;
 
     std::shared_ptr<DeviceTensorND> load_tensor_shared() override;
 
     void load_single_opr(const fbs::Operator* opr);
 
+    void load_packed_weights();
+
 public:
     OprLoadContextImpl(GraphLoaderOSS* loader, uint32_t version)
             : OprLoadContextFlatBuffers(version), m_loader{loader} {
@@ -635,7 +858,18 @@ void GraphLoaderOSS::OprLoadContextImpl::load_tensor_value(
     auto&& file = m_loader->m_file;
     auto begin_pos = file->tell();
     file->skip(tensor->offset());
-    if (loader) {
+    auto compression = static_cast<TensorCompression>(tensor->compression());
+    if (compression != TensorCompression::NONE) {
+        // built-in compression takes precedence over the custom loader
+        auto size = tensor->data_size() - tensor->offset();
+        if (dest) {
+            dest->dtype(layout.dtype).resize(layout);
+            TensorValueDecoder{compression, file->read_shared(size), layout}
+                    .decode_all(dest->raw_ptr());
+        } else {
+            file->skip(size);
+        }
+    } else if (loader) {
         // call custom loader
         void* dest_ptr = nullptr;
         if (dest) {
@@ -670,6 +904,90 @@ void GraphLoaderOSS::OprLoadContextImpl::load_tensor_value(
     }
 }
 
+void GraphLoaderOSS::OprLoadContextImpl::load_tensor_value_async(
+        HostTensorND& dest, const TensorLayout& layout, const fbs::Tensor* tensor) {
+    auto&& file = m_loader->m_file;
+    auto data_size = tensor->data_size();
+    mgb_throw_if(
+            tensor->offset() > data_size, SerializationError,
+            "invalid tensor value offset: offset %u, data size %u",
+            tensor->offset(), data_size);
+    size_t size = data_size - tensor->offset();
+    auto&& config = *m_loader->m_cur_load_config;
+    auto compression = static_cast<TensorCompression>(tensor->compression());
+    if (config.nr_load_threads <= 1 || !size ||
+        (compression == TensorCompression::NONE && !config.tensor_value_loader)) {
+        load_tensor_value(&dest, layout, tensor);
+        return;
+    }
+    if (!m_value_load_pool) {
+        m_value_load_pool = std::make_unique<FutureThreadPool<void>>("tensor_load");
+        m_value_load_pool->start(config.nr_load_threads);
+    }
+
+    // file access is sequential, so only the decoding is done by the pool
+    file->skip(tensor->offset());
+    auto buf = file->read_shared(size);
+    dest.dtype(layout.dtype).resize(layout);
+    auto&& futures = m_value_load_futures[dest.storage().raw_storage().get()];
+    if (compression != TensorCompression::NONE) {
+        // decode parts concurrently; dest is copied to hold the storage
+        auto decoder = std::make_shared<TensorValueDecoder>(
+                compression, std::move(buf), layout);
+        for (size_t i = 0; i < decoder->nr_parts(); ++i) {
+            auto task = [decoder, dest, i]() { decoder->decode(dest.raw_ptr(), i); };
+            futures.emplace_back(m_value_load_pool->launch(std::move(task)));
+        }
+        return;
+    }
+    auto&& loader = config.tensor_value_loader;
+    // dest is copied to hold the storage until the task finishes
+    auto task = [&loader, dest, layout, buf]() mutable {
+        auto fin = InputFile::make_mem_proxy(buf.data(), buf.size());
+        loader(dest.raw_ptr(), layout, *fin);
+        if (fin->tell() < buf.size()) {
+            mgb_log_warn(
+                    "Tensor value loader consumed less data than available: "
+                    "consumed %zu bytes, has %zu bytes",
+                    fin->tell(), buf.size());
+        }
+    };
+    futures.emplace_back(m_value_load_pool->launch(std::move(task)));
+}
+
+void GraphLoaderOSS::OprLoadContextImpl::wait_tensor_value(
+        const DeviceTensorND& tensor) {
+    // values on other mem nodes are only copied after all values are loaded
+    if (m_value_load_futures.empty() || tensor.storage().has_no_real_storage() ||
+        tensor.comp_node().mem_node() != CompNode::default_cpu().mem_node()) {
+        return;
+    }
+    auto iter = m_value_load_futures.find(tensor.storage().raw_storage().get());
+    if (iter == m_value_load_futures.end()) {
+        return;
+    }
+    auto futures = std::move(iter->second);
+    m_value_load_futures.erase(iter);
+    // get() rethrows the exception raised by the loader
+    for (auto&& i : futures) {
+        i.get();
+    }
+}
+
+void GraphLoaderOSS::OprLoadContextImpl::wait_tensor_value_loading() {
+    // get() rethrows the exception raised by the loader
+    for (auto&& i : m_value_load_futures) {
+        for (auto&& j : i.second) {
+            j.get();
+        }
+    }
+    m_value_load_futures.clear();
+    if (m_value_load_pool) {
+        m_value_load_pool->stop();
+        m_value_load_pool.reset();
+    }
+}
+
 std::shared_ptr<HostTensorND> GraphLoaderOSS::OprLoadContextImpl::load_tensor() {
     mgb_assert(
             m_current_opr->tensors() &&
@@ -720,18 +1038,70 @@ std::shared_ptr<DeviceTensorND> GraphLoaderOSS::OprLoadContextImpl::
     if (comp_node.mem_node() == CompNode::default_cpu().mem_node()) {
         // directly forward CPU memory
         HostTensorND hv{comp_node};
-        load_tensor_value(&hv, layout, tensor);
+        load_tensor_value_async(hv, layout, tensor);
         sh_ptr_ref = std::make_shared<DeviceTensorND>();
         *sh_ptr_ref = DeviceTensorND::make_proxy(hv);
     } else {
         // use lazy load for non-CPU devices
         HostTensorND hv{CompNode::default_cpu()};
-        load_tensor_value(&hv, layout, tensor);
+        load_tensor_value_async(hv, layout, tensor);
         sh_ptr_ref = m_device_value_loader.make(comp_node, std::move(hv));
     }
     return sh_ptr_ref;
 }
 
+void GraphLoaderOSS::OprLoadContextImpl::load_packed_weights() {
+    const auto* packed_weights = m_loader->m_graph->packed_weights();
+    // values of unused packed weights are skipped with the graph
+    if (!packed_weights || !m_graph->options().graph_opt.weight_preprocess) {
+        return;
+    }
+    using WeightPreprocessExecutor = opr::mixin::WeightPreprocessExecutor;
+    for (const auto* fbweight : *packed_weights) {
+        mgb_throw_if(
+                fbweight->opr() >= m_oprs.size(), SerializationError,
+                "invalid opr index of packed weight: %u", fbweight->opr());
+        // the opr may have been replaced by its loader
+        auto opr = dynamic_cast<WeightPreprocessExecutor*>(m_oprs[fbweight->opr()]);
+        WeightPreprocessExecutor::PackedWeight weight;
+        auto&& algo = weight.algo;
+        algo.handle_type =
+                static_cast<megdnn::Handle::HandleType>(fbweight->handle_type());
+        algo.type = fbweight->algo_type();
+        if (fbweight->algo_param()) {
+            algo.param.assign(
+                    reinterpret_cast<const char*>(fbweight->algo_param()->data()),
+                    fbweight->algo_param()->size());
+        }
+        if (fbweight->algo_name()) {
+            algo.name = fbweight->algo_name()->str();
+        }
+        if (fbweight->tensors()) {
+            for (const auto* tensor : *fbweight->tensors()) {
+                auto layout = load_tensor_layout(tensor);
+                if (!opr) {
+                    load_tensor_value(nullptr, layout, tensor);
+                    continue;
+                }
+                auto comp_node = load_comp_node(tensor->comp_node());
+                if (comp_node.mem_node() == CompNode::default_cpu().mem_node()) {
+                    HostTensorND hv{comp_node};
+                    load_tensor_value_async(hv, layout, tensor);
+                    weight.tensors.emplace_back(DeviceTensorND::make_proxy(hv));
+                } else {
+                    HostTensorND hv{CompNode::default_cpu()};
+                    load_tensor_value(&hv, layout, tensor);
+                    weight.tensors.emplace_back();
+                    weight.tensors.back().comp_node(comp_node).copy_from(hv).sync();
+                }
+            }
+        }
+        if (opr) {
+            opr->set_packed_weight(std::move(weight));
+        }
+    }
+}
+
 Metadata GraphLoaderOSS::OprLoadContextImpl::load_metadata() {
     const auto* fbmeta = m_loader->m_graph->metadata();
     Metadata ret;
@@ -800,6 +1170,7 @@ void GraphLoaderOSS::OprLoadContextImpl::load_single_opr(const fbs::Operator* fb
     // call loader
     auto accessor = registry->loader(*this, inputs, config);
     auto opr = accessor.opr();
+    m_oprs.push_back(opr);
 
     // check opr type; note that:
     // 1. registry->type may be empty for dynamic opr loaders or legacy oprs
@@ -837,6 +1208,11 @@ GraphLoader::LoadResult GraphLoaderOSS::OprLoadContextImpl::load_oprs() {
         }
     }
 
+    load_packed_weights();
+
+    // host values must be ready before being copied to devices
+    wait_tensor_value_loading();
+
     // batched loading device values
     m_device_value_loader.apply();
 
@@ -874,6 +1250,11 @@ GraphLoader::LoadResult GraphLoaderOSS::load(const LoadConfig& config, bool rewi
         // read FeatureBits
         magic_compare = true;
         m_file->read(&m_feature_bits, 8);
+        mgb_throw_if(
+                m_feature_bits.bits & ~FeatureBits64::KNOWN_BITS, SerializationError,
+                "model uses unknown features (feature bits %#" PRIx64
+                "); please upgrade the runtime",
+                m_feature_bits.bits);
     } else {
         magic_compare = false;
     }
@@ -962,7 +1343,13 @@ bool is_fbs_file(InputFile& file) {
     uint64_t magic_with_reserved = 0;
     file.read(&magic_with_reserved, sizeof(magic_with_reserved));
     file.skip(-sizeof(magic_with_reserved));
-    return (magic_with_reserved == MGB_MAGIC) || (magic_with_reserved == MAGIC_V0);
+    if (magic_with_reserved == MAGIC_V0) {
+        return true;
+    }
+    // low half of the feature bits follows the magic
+    auto low_feature_bits = magic_with_reserved >> 32;
+    return static_cast<uint32_t>(magic_with_reserved) == MGB_MAGIC &&
+           !(low_feature_bits & ~FeatureBits64::KNOWN_BITS);
 }
 
 }  // namespace serialization
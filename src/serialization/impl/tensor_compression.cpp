@@ -0,0 +1,484 @@
+/**
+ * \file src/serialization/impl/tensor_compression.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * Encoded value layouts:
+ *
+ * FLOAT16: [float16 x N]
+ *
+ * INT8_PER_CHANNEL: [uint32_t K] [float32 scale x C] [int8 x N], where C is the
+ * product of the first K axes of the shape
+ *
+ * ENTROPY:
+ * [uint32_t block size] [uint32_t nr block] [uint32_t encoded block size x nr]
+ * [block 1] [block 2] [...]
+ * where each block is either
+ * [00] [raw bytes]
+ * or, if it is compressible,
+ * [01] [uint16_t freq x 256] [uint32_t rANS state] [rANS stream]
+ * The rANS stream encodes the bytes of the block after shuffling them into
+ * byte planes (byte k of all the elements, then byte k + 1, ...), which
+ * makes exponent bytes of float values highly compressible.
+ */
+
+#include "./tensor_compression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace mgb;
+using namespace serialization;
+
+namespace {
+
+//! number of bytes in a part of the decoded value
+constexpr size_t PART_SIZE = 1 << 20;
+
+constexpr uint32_t RANS_SCALE_BITS = 12, RANS_M = 1u << RANS_SCALE_BITS,
+                   RANS_L = 1u << 23;
+
+constexpr uint8_t BLOCK_RAW = 0, BLOCK_RANS = 1;
+constexpr size_t RANS_HEADER_SIZE = 1 + 256 * sizeof(uint16_t) + sizeof(uint32_t);
+
+template <typename T>
+T load_unaligned(const uint8_t* ptr) {
+    T ret;
+    memcpy(&ret, ptr, sizeof(T));
+    return ret;
+}
+
+template <typename T>
+void store_unaligned(uint8_t* ptr, T val) {
+    memcpy(ptr, &val, sizeof(T));
+}
+
+//! width of the byte planes for ENTROPY
+size_t shuffle_width(DType dtype) {
+    return dtype.is_low_bit() ? 1 : dtype.size();
+}
+
+//! scale symbol counts so that they sum to RANS_M, keeping present symbols
+//! non-zero
+void normalize_freq(const size_t* count, size_t total, uint16_t* freq) {
+    size_t sum = 0;
+    for (int i = 0; i < 256; ++i) {
+        if (!count[i]) {
+            freq[i] = 0;
+            continue;
+        }
+        auto f = static_cast<size_t>(
+                static_cast<uint64_t>(count[i]) * RANS_M / total);
+        freq[i] = std::max<size_t>(f, 1);
+        sum += freq[i];
+    }
+    while (sum != RANS_M) {
+        auto imax = std::max_element(freq, freq + 256) - freq;
+        if (sum > RANS_M) {
+            auto dec = std::min<size_t>(sum - RANS_M, freq[imax] - 1);
+            freq[imax] -= dec;
+            sum -= dec;
+        } else {
+            freq[imax] += RANS_M - sum;
+            sum = RANS_M;
+        }
+    }
+}
+
+/*!
+ * \brief encode a block with rANS
+ * \return encoded block, or empty if the block is not compressible
+ */
+std::vector<uint8_t> rans_encode(const uint8_t* src, size_t size) {
+    size_t count[256] = {0};
+    for (size_t i = 0; i < size; ++i) {
+        ++count[src[i]];
+    }
+    uint16_t freq[256];
+    uint32_t cum[256];
+    normalize_freq(count, size, freq);
+    for (uint32_t i = 0, c = 0; i < 256; ++i) {
+        cum[i] = c;
+        c += freq[i];
+    }
+
+    // each symbol emits at most two bytes; the stream is written backwards
+    std::vector<uint8_t> stream(size * 2 + sizeof(uint32_t));
+    uint8_t* const stream_end = stream.data() + stream.size();
+    uint8_t* ptr = stream_end;
+    uint32_t x = RANS_L;
+    for (size_t i = size; i; --i) {
+        uint8_t s = src[i - 1];
+        uint32_t f = freq[s];
+        uint32_t x_max = ((RANS_L >> RANS_SCALE_BITS) << 8) * f;
+        while (x >= x_max) {
+            *--ptr = static_cast<uint8_t>(x & 0xff);
+            x >>= 8;
+        }
+        x = ((x / f) << RANS_SCALE_BITS) + (x % f) + cum[s];
+    }
+    ptr -= sizeof(uint32_t);
+    store_unaligned<uint32_t>(ptr, x);
+
+    size_t stream_size = stream_end - ptr;
+    if (RANS_HEADER_SIZE - sizeof(uint32_t) + stream_size >= 1 + size) {
+        return {};
+    }
+    std::vector<uint8_t> ret(1 + 256 * sizeof(uint16_t) + stream_size);
+    ret[0] = BLOCK_RANS;
+    memcpy(ret.data() + 1, freq, sizeof(freq));
+    memcpy(ret.data() + 1 + sizeof(freq), ptr, stream_size);
+    return ret;
+}
+
+//! decode a rANS block of \p size bytes
+void rans_decode(const uint8_t* src, size_t src_size, uint8_t* dest, size_t size) {
+    mgb_throw_if(
+            src_size < RANS_HEADER_SIZE, SerializationError,
+            "corrupted compressed tensor value: block too small");
+    uint16_t freq[256];
+    uint32_t cum[256];
+    memcpy(freq, src + 1, sizeof(freq));
+    std::vector<uint8_t> slot2sym(RANS_M);
+    uint32_t c = 0;
+    for (uint32_t i = 0; i < 256; ++i) {
+        cum[i] = c;
+        mgb_throw_if(
+                c + freq[i] > RANS_M, SerializationError,
+                "corrupted compressed tensor value: bad frequency table");
+        std::fill_n(slot2sym.data() + c, freq[i], static_cast<uint8_t>(i));
+        c += freq[i];
+    }
+    mgb_throw_if(
+            c != RANS_M, SerializationError,
+            "corrupted compressed tensor value: bad frequency table");
+
+    const uint8_t* ptr = src + 1 + sizeof(freq);
+    const uint8_t* const end = src + src_size;
+    uint32_t x = load_unaligned<uint32_t>(ptr);
+    ptr += sizeof(uint32_t);
+    for (size_t i = 0; i < size; ++i) {
+        uint32_t slot = x & (RANS_M - 1);
+        uint8_t s = slot2sym[slot];
+        dest[i] = s;
+        x = freq[s] * (x >> RANS_SCALE_BITS) + slot - cum[s];
+        while (x < RANS_L) {
+            mgb_throw_if(
+                    ptr == end, SerializationError,
+                    "corrupted compressed tensor value: truncated stream");
+            x = (x << 8) | *ptr++;
+        }
+    }
+}
+
+void encode_entropy(OutputFile& fout, const HostTensorND& value) {
+    auto src = reinterpret_cast<const uint8_t*>(value.raw_ptr());
+    size_t size = value.layout().span().high_byte,
+           width = shuffle_width(value.dtype());
+    uint32_t nr_block = (size + PART_SIZE - 1) / PART_SIZE;
+    std::vector<std::vector<uint8_t>> blocks(nr_block);
+    std::vector<uint32_t> block_sizes(nr_block);
+    std::vector<uint8_t> shuffled;
+    for (size_t i = 0; i < nr_block; ++i) {
+        auto block_src = src + i * PART_SIZE;
+        auto block_size = std::min(PART_SIZE, size - i * PART_SIZE);
+        mgb_assert(block_size % width == 0);
+        auto nr_elem = block_size / width;
+        shuffled.resize(block_size);
+        for (size_t j = 0; j < nr_elem; ++j) {
+            for (size_t k = 0; k < width; ++k) {
+                shuffled[k * nr_elem + j] = block_src[j * width + k];
+            }
+        }
+        auto&& block = blocks[i];
+        block = rans_encode(shuffled.data(), block_size);
+        if (block.empty()) {
+            block.resize(1 + block_size);
+            block[0] = BLOCK_RAW;
+            memcpy(block.data() + 1, block_src, block_size);
+        }
+        block_sizes[i] = block.size();
+    }
+
+    uint32_t block_size = PART_SIZE;
+    fout.write(&block_size, sizeof(block_size));
+    fout.write(&nr_block, sizeof(nr_block));
+    fout.write(block_sizes.data(), block_sizes.size() * sizeof(uint32_t));
+    for (auto&& i : blocks) {
+        fout.write(i.data(), i.size());
+    }
+}
+
+//! number of channels formed by the first \p channel_dims axes
+size_t get_nr_channel(const TensorShape& shape, size_t channel_dims) {
+    size_t ret = 1;
+    for (size_t i = 0; i < channel_dims; ++i) {
+        ret *= shape[i];
+    }
+    return ret;
+}
+
+void encode_int8_per_channel(
+        OutputFile& fout, const HostTensorND& value, size_t channel_dims) {
+    auto ptr = value.ptr<float>();
+    size_t nr_channel = get_nr_channel(value.shape(), channel_dims),
+           channel_size = value.shape().total_nr_elems() / nr_channel;
+    std::vector<float> scale(nr_channel);
+    std::vector<int8_t> quantized(nr_channel * channel_size);
+    for (size_t i = 0; i < nr_channel; ++i) {
+        auto chan = ptr + i * channel_size;
+        float max_abs = 0;
+        for (size_t j = 0; j < channel_size; ++j) {
+            max_abs = std::max(max_abs, std::abs(chan[j]));
+        }
+        scale[i] = max_abs / 127.f;
+        auto dest = quantized.data() + i * channel_size;
+        for (size_t j = 0; j < channel_size; ++j) {
+            float q = scale[i] ? std::round(chan[j] / scale[i]) : 0.f;
+            dest[j] = static_cast<int8_t>(std::max(-127.f, std::min(127.f, q)));
+        }
+    }
+    uint32_t channel_dims_u32 = channel_dims;
+    fout.write(&channel_dims_u32, sizeof(channel_dims_u32));
+    fout.write(scale.data(), scale.size() * sizeof(float));
+    fout.write(quantized.data(), quantized.size());
+}
+
+void encode_float16(OutputFile& fout, const HostTensorND& value) {
+#if !MEGDNN_DISABLE_FLOAT16
+    auto ptr = value.ptr<float>();
+    size_t nr_elem = value.shape().total_nr_elems();
+    std::vector<dt_float16> half(nr_elem);
+    for (size_t i = 0; i < nr_elem; ++i) {
+        half[i] = static_cast<dt_float16>(ptr[i]);
+    }
+    fout.write(half.data(), half.size() * sizeof(dt_float16));
+#else
+    MGB_MARK_USED_VAR(fout);
+    MGB_MARK_USED_VAR(value);
+    mgb_throw(SerializationError, "float16 is disabled at compile time");
+#endif
+}
+
+}  // anonymous namespace
+
+/* ==================== TensorValueEncoder ==================== */
+
+bool TensorValueEncoder::applicable(
+        TensorCompression method, const HostTensorND& value, size_t channel_dims) {
+    if (!value.layout().is_contiguous() || value.shape().is_empty()) {
+        return false;
+    }
+    switch (method) {
+        case TensorCompression::NONE:
+            return false;
+        case TensorCompression::FLOAT16:
+#if MEGDNN_DISABLE_FLOAT16
+            return false;
+#else
+            return value.dtype() == dtype::Float32();
+#endif
+        case TensorCompression::INT8_PER_CHANNEL: {
+            // a vector would need a scale per element to keep its precision
+            size_t nr_non_one = 0;
+            for (size_t i = 0; i < value.shape().ndim; ++i) {
+                nr_non_one += value.shape(i) != 1;
+            }
+            return value.dtype() == dtype::Float32() && nr_non_one >= 2 &&
+                   channel_dims < value.shape().ndim;
+        }
+        case TensorCompression::ENTROPY:
+            return true;
+    }
+    return false;
+}
+
+void TensorValueEncoder::encode(
+        TensorCompression method, OutputFile& fout, const HostTensorND& value,
+        size_t channel_dims) {
+    mgb_assert(applicable(method, value, channel_dims));
+    switch (method) {
+        case TensorCompression::FLOAT16:
+            encode_float16(fout, value);
+            break;
+        case TensorCompression::INT8_PER_CHANNEL:
+            encode_int8_per_channel(fout, value, channel_dims);
+            break;
+        case TensorCompression::ENTROPY:
+            encode_entropy(fout, value);
+            break;
+        default:
+            mgb_throw(
+                    SerializationError, "bad tensor compression method: %d",
+                    static_cast<int>(method));
+    }
+}
+
+/* ==================== TensorValueDecoder ==================== */
+
+TensorValueDecoder::TensorValueDecoder(
+        TensorCompression method, SharedBuffer buf, const TensorLayout& layout)
+        : m_method{method}, m_buf{std::move(buf)}, m_layout{layout} {
+    mgb_assert(m_layout.is_contiguous());
+    switch (m_method) {
+        case TensorCompression::FLOAT16:
+            mgb_throw_if(
+                    m_layout.dtype != dtype::Float32(), SerializationError,
+                    "float16 compression requires float32 tensor, got %s",
+                    m_layout.dtype.name());
+#if MEGDNN_DISABLE_FLOAT16
+            mgb_throw(SerializationError, "float16 is disabled at compile time");
+#endif
+            init_elemwise_parts(0, 2);
+            break;
+        case TensorCompression::INT8_PER_CHANNEL: {
+            mgb_throw_if(
+                    m_layout.dtype != dtype::Float32() || m_layout.ndim < 2,
+                    SerializationError,
+                    "int8 compression requires float32 tensor with ndim >= 2, "
+                    "got %s",
+                    m_layout.to_string().c_str());
+            mgb_throw_if(
+                    m_buf.size() < sizeof(uint32_t), SerializationError,
+                    "corrupted compressed tensor value: size %zu", m_buf.size());
+            size_t channel_dims = load_unaligned<uint32_t>(src_ptr());
+            mgb_throw_if(
+                    channel_dims >= m_layout.ndim, SerializationError,
+                    "corrupted compressed tensor value: %zu channel axes for %s",
+                    channel_dims, m_layout.to_string().c_str());
+            size_t nr_channel = get_nr_channel(m_layout, channel_dims);
+            m_channel_size = m_layout.total_nr_elems() / nr_channel;
+            size_t header_bytes = sizeof(uint32_t) + nr_channel * sizeof(float);
+            mgb_throw_if(
+                    m_buf.size() < header_bytes, SerializationError,
+                    "corrupted compressed tensor value: size %zu", m_buf.size());
+            m_scale.resize(nr_channel);
+            memcpy(m_scale.data(), src_ptr() + sizeof(uint32_t),
+                   nr_channel * sizeof(float));
+            init_elemwise_parts(header_bytes, 1);
+            break;
+        }
+        case TensorCompression::ENTROPY:
+            init_entropy_parts();
+            break;
+        default:
+            mgb_throw(
+                    SerializationError, "bad tensor compression method: %d",
+                    static_cast<int>(m_method));
+    }
+}
+
+void TensorValueDecoder::init_elemwise_parts(size_t src_offset, size_t src_elem_size) {
+    size_t nr_elem = m_layout.total_nr_elems();
+    mgb_throw_if(
+            m_buf.size() != src_offset + nr_elem * src_elem_size, SerializationError,
+            "corrupted compressed tensor value: size %zu, expect %zu", m_buf.size(),
+            src_offset + nr_elem * src_elem_size);
+    constexpr size_t part_elems = PART_SIZE / sizeof(float);
+    for (size_t i = 0; i < nr_elem; i += part_elems) {
+        size_t end = std::min(nr_elem, i + part_elems);
+        m_parts.push_back(
+                {src_offset + i * src_elem_size, src_offset + end * src_elem_size,
+                 i * sizeof(float), end * sizeof(float)});
+    }
+}
+
+void TensorValueDecoder::init_entropy_parts() {
+    auto ptr = src_ptr();
+    constexpr size_t header_size = sizeof(uint32_t) * 2;
+    mgb_throw_if(
+            m_buf.size() < header_size, SerializationError,
+            "corrupted compressed tensor value: size %zu", m_buf.size());
+    size_t block_size = load_unaligned<uint32_t>(ptr),
+           nr_block = load_unaligned<uint32_t>(ptr + sizeof(uint32_t)),
+           size = m_layout.span().high_byte;
+    mgb_throw_if(
+            !block_size || block_size % shuffle_width(m_layout.dtype) ||
+                    nr_block != (size + block_size - 1) / block_size ||
+                    m_buf.size() < header_size + nr_block * sizeof(uint32_t),
+            SerializationError, "corrupted compressed tensor value: bad header");
+    size_t src_offset = header_size + nr_block * sizeof(uint32_t);
+    for (size_t i = 0; i < nr_block; ++i) {
+        size_t src_size = load_unaligned<uint32_t>(
+                ptr + header_size + i * sizeof(uint32_t));
+        size_t dest_begin = i * block_size,
+               dest_end = std::min(size, dest_begin + block_size);
+        m_parts.push_back({src_offset, src_offset + src_size, dest_begin, dest_end});
+        src_offset += src_size;
+    }
+    mgb_throw_if(
+            src_offset != m_buf.size(), SerializationError,
+            "corrupted compressed tensor value: size %zu, expect %zu", m_buf.size(),
+            src_offset);
+}
+
+void TensorValueDecoder::decode(void* dest, size_t part_idx) const {
+    auto&& part = m_parts.at(part_idx);
+    auto src = src_ptr() + part.src_begin;
+    auto dest_ptr = static_cast<uint8_t*>(dest) + part.dest_begin;
+    size_t dest_size = part.dest_end - part.dest_begin;
+    switch (m_method) {
+        case TensorCompression::FLOAT16: {
+#if !MEGDNN_DISABLE_FLOAT16
+            auto fdest = reinterpret_cast<float*>(dest_ptr);
+            for (size_t i = 0, it = dest_size / sizeof(float); i < it; ++i) {
+                fdest[i] = static_cast<float>(
+                        load_unaligned<dt_float16>(src + i * sizeof(dt_float16)));
+            }
+#endif
+            break;
+        }
+        case TensorCompression::INT8_PER_CHANNEL: {
+            auto fdest = reinterpret_cast<float*>(dest_ptr);
+            auto qsrc = reinterpret_cast<const int8_t*>(src);
+            size_t elem_begin = part.dest_begin / sizeof(float);
+            for (size_t i = 0, it = dest_size / sizeof(float); i < it; ++i) {
+                fdest[i] = qsrc[i] * m_scale[(elem_begin + i) / m_channel_size];
+            }
+            break;
+        }
+        case TensorCompression::ENTROPY: {
+            size_t src_size = part.src_end - part.src_begin;
+            mgb_throw_if(
+                    !src_size, SerializationError,
+                    "corrupted compressed tensor value: empty block");
+            if (src[0] == BLOCK_RAW) {
+                mgb_throw_if(
+                        src_size != 1 + dest_size, SerializationError,
+                        "corrupted compressed tensor value: bad raw block");
+                memcpy(dest_ptr, src + 1, dest_size);
+                break;
+            }
+            mgb_throw_if(
+                    src[0] != BLOCK_RANS, SerializationError,
+                    "corrupted compressed tensor value: bad block type %d", src[0]);
+            size_t width = shuffle_width(m_layout.dtype);
+            if (width == 1) {
+                rans_decode(src, src_size, dest_ptr, dest_size);
+                break;
+            }
+            std::vector<uint8_t> shuffled(dest_size);
+            rans_decode(src, src_size, shuffled.data(), dest_size);
+            size_t nr_elem = dest_size / width;
+            for (size_t k = 0; k < width; ++k) {
+                auto plane = shuffled.data() + k * nr_elem;
+                for (size_t j = 0; j < nr_elem; ++j) {
+                    dest_ptr[j * width + k] = plane[j];
+                }
+            }
+            break;
+        }
+        default:
+            mgb_assert(0);
+    }
+}
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -0,0 +1,90 @@
+/**
+ * \file src/serialization/impl/tensor_compression.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#pragma once
+
+#include "megbrain/serialization/file.h"
+#include "megbrain/serialization/load_dump_config.h"
+#include "megbrain/tensor.h"
+
+namespace mgb {
+namespace serialization {
+
+/*!
+ * \brief encoder of the built-in tensor value compression methods
+ */
+class TensorValueEncoder {
+public:
+    /*!
+     * \brief whether \p method can be used to encode given value
+     * \param channel_dims number of leading axes whose indices form the
+     *      output channels, which get separate scales in INT8_PER_CHANNEL;
+     *      0 for a single scale
+     */
+    static bool applicable(
+            TensorCompression method, const HostTensorND& value,
+            size_t channel_dims = 0);
+
+    //! write encoded value to \p fout; applicable() must be true
+    static void encode(
+            TensorCompression method, OutputFile& fout, const HostTensorND& value,
+            size_t channel_dims = 0);
+};
+
+/*!
+ * \brief decoder of the built-in tensor value compression methods
+ *
+ * The value is split into parts that can be decoded concurrently, and each
+ * part is written directly into the destination tensor.
+ */
+class TensorValueDecoder {
+    //! byte ranges of the encoded data and the decoded value
+    struct Part {
+        size_t src_begin, src_end, dest_begin, dest_end;
+    };
+
+    const TensorCompression m_method;
+    const SharedBuffer m_buf;
+    const TensorLayout m_layout;
+    std::vector<Part> m_parts;
+    //! channel scales for INT8_PER_CHANNEL
+    std::vector<float> m_scale;
+    size_t m_channel_size = 0;
+
+    const uint8_t* src_ptr() const { return static_cast<const uint8_t*>(m_buf.data()); }
+
+    void init_elemwise_parts(size_t src_offset, size_t src_elem_size);
+    void init_entropy_parts();
+
+public:
+    /*!
+     * \param buf the whole encoded value
+     * \param layout layout of the decoded value, which must be contiguous
+     */
+    TensorValueDecoder(
+            TensorCompression method, SharedBuffer buf, const TensorLayout& layout);
+
+    size_t nr_parts() const { return m_parts.size(); }
+
+    //! decode a part into \p dest, which has the layout given in constructor
+    void decode(void* dest, size_t part) const;
+
+    //! decode all parts on the caller thread
+    void decode_all(void* dest) const {
+        for (size_t i = 0; i < nr_parts(); ++i) {
+            decode(dest, i);
+        }
+    }
+};
+
+}  // namespace serialization
+}  // namespace mgb
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -89,6 +89,18 @@ public:
      */
     MGE_WIN_DECLSPEC_FUC static std::unique_ptr<InputFile> make_mem_proxy(
             std::shared_ptr<void> ptr, size_t size, bool writable = true);
+
+    /*!
+     * \brief create an InputFile that maps a file on local file system
+     *      into memory
+     *
+     * Tensor values whose file offsets satisfy the alignment of their comp
+     * nodes are not copied: CPU tensors directly refer to the mapping, which
+     * is kept alive by the tensors. Dump with
+     * GraphDumpConfig::tensor_value_alignment to make all values aligned.
+     * Falls back to make_fs() on platforms without mmap.
+     */
+    MGE_WIN_DECLSPEC_FUC static std::unique_ptr<InputFile> make_mmap(const char* path);
 };
 
 //! abstract output file interface
@@ -15,6 +15,30 @@
 
 namespace mgb {
 namespace serialization {
+
+/*!
+ * \brief built-in encoding of param values in the dump file
+ *
+ * Only shared tensors (i.e. model params) are encoded; the lossy methods
+ * are further restricted to float32 params. Encoded values are decoded
+ * when loading the graph, and the decoding can run on a thread pool (see
+ * GraphLoadConfig::nr_load_threads).
+ */
+enum class TensorCompression : uint8_t {
+    NONE = 0,
+    //! store float32 values as float16
+    FLOAT16 = 1,
+    //! quantize float32 values to int8; params only used as filters of
+    //! Convolution or ConvBias in NCHW or NHWC get one scale per output
+    //! channel (the first axis, or the first two for group conv), others one
+    //! scale for the whole param; params with less than two non-1 dims (e.g.
+    //! biases) are not quantized
+    INT8_PER_CHANNEL = 2,
+    //! lossless coding of the raw bytes with an in-tree rANS entropy
+    //! coder; bytes of each element are shuffled into planes first
+    ENTROPY = 3,
+};
+
 //! config for dumping a whole graph; setup in GraphDumper
 struct GraphDumpConfig {
     /*!
@@ -58,6 +82,33 @@ struct GraphDumpConfig {
     //! names. this list record the mapping between output node and it's name
     std::vector<std::pair<std::string, SymbolVar>> alias_name_map;
 
+    /*!
+     * \brief alignment of tensor value blobs in the output file, which
+     *      must be a power of two; 0 means no alignment
+     *
+     * Blobs of at least this many bytes are placed at file offsets that are
+     * multiples of this value, and smaller ones are aligned to 64 bytes.
+     * Setting it to the page size lets InputFile::make_mmap() share tensor
+     * values with the page cache instead of copying them.
+     */
+    size_t tensor_value_alignment = 0;
+
+    //! encoding of param values; it can not be used together with
+    //! tensor_value_dumper
+    TensorCompression tensor_compression = TensorCompression::NONE;
+
+    /*!
+     * \brief whether to also dump filters preprocessed by the chosen
+     *      algorithms (see ComputingGraph::Options::GraphOpt::weight_preprocess)
+     *
+     * The graph must have been executed with weight_preprocess enabled on
+     * the target device. The packed filters are used by the loader if
+     * weight_preprocess is enabled in the graph to load into, and the
+     * algorithm chosen at runtime is the same; otherwise the original
+     * filters are preprocessed at first execution as usual.
+     */
+    bool dump_packed_weight = false;
+
     GraphDumpConfig(
             int keep_var_name_ = 1, bool keep_param_name_ = false,
             bool keep_opr_priority_ = false, bool keep_op_name_ = true,
@@ -132,6 +183,15 @@ struct GraphLoadConfig {
     //! GraphDumpConfig
     TensorValueLoader tensor_value_loader;
 
+    //! number of threads to decode shared tensors (i.e. model params) that
+    //! are compressed or loaded by tensor_value_loader; if it is larger
+    //! than 1, the raw data of each param is read on the caller thread and
+    //! decoded on a thread pool, so tensor_value_loader must be thread-safe.
+    //! Operators are still created in order, and all values are ready when
+    //! load() returns; opr loaders that read a value before that must call
+    //! OprLoadContext::wait_tensor_value().
+    size_t nr_load_threads = 1;
+
     GraphLoadConfig(
             const CompNodeMapper& comp_node_mapper_ = {},
             const OprLoaderMaker& opr_loader_maker_ = {},
@@ -203,6 +203,18 @@ public:
      */
     virtual std::shared_ptr<DeviceTensorND> load_tensor_shared() = 0;
 
+    /*!
+     * \brief wait until the host value of a tensor returned by
+     *      load_tensor_shared() is ready
+     *
+     * The value may still be decoded asynchronously when it is returned (see
+     * GraphLoadConfig::nr_load_threads), so opr loaders that copy or inspect
+     * the value must call this first.
+     */
+    virtual void wait_tensor_value(const DeviceTensorND& tensor) {
+        MGB_MARK_USED_VAR(tensor);
+    }
+
     //! get associated global configuration
     virtual const GraphLoadConfig& config() const = 0;
 
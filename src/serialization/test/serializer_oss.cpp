@@ -10,6 +10,7 @@
  */
 #if MGB_ENABLE_FBS_SERIALIZATION
 
+#include "megbrain/gopt/inference.h"
 #include "megbrain/opr/basic_arith_wrapper.h"
 #include "megbrain/opr/dnn/convolution.h"
 #include "megbrain/opr/io.h"
@@ -18,6 +19,9 @@
 #include "megbrain/serialization/serializer.h"
 #include "megbrain/test/helper.h"
 
+#include <cmath>
+#include <unordered_set>
+
 using namespace mgb;
 using namespace serialization;
 
@@ -225,6 +229,71 @@ TEST(TestSerializer2, APlusBParam) {
     ASSERT_EQ(1u + (cns[1].mem_node() != cns[0].mem_node()), shmap.at("y")->size());
 }
 
+TEST(TestSerializer2, AlignedValueMmap) {
+    auto cn = CompNode::load("cpu0");
+    auto fname = GET_OUTPUT_FILE();
+    constexpr size_t ALIGN = 4096;
+
+    HostTensorGenerator<> gen;
+    auto w_hv = gen({32, 64}, cn), b_hv = gen({1, 64}, cn);
+    {
+        auto host_x = std::make_shared<HostTensorND>(cn, TensorShape{32, 64});
+        auto graph = ComputingGraph::make();
+        auto w = std::make_shared<DeviceTensorND>(),
+             b = std::make_shared<DeviceTensorND>();
+        w->copy_from(*w_hv);
+        b->copy_from(*b_hv);
+        auto x = opr::Host2DeviceCopy::make(*graph, host_x, {"x"}),
+             y = x * opr::SharedDeviceTensor::make(*graph, w, {"w"}) +
+                 opr::SharedDeviceTensor::make(*graph, b, {"b"});
+
+        auto dumper = GraphDumper::make(
+                OutputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+        GraphDumper::DumpConfig config;
+        config.keep_param_name = true;
+        config.tensor_value_alignment = ALIGN;
+        auto rst = dumper->dump({y.rename("y")}, config);
+        ASSERT_EQ(
+                w_hv->layout().span().high_byte + b_hv->layout().span().high_byte,
+                rst.tensor_value_bytes);
+    }
+
+    auto check = [&](std::unique_ptr<InputFile> file, bool expect_shared) {
+        auto loader = GraphLoader::make(std::move(file), GraphDumpFormat::FLATBUFFERS);
+        auto rst = loader->load();
+        auto xv = rst.tensor_map.at("x");
+        *xv = *gen({32, 64}, cn);
+        HostTensorND host_y, host_y_expect;
+        host_y_expect.copy_from(*xv);
+        auto py = host_y_expect.ptr<float>();
+        for (size_t i = 0; i < 32; ++i) {
+            for (size_t j = 0; j < 64; ++j) {
+                py[i * 64 + j] = py[i * 64 + j] * w_hv->ptr<float>()[i * 64 + j] +
+                                 b_hv->ptr<float>()[j];
+            }
+        }
+        auto func = rst.graph_compile(
+                {make_callback_copy(rst.output_var_map.at("y"), host_y)});
+        func->execute();
+        MGB_ASSERT_TENSOR_EQ(host_y_expect, host_y);
+
+        auto&& shmap = loader->shared_tensor_name_map();
+        auto w_ptr = reinterpret_cast<uintptr_t>(
+                shmap.at("w")->begin()->second->raw_ptr());
+        auto b_ptr = reinterpret_cast<uintptr_t>(
+                shmap.at("b")->begin()->second->raw_ptr());
+        if (expect_shared) {
+            // values refer to the mapping, which starts at a page boundary
+            ASSERT_EQ(0u, w_ptr % ALIGN);
+            ASSERT_EQ(0u, b_ptr % 64);
+        }
+    };
+    check(InputFile::make_fs(fname.c_str()), false);
+#if !defined(WIN32)
+    check(InputFile::make_mmap(fname.c_str()), true);
+#endif
+}
+
 TEST(TestSerializer2, Immutable) {
     auto fname = GET_OUTPUT_FILE();
     TensorShape shape{2, 3};
@@ -339,6 +408,355 @@ TEST(TestSerializer2, CustomLoader) {
     ASSERT_EQ(4, load_nr_call);
 }
 
+TEST(TestSerializer2, CustomLoaderParallel) {
+    auto fname = GET_OUTPUT_FILE();
+    constexpr size_t NR_PARAM = 16;
+    TensorShape shape{4, 8};
+    HostTensorGenerator<> gen;
+    std::vector<std::shared_ptr<HostTensorND>> params;
+    for (size_t i = 0; i < NR_PARAM; ++i) {
+        params.push_back(gen(shape));
+    }
+
+    // store negated values, so the loader has to decode them
+    auto tensor_value_dumper = [](OutputFile& fout, const cg::OperatorNodeBase&,
+                                  const HostTensorND& tensor) {
+        auto ptr = tensor.ptr<float>();
+        for (size_t i = 0, it = tensor.shape().total_nr_elems(); i < it; ++i) {
+            float v = -ptr[i];
+            fout.write(&v, sizeof(v));
+        }
+    };
+    std::mutex mtx;
+    std::unordered_set<std::thread::id> loader_threads;
+    auto tensor_value_loader = [&](void* ptr, const TensorLayout& layout,
+                                   InputFile& fin) {
+        auto nr_elems = layout.total_nr_elems();
+        if (!ptr) {
+            fin.skip(nr_elems * sizeof(float));
+            return;
+        }
+        auto dest = static_cast<float*>(ptr);
+        fin.read(dest, nr_elems * sizeof(float));
+        for (size_t i = 0; i < nr_elems; ++i) {
+            dest[i] = -dest[i];
+        }
+        MGB_LOCK_GUARD(mtx);
+        loader_threads.insert(std::this_thread::get_id());
+    };
+
+    {
+        auto host_x = std::make_shared<HostTensorND>(CompNode::load("xpu0"), shape);
+        auto graph = ComputingGraph::make();
+        auto y = opr::Host2DeviceCopy::make(*graph, host_x, {"x"});
+        for (auto&& i : params) {
+            y = y + opr::SharedDeviceTensor::make(*graph, *i);
+        }
+        auto dumper = GraphDumper::make(
+                OutputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+        GraphDumpConfig config;
+        config.tensor_value_dumper = tensor_value_dumper;
+        dumper->dump({y.rename("y")}, config);
+    }
+
+    GraphLoadConfig config;
+    config.tensor_value_loader = tensor_value_loader;
+    config.nr_load_threads = 4;
+    auto loader = GraphLoader::make(
+            InputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+    auto rst = loader->load(config);
+    ASSERT_FALSE(loader_threads.empty());
+    ASSERT_FALSE(loader_threads.count(std::this_thread::get_id()));
+
+    auto xv = rst.tensor_map.at("x");
+    *xv = *gen(shape);
+    HostTensorND host_y, host_y_expect;
+    host_y_expect.copy_from(*xv);
+    auto py = host_y_expect.ptr<float>();
+    for (auto&& i : params) {
+        for (size_t j = 0, it = shape.total_nr_elems(); j < it; ++j) {
+            py[j] += i->ptr<float>()[j];
+        }
+    }
+    auto func = rst.graph_compile(
+            {make_callback_copy(rst.output_var_map.at("y"), host_y)});
+    func->execute();
+    MGB_ASSERT_TENSOR_NEAR(host_y_expect, host_y, 1e-5);
+}
+
+TEST(TestSerializer2, CompressedParams) {
+    auto fname = GET_OUTPUT_FILE();
+    auto cn = CompNode::load("cpu0");
+    // w is large enough to be split into multiple parts
+    TensorShape w_shape{512, 600}, b_shape{1, 600};
+    HostTensorGenerator<> gen;
+    auto w_hv = gen(w_shape, cn), b_hv = gen(b_shape, cn);
+    // use values that are representable in float16 and compressible
+    for (auto&& hv : {w_hv, b_hv}) {
+        auto ptr = hv->ptr<float>();
+        for (size_t i = 0, it = hv->shape().total_nr_elems(); i < it; ++i) {
+            ptr[i] = std::round(ptr[i] * 8) / 8;
+        }
+    }
+
+    auto dump = [&](TensorCompression compression) {
+        auto host_x = std::make_shared<HostTensorND>(cn, w_shape);
+        auto graph = ComputingGraph::make();
+        auto y = opr::Host2DeviceCopy::make(*graph, host_x, {"x"}) *
+                         opr::SharedDeviceTensor::make(*graph, *w_hv, {"w"}) +
+                 opr::SharedDeviceTensor::make(*graph, *b_hv, {"b"});
+        auto dumper = GraphDumper::make(
+                OutputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+        GraphDumpConfig config;
+        config.keep_param_name = true;
+        config.tensor_compression = compression;
+        return dumper->dump({y.rename("y")}, config).tensor_value_bytes;
+    };
+
+    auto check = [&](float max_err, size_t nr_load_threads) {
+        GraphLoadConfig config;
+        config.nr_load_threads = nr_load_threads;
+        auto loader = GraphLoader::make(
+                InputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+        auto rst = loader->load(config);
+        auto&& shmap = loader->shared_tensor_name_map();
+        for (auto&& i : {std::make_pair("w", w_hv), std::make_pair("b", b_hv)}) {
+            HostTensorND got;
+            got.copy_from(*shmap.at(i.first)->begin()->second).sync();
+            MGB_ASSERT_TENSOR_NEAR(*i.second, got, max_err);
+        }
+
+        auto xv = rst.tensor_map.at("x");
+        *xv = *gen(w_shape, cn);
+        HostTensorND host_y;
+        auto func = rst.graph_compile(
+                {make_callback_copy(rst.output_var_map.at("y"), host_y)});
+        func->execute();
+        ASSERT_EQ(w_shape, host_y.shape());
+    };
+
+    auto raw_bytes = dump(TensorCompression::NONE);
+    ASSERT_EQ(
+            w_hv->layout().span().high_byte + b_hv->layout().span().high_byte,
+            raw_bytes);
+
+    ASSERT_LT(dump(TensorCompression::ENTROPY), raw_bytes / 2);
+    check(1e-6f, 1);
+    check(1e-6f, 4);
+
+    ASSERT_EQ(raw_bytes / 2, dump(TensorCompression::FLOAT16));
+    check(1e-6f, 1);
+    check(1e-6f, 4);
+
+    // w is not a conv filter so it gets a single scale, and b is a vector
+    // which is not quantized
+    ASSERT_EQ(
+            w_shape.total_nr_elems() + sizeof(uint32_t) + sizeof(float) +
+                    b_hv->layout().span().high_byte,
+            dump(TensorCompression::INT8_PER_CHANNEL));
+    // quantization error is bounded by half of the scale
+    float max_abs = 0;
+    for (auto&& hv : {w_hv, b_hv}) {
+        auto ptr = hv->ptr<float>();
+        for (size_t i = 0, it = hv->shape().total_nr_elems(); i < it; ++i) {
+            max_abs = std::max(max_abs, std::abs(ptr[i]));
+        }
+    }
+    check(max_abs / 254 + 1e-5f, 1);
+    check(max_abs / 254 + 1e-5f, 4);
+
+    // compressed values are marked in the feature bits following the magic,
+    // and a model with unknown feature bits is rejected
+    auto feature_bits = [&](uint64_t* set_bits) {
+        FILE* fp = fopen(fname.c_str(), "r+b");
+        mgb_assert(fp);
+        uint64_t bits;
+        fseek(fp, 4, SEEK_SET);
+        mgb_assert(fread(&bits, sizeof(bits), 1, fp) == 1);
+        if (set_bits) {
+            fseek(fp, 4, SEEK_SET);
+            mgb_assert(fwrite(set_bits, sizeof(bits), 1, fp) == 1);
+        }
+        fclose(fp);
+        return bits;
+    };
+    ASSERT_EQ(1u, feature_bits(nullptr));
+    dump(TensorCompression::NONE);
+    ASSERT_EQ(0u, feature_bits(nullptr));
+    uint64_t unknown_bits = 1ull << 40;
+    feature_bits(&unknown_bits);
+    ASSERT_THROW(check(0, 1), SerializationError);
+}
+
+TEST(TestSerializer2, CompressedParamsWithFormatParallel) {
+    auto fname = GET_OUTPUT_FILE();
+    auto cn = CompNode::load("cpu0");
+    HostTensorGenerator<> gen;
+    // large enough to be split into multiple parts, with values representable
+    // in float16
+    std::vector<std::shared_ptr<HostTensorND>> host_vals{
+            gen({512, 600}, cn), gen({300, 700}, cn)};
+    opr::MultipleDeviceTensorWithFormatHolder::ValueArray dev_vals;
+    for (auto&& hv : host_vals) {
+        auto ptr = hv->ptr<float>();
+        for (size_t i = 0, it = hv->shape().total_nr_elems(); i < it; ++i) {
+            ptr[i] = std::round(ptr[i] * 8) / 8;
+        }
+        dev_vals.push_back(std::make_shared<DeviceTensorND>());
+        dev_vals.back()->copy_from(*hv).sync();
+    }
+    {
+        auto graph = ComputingGraph::make();
+        auto outputs = opr::MultipleDeviceTensorWithFormatHolder::make(
+                *graph, dev_vals);
+        auto dumper = GraphDumper::make(
+                OutputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+        GraphDumpConfig config;
+        config.tensor_compression = TensorCompression::FLOAT16;
+        dumper->dump(outputs, config);
+    }
+
+    // the opr loader copies the values while they are decoded on the pool
+    GraphLoadConfig config;
+    config.nr_load_threads = 4;
+    auto loader = GraphLoader::make(
+            InputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+    auto rst = loader->load(config);
+    ASSERT_EQ(host_vals.size(), rst.output_var_list.size());
+    HostTensorND got0, got1;
+    auto func = rst.graph_compile(
+            {make_callback_copy(rst.output_var_list[0], got0),
+             make_callback_copy(rst.output_var_list[1], got1)});
+    func->execute();
+    MGB_ASSERT_TENSOR_EQ(*host_vals[0], got0);
+    MGB_ASSERT_TENSOR_EQ(*host_vals[1], got1);
+}
+
+TEST(TestSerializer2, CompressedConvFilterPerChannel) {
+    auto fname = GET_OUTPUT_FILE();
+    auto cn = CompNode::load("cpu0");
+    HostTensorGenerator<> gen;
+    // group conv filter of (group, ocpg, icpg, fh, fw), with channels of very
+    // different ranges
+    auto host_x = gen({1, 4, 8, 8}, cn), host_w = gen({2, 3, 2, 3, 3}, cn),
+         host_b = gen({1, 6, 1, 1}, cn);
+    auto w_ptr = host_w->ptr<float>();
+    for (size_t i = 0; i < 6; ++i) {
+        for (size_t j = 0; j < 18; ++j) {
+            w_ptr[i * 18 + j] *= std::pow(10.f, -static_cast<float>(i));
+        }
+    }
+
+    // params merged by ParamMergePass (as in optimize_for_inference) are
+    // dumped by a MultipleDeviceTensorHolder with many outputs
+    auto run = [&](bool merge_params) {
+        {
+            auto graph = ComputingGraph::make();
+            opr::ConvBias::Param param;
+            param.sparse = opr::ConvBias::Param::Sparse::GROUP;
+            param.pad_h = param.pad_w = 1;
+            auto y = opr::ConvBias::make(
+                    opr::Host2DeviceCopy::make(*graph, host_x, {"x"}),
+                    opr::SharedDeviceTensor::make(*graph, *host_w, {"w"}),
+                    opr::SharedDeviceTensor::make(*graph, *host_b, {"b"}), param);
+            if (merge_params) {
+                y = gopt::GraphOptimizer{}
+                            .add_pass<gopt::ParamMergePass>()
+                            .apply({{y}})
+                            .endpoint_vars()[0];
+                ASSERT_TRUE(y.node()
+                                    ->owner_opr()
+                                    ->input(1)
+                                    ->owner_opr()
+                                    ->same_type<opr::MultipleDeviceTensorHolder>());
+            }
+            auto dumper = GraphDumper::make(
+                    OutputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+            GraphDumpConfig config;
+            config.keep_param_name = true;
+            config.tensor_compression = TensorCompression::INT8_PER_CHANNEL;
+            auto rst = dumper->dump({y.rename("y")}, config);
+            // one scale for each of group * ocpg channels, and raw bias
+            ASSERT_EQ(
+                    host_w->shape().total_nr_elems() + sizeof(uint32_t) +
+                            6 * sizeof(float) + host_b->layout().span().high_byte,
+                    rst.tensor_value_bytes);
+        }
+
+        auto loader = GraphLoader::make(
+                InputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+        loader->load();
+        auto&& shmap = loader->shared_tensor_name_map();
+        HostTensorND got_w, got_b;
+        got_w.copy_from(*shmap.at("w")->begin()->second).sync();
+        got_b.copy_from(*shmap.at("b")->begin()->second).sync();
+        MGB_ASSERT_TENSOR_EQ(*host_b, got_b);
+        auto got_ptr = got_w.ptr<float>();
+        for (size_t i = 0; i < 6; ++i) {
+            float max_abs = 0;
+            for (size_t j = 0; j < 18; ++j) {
+                max_abs = std::max(max_abs, std::abs(w_ptr[i * 18 + j]));
+            }
+            for (size_t j = 0; j < 18; ++j) {
+                ASSERT_NEAR(
+                        w_ptr[i * 18 + j], got_ptr[i * 18 + j],
+                        max_abs / 254 * 1.01f)
+                        << "channel " << i << " merge_params " << merge_params;
+            }
+        }
+    };
+    run(false);
+    run(true);
+}
+
+TEST(TestSerializer2, PackedWeight) {
+    auto fname = GET_OUTPUT_FILE();
+    auto cn = CompNode::load("cpu0");
+    HostTensorGenerator<> gen;
+    auto host_x = gen({2, 8, 16, 16}, cn), host_w = gen({16, 8, 3, 3}, cn),
+         host_b = gen({1, 16, 1, 1}, cn);
+    opr::ConvBias::Param param;
+    param.pad_h = param.pad_w = 1;
+
+    HostTensorND host_y_expect;
+    {
+        auto graph = ComputingGraph::make();
+        graph->options().graph_opt.weight_preprocess = true;
+        // weights must be const after loading to allow preprocessing
+        auto dev_w = std::make_shared<DeviceTensorND>(),
+             dev_b = std::make_shared<DeviceTensorND>();
+        dev_w->copy_from(*host_w);
+        dev_b->copy_from(*host_b);
+        auto wb = opr::MultipleDeviceTensorHolder::make(*graph, {dev_w, dev_b});
+        auto x = opr::Host2DeviceCopy::make(*graph, host_x, {"x"}),
+             y = opr::ConvBias::make(x, wb[0], wb[1], param);
+        auto func = graph->compile({make_callback_copy(y, host_y_expect)});
+        func->execute();
+
+        auto dumper = GraphDumper::make(
+                OutputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+        GraphDumpConfig config;
+        config.dump_packed_weight = true;
+        dumper->dump({y.rename("y")}, config);
+    }
+
+    // whether or not the chosen algo packs the weight, results should match
+    for (bool weight_preprocess : {false, true}) {
+        GraphLoadConfig config;
+        config.comp_graph = ComputingGraph::make();
+        config.comp_graph->options().graph_opt.weight_preprocess = weight_preprocess;
+        auto loader = GraphLoader::make(
+                InputFile::make_fs(fname.c_str()), GraphDumpFormat::FLATBUFFERS);
+        auto rst = loader->load(config);
+        rst.tensor_map.at("x")->copy_from(*host_x);
+        HostTensorND host_y;
+        auto func = rst.graph_compile(
+                {make_callback_copy(rst.output_var_map.at("y"), host_y)});
+        func->execute();
+        MGB_ASSERT_TENSOR_NEAR(host_y_expect, host_y, 1e-4);
+    }
+}
+
 TEST(TestSerializer2, ManyIOVars) {
     auto fname = GET_OUTPUT_FILE();
     constexpr size_t NR_VARS = 32;